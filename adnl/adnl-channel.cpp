@@ -83,7 +83,7 @@ AdnlChannelImpl::AdnlChannelImpl(AdnlNodeIdShort local_id, AdnlNodeIdShort peer_
 }
 
 void AdnlChannelImpl::decrypt(td::BufferSlice raw_data, td::Promise<AdnlPacket> promise) {
-  TRY_RESULT_PROMISE_PREFIX(promise, data, decryptor_->decrypt(raw_data.as_slice()),
+  TRY_RESULT_PROMISE_PREFIX(promise, data, decryptor_->decrypt_in_place(std::move(raw_data)),
                             "failed to decrypt channel message: ");
   TRY_RESULT_PROMISE_PREFIX(promise, tl_packet, fetch_tl_object<ton_api::adnl_packetContents>(std::move(data), true),
                             "decrypted channel packet contains invalid TL scheme: ");
@@ -18,15 +18,25 @@
 */
 #include "td/utils/crypto.h"
 #include "td/utils/Random.h"
+#include "td/utils/overloaded.h"
 
 #include "adnl-local-id.h"
 #include "keys/encryptor.h"
+#include "auto/tl/ton_api.hpp"
 #include "utils.hpp"
 
 namespace ton {
 
 namespace adnl {
 
+// Packets from the same address go to the same keyring worker: the sender is unknown until the packet is decrypted,
+// and one busy sender can not take all workers
+static td::uint64 decrypt_shard_key(const td::IPAddress &addr) {
+  td::uint64 key = addr.is_ipv4() ? addr.get_ipv4() : std::hash<std::string>()(addr.get_ipv6());
+  key = (key << 16 | static_cast<td::uint16>(addr.get_port())) * 0x9e3779b97f4a7c15ULL;
+  return key >> 32;
+}
+
 AdnlNodeIdFull AdnlLocalId::get_id() const {
   return id_;
 }
@@ -48,25 +58,46 @@ void AdnlLocalId::receive(td::IPAddress addr, td::BufferSlice data) {
     return;
   }
   ++rate_limiter.currently_decrypting_packets;
+  // The promise is fulfilled by one of the keyring's decryptor actors. The packet is parsed there as well, so both
+  // stages run in parallel for different senders, and this actor only does the bookkeeping.
+  // The packet is decrypted inside the received buffer, and the parser keeps views of it for large payloads, so
+  // normally the payload is not copied between the socket and the subscriber.
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), peer_table = peer_table_, dst = short_id_, addr,
-                                       id = print_id(), size = data.size()](td::Result<AdnlPacket> R) {
-    td::actor::send_closure(SelfId, &AdnlLocalId::decrypt_packet_done, addr);
-    if (R.is_error()) {
-      VLOG(ADNL_WARNING) << id << ": dropping IN message: cannot decrypt: " << R.move_as_error();
+                                       id = print_id(), size = data.size(), raw = data.as_slice().begin(),
+                                       started_at = td::Time::now()](td::Result<td::BufferSlice> R) {
+    double decrypted_at = td::Time::now();
+    td::uint64 copied_bytes = 0;
+    td::Result<AdnlPacket> packetR;
+    if (R.is_ok()) {
+      auto decrypted = R.move_as_ok();
+      if (decrypted.as_slice().begin() < raw || decrypted.as_slice().end() > raw + size) {
+        copied_bytes += decrypted.size();
+      }
+      packetR = parse_packet(std::move(decrypted), &copied_bytes);
     } else {
-      auto packet = R.move_as_ok();
+      packetR = R.move_as_error();
+    }
+    double parsed_at = td::Time::now();
+    td::actor::send_closure(SelfId, &AdnlLocalId::decrypt_packet_done, addr, decrypted_at - started_at,
+                            parsed_at - decrypted_at, (td::uint64)size, copied_bytes);
+    if (packetR.is_error()) {
+      VLOG(ADNL_WARNING) << id << ": dropping IN message: cannot decrypt: " << packetR.move_as_error();
+    } else {
+      auto packet = packetR.move_as_ok();
       packet.set_remote_addr(addr);
       td::actor::send_closure(peer_table, &AdnlPeerTable::receive_decrypted_packet, dst, std::move(packet), size);
     }
   });
-  decrypt(std::move(data), std::move(P));
+  td::actor::send_closure(keyring_, &keyring::Keyring::decrypt_message_in_place, short_id_.pubkey_hash(),
+                          std::move(data), decrypt_shard_key(addr), std::move(P));
 }
 
-void AdnlLocalId::decrypt_packet_done(td::IPAddress addr) {
+void AdnlLocalId::decrypt_packet_done(td::IPAddress addr, double decrypt_time, double parse_time,
+                                      td::uint64 received_bytes, td::uint64 copied_bytes) {
   auto it = inbound_rate_limiter_.find(addr);
   CHECK(it != inbound_rate_limiter_.end());
   --it->second.currently_decrypting_packets;
-  add_decrypted_packet_stats(addr);
+  add_decrypted_packet_stats(addr, decrypt_time, parse_time, received_bytes, copied_bytes);
 }
 
 void AdnlLocalId::deliver(AdnlNodeIdShort src, td::BufferSlice data) {
@@ -231,31 +262,39 @@ void AdnlLocalId::decrypt_message(td::BufferSlice data, td::Promise<td::BufferSl
 }
 
 void AdnlLocalId::decrypt(td::BufferSlice data, td::Promise<AdnlPacket> promise) {
-  auto P = td::PromiseCreator::lambda(
-      [SelfId = actor_id(this), p = std::move(promise)](td::Result<td::BufferSlice> res) mutable {
-        if (res.is_error()) {
-          p.set_error(res.move_as_error());
-        } else {
-          td::actor::send_closure_later(SelfId, &AdnlLocalId::decrypt_continue, res.move_as_ok(), std::move(p));
-        }
-      });
-  td::actor::send_closure(keyring_, &keyring::Keyring::decrypt_message, short_id_.pubkey_hash(), std::move(data),
-                          std::move(P));
+  auto P = td::PromiseCreator::lambda([p = std::move(promise)](td::Result<td::BufferSlice> res) mutable {
+    TRY_RESULT_PROMISE(p, data, std::move(res));
+    p.set_result(parse_packet(std::move(data)));
+  });
+  td::actor::send_closure(keyring_, &keyring::Keyring::decrypt_message_in_place, short_id_.pubkey_hash(),
+                          std::move(data), td::Random::fast_uint64(), std::move(P));
 }
 
-void AdnlLocalId::decrypt_continue(td::BufferSlice data, td::Promise<AdnlPacket> promise) {
-  auto R = fetch_tl_object<ton_api::adnl_packetContents>(std::move(data), true);
-  if (R.is_error()) {
-    promise.set_error(R.move_as_error());
-    return;
-  }
-
-  auto packetR = AdnlPacket::create(R.move_as_ok());
-  if (packetR.is_error()) {
-    promise.set_error(packetR.move_as_error());
-    return;
+td::Result<AdnlPacket> AdnlLocalId::parse_packet(td::BufferSlice data, td::uint64 *copied_bytes) {
+  td::Slice buffer = data.as_slice();
+  TRY_RESULT(packet, fetch_tl_object<ton_api::adnl_packetContents>(std::move(data), true));
+  if (copied_bytes) {
+    // TlBufferParser returns views of the packet buffer only for aligned payloads, the rest are copied
+    auto count = [&](const td::BufferSlice &payload) {
+      if (payload.as_slice().begin() < buffer.begin() || payload.as_slice().end() > buffer.end()) {
+        *copied_bytes += payload.size();
+      }
+    };
+    auto count_message = [&](ton_api::adnl_Message &message) {
+      ton_api::downcast_call(message, td::overloaded([&](ton_api::adnl_message_custom &obj) { count(obj.data_); },
+                                                     [&](ton_api::adnl_message_query &obj) { count(obj.query_); },
+                                                     [&](ton_api::adnl_message_answer &obj) { count(obj.answer_); },
+                                                     [&](ton_api::adnl_message_part &obj) { count(obj.data_); },
+                                                     [&](auto &) {}));
+    };
+    if (packet->message_) {
+      count_message(*packet->message_);
+    }
+    for (auto &message : packet->messages_) {
+      count_message(*message);
+    }
   }
-  promise.set_value(packetR.move_as_ok());
+  return AdnlPacket::create(std::move(packet));
 }
 
 void AdnlLocalId::sign_async(td::BufferSlice data, td::Promise<td::BufferSlice> promise) {
@@ -323,10 +362,22 @@ void AdnlLocalId::get_stats(bool all, td::Promise<tl_object_ptr<ton_api::adnl_st
   promise.set_result(std::move(stats));
 }
 
-void AdnlLocalId::add_decrypted_packet_stats(td::IPAddress addr) {
+void AdnlLocalId::get_decryption_stats(td::Promise<tl_object_ptr<ton_api::adnl_stats_localIdDecryption>> promise) {
   prepare_packet_stats();
-  packet_stats_cur_.decrypted_packets[addr].inc();
-  packet_stats_total_.decrypted_packets[addr].inc();
+  auto stats = create_tl_object<ton_api::adnl_stats_localIdDecryption>();
+  stats->short_id_ = short_id_.bits256_value();
+  stats->recent_ = packet_stats_prev_.tl_decryption();
+  stats->total_ = packet_stats_total_.tl_decryption();
+  stats->total_->ts_start_ = (double)Adnl::adnl_start_time();
+  stats->total_->ts_end_ = td::Clocks::system();
+  promise.set_result(std::move(stats));
+}
+
+void AdnlLocalId::add_decrypted_packet_stats(td::IPAddress addr, double decrypt_time, double parse_time,
+                                             td::uint64 received_bytes, td::uint64 copied_bytes) {
+  prepare_packet_stats();
+  packet_stats_cur_.add_decrypted(addr, decrypt_time, parse_time, received_bytes, copied_bytes);
+  packet_stats_total_.add_decrypted(addr, decrypt_time, parse_time, received_bytes, copied_bytes);
 }
 
 void AdnlLocalId::add_dropped_packet_stats(td::IPAddress addr) {
@@ -351,6 +402,16 @@ void AdnlLocalId::prepare_packet_stats() {
   }
 }
 
+void AdnlLocalId::PacketStats::add_decrypted(td::IPAddress addr, double decrypt_time, double parse_time,
+                                             td::uint64 received_bytes, td::uint64 copied_bytes) {
+  decrypted_packets[addr].inc();
+  ++decrypted_total;
+  decrypt_latency.add(decrypt_time);
+  parse_latency.add(parse_time);
+  this->received_bytes += received_bytes;
+  this->copied_bytes += copied_bytes;
+}
+
 tl_object_ptr<ton_api::adnl_stats_localIdPackets> AdnlLocalId::PacketStats::tl(bool all) const {
   double threshold = all ? -1.0 : td::Clocks::system() - 600.0;
   auto obj = create_tl_object<ton_api::adnl_stats_localIdPackets>();
@@ -371,6 +432,22 @@ tl_object_ptr<ton_api::adnl_stats_localIdPackets> AdnlLocalId::PacketStats::tl(b
   return obj;
 }
 
+tl_object_ptr<ton_api::adnl_stats_decryption> AdnlLocalId::PacketStats::tl_decryption() const {
+  auto obj = create_tl_object<ton_api::adnl_stats_decryption>();
+  obj->ts_start_ = ts_start;
+  obj->ts_end_ = ts_end;
+  obj->decrypted_total_ = decrypted_total;
+  if (decrypted_total > 0) {
+    obj->decrypt_time_avg_ = decrypt_latency.sum / (double)decrypted_total;
+    obj->parse_time_avg_ = parse_latency.sum / (double)decrypted_total;
+  }
+  obj->decrypt_time_max_ = decrypt_latency.max;
+  obj->parse_time_max_ = parse_latency.max;
+  obj->received_bytes_ = received_bytes;
+  obj->copied_bytes_ = copied_bytes;
+  return obj;
+}
+
 
 }  // namespace adnl
 
@@ -50,12 +50,14 @@ class AdnlLocalId : public td::actor::Actor {
   }
 
   void decrypt(td::BufferSlice data, td::Promise<AdnlPacket> promise);
-  void decrypt_continue(td::BufferSlice data, td::Promise<AdnlPacket> promise);
+  // copied_bytes is increased by the size of message payloads which the parser could not keep as views of data
+  static td::Result<AdnlPacket> parse_packet(td::BufferSlice data, td::uint64 *copied_bytes = nullptr);
   void decrypt_message(td::BufferSlice data, td::Promise<td::BufferSlice> promise);
   void deliver(AdnlNodeIdShort src, td::BufferSlice data);
   void deliver_query(AdnlNodeIdShort src, td::BufferSlice data, td::Promise<td::BufferSlice> promise);
   void receive(td::IPAddress addr, td::BufferSlice data);
-  void decrypt_packet_done(td::IPAddress addr);
+  void decrypt_packet_done(td::IPAddress addr, double decrypt_time, double parse_time, td::uint64 received_bytes,
+                           td::uint64 copied_bytes);
 
   void subscribe(std::string prefix, std::unique_ptr<AdnlPeerTable::Callback> callback);
   void unsubscribe(std::string prefix);
@@ -79,6 +81,7 @@ class AdnlLocalId : public td::actor::Actor {
                      td::int32 update_priority_addr_list_if, td::Promise<AdnlPacket> promise);
 
   void get_stats(bool all, td::Promise<tl_object_ptr<ton_api::adnl_stats_localId>> promise);
+  void get_decryption_stats(td::Promise<tl_object_ptr<ton_api::adnl_stats_localIdDecryption>> promise);
 
   td::uint32 get_mode() {
     return mode_;
@@ -124,9 +127,26 @@ class AdnlLocalId : public td::actor::Actor {
     std::map<td::IPAddress, Counter> decrypted_packets;
     std::map<td::IPAddress, Counter> dropped_packets;
 
+    struct Latency {
+      double sum = 0.0, max = 0.0;
+
+      void add(double time) {
+        sum += time;
+        max = std::max(max, time);
+      }
+    };
+    td::uint64 decrypted_total = 0;
+    Latency decrypt_latency, parse_latency;
+    // Bytes of received packets and bytes copied on the way from the socket buffer to the message payloads
+    td::uint64 received_bytes = 0, copied_bytes = 0;
+    void add_decrypted(td::IPAddress addr, double decrypt_time, double parse_time, td::uint64 received_bytes,
+                       td::uint64 copied_bytes);
+
     tl_object_ptr<ton_api::adnl_stats_localIdPackets> tl(bool all = true) const;
+    tl_object_ptr<ton_api::adnl_stats_decryption> tl_decryption() const;
   } packet_stats_cur_, packet_stats_prev_, packet_stats_total_;
-  void add_decrypted_packet_stats(td::IPAddress addr);
+  void add_decrypted_packet_stats(td::IPAddress addr, double decrypt_time, double parse_time,
+                                  td::uint64 received_bytes, td::uint64 copied_bytes);
   void add_dropped_packet_stats(td::IPAddress addr);
   void prepare_packet_stats();
 
@@ -27,8 +27,8 @@ namespace ton {
 
 namespace adnl {
 
-td::actor::ActorOwn<AdnlNetworkManager> AdnlNetworkManager::create(td::uint16 port) {
-  return td::actor::create_actor<AdnlNetworkManagerImpl>("NetworkManager", port);
+td::actor::ActorOwn<AdnlNetworkManager> AdnlNetworkManager::create(td::uint16 port, td::UdpBatchOptions udp_options) {
+  return td::actor::create_actor<AdnlNetworkManagerImpl>("NetworkManager", port, udp_options);
 }
 
 AdnlNetworkManagerImpl::OutDesc *AdnlNetworkManagerImpl::choose_out_iface(td::uint8 cat, td::uint32 priority) {
@@ -69,7 +69,7 @@ size_t AdnlNetworkManagerImpl::add_listening_udp_port(td::uint16 port) {
   };
 
   auto idx = udp_sockets_.size();
-  auto X = td::UdpServer::create("udp server", port, std::make_unique<Callback>(actor_shared(this), idx));
+  auto X = td::UdpServer::create("udp server", port, std::make_unique<Callback>(actor_shared(this), idx), udp_options_);
   X.ensure();
   port_2_socket_[port] = idx;
   udp_sockets_.push_back(UdpSocketDesc{port, X.move_as_ok()});
@@ -21,6 +21,7 @@
 #include "td/actor/actor.h"
 
 #include "td/actor/PromiseFuture.h"
+#include "td/utils/BufferedUdp.h"
 #include "td/utils/port/IPAddress.h"
 
 #include "adnl-node-id.hpp"
@@ -64,7 +65,7 @@ class AdnlNetworkManager : public td::actor::Actor {
     //virtual void receive_packet(td::IPAddress addr, ConnHandle conn_handle, td::BufferSlice data) = 0;
     virtual void receive_packet(td::IPAddress addr, AdnlCategoryMask cat_mask, td::BufferSlice data) = 0;
   };
-  static td::actor::ActorOwn<AdnlNetworkManager> create(td::uint16 out_port);
+  static td::actor::ActorOwn<AdnlNetworkManager> create(td::uint16 out_port, td::UdpBatchOptions udp_options = {});
 
   virtual ~AdnlNetworkManager() = default;
 
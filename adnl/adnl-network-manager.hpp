@@ -98,7 +98,8 @@ class AdnlNetworkManagerImpl : public AdnlNetworkManager {
 
   OutDesc *choose_out_iface(td::uint8 cat, td::uint32 priority);
 
-  AdnlNetworkManagerImpl(td::uint16 out_udp_port) : out_udp_port_(out_udp_port) {
+  AdnlNetworkManagerImpl(td::uint16 out_udp_port, td::UdpBatchOptions udp_options)
+      : out_udp_port_(out_udp_port), udp_options_(udp_options) {
   }
 
   void install_callback(std::unique_ptr<Callback> callback) override {
@@ -161,6 +162,7 @@ class AdnlNetworkManagerImpl : public AdnlNetworkManager {
   std::map<AdnlNodeIdShort, td::uint8> adnl_id_2_cat_;
 
   td::uint16 out_udp_port_;
+  td::UdpBatchOptions udp_options_;
 };
 
 }  // namespace adnl
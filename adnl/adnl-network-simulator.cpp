@@ -0,0 +1,96 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "adnl-network-simulator.h"
+
+#include "td/utils/as.h"
+
+namespace ton {
+
+namespace adnl {
+
+double SimulatedLink::uniform() {
+  return static_cast<double>(rnd_() >> 11) * (1.0 / static_cast<double>(1ull << 53));
+}
+
+td::optional<double> SimulatedLink::send(double now, size_t size) {
+  stats_.packets++;
+  stats_.bytes += size;
+  if (profile_.loss > 0 && uniform() < profile_.loss) {
+    stats_.lost++;
+    return {};
+  }
+  double sent_at = now;
+  if (profile_.bandwidth > 0) {
+    auto start_at = std::max(now, busy_till_);
+    if (start_at - now > profile_.max_queue_delay) {
+      stats_.dropped++;
+      return {};
+    }
+    busy_till_ = start_at + static_cast<double>(size) / profile_.bandwidth;
+    sent_at = busy_till_;
+  }
+  double delay = profile_.delay;
+  if (profile_.jitter > 0) {
+    delay += uniform() * profile_.jitter;
+  }
+  return sent_at + delay;
+}
+
+void SimulatedNetworkManager::send_udp_packet(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, td::IPAddress dst_addr,
+                                              td::uint32 priority, td::BufferSlice data) {
+  auto r_at = get_link(src_id, dst_id).send(td::Time::now(), data.size());
+  if (!r_at) {
+    return;
+  }
+  in_flight_.push(r_at.unwrap(), Packet{dst_addr, std::move(data)});
+  alarm_timestamp().relax(in_flight_.next_at());
+}
+
+void SimulatedNetworkManager::set_link_profile(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id,
+                                               SimulatedLinkProfile profile) {
+  get_link(src_id, dst_id).set_profile(profile);
+}
+
+void SimulatedNetworkManager::get_link_stats(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id,
+                                             td::Promise<SimulatedLink::Stats> promise) {
+  promise.set_value(SimulatedLink::Stats(get_link(src_id, dst_id).stats()));
+}
+
+void SimulatedNetworkManager::alarm() {
+  CHECK(callback_);
+  in_flight_.deliver(td::Time::now(), [&](Packet packet) {
+    AdnlCategoryMask m;
+    m[0] = true;
+    callback_->receive_packet(packet.addr, std::move(m), std::move(packet.data));
+  });
+  alarm_timestamp() = in_flight_.next_at();
+}
+
+SimulatedLink &SimulatedNetworkManager::get_link(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id) {
+  auto key = std::make_pair(src_id, dst_id);
+  auto it = links_.find(key);
+  if (it == links_.end()) {
+    auto seed = seed_ ^ td::as<td::uint64>(src_id.bits256_value().data()) ^
+                (td::as<td::uint64>(dst_id.bits256_value().data()) * 0x9E3779B97F4A7C15ull);
+    it = links_.emplace(key, SimulatedLink{default_profile_, seed}).first;
+  }
+  return it->second;
+}
+
+}  // namespace adnl
+
+}  // namespace ton
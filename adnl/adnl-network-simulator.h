@@ -0,0 +1,162 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "adnl/adnl.h"
+#include "td/utils/optional.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <map>
+
+namespace ton {
+
+namespace adnl {
+
+// Impairments of one direction of a simulated link
+struct SimulatedLinkProfile {
+  double delay = 0.0;            // one-way propagation delay, seconds
+  double jitter = 0.0;           // extra delay uniformly distributed in [0, jitter], reorders packets
+  double loss = 0.0;             // probability to lose a packet
+  double bandwidth = 0.0;        // bytes per second, 0 means unlimited
+  double max_queue_delay = 0.5;  // packets which would wait longer in the bottleneck queue are dropped
+
+  static SimulatedLinkProfile lan() {
+    return {0.0005, 0.0, 0.0, 100e6, 0.05};
+  }
+  static SimulatedLinkProfile wan() {
+    return {0.04, 0.002, 0.001, 10e6, 0.2};
+  }
+  static SimulatedLinkProfile lossy_wan() {
+    return {0.08, 0.01, 0.02, 5e6, 0.2};
+  }
+  static SimulatedLinkProfile mobile() {
+    return {0.06, 0.04, 0.05, 1e6, 0.5};
+  }
+};
+
+// One direction of a simulated link. All randomness comes from the seed
+class SimulatedLink {
+ public:
+  struct Stats {
+    td::uint64 packets = 0;
+    td::uint64 bytes = 0;
+    td::uint64 lost = 0;
+    td::uint64 dropped = 0;
+  };
+
+  SimulatedLink(SimulatedLinkProfile profile, td::uint64 seed) : profile_(profile), rnd_(seed) {
+  }
+
+  // Returns the time the packet is delivered at, or none if it is lost or dropped by the queue
+  td::optional<double> send(double now, size_t size);
+
+  void set_profile(SimulatedLinkProfile profile) {
+    profile_ = profile;
+  }
+  const Stats &stats() const {
+    return stats_;
+  }
+
+ private:
+  SimulatedLinkProfile profile_;
+  td::Random::Xorshift128plus rnd_;
+  double busy_till_ = 0.0;
+  Stats stats_;
+
+  double uniform();
+};
+
+// Packets in flight, ordered by delivery time. Packets delivered at the same time keep the order they were sent in
+template <class T>
+class SimulatedPacketQueue {
+ public:
+  void push(double at, T packet) {
+    packets_.emplace(std::make_pair(at, next_id_++), std::move(packet));
+  }
+  td::Timestamp next_at() const {
+    return packets_.empty() ? td::Timestamp::never() : td::Timestamp::at(packets_.begin()->first.first);
+  }
+  bool empty() const {
+    return packets_.empty();
+  }
+  template <class F>
+  size_t deliver(double now, F &&f) {
+    size_t cnt = 0;
+    while (!packets_.empty() && packets_.begin()->first.first <= now) {
+      auto packet = std::move(packets_.begin()->second);
+      packets_.erase(packets_.begin());
+      f(std::move(packet));
+      cnt++;
+    }
+    return cnt;
+  }
+
+ private:
+  std::map<std::pair<double, td::uint64>, T> packets_;
+  td::uint64 next_id_ = 0;
+};
+
+// Drop-in replacement of TestLoopbackNetworkManager with per-link impairments.
+// Every (src, dst) pair gets its own link, seeded from the network seed and the ids, so runs with the same seed
+// and the same traffic lose and delay the same packets. Time is the scheduler's clock
+class SimulatedNetworkManager : public AdnlNetworkManager {
+ public:
+  explicit SimulatedNetworkManager(td::uint64 seed, SimulatedLinkProfile default_profile = {})
+      : seed_(seed), default_profile_(default_profile) {
+  }
+
+  void install_callback(std::unique_ptr<Callback> callback) override {
+    CHECK(!callback_);
+    callback_ = std::move(callback);
+  }
+  void add_self_addr(td::IPAddress addr, AdnlCategoryMask cat_mask, td::uint32 priority) override {
+  }
+  void add_proxy_addr(td::IPAddress addr, td::uint16 local_port, std::shared_ptr<AdnlProxy> proxy,
+                      AdnlCategoryMask cat_mask, td::uint32 priority) override {
+  }
+  void set_local_id_category(AdnlNodeIdShort id, td::uint8 cat) override {
+  }
+  void send_udp_packet(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, td::IPAddress dst_addr, td::uint32 priority,
+                       td::BufferSlice data) override;
+
+  void set_default_profile(SimulatedLinkProfile profile) {
+    default_profile_ = profile;
+  }
+  void set_link_profile(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, SimulatedLinkProfile profile);
+  void get_link_stats(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id, td::Promise<SimulatedLink::Stats> promise);
+
+  void alarm() override;
+
+ private:
+  struct Packet {
+    td::IPAddress addr;
+    td::BufferSlice data;
+  };
+
+  td::uint64 seed_;
+  SimulatedLinkProfile default_profile_;
+  std::unique_ptr<Callback> callback_;
+  std::map<std::pair<AdnlNodeIdShort, AdnlNodeIdShort>, SimulatedLink> links_;
+  SimulatedPacketQueue<Packet> in_flight_;
+
+  SimulatedLink &get_link(AdnlNodeIdShort src_id, AdnlNodeIdShort dst_id);
+};
+
+}  // namespace adnl
+
+}  // namespace ton
@@ -467,6 +467,54 @@ void AdnlPeerTableImpl::get_stats(bool all, td::Promise<tl_object_ptr<ton_api::a
   td::actor::send_closure(callback, &Cb::dec_pending);
 }
 
+void AdnlPeerTableImpl::get_decryption_stats(td::Promise<tl_object_ptr<ton_api::adnl_decryptionStats>> promise) {
+  class Cb : public td::actor::Actor {
+   public:
+    explicit Cb(td::Promise<tl_object_ptr<ton_api::adnl_decryptionStats>> promise) : promise_(std::move(promise)) {
+    }
+
+    void got_local_id_stats(tl_object_ptr<ton_api::adnl_stats_localIdDecryption> local_id) {
+      stats_->local_ids_.push_back(std::move(local_id));
+      dec_pending();
+    }
+
+    void inc_pending() {
+      ++pending_;
+    }
+
+    void dec_pending() {
+      CHECK(pending_ > 0);
+      --pending_;
+      if (pending_ == 0) {
+        stats_->timestamp_ = td::Clocks::system();
+        promise_.set_result(std::move(stats_));
+        stop();
+      }
+    }
+
+   private:
+    td::Promise<tl_object_ptr<ton_api::adnl_decryptionStats>> promise_;
+    size_t pending_ = 1;
+    tl_object_ptr<ton_api::adnl_decryptionStats> stats_ = create_tl_object<ton_api::adnl_decryptionStats>();
+  };
+  auto callback = td::actor::create_actor<Cb>("adnldecryptstats", std::move(promise)).release();
+
+  for (auto &[id, local_id] : local_ids_) {
+    td::actor::send_closure(callback, &Cb::inc_pending);
+    td::actor::send_closure(local_id.local_id, &AdnlLocalId::get_decryption_stats,
+                            [id = id, callback](td::Result<tl_object_ptr<ton_api::adnl_stats_localIdDecryption>> R) {
+                              if (R.is_error()) {
+                                VLOG(ADNL_NOTICE) << "failed to get decryption stats for local id " << id << " : "
+                                                  << R.move_as_error();
+                                td::actor::send_closure(callback, &Cb::dec_pending);
+                              } else {
+                                td::actor::send_closure(callback, &Cb::got_local_id_stats, R.move_as_ok());
+                              }
+                            });
+  }
+  td::actor::send_closure(callback, &Cb::dec_pending);
+}
+
 }  // namespace adnl
 
 }  // namespace ton
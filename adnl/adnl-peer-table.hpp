@@ -109,6 +109,7 @@ class AdnlPeerTableImpl : public AdnlPeerTable {
   void get_conn_ip_str(AdnlNodeIdShort l_id, AdnlNodeIdShort p_id, td::Promise<td::string> promise) override;
 
   void get_stats(bool all, td::Promise<tl_object_ptr<ton_api::adnl_stats>> promise) override;
+  void get_decryption_stats(td::Promise<tl_object_ptr<ton_api::adnl_decryptionStats>> promise) override;
 
   struct PrintId {};
   PrintId print_id() const {
@@ -122,6 +122,7 @@ class Adnl : public AdnlSenderInterface {
                              td::Promise<std::pair<td::actor::ActorOwn<AdnlTunnel>, AdnlAddress>> promise) = 0;
 
   virtual void get_stats(bool all, td::Promise<tl_object_ptr<ton_api::adnl_stats>> promise) = 0;
+  virtual void get_decryption_stats(td::Promise<tl_object_ptr<ton_api::adnl_decryptionStats>> promise) = 0;
 
   static td::actor::ActorOwn<Adnl> create(std::string db, td::actor::ActorId<keyring::Keyring> keyring);
 
@@ -0,0 +1,210 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "catchain/catchain-block-log.h"
+#include "crypto/Ed25519.h"
+#include "auto/tl/ton_api.hpp"
+#include "tl-utils/tl-utils.hpp"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <map>
+
+// Measures how long it takes to restore a catchain session with many blocks from the block log:
+// reading the log, ordering blocks by dependencies and checking them. Replay that relies on checkpoints
+// is compared with replay that verifies the signature of every block, as the RocksDB-based replay did.
+
+namespace {
+
+using ton::catchain::CatChainBlockHash;
+using ton::catchain::CatChainBlockLog;
+
+struct Source {
+  td::Ed25519::PrivateKey key;
+  td::Ed25519::PublicKey pub;
+  td::Bits256 hash;
+  ton::tl_object_ptr<ton::ton_api::catchain_block_dep> last;
+};
+
+ton::tl_object_ptr<ton::ton_api::catchain_block_id> block_id(const td::Bits256 &incarnation, const td::Bits256 &src,
+                                                             td::int32 height, const td::Bits256 &data_hash) {
+  return ton::create_tl_object<ton::ton_api::catchain_block_id>(incarnation, src, height, data_hash);
+}
+
+ton::tl_object_ptr<ton::ton_api::catchain_block_dep> clone_dep(const ton::ton_api::catchain_block_dep &dep) {
+  return ton::create_tl_object<ton::ton_api::catchain_block_dep>(dep.src_, dep.height_, dep.data_hash_,
+                                                                 dep.signature_.clone());
+}
+
+void write_log(const std::string &path, size_t blocks_cnt, size_t sources_cnt, size_t payload_size,
+               std::vector<Source> &sources, const td::Bits256 &incarnation) {
+  CatChainBlockLog::destroy(path);
+  std::vector<std::pair<CatChainBlockHash, td::BufferSlice>> blocks;
+  for (size_t i = 0; i < blocks_cnt; ++i) {
+    auto src = static_cast<td::int32>(td::Random::fast(0, static_cast<int>(sources_cnt) - 1));
+    Source &s = sources[src];
+    td::int32 height = s.last ? s.last->height_ + 1 : 1;
+    auto prev = s.last ? clone_dep(*s.last)
+                       : ton::create_tl_object<ton::ton_api::catchain_block_dep>(
+                             static_cast<td::int32>(sources_cnt), 0, incarnation, td::BufferSlice());
+    std::vector<ton::tl_object_ptr<ton::ton_api::catchain_block_dep>> deps;
+    for (int j = 0; j < 2; ++j) {
+      auto &other = sources[td::Random::fast(0, static_cast<int>(sources_cnt) - 1)];
+      if (&other != &s && other.last) {
+        deps.push_back(clone_dep(*other.last));
+      }
+    }
+    std::string payload(payload_size, '\0');
+    td::Random::secure_bytes(payload);
+    td::Bits256 data_hash;
+    td::sha256(payload, data_hash.as_slice());
+    auto id = block_id(incarnation, s.hash, height, data_hash);
+    auto signature = s.key.sign(ton::serialize_tl_object(id, true)).move_as_ok();
+    auto block = ton::create_tl_object<ton::ton_api::catchain_block>(
+        incarnation, src, height, ton::create_tl_object<ton::ton_api::catchain_block_data>(std::move(prev), std::move(deps)),
+        td::BufferSlice(signature.as_slice()));
+    s.last = ton::create_tl_object<ton::ton_api::catchain_block_dep>(src, height, data_hash,
+                                                                     td::BufferSlice(signature.as_slice()));
+    blocks.emplace_back(ton::get_tl_object_sha_bits256(id), ton::serialize_tl_object(block, true, td::Slice(payload)));
+  }
+
+  td::actor::Scheduler scheduler({1});
+  std::unique_ptr<CatChainBlockLog> log;
+  double started_at = td::Time::now();
+  scheduler.run_in_context([&] {
+    log = std::make_unique<CatChainBlockLog>(path);
+    log->open(CatChainBlockLog::Replay{}).ensure();
+    for (auto &[hash, data] : blocks) {
+      log->add_block(hash, data.as_slice());
+    }
+    log->sync([&](td::Result<td::Unit> R) {
+      R.ensure();
+      log = nullptr;
+      td::actor::SchedulerContext::get()->stop();
+    });
+  });
+  scheduler.run();
+  LOG(PLAIN) << "written " << blocks_cnt << " blocks in " << td::format::as_time(td::Time::now() - started_at);
+}
+
+void replay_log(const std::string &path, const std::vector<Source> &sources, const td::Bits256 &incarnation,
+                bool trust_checkpoints) {
+  double started_at = td::Time::now();
+  auto replay = CatChainBlockLog::replay(path).move_as_ok();
+  double read_at = td::Time::now();
+
+  struct Entry {
+    ton::tl_object_ptr<ton::ton_api::catchain_block> block;
+    td::BufferSlice payload;
+    bool verified;
+    td::uint32 pending_deps = 0;
+    std::vector<size_t> rev_deps;
+  };
+  std::vector<Entry> entries;
+  std::map<CatChainBlockHash, size_t> idx;
+  for (auto &b : replay.blocks) {
+    idx[b.hash] = entries.size();
+    auto block = ton::fetch_tl_prefix<ton::ton_api::catchain_block>(b.data, true).move_as_ok();
+    entries.push_back(Entry{std::move(block), std::move(b.data), b.verified && trust_checkpoints});
+  }
+  auto dep_hash = [&](const ton::ton_api::catchain_block_dep &dep) {
+    return ton::get_tl_object_sha_bits256(block_id(incarnation, sources[dep.src_].hash, dep.height_, dep.data_hash_));
+  };
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto add_dep = [&](const ton::ton_api::catchain_block_dep &dep) {
+      if (dep.height_ == 0) {
+        return;
+      }
+      auto it = idx.find(dep_hash(dep));
+      CHECK(it != idx.end());
+      entries[it->second].rev_deps.push_back(i);
+      ++entries[i].pending_deps;
+    };
+    add_dep(*entries[i].block->data_->prev_);
+    for (const auto &dep : entries[i].block->data_->deps_) {
+      add_dep(*dep);
+    }
+  }
+  std::vector<size_t> batch;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].pending_deps == 0) {
+      batch.push_back(i);
+    }
+  }
+  double ordered_at = td::Time::now();
+
+  size_t processed = 0, batches = 0, verified = 0;
+  while (!batch.empty()) {
+    ++batches;
+    std::vector<size_t> next_batch;
+    for (size_t i : batch) {
+      Entry &e = entries[i];
+      td::Bits256 data_hash;
+      td::sha256(e.payload.as_slice(), data_hash.as_slice());
+      if (!e.verified) {
+        auto &s = sources[e.block->src_];
+        auto id = block_id(incarnation, s.hash, e.block->height_, data_hash);
+        s.pub.verify_signature(ton::serialize_tl_object(id, true), e.block->signature_.as_slice()).ensure();
+        ++verified;
+      }
+      ++processed;
+      for (size_t j : e.rev_deps) {
+        if (--entries[j].pending_deps == 0) {
+          next_batch.push_back(j);
+        }
+      }
+    }
+    batch = std::move(next_batch);
+  }
+  CHECK(processed == entries.size());
+  double done_at = td::Time::now();
+  LOG(PLAIN) << (trust_checkpoints ? "checkpointed replay: " : "full verification:   ") << processed << " blocks in "
+             << batches << " batches, " << verified << " signatures checked; read "
+             << td::format::as_time(read_at - started_at) << ", order " << td::format::as_time(ordered_at - read_at)
+             << ", check " << td::format::as_time(done_at - ordered_at)
+             << ", time-to-rejoin " << td::format::as_time(done_at - started_at);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  size_t blocks_cnt = 100000;
+  if (argc > 1) {
+    blocks_cnt = td::to_integer<size_t>(td::Slice(argv[1]));
+  }
+  size_t sources_cnt = 100;
+  size_t payload_size = 512;
+  td::Bits256 incarnation;
+  td::Random::secure_bytes(incarnation.as_slice());
+  std::vector<Source> sources;
+  for (size_t i = 0; i < sources_cnt; ++i) {
+    auto key = td::Ed25519::generate_private_key().move_as_ok();
+    auto pub = key.get_public_key().move_as_ok();
+    td::Bits256 hash;
+    td::sha256(pub.as_octet_string(), hash.as_slice());
+    sources.push_back(Source{std::move(key), std::move(pub), hash, nullptr});
+  }
+  std::string path = "catchain-bench.blocks";
+  write_log(path, blocks_cnt, sources_cnt, payload_size, sources, incarnation);
+  replay_log(path, sources, incarnation, true);
+  replay_log(path, sources, incarnation, false);
+  CatChainBlockLog::destroy(path);
+  return 0;
+}
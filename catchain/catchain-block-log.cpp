@@ -0,0 +1,176 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "catchain-block-log.h"
+
+#include "td/utils/as.h"
+#include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+
+namespace ton {
+
+namespace catchain {
+
+namespace {
+
+constexpr td::uint32 RECORD_BLOCK = 0x426c6f63;
+constexpr td::uint32 RECORD_ROOT = 0x526f6f74;
+constexpr td::uint32 RECORD_CHECKPOINT = 0x43686b70;
+constexpr size_t RECORD_HEADER_SIZE = 12;
+
+struct Record {
+  td::uint32 tag;
+  td::Slice prefix;
+  td::Slice data;
+
+  td::int64 serialize(td::MutableSlice dest) const {
+    size_t size = RECORD_HEADER_SIZE + prefix.size() + data.size();
+    if (dest.size() < size) {
+      return -static_cast<td::int64>(size);
+    }
+    td::as<td::uint32>(dest.data()) = tag;
+    td::as<td::uint32>(dest.data() + 4) = static_cast<td::uint32>(prefix.size() + data.size());
+    td::as<td::uint32>(dest.data() + 8) = td::crc32c_extend(td::crc32c(prefix), data);
+    dest.remove_prefix(RECORD_HEADER_SIZE);
+    dest.copy_from(prefix);
+    dest.substr(prefix.size()).copy_from(data);
+    return static_cast<td::int64>(size);
+  }
+};
+
+class CatChainBlockLogReplayer : public td::actor::Actor {
+ public:
+  CatChainBlockLogReplayer(std::string path, td::Promise<CatChainBlockLog::Replay> promise)
+      : path_(std::move(path)), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    promise_.set_result(CatChainBlockLog::replay(path_));
+    stop();
+  }
+
+ private:
+  std::string path_;
+  td::Promise<CatChainBlockLog::Replay> promise_;
+};
+
+}  // namespace
+
+td::Result<CatChainBlockLog::Replay> CatChainBlockLog::replay(td::CSlice path) {
+  Replay res;
+  if (td::stat(path).is_error()) {
+    return res;
+  }
+  TRY_RESULT(file, td::read_file(path));
+  td::Slice data = file.as_slice();
+  size_t verified_blocks = 0;
+  while (data.size() >= RECORD_HEADER_SIZE) {
+    auto tag = td::as<td::uint32>(data.data());
+    auto size = td::as<td::uint32>(data.data() + 4);
+    auto crc = td::as<td::uint32>(data.data() + 8);
+    if (data.size() - RECORD_HEADER_SIZE < size) {
+      break;
+    }
+    td::Slice record = data.substr(RECORD_HEADER_SIZE, size);
+    if (td::crc32c(record) != crc) {
+      break;
+    }
+    if (tag == RECORD_BLOCK && size >= 32) {
+      res.blocks.push_back(Block{CatChainBlockHash{record.ubegin()}, file.from_slice(record.substr(32)), false});
+    } else if (tag == RECORD_ROOT && size == 32) {
+      res.root = CatChainBlockHash{record.ubegin()};
+    } else if (tag == RECORD_CHECKPOINT && size == 8) {
+      if (td::as<td::uint32>(record.data()) == res.valid_crc &&
+          td::as<td::uint32>(record.data() + 4) == res.blocks.size()) {
+        verified_blocks = res.blocks.size();
+      } else {
+        LOG(WARNING) << "catchain block log " << path << ": checkpoint mismatch at offset " << res.valid_size;
+      }
+    } else {
+      break;
+    }
+    res.valid_crc = td::crc32c_extend(res.valid_crc, data.substr(0, RECORD_HEADER_SIZE + size));
+    res.valid_size += RECORD_HEADER_SIZE + size;
+    data.remove_prefix(RECORD_HEADER_SIZE + size);
+  }
+  for (size_t i = 0; i < verified_blocks; ++i) {
+    res.blocks[i].verified = true;
+  }
+  res.dropped_size = file.size() - res.valid_size;
+  return res;
+}
+
+void CatChainBlockLog::replay_async(std::string path, td::Promise<Replay> promise) {
+  td::actor::create_actor<CatChainBlockLogReplayer>("cclogreplay", std::move(path), std::move(promise)).release();
+}
+
+void CatChainBlockLog::destroy(td::CSlice path) {
+  td::Binlog::destroy(path);
+}
+
+td::Status CatChainBlockLog::open(const Replay &replay) {
+  if (replay.dropped_size > 0) {
+    TRY_RESULT(fd, td::FileFd::open(path_, td::FileFd::Flags::Write));
+    TRY_STATUS(fd.truncate_to_current_position(static_cast<td::int64>(replay.valid_size)));
+    TRY_STATUS(fd.sync());
+    fd.close();
+  }
+  crc_.crc = replay.valid_crc;
+  blocks_ = static_cast<td::uint32>(replay.blocks.size());
+  return writer_.open();
+}
+
+void CatChainBlockLog::add_block(const CatChainBlockHash &hash, td::Slice data) {
+  write_record(RECORD_BLOCK, hash.as_slice(), data);
+  ++blocks_;
+  if (++blocks_since_checkpoint_ >= checkpoint_interval()) {
+    write_checkpoint();
+  }
+}
+
+void CatChainBlockLog::set_root(const CatChainBlockHash &hash) {
+  write_record(RECORD_ROOT, hash.as_slice(), {});
+}
+
+void CatChainBlockLog::sync(td::Promise<td::Unit> promise) {
+  if (blocks_since_checkpoint_ > 0) {
+    write_checkpoint();
+  }
+  writer_.sync(std::move(promise));
+}
+
+void CatChainBlockLog::write_record(td::uint32 tag, td::Slice prefix, td::Slice data) {
+  writer_.write_event(Record{tag, prefix, data}, &crc_).ensure();
+}
+
+void CatChainBlockLog::write_checkpoint() {
+  char buf[8];
+  td::as<td::uint32>(buf) = crc_.crc;
+  td::as<td::uint32>(buf + 4) = blocks_;
+  write_record(RECORD_CHECKPOINT, td::Slice(buf, 8), {});
+  blocks_since_checkpoint_ = 0;
+}
+
+td::Result<td::int64> CatChainBlockLog::CrcReader::parse(td::Slice data) {
+  crc = td::crc32c_extend(crc, data);
+  return static_cast<td::int64>(data.size());
+}
+
+}  // namespace catchain
+
+}  // namespace ton
@@ -0,0 +1,90 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "catchain-types.h"
+#include "td/actor/actor.h"
+#include "td/db/binlog/Binlog.h"
+#include "td/db/binlog/BinlogReaderInterface.h"
+
+namespace ton {
+
+namespace catchain {
+
+// Append-only storage of catchain blocks of one session.
+// Every record is [tag:uint32][size:uint32][crc32c:uint32][data:size bytes]:
+// - block: block hash (32 bytes) and the serialized block with payload, as it was stored in RocksDB,
+// - root: hash of the last block created by this node,
+// - checkpoint: crc32c of everything before the record and the number of blocks in it.
+// Blocks are written to the log only after they were validated. A checkpoint confirms that the prefix of the log is
+// intact, so blocks before the last valid checkpoint are not validated again on replay.
+// A torn record at the end of the log (the node was stopped while writing it) and everything after it are dropped.
+class CatChainBlockLog {
+ public:
+  struct Block {
+    CatChainBlockHash hash;
+    td::BufferSlice data;
+    bool verified;
+  };
+  struct Replay {
+    std::vector<Block> blocks;
+    CatChainBlockHash root = CatChainBlockHash::zero();
+    td::uint64 valid_size = 0;
+    td::uint32 valid_crc = 0;
+    td::uint64 dropped_size = 0;
+  };
+
+  // A missing log is replayed as an empty one
+  static td::Result<Replay> replay(td::CSlice path);
+  // Same, but the file is read and parsed by a separate actor
+  static void replay_async(std::string path, td::Promise<Replay> promise);
+  static void destroy(td::CSlice path);
+
+  explicit CatChainBlockLog(std::string path) : path_(std::move(path)), writer_(path_) {
+  }
+  // Truncates the log to the replayed prefix and opens it for appending. Must be called from an actor.
+  td::Status open(const Replay &replay);
+
+  void add_block(const CatChainBlockHash &hash, td::Slice data);
+  void set_root(const CatChainBlockHash &hash);
+  // Writes a checkpoint and waits until the log is synced to disk
+  void sync(td::Promise<td::Unit> promise);
+
+  static constexpr td::uint32 checkpoint_interval() {
+    return 1024;
+  }
+
+ private:
+  class CrcReader : public td::BinlogReaderInterface {
+   public:
+    td::Result<td::int64> parse(td::Slice data) override;
+    td::uint32 crc = 0;
+  };
+
+  std::string path_;
+  td::BinlogWriterAsync writer_;
+  CrcReader crc_;
+  td::uint32 blocks_ = 0;
+  td::uint32 blocks_since_checkpoint_ = 0;
+
+  void write_record(td::uint32 tag, td::Slice prefix, td::Slice data);
+  void write_checkpoint();
+};
+
+}  // namespace catchain
+
+}  // namespace ton
@@ -406,10 +406,7 @@ td::Status CatChainReceivedBlock::pre_validate_block(const CatChainReceiver *cha
     used.insert(X->src_);
   }
 
-  TRY_STATUS(chain->validate_block_sync(block->data_->prev_));
-  for (const auto &X : block->data_->deps_) {
-    TRY_STATUS(chain->validate_block_sync(X));
-  }
+  TRY_STATUS(chain->validate_block_deps_sync(block->data_->prev_, block->data_->deps_));
 
   if (payload.empty()) {
     return td::Status::Error(ErrorCode::protoviolation, "empty payload");
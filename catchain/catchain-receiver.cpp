@@ -140,8 +140,7 @@ void CatChainReceiverImpl::receive_block(adnl::AdnlNodeIdShort src, tl_object_pt
   create_block(std::move(block), td::SharedSlice{payload.as_slice()});
 
   if (!opts_.debug_disable_db) {
-    db_.set(
-        id, std::move(raw_data), [](td::Unit) {}, 1.0);
+    write_block_to_db(id, std::move(raw_data), [](td::Unit) {}, false);
   }
   block_written_to_db(id);
 }
@@ -261,6 +260,42 @@ td::Status CatChainReceiverImpl::validate_block_sync(const tl_object_ptr<ton_api
   return E->check_signature(B.as_slice(), block->signature_.as_slice());
 }
 
+td::Status CatChainReceiverImpl::validate_block_deps_sync(
+    const tl_object_ptr<ton_api::catchain_block_dep> &prev,
+    const std::vector<tl_object_ptr<ton_api::catchain_block_dep>> &deps) const {
+  // Keys and serialized ids must not be reallocated: the batch refers to them
+  std::vector<td::Bits256> public_keys;
+  std::vector<td::BufferSlice> to_sign;
+  std::vector<td::Ed25519::SignatureToCheck> batch;
+  public_keys.reserve(deps.size() + 1);
+  to_sign.reserve(deps.size() + 1);
+  for (size_t i = 0; i <= deps.size(); ++i) {
+    const tl_object_ptr<ton_api::catchain_block_dep> &dep = i == 0 ? prev : deps[i - 1];
+    TRY_STATUS_PREFIX(CatChainReceivedBlock::pre_validate_block(this, dep), "failed to validate block: ");
+    if (dep->height_ == 0) {
+      continue;
+    }
+    auto id = CatChainReceivedBlock::block_id(this, dep);
+    if (get_block(get_tl_object_sha_bits256(id))) {
+      continue;
+    }
+    CatChainReceiverSource *S = get_source_by_hash(PublicKeyHash{id->src_});
+    CHECK(S != nullptr);
+    td::BufferSlice B = serialize_tl_object(id, true);
+    PublicKey full_id = S->get_full_id();
+    if (!full_id.is_ed25519()) {
+      Encryptor *E = S->get_encryptor_sync();
+      CHECK(E != nullptr);
+      TRY_STATUS(E->check_signature(B.as_slice(), dep->signature_.as_slice()));
+      continue;
+    }
+    public_keys.push_back(full_id.ed25519_value().raw());
+    to_sign.push_back(std::move(B));
+    batch.push_back({public_keys.back().as_slice(), to_sign.back().as_slice(), dep->signature_.as_slice()});
+  }
+  return td::status_prefix(td::Ed25519::verify_batch(batch), "bad signature: ");
+}
+
 void CatChainReceiverImpl::run_scheduler() {
   while (!to_run_.empty()) {
     CatChainReceivedBlock *B = to_run_.front();
@@ -310,16 +345,13 @@ void CatChainReceiverImpl::add_block_cont_2(tl_object_ptr<ton_api::catchain_bloc
 
   CatChainBlockHash id = CatChainReceivedBlock::block_hash(this, block, payload);
 
-  td::BufferSlice raw_data{id.as_array().size()};
-  raw_data.as_slice().copy_from(as_slice(id));
-
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = std::move(block),
                                        payload = std::move(payload)](td::Result<td::Unit> R) mutable {
     R.ensure();
     td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_3, std::move(block), std::move(payload));
   });
 
-  db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(P), 0);
+  write_root_block_to_db(id, std::move(P));
 }
 
 void CatChainReceiverImpl::add_block_cont(tl_object_ptr<ton_api::catchain_block> block, td::BufferSlice payload) {
@@ -338,7 +370,7 @@ void CatChainReceiverImpl::add_block_cont(tl_object_ptr<ton_api::catchain_block>
     td::actor::send_closure(SelfId, &CatChainReceiverImpl::add_block_cont_2, std::move(block), std::move(payload));
   });
 
-  db_.set(id, std::move(raw_data), std::move(P), 0);
+  write_block_to_db(id, std::move(raw_data), std::move(P), true);
 }
 
 void CatChainReceiverImpl::add_block(td::BufferSlice payload, std::vector<CatChainBlockHash> deps) {
@@ -535,10 +567,16 @@ void CatChainReceiverImpl::start_up() {
 
   CHECK(root_block_);
 
-  if (!opts_.debug_disable_db) {
-    std::shared_ptr<td::KeyValue> kv = std::make_shared<td::RocksDb>(
-        td::RocksDb::open(db_root_ + "/catchainreceiver" + db_suffix_ + td::base64url_encode(as_slice(incarnation_)))
-            .move_as_ok());
+  if (opts_.debug_disable_db) {
+    read_db();
+  } else if (td::stat(db_name()).is_error() || td::stat(db_name() + ".blocks").is_ok()) {
+    CatChainBlockLog::replay_async(db_name() + ".blocks",
+                                   [SelfId = actor_id(this)](td::Result<CatChainBlockLog::Replay> R) {
+                                     td::actor::send_closure(SelfId, &CatChainReceiverImpl::read_block_log,
+                                                             std::move(R));
+                                   });
+  } else {
+    std::shared_ptr<td::KeyValue> kv = std::make_shared<td::RocksDb>(td::RocksDb::open(db_name()).move_as_ok());
     db_ = DbType{std::move(kv)};
 
     auto P = td::PromiseCreator::lambda([SelfId = actor_id(this)](td::Result<DbType::GetResult> R) {
@@ -556,8 +594,6 @@ void CatChainReceiverImpl::start_up() {
     });
 
     db_.get(CatChainBlockHash::zero(), std::move(P));
-  } else {
-    read_db();
   }
 }
 
@@ -636,6 +672,95 @@ void CatChainReceiverImpl::read_block_from_db(CatChainBlockHash id, td::BufferSl
   }
 }
 
+void CatChainReceiverImpl::read_block_log(td::Result<CatChainBlockLog::Replay> R) {
+  if (R.is_error()) {
+    // Nothing in an unreadable log can be trusted: the session starts from scratch, and all blocks are received
+    // from the neighbours and fully verified again
+    LOG(WARNING) << this << ": cannot read block log, dropping it: " << R.error();
+    CatChainBlockLog::destroy(db_name() + ".blocks");
+    R = CatChainBlockLog::Replay();
+  }
+  auto replay = R.move_as_ok();
+  double started_at = td::Time::now();
+  struct Entry {
+    tl_object_ptr<ton_api::catchain_block> block;
+    td::BufferSlice payload;
+    bool verified;
+    td::uint32 pending_deps = 0;
+    std::vector<size_t> rev_deps;
+  };
+  std::vector<Entry> entries;
+  std::map<CatChainBlockHash, size_t> idx;
+  for (auto &b : replay.blocks) {
+    auto F = fetch_tl_prefix<ton_api::catchain_block>(b.data, true);
+    if (F.is_error() || F.ok()->incarnation_ != incarnation_ || idx.count(b.hash)) {
+      LOG(WARNING) << this << ": dropping broken block " << b.hash << " from block log";
+      continue;
+    }
+    idx[b.hash] = entries.size();
+    entries.push_back(Entry{F.move_as_ok(), std::move(b.data), b.verified, 0, {}});
+  }
+  replay.blocks.clear();
+
+  // Blocks are created in topological order, so that dependencies are initialized before the blocks that refer to them
+  std::vector<size_t> batch;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto add_dep = [&](const tl_object_ptr<ton_api::catchain_block_dep> &dep) {
+      if (dep->height_ == 0) {
+        return;
+      }
+      auto it = idx.find(CatChainReceivedBlock::block_hash(this, dep));
+      if (it != idx.end()) {
+        entries[it->second].rev_deps.push_back(i);
+        ++entries[i].pending_deps;
+      }
+    };
+    add_dep(entries[i].block->data_->prev_);
+    for (const auto &dep : entries[i].block->data_->deps_) {
+      add_dep(dep);
+    }
+  }
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].pending_deps == 0) {
+      batch.push_back(i);
+    }
+  }
+  size_t created = 0, verified = 0, batches = 0;
+  while (!batch.empty()) {
+    ++batches;
+    std::vector<size_t> next_batch;
+    for (size_t i : batch) {
+      Entry &e = entries[i];
+      td::Status S = e.verified ? CatChainReceivedBlock::pre_validate_block(this, e.block, e.payload)
+                                : validate_block_sync(e.block, e.payload.as_slice());
+      if (S.is_error()) {
+        LOG(WARNING) << this << ": dropping block from block log: " << S;
+      } else {
+        CatChainReceivedBlock *B = create_block(std::move(e.block), td::SharedSlice{e.payload.as_slice()});
+        CHECK(B);
+        B->written();
+        ++created;
+        verified += !e.verified;
+      }
+      e.payload = {};
+      for (size_t j : e.rev_deps) {
+        if (--entries[j].pending_deps == 0) {
+          next_batch.push_back(j);
+        }
+      }
+    }
+    batch = std::move(next_batch);
+  }
+  db_root_block_ = replay.root;
+  LOG(INFO) << this << ": replayed " << created << " blocks from block log in " << batches << " batches ("
+            << verified << " blocks after the last checkpoint verified, " << replay.dropped_size
+            << " bytes of torn tail dropped) in " << td::Time::now() - started_at << "s";
+
+  block_log_ = std::make_unique<CatChainBlockLog>(db_name() + ".blocks");
+  block_log_->open(replay).ensure();
+  read_db();
+}
+
 void CatChainReceiverImpl::read_db() {
   if (!db_root_block_.is_zero()) {
     run_scheduler();
@@ -945,15 +1070,12 @@ bool CatChainReceiverImpl::unsafe_start_up_check_completed() {
 
   CatChainBlockHash id = B->get_hash();
 
-  td::BufferSlice raw_data{id.as_array().size()};
-  raw_data.as_slice().copy_from(as_slice(id));
-
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), block = B](td::Result<td::Unit> R) mutable {
     R.ensure();
     td::actor::send_closure(SelfId, &CatChainReceiverImpl::written_unsafe_root_block, block);
   });
 
-  db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(P), 0);
+  write_root_block_to_db(id, std::move(P));
   initial_sync_complete_at_ = td::Timestamp::in(EXPECTED_INITIAL_SYNC_DURATION);
   LOG(INFO) << "catchain: need update root";
   return false;
@@ -1037,6 +1159,35 @@ void CatChainReceiverImpl::send_custom_message_data(const PublicKeyHash &dst, td
                           get_source(local_idx_)->get_adnl_id(), overlay_id_, std::move(data));
 }
 
+void CatChainReceiverImpl::write_block_to_db(CatChainBlockHash id, td::BufferSlice raw_data,
+                                             td::Promise<td::Unit> promise, bool sync) {
+  if (!block_log_) {
+    db_.set(id, std::move(raw_data), std::move(promise), sync ? 0 : 1.0);
+    return;
+  }
+  block_log_->add_block(id, raw_data.as_slice());
+  if (sync) {
+    block_log_->sync(std::move(promise));
+  } else {
+    promise.set_value(td::Unit());
+  }
+}
+
+void CatChainReceiverImpl::write_root_block_to_db(CatChainBlockHash id, td::Promise<td::Unit> promise) {
+  if (!block_log_) {
+    td::BufferSlice raw_data{id.as_array().size()};
+    raw_data.as_slice().copy_from(as_slice(id));
+    db_.set(CatChainBlockHash::zero(), std::move(raw_data), std::move(promise), 0);
+    return;
+  }
+  block_log_->set_root(id);
+  block_log_->sync(std::move(promise));
+}
+
+std::string CatChainReceiverImpl::db_name() const {
+  return db_root_ + "/catchainreceiver" + db_suffix_ + td::base64url_encode(as_slice(incarnation_));
+}
+
 void CatChainReceiverImpl::block_written_to_db(CatChainBlockHash hash) {
   CatChainReceivedBlock *block = get_block(hash);
   CHECK(block);
@@ -1076,8 +1227,14 @@ void CatChainReceiverImpl::on_blame_processed(td::uint32 source_id) {
 }
 
 void CatChainReceiverImpl::destroy() {
-  auto name = db_root_ + "/catchainreceiver" + db_suffix_ + td::base64url_encode(as_slice(incarnation_));
-  delay_action([name]() { destroy_db(name, 0); }, td::Timestamp::in(DESTROY_DB_DELAY));
+  auto name = db_name();
+  block_log_ = nullptr;
+  delay_action(
+      [name]() {
+        CatChainBlockLog::destroy(name + ".blocks");
+        destroy_db(name, 0);
+      },
+      td::Timestamp::in(DESTROY_DB_DELAY));
   stop();
 }
 
@@ -64,6 +64,10 @@ class CatChainReceiver : public CatChainReceiverInterface {
   virtual td::Status validate_block_sync(const tl_object_ptr<ton_api::catchain_block_dep> &dep) const = 0;
   virtual td::Status validate_block_sync(const tl_object_ptr<ton_api::catchain_block> &block,
                                          const td::Slice &payload) const = 0;
+  // Same as validate_block_sync for prev and each of deps, signatures are checked as one batch
+  virtual td::Status validate_block_deps_sync(
+      const tl_object_ptr<ton_api::catchain_block_dep> &prev,
+      const std::vector<tl_object_ptr<ton_api::catchain_block_dep>> &deps) const = 0;
 
   virtual ~CatChainReceiver() = default;
 };
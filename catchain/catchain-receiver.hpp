@@ -26,6 +26,7 @@
 #include "catchain-receiver.h"
 #include "catchain-receiver-source.h"
 #include "catchain-received-block.h"
+#include "catchain-block-log.h"
 
 #include "td/db/KeyValueAsync.h"
 
@@ -88,6 +89,9 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   td::Status validate_block_sync(const tl_object_ptr<ton_api::catchain_block_dep> &dep) const override;
   td::Status validate_block_sync(const tl_object_ptr<ton_api::catchain_block> &block,
                                  const td::Slice &payload) const override;
+  td::Status validate_block_deps_sync(
+      const tl_object_ptr<ton_api::catchain_block_dep> &prev,
+      const std::vector<tl_object_ptr<ton_api::catchain_block_dep>> &deps) const override;
 
   void send_fec_broadcast(td::BufferSlice data) override;
   void send_custom_query_data(const PublicKeyHash &dst, std::string name, td::Promise<td::BufferSlice> promise,
@@ -122,8 +126,12 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   void read_db();
   void read_db_from(CatChainBlockHash id);
   void read_block_from_db(CatChainBlockHash id, td::BufferSlice data);
+  void read_block_log(td::Result<CatChainBlockLog::Replay> R);
 
+  void write_block_to_db(CatChainBlockHash id, td::BufferSlice raw_data, td::Promise<td::Unit> promise, bool sync);
+  void write_root_block_to_db(CatChainBlockHash id, td::Promise<td::Unit> promise);
   void block_written_to_db(CatChainBlockHash hash);
+  std::string db_name() const;
 
   bool unsafe_start_up_check_completed();
   void written_unsafe_root_block(CatChainReceivedBlock *block);
@@ -211,8 +219,10 @@ class CatChainReceiverImpl final : public CatChainReceiver {
   std::string db_root_;
   std::string db_suffix_;
 
+  // Blocks of sessions started before the block log was introduced are kept in RocksDB
   using DbType = td::KeyValueAsync<CatChainBlockHash, td::BufferSlice>;
   DbType db_;
+  std::unique_ptr<CatChainBlockLog> block_log_;
 
   bool intentional_fork_ = false;
   td::Timestamp initial_sync_complete_at_{td::Timestamp::never()};
@@ -41,6 +41,8 @@
 
 #endif
 
+#include <map>
+
 namespace td {
 
 Ed25519::PublicKey::PublicKey(SecureString octet_string) : octet_string_(std::move(octet_string)) {
@@ -235,6 +237,52 @@ Status Ed25519::PublicKey::verify_signature(Slice data, Slice signature) const {
   return Status::Error("Wrong signature");
 }
 
+Status Ed25519::verify_batch(Span<SignatureToCheck> batch, size_t *bad_index) {
+  std::map<Slice, EVP_PKEY *> pkeys;
+  SCOPE_EXIT {
+    for (auto &p : pkeys) {
+      EVP_PKEY_free(p.second);
+    }
+  };
+  EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+  if (md_ctx == nullptr) {
+    return Status::Error("Can't create EVP_MD_CTX");
+  }
+  SCOPE_EXIT {
+    EVP_MD_CTX_free(md_ctx);
+  };
+
+  auto check = [&](const SignatureToCheck &item) -> Status {
+    EVP_PKEY *&pkey = pkeys[item.public_key];
+    if (pkey == nullptr) {
+      if (item.public_key.size() != PublicKey::LENGTH ||
+          (pkey = detail::X25519_key_to_PKEY(item.public_key, false)) == nullptr) {
+        return Status::Error("Can't import public key");
+      }
+    }
+    if (EVP_DigestVerifyInit(md_ctx, nullptr, nullptr, nullptr, pkey) <= 0) {
+      return Status::Error("Can't init DigestVerify");
+    }
+    bool ok = EVP_DigestVerify(md_ctx, item.signature.ubegin(), item.signature.size(), item.data.ubegin(),
+                               item.data.size()) > 0;
+    EVP_MD_CTX_reset(md_ctx);
+    if (!ok) {
+      return Status::Error("Wrong signature");
+    }
+    return Status::OK();
+  };
+  for (size_t i = 0; i < batch.size(); i++) {
+    auto status = check(batch[i]);
+    if (status.is_error()) {
+      if (bad_index) {
+        *bad_index = i;
+      }
+      return status;
+    }
+  }
+  return Status::OK();
+}
+
 Result<SecureString> Ed25519::compute_shared_secret(const PublicKey &public_key, const PrivateKey &private_key) {
   BigNum p = BigNum::from_hex("7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed").move_as_ok();
   auto public_y = public_key.as_octet_string();
@@ -375,6 +423,37 @@ Status Ed25519::PublicKey::verify_signature(Slice data, Slice signature) const {
   return Status::Error("Wrong signature");
 }
 
+Status Ed25519::verify_batch(Span<SignatureToCheck> batch, size_t *bad_index) {
+  std::map<Slice, crypto::Ed25519::PublicKey> public_keys;
+  auto check = [&](const SignatureToCheck &item) -> Status {
+    if (item.signature.size() != crypto::Ed25519::sign_bytes) {
+      return Status::Error("Signature has invalid length");
+    }
+    auto it = public_keys.find(item.public_key);
+    if (it == public_keys.end()) {
+      crypto::Ed25519::PublicKey public_key;
+      if (item.public_key.size() != PublicKey::LENGTH || !public_key.import_public_key(item.public_key.ubegin())) {
+        return Status::Error("Bad public key");
+      }
+      it = public_keys.emplace(item.public_key, std::move(public_key)).first;
+    }
+    if (!it->second.check_message_signature(item.signature, item.data)) {
+      return Status::Error("Wrong signature");
+    }
+    return Status::OK();
+  };
+  for (size_t i = 0; i < batch.size(); i++) {
+    auto status = check(batch[i]);
+    if (status.is_error()) {
+      if (bad_index) {
+        *bad_index = i;
+      }
+      return status;
+    }
+  }
+  return Status::OK();
+}
+
 Result<SecureString> Ed25519::compute_shared_secret(const PublicKey &public_key, const PrivateKey &private_key) {
   crypto::Ed25519::PrivateKey tmp_private_key;
   if (!tmp_private_key.import_private_key(Slice(private_key.as_octet_string()).ubegin())) {
@@ -20,6 +20,7 @@
 
 #include "td/utils/common.h"
 #include "td/utils/SharedSlice.h"
+#include "td/utils/Span.h"
 #include "td/utils/Status.h"
 
 #if TD_HAVE_OPENSSL
@@ -62,6 +63,16 @@ class Ed25519 {
     SecureString octet_string_;
   };
 
+  struct SignatureToCheck {
+    Slice public_key;
+    Slice data;
+    Slice signature;
+  };
+
+  // Checks all signatures in the batch. Every public key is imported only once per batch.
+  // Returns the error of the first invalid signature, its index is stored to bad_index if it is not null.
+  static Status verify_batch(Span<SignatureToCheck> batch, size_t *bad_index = nullptr);
+
   static Result<PrivateKey> generate_private_key();
 
   static Result<SecureString> compute_shared_secret(const PublicKey &public_key, const PrivateKey &private_key);
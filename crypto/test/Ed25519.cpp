@@ -222,6 +222,48 @@ TEST(Crypto, almost_zero) {
   }
 }
 
+TEST(Crypto, ed25519_verify_batch) {
+  std::vector<td::SecureString> public_keys;
+  std::vector<std::string> messages;
+  std::vector<td::SecureString> signatures;
+  for (int i = 0; i < 5; i++) {
+    auto private_key = td::Ed25519::generate_private_key().move_as_ok();
+    public_keys.push_back(private_key.get_public_key().move_as_ok().as_octet_string());
+    for (int j = 0; j < 4; j++) {
+      messages.push_back(PSTRING() << "message " << i << " " << j);
+      signatures.push_back(private_key.sign(messages.back()).move_as_ok());
+    }
+  }
+  std::vector<td::Ed25519::SignatureToCheck> batch;
+  for (size_t i = 0; i < signatures.size(); i++) {
+    batch.push_back({public_keys[i / 4], messages[i], signatures[i]});
+  }
+  CHECK(td::Ed25519::verify_batch(batch).is_ok());
+  CHECK(td::Ed25519::verify_batch({}).is_ok());
+
+  for (size_t bad : {0, 7, 19}) {
+    auto bad_signature = signatures[bad].copy();
+    bad_signature.as_mutable_slice()[5] ^= 1;
+    auto bad_batch = batch;
+    bad_batch[bad].signature = bad_signature;
+    size_t bad_index = 0;
+    CHECK(td::Ed25519::verify_batch(bad_batch, &bad_index).is_error());
+    CHECK(bad_index == bad);
+    auto public_key = td::Ed25519::PublicKey(public_keys[bad / 4].copy());
+    CHECK(public_key.verify_signature(messages[bad], bad_signature).is_error());
+  }
+
+  auto bad_batch = batch;
+  bad_batch[3].data = messages[4];
+  size_t bad_index = 0;
+  CHECK(td::Ed25519::verify_batch(bad_batch, &bad_index).is_error());
+  CHECK(bad_index == 3);
+  bad_batch = batch;
+  bad_batch[10].public_key = td::Slice(public_keys[0]).substr(1);
+  CHECK(td::Ed25519::verify_batch(bad_batch, &bad_index).is_error());
+  CHECK(bad_index == 10);
+}
+
 BENCH(ed25519_sign, "ed25519_sign") {
   auto private_key = td::Ed25519::generate_private_key().move_as_ok();
   std::string hash_to_sign(32, 'a');
@@ -249,8 +291,27 @@ BENCH(ed25519_verify, "ed25519_verify") {
   }
 }
 
+BENCH(ed25519_verify_batch, "ed25519_verify_batch") {
+  std::vector<td::SecureString> public_keys;
+  std::vector<td::SecureString> signatures;
+  std::string hash_to_sign(32, 'a');
+  for (int i = 0; i < 100; i++) {
+    auto private_key = td::Ed25519::generate_private_key().move_as_ok();
+    public_keys.push_back(private_key.get_public_key().move_as_ok().as_octet_string());
+    signatures.push_back(private_key.sign(hash_to_sign).move_as_ok());
+  }
+  std::vector<td::Ed25519::SignatureToCheck> batch;
+  for (size_t i = 0; i < signatures.size(); i++) {
+    batch.push_back({public_keys[i], hash_to_sign, signatures[i]});
+  }
+  for (int i = 0; i < n; i += 100) {
+    td::Ed25519::verify_batch(batch).ensure();
+  }
+}
+
 TEST(Crypto, ed25519_benchmark) {
   bench(ed25519_signBench());
   bench(ed25519_shared_secretBench());
   bench(ed25519_verifyBench());
+  bench(ed25519_verify_batchBench());
 }
\ No newline at end of file
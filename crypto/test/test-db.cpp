@@ -854,6 +854,211 @@ TEST(TonDb, BenchCellBuilder3) {
   td::bench(BenchCellBuilder3());
 }
 
+namespace {
+struct DictTestAug : public vm::dict::AugmentationData {
+  // extra:uint64 = sum of the first 32 bits of values
+  bool skip_extra(vm::CellSlice &cs) const override {
+    return cs.advance(64);
+  }
+  bool eval_leaf(vm::CellBuilder &cb, vm::CellSlice &val_cs) const override {
+    return cb.store_long_bool(val_cs.prefetch_ulong(32), 64);
+  }
+  bool eval_fork(vm::CellBuilder &cb, vm::CellSlice &left_cs, vm::CellSlice &right_cs) const override {
+    return cb.store_long_bool(left_cs.prefetch_ulong(64) + right_cs.prefetch_ulong(64), 64);
+  }
+  bool eval_empty(vm::CellBuilder &cb) const override {
+    return cb.store_long_bool(0, 64);
+  }
+};
+
+Ref<vm::CellSlice> dict_test_value(unsigned x) {
+  vm::CellBuilder cb;
+  cb.store_long(x, 32);
+  return vm::load_cell_slice_ref(cb.finalize());
+}
+
+bool same_dict_root(const vm::DictionaryFixed &a, const vm::DictionaryFixed &b) {
+  auto ra = a.get_root_cell(), rb = b.get_root_cell();
+  return ra.is_null() ? rb.is_null() : rb.not_null() && ra->get_hash() == rb->get_hash();
+}
+
+template <unsigned n>
+std::vector<td::BitArray<n>> gen_sorted_keys(td::Random::Xorshift128plus &rnd, size_t count, int density) {
+  std::set<td::BitArray<n>> keys;
+  while (keys.size() < count) {
+    td::BitArray<n> key;
+    for (unsigned i = 0; i < n; i++) {
+      key[i] = rnd.fast(0, 7) < density;
+    }
+    keys.insert(key);
+  }
+  return {keys.begin(), keys.end()};
+}
+}  // namespace
+
+TEST(TonDb, DictBulkOps) {
+  td::Random::Xorshift128plus rnd(123);
+  DictTestAug aug;
+  for (int t = 0; t < 200; t++) {
+    constexpr unsigned n = 32;
+    // low density gives long common prefixes and labels of equal bits
+    int density = t % 7 + 1;
+    auto old_keys = gen_sorted_keys<n>(rnd, rnd.fast(0, 200), density);
+    auto new_keys = gen_sorted_keys<n>(rnd, rnd.fast(0, 200), density);
+    if (!old_keys.empty() && t % 2) {
+      new_keys.push_back(old_keys[0]);
+      std::sort(new_keys.begin(), new_keys.end());
+      new_keys.erase(std::unique(new_keys.begin(), new_keys.end()), new_keys.end());
+    }
+
+    unsigned x = 0;
+    vm::Dictionary dict{n}, dict_bulk{n};
+    vm::AugmentedDictionary adict{n, aug}, adict_bulk{n, aug};
+    std::vector<vm::DictionaryFixed::key_value_t> entries;
+    for (auto &key : old_keys) {
+      auto value = dict_test_value(++x);
+      dict.set(key, value);
+      adict.set(key, value);
+      entries.emplace_back(key.cbits(), value);
+    }
+    ASSERT_TRUE(dict_bulk.build_from_sorted(entries, n));
+    ASSERT_TRUE(adict_bulk.build_from_sorted(entries, n));
+    ASSERT_TRUE(same_dict_root(dict, dict_bulk));
+    ASSERT_TRUE(same_dict_root(adict, adict_bulk));
+
+    for (auto mode : {vm::Dictionary::SetMode::Set, vm::Dictionary::SetMode::Add, vm::Dictionary::SetMode::Replace}) {
+      vm::Dictionary dict2 = dict, dict2_bulk = dict;
+      vm::AugmentedDictionary adict2 = adict, adict2_bulk = adict;
+      entries.clear();
+      int changed = 0;
+      for (auto &key : new_keys) {
+        auto value = dict_test_value(++x);
+        changed += dict2.set(key, value, mode);
+        adict2.set(key, value, mode);
+        entries.emplace_back(key.cbits(), value);
+      }
+      ASSERT_EQ(changed, dict2_bulk.set_many(entries, n, mode));
+      ASSERT_EQ(changed, adict2_bulk.set_many(entries, n, mode));
+      ASSERT_TRUE(same_dict_root(dict2, dict2_bulk));
+      ASSERT_TRUE(same_dict_root(adict2, adict2_bulk));
+      ASSERT_TRUE(adict2_bulk.validate_all());
+
+      auto keys = old_keys;
+      keys.insert(keys.end(), new_keys.begin(), new_keys.end());
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      auto values = dict2_bulk.lookup_many(keys);
+      auto avalues = adict2_bulk.lookup_many(keys);
+      for (size_t i = 0; i < keys.size(); i++) {
+        auto value = dict2.lookup(keys[i]);
+        ASSERT_EQ(value.is_null(), values[i].is_null());
+        ASSERT_EQ(value.is_null(), avalues[i].is_null());
+        if (value.not_null()) {
+          ASSERT_EQ(value->prefetch_ulong(32), values[i]->prefetch_ulong(32));
+          ASSERT_EQ(value->prefetch_ulong(32), avalues[i]->prefetch_ulong(32));
+        }
+      }
+    }
+  }
+  // unsorted keys are rejected
+  vm::Dictionary dict{32};
+  td::BitArray<32> a, b;
+  a.store_ulong(2);
+  b.store_ulong(1);
+  std::vector<vm::DictionaryFixed::key_value_t> entries{{a.cbits(), dict_test_value(1)},
+                                                         {b.cbits(), dict_test_value(2)}};
+  ASSERT_EQ(-1, dict.set_many(entries, 32));
+  ASSERT_TRUE(!dict.build_from_sorted(entries, 32));
+}
+
+class BenchDictBulk : public td::Benchmark {
+ public:
+  enum class Mode { Set, SetMany, BuildFromSorted, Lookup, LookupMany };
+  BenchDictBulk(Mode mode, size_t count, bool augmented) : mode_(mode), count_(count), augmented_(augmented) {
+  }
+  std::string get_description() const override {
+    static const char *names[] = {"set", "set_many", "build_from_sorted", "lookup", "lookup_many"};
+    return PSTRING() << "Dictionary " << names[static_cast<int>(mode_)] << (augmented_ ? " (augmented)" : "")
+                     << " keys=" << count_;
+  }
+  void start_up() override {
+    td::Random::Xorshift128plus rnd(123);
+    keys_ = gen_sorted_keys<256>(rnd, count_, 4);
+    entries_.clear();
+    for (auto &key : keys_) {
+      entries_.emplace_back(key.cbits(), dict_test_value(static_cast<unsigned>(rnd())));
+    }
+    if (augmented_) {
+      vm::AugmentedDictionary dict{256, aug_};
+      dict.build_from_sorted(entries_, 256);
+      root_ = dict.get_root_cell();
+    } else {
+      vm::Dictionary dict{256};
+      dict.build_from_sorted(entries_, 256);
+      root_ = dict.get_root_cell();
+    }
+  }
+  void run(int n) override {
+    // set modes start from an empty dictionary, lookup modes use a prebuilt one
+    bool lookup = mode_ == Mode::Lookup || mode_ == Mode::LookupMany;
+    for (int i = 0; i < n; i++) {
+      if (augmented_) {
+        vm::AugmentedDictionary dict{lookup ? root_ : Ref<vm::Cell>{}, 256, aug_};
+        run_once(dict);
+      } else {
+        vm::Dictionary dict{lookup ? root_ : Ref<vm::Cell>{}, 256};
+        run_once(dict);
+      }
+    }
+  }
+
+ private:
+  Mode mode_;
+  size_t count_;
+  bool augmented_;
+  DictTestAug aug_;
+  std::vector<td::BitArray<256>> keys_;
+  std::vector<vm::DictionaryFixed::key_value_t> entries_;
+  Ref<vm::Cell> root_;
+
+  template <class Dict>
+  void run_once(Dict &dict) {
+    switch (mode_) {
+      case Mode::Set:
+        for (auto &entry : entries_) {
+          dict.set(entry.first, 256, entry.second);
+        }
+        break;
+      case Mode::SetMany:
+        dict.set_many(entries_, 256);
+        break;
+      case Mode::BuildFromSorted:
+        dict.build_from_sorted(entries_, 256);
+        break;
+      case Mode::Lookup:
+        for (auto &key : keys_) {
+          td::do_not_optimize_away(dict.lookup(key).not_null());
+        }
+        break;
+      case Mode::LookupMany:
+        td::do_not_optimize_away(dict.lookup_many(keys_).size());
+        break;
+    }
+    td::do_not_optimize_away(dict.get_root_cell().not_null());
+  }
+};
+
+TEST(TonDb, BenchDictBulk) {
+  using Mode = BenchDictBulk::Mode;
+  for (size_t count : {1000, 10000}) {
+    for (bool augmented : {false, true}) {
+      for (auto mode : {Mode::Set, Mode::SetMany, Mode::BuildFromSorted, Mode::Lookup, Mode::LookupMany}) {
+        td::bench(BenchDictBulk(mode, count, augmented));
+      }
+    }
+  }
+}
+
 TEST(TonDb, BocFuzz) {
   vm::std_boc_deserialize(td::base64_decode("te6ccgEBAQEAAgAoAAA=").move_as_ok()).ensure_error();
   vm::std_boc_deserialize(td::base64_decode("te6ccgQBQQdQAAAAAAEAte6ccgQBB1BBAAAAAAEAAAAAAP/"
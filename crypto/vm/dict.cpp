@@ -24,6 +24,7 @@
 #include "td/utils/Random.h"
 
 #include "td/utils/bits.h"
+#include <algorithm>
 
 namespace vm {
 
@@ -1115,6 +1116,210 @@ Ref<CellSlice> Dictionary::lookup_set_builder(td::ConstBitPtr key, int key_len,
   return lookup_set_gen(key, key_len, [val_b](CellBuilder& cb) { return cb.append_builder_bool(val_b); }, mode);
 }
 
+/*
+ *
+ *  Bulk operations over sorted keys
+ *
+ */
+
+bool DictionaryFixed::check_sorted(const key_value_t* entries, std::size_t cnt, int key_len) {
+  for (std::size_t i = 0; i < cnt; i++) {
+    if (entries[i].second.is_null() ||
+        (i > 0 && td::bitstring::bits_memcmp(entries[i - 1].first, entries[i].first, key_len) >= 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DictionaryFixed::dict_lookup_many(Ref<Cell> dict, const td::ConstBitPtr* keys, std::size_t cnt, int offs, int n,
+                                       Ref<CellSlice>* res) const {
+  while (cnt > 0) {
+    LabelParser label{std::move(dict), n, label_mode()};
+    // keys having the label as a prefix form a contiguous range, the others are absent
+    std::size_t l = 0;
+    while (l < cnt && !label.is_prefix_of(keys[l] + offs, n)) {
+      ++l;
+    }
+    std::size_t r = l;
+    while (r < cnt && label.is_prefix_of(keys[r] + offs, n)) {
+      ++r;
+    }
+    if (l == r) {
+      return;
+    }
+    keys += l;
+    res += l;
+    cnt = r - l;
+    if (label.l_bits == n) {
+      // leaf node, keys are unique
+      label.skip_label();
+      res[0] = std::move(label.remainder);
+      return;
+    }
+    int pos = offs + label.l_bits;
+    std::size_t m = std::partition_point(keys, keys + cnt, [pos](td::ConstBitPtr key) { return !key[pos]; }) - keys;
+    offs = pos + 1;
+    n -= label.l_bits + 1;
+    if (m > 0) {
+      dict_lookup_many(label.remainder->prefetch_ref(0), keys, m, offs, n, res);
+    }
+    dict = label.remainder->prefetch_ref(1);
+    keys += m;
+    res += m;
+    cnt -= m;
+  }
+}
+
+std::vector<Ref<CellSlice>> DictionaryFixed::lookup_many(const std::vector<td::ConstBitPtr>& keys, int key_len) {
+  force_validate();
+  std::vector<Ref<CellSlice>> res(keys.size());
+  if (key_len != get_key_bits() || is_empty() || keys.empty()) {
+    return res;
+  }
+  for (std::size_t i = 1; i < keys.size(); i++) {
+    if (td::bitstring::bits_memcmp(keys[i - 1], keys[i], key_len) >= 0) {
+      // not sorted (or has duplicates): fall back to separate lookups
+      for (std::size_t j = 0; j < keys.size(); j++) {
+        res[j] = lookup(keys[j], key_len);
+      }
+      return res;
+    }
+  }
+  dict_lookup_many(get_root_cell(), keys.data(), keys.size(), 0, key_len, res.data());
+  return res;
+}
+
+Ref<Cell> DictionaryFixed::dict_build_sorted(const key_value_t* entries, std::size_t cnt, int offs, int n) const {
+  assert(cnt > 0);
+  td::ConstBitPtr key = entries[0].first + offs;
+  CellBuilder cb;
+  if (cnt == 1) {
+    append_dict_label(cb, key, n, n);
+    return finish_create_leaf(cb, *entries[0].second);
+  }
+  // keys are sorted, so the common prefix of all keys is the common prefix of the first and the last one
+  std::size_t same_upto = 0;
+  td::bitstring::bits_memcmp(key, entries[cnt - 1].first + offs, n, &same_upto);
+  int pfx_len = (int)same_upto;
+  assert(pfx_len < n);
+  int pos = offs + pfx_len;
+  std::size_t m =
+      std::partition_point(entries, entries + cnt, [pos](const key_value_t& entry) { return !entry.first[pos]; }) -
+      entries;
+  Ref<Cell> c1 = dict_build_sorted(entries, m, pos + 1, n - pfx_len - 1);
+  Ref<Cell> c2 = dict_build_sorted(entries + m, cnt - m, pos + 1, n - pfx_len - 1);
+  append_dict_label(cb, key, pfx_len, n);
+  return finish_create_fork(cb, std::move(c1), std::move(c2), n - pfx_len);
+}
+
+std::pair<Ref<Cell>, int> DictionaryFixed::dict_set_many(Ref<Cell> dict, const key_value_t* entries, std::size_t cnt,
+                                                         int offs, int n, SetMode mode) const {
+  if (cnt == 0) {
+    return std::make_pair(std::move(dict), 0);
+  }
+  if (dict.is_null()) {
+    if (mode == SetMode::Replace) {
+      return std::make_pair(Ref<Cell>{}, 0);
+    }
+    return std::make_pair(dict_build_sorted(entries, cnt, offs, n), (int)cnt);
+  }
+  LabelParser label{dict, n, label_mode()};
+  td::ConstBitPtr key = entries[0].first + offs;
+  // minimal common prefix of the label and a key from a sorted range is reached on the first or on the last key
+  int pfx_len = std::min(label.common_prefix_len(key, n), label.common_prefix_len(entries[cnt - 1].first + offs, n));
+  assert(pfx_len >= 0 && pfx_len <= label.l_bits && label.l_bits <= n);
+  if (pfx_len < label.l_bits) {
+    // some keys leave the current edge: have to insert a new fork inside it
+    bool old_bit = label.l_same ? (label.l_same & 1) : label.bits()[pfx_len];
+    int pos = offs + pfx_len;
+    std::size_t m =
+        std::partition_point(entries, entries + cnt, [pos](const key_value_t& entry) { return !entry.first[pos]; }) -
+        entries;
+    const key_value_t* old_entries = old_bit ? entries + m : entries;
+    std::size_t old_cnt = old_bit ? cnt - m : m;
+    const key_value_t* new_entries = old_bit ? entries : entries + m;
+    std::size_t new_cnt = cnt - old_cnt;
+    if (mode == SetMode::Replace) {
+      // new keys are skipped
+      return dict_set_many(std::move(dict), old_entries, old_cnt, offs, n, mode);
+    }
+    int m_bits = n - pfx_len - 1;
+    Ref<Cell> c_new = dict_build_sorted(new_entries, new_cnt, pos + 1, m_bits);
+    // create the lower portion of the old edge
+    CellBuilder cb;
+    int t = label.l_bits - pfx_len - 1;
+    auto cs = std::move(label.remainder);
+    if (label.l_same) {
+      append_dict_label_same(cb, label.l_same & 1, t, m_bits);
+    } else {
+      cs.write().advance(pfx_len + 1);
+      append_dict_label(cb, cs->data_bits(), t, m_bits);
+      cs.unique_write().advance(t);
+    }
+    if (!cell_builder_add_slice_bool(cb, *cs)) {
+      throw VmError{Excno::cell_ov, "cannot change label of an old dictionary cell (?)"};
+    }
+    auto res = dict_set_many(cb.finalize(), old_entries, old_cnt, pos + 1, m_bits, mode);
+    Ref<Cell> c_old = std::move(res.first);
+    append_dict_label(cb, key, pfx_len, n);
+    if (old_bit) {
+      return std::make_pair(finish_create_fork(cb, std::move(c_new), std::move(c_old), n - pfx_len),
+                            res.second + (int)new_cnt);
+    } else {
+      return std::make_pair(finish_create_fork(cb, std::move(c_old), std::move(c_new), n - pfx_len),
+                            res.second + (int)new_cnt);
+    }
+  }
+  if (label.l_bits == n) {
+    // the edge leads to a leaf node with the only key of the range
+    if (mode == SetMode::Add) {
+      return std::make_pair(std::move(dict), 0);
+    }
+    CellBuilder cb;
+    append_dict_label(cb, key, n, n);
+    return std::make_pair(finish_create_leaf(cb, *entries[0].second), 1);
+  }
+  // the edge leads to a fork, split the keys between the two subtrees
+  int pos = offs + label.l_bits;
+  std::size_t m =
+      std::partition_point(entries, entries + cnt, [pos](const key_value_t& entry) { return !entry.first[pos]; }) -
+      entries;
+  int m_bits = n - label.l_bits - 1;
+  auto res1 = dict_set_many(label.remainder->prefetch_ref(0), entries, m, pos + 1, m_bits, mode);
+  auto res2 = dict_set_many(label.remainder->prefetch_ref(1), entries + m, cnt - m, pos + 1, m_bits, mode);
+  if (!res1.second && !res2.second) {
+    return std::make_pair(std::move(dict), 0);
+  }
+  CellBuilder cb;
+  append_dict_label(cb, key, label.l_bits, n);
+  return std::make_pair(finish_create_fork(cb, std::move(res1.first), std::move(res2.first), n - label.l_bits),
+                        res1.second + res2.second);
+}
+
+int DictionaryFixed::set_many(const std::vector<key_value_t>& entries, int key_len, SetMode mode) {
+  force_validate();
+  if (key_len != get_key_bits() || !check_sorted(entries.data(), entries.size(), key_len)) {
+    return -1;
+  }
+  auto res = dict_set_many(get_root_cell(), entries.data(), entries.size(), 0, key_len, mode);
+  if (res.second > 0) {
+    set_root_cell(std::move(res.first));
+  }
+  return res.second;
+}
+
+bool DictionaryFixed::build_from_sorted(const std::vector<key_value_t>& entries, int key_len) {
+  if (key_len != get_key_bits() || !check_sorted(entries.data(), entries.size(), key_len)) {
+    return false;
+  }
+  reset();
+  if (!entries.empty()) {
+    set_root_cell(dict_build_sorted(entries.data(), entries.size(), 0, key_len));
+  }
+  return true;
+}
+
 std::pair<Ref<CellSlice>, Ref<Cell>> DictionaryFixed::dict_lookup_delete(Ref<Cell> dict, td::ConstBitPtr key,
                                                                          int n) const {
   // std::cerr << "dictionary delete for " << n << "-bit key = " << key.to_hex(n) << std::endl;
@@ -2681,6 +2886,19 @@ std::pair<Ref<CellSlice>, Ref<CellSlice>> AugmentedDictionary::lookup_extra(td::
   return decompose_value_extra(lookup_with_extra(key, key_len));
 }
 
+std::vector<Ref<CellSlice>> AugmentedDictionary::lookup_many_with_extra(const std::vector<td::ConstBitPtr>& keys,
+                                                                         int key_len) {
+  return DictionaryFixed::lookup_many(keys, key_len);
+}
+
+std::vector<Ref<CellSlice>> AugmentedDictionary::lookup_many(const std::vector<td::ConstBitPtr>& keys, int key_len) {
+  auto res = DictionaryFixed::lookup_many(keys, key_len);
+  for (auto& value : res) {
+    value = extract_value(std::move(value));
+  }
+  return res;
+}
+
 std::pair<Ref<Cell>, Ref<CellSlice>> AugmentedDictionary::lookup_ref_extra(td::ConstBitPtr key, int key_len) {
   return decompose_value_ref_extra(lookup_with_extra(key, key_len));
 }
@@ -185,6 +185,7 @@ class DictionaryFixed : public DictionaryBase {
   typedef std::function<bool(CellBuilder&, Ref<CellSlice>, Ref<CellSlice>, td::ConstBitPtr, int)> combine_func_t;
   typedef std::function<bool(Ref<CellSlice>, td::ConstBitPtr, int)> foreach_func_t;
   typedef std::function<bool(td::ConstBitPtr, int, Ref<CellSlice>, Ref<CellSlice>)> scan_diff_func_t;
+  typedef std::pair<td::ConstBitPtr, Ref<CellSlice>> key_value_t;
 
   DictionaryFixed(int _n, bool validate = true) : DictionaryBase(_n, validate) {
   }
@@ -219,6 +220,13 @@ class DictionaryFixed : public DictionaryBase {
                                     bool invert_first = false);
   Ref<CellSlice> lookup_nearest_key(td::BitPtr key_buffer, int key_len, bool fetch_next = false, bool allow_eq = false,
                                     bool invert_first = false);
+  // bulk operations: keys are expected to be sorted in ascending order (as unsigned integers)
+  // each dictionary node is visited (and each new node is created) at most once per call
+  std::vector<Ref<CellSlice>> lookup_many(const std::vector<td::ConstBitPtr>& keys, int key_len);
+  // returns the number of stored values, or -1 if the keys are not unique and sorted
+  int set_many(const std::vector<key_value_t>& entries, int key_len, SetMode mode = SetMode::Set);
+  // replaces the contents of the dictionary, keys must be unique and sorted
+  bool build_from_sorted(const std::vector<key_value_t>& entries, int key_len);
   bool has_common_prefix(td::ConstBitPtr prefix, int prefix_len);
   int get_common_prefix(td::BitPtr buffer, unsigned buffer_len);
   bool cut_prefix_subdict(td::ConstBitPtr prefix, int prefix_len, bool remove_prefix = false);
@@ -251,6 +259,15 @@ class DictionaryFixed : public DictionaryBase {
     return lookup(key.bits(), key.size());
   }
   template <typename T>
+  std::vector<Ref<CellSlice>> lookup_many(const std::vector<T>& keys) {
+    std::vector<td::ConstBitPtr> key_ptrs;
+    key_ptrs.reserve(keys.size());
+    for (const auto& key : keys) {
+      key_ptrs.push_back(key.cbits());
+    }
+    return lookup_many(key_ptrs, T::size());
+  }
+  template <typename T>
   Ref<CellSlice> lookup_delete(const T& key) {
     return lookup_delete(key.bits(), key.size());
   }
@@ -287,6 +304,12 @@ class DictionaryFixed : public DictionaryBase {
 
  private:
   std::pair<Ref<CellSlice>, Ref<Cell>> dict_lookup_delete(Ref<Cell> dict, td::ConstBitPtr key, int n) const;
+  void dict_lookup_many(Ref<Cell> dict, const td::ConstBitPtr* keys, std::size_t cnt, int offs, int n,
+                        Ref<CellSlice>* res) const;
+  Ref<Cell> dict_build_sorted(const key_value_t* entries, std::size_t cnt, int offs, int n) const;
+  std::pair<Ref<Cell>, int> dict_set_many(Ref<Cell> dict, const key_value_t* entries, std::size_t cnt, int offs, int n,
+                                          SetMode mode) const;
+  static bool check_sorted(const key_value_t* entries, std::size_t cnt, int key_len);
   Ref<CellSlice> dict_lookup_minmax(Ref<Cell> dict, td::BitPtr key_buffer, int n, int mode) const;
   Ref<CellSlice> dict_lookup_nearest(Ref<Cell> dict, td::BitPtr key_buffer, int n, bool allow_eq, int mode) const;
   std::pair<Ref<Cell>, bool> extract_prefix_subdict_internal(Ref<Cell> dict, td::ConstBitPtr prefix, int prefix_len,
@@ -579,6 +602,8 @@ class AugmentedDictionary final : public DictionaryFixed {
   Ref<CellSlice> lookup_with_extra(td::ConstBitPtr key, int key_len);
   std::pair<Ref<CellSlice>, Ref<CellSlice>> lookup_extra(td::ConstBitPtr key, int key_len);
   std::pair<Ref<Cell>, Ref<CellSlice>> lookup_ref_extra(td::ConstBitPtr key, int key_len);
+  std::vector<Ref<CellSlice>> lookup_many(const std::vector<td::ConstBitPtr>& keys, int key_len);
+  std::vector<Ref<CellSlice>> lookup_many_with_extra(const std::vector<td::ConstBitPtr>& keys, int key_len);
   Ref<CellSlice> lookup_delete(td::ConstBitPtr key, int key_len);
   Ref<Cell> lookup_delete_ref(td::ConstBitPtr key, int key_len);
   Ref<CellSlice> lookup_delete_with_extra(td::ConstBitPtr key, int key_len);
@@ -602,6 +627,15 @@ class AugmentedDictionary final : public DictionaryFixed {
     return lookup_ref(key.bits(), key.size());
   }
   template <typename T>
+  std::vector<Ref<CellSlice>> lookup_many(const std::vector<T>& keys) {
+    std::vector<td::ConstBitPtr> key_ptrs;
+    key_ptrs.reserve(keys.size());
+    for (const auto& key : keys) {
+      key_ptrs.push_back(key.cbits());
+    }
+    return lookup_many(key_ptrs, T::size());
+  }
+  template <typename T>
   bool set(const T& key, Ref<CellSlice> val_ref, SetMode mode = SetMode::Set) {
     return set(key.bits(), key.size(), std::move(val_ref), mode);
   }
@@ -0,0 +1,159 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "emulator/emulator-cache.h"
+#include "emulator/transaction-emulator.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "smc-envelope/WalletV3.h"
+#include "vm/boc.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+
+// Measures emulations per second with one TransactionEmulator per thread, as services that emulate in many
+// worker threads do. Emulators either decode their own copy of the config or share one from SharedCache.
+// Usage: benchmark-emulator <config-params.boc> [max-threads]
+// The config params BoC can be saved with `saveconfig` command of lite-client.
+
+namespace {
+
+constexpr td::int64 Ton = 1000000000;
+constexpr ton::UnixTime Now = 1700000000;
+
+td::Ref<vm::CellSlice> pack_address(const block::StdAddress &addr) {
+  block::gen::MsgAddressInt::Record_addr_std rec;
+  rec.anycast = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+  rec.workchain_id = addr.workchain;
+  rec.address = addr.addr;
+  td::Ref<vm::CellSlice> res;
+  CHECK(tlb::csr_pack(res, rec));
+  return res;
+}
+
+td::Ref<vm::Cell> make_message(const block::StdAddress &dest, td::int64 value, td::Ref<vm::Cell> init_state) {
+  block::gen::Message::Record message;
+  block::gen::CommonMsgInfo::Record_int_msg_info msg_info;
+  msg_info.ihr_disabled = true;
+  msg_info.bounce = false;
+  msg_info.bounced = false;
+  msg_info.src = pack_address(block::StdAddress(0, ton::StdSmcAddress()));
+  msg_info.dest = pack_address(dest);
+  CHECK(block::CurrencyCollection{value}.pack_to(msg_info.value));
+  vm::CellBuilder cb;
+  block::tlb::t_Grams.store_integer_value(cb, td::BigInt256(0));
+  msg_info.fwd_fee = cb.as_cellslice_ref();
+  msg_info.ihr_fee = cb.as_cellslice_ref();
+  msg_info.created_lt = 0;
+  msg_info.created_at = Now;
+  CHECK(tlb::csr_pack(message.info, msg_info));
+  if (init_state.not_null()) {
+    message.init = vm::CellBuilder()
+                       .store_ones(1)
+                       .store_zeroes(1)
+                       .append_cellslice(vm::load_cell_slice(init_state))
+                       .as_cellslice_ref();
+  } else {
+    message.init = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+  }
+  message.body = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+  td::Ref<vm::Cell> res;
+  CHECK(tlb::type_pack_cell(res, block::gen::t_Message_Any, message));
+  return res;
+}
+
+void run(td::Ref<vm::Cell> config_params, bool shared, size_t threads_cnt, td::Ref<vm::Cell> shard_account,
+         const block::StdAddress &addr, td::Ref<vm::Cell> msg) {
+  double started_at = td::Time::now();
+  std::vector<std::unique_ptr<emulator::TransactionEmulator>> emulators;
+  for (size_t i = 0; i < threads_cnt; ++i) {
+    std::shared_ptr<const block::Config> config;
+    if (shared) {
+      config = emulator::SharedCache::get_config(config_params).move_as_ok();
+    } else {
+      config = std::make_shared<block::Config>(emulator::SharedCache::decode_config(config_params).move_as_ok());
+    }
+    emulators.push_back(std::make_unique<emulator::TransactionEmulator>(std::move(config)));
+    emulators.back()->set_unixtime(Now);
+  }
+  double created_at = td::Time::now();
+
+  const double duration = 2.0;
+  std::atomic<size_t> emulations{0};
+  std::vector<td::thread> threads;
+  for (auto &e : emulators) {
+    threads.emplace_back([&, e = e.get()] {
+      size_t cnt = 0;
+      double deadline = td::Time::now() + duration;
+      while (td::Time::now() < deadline) {
+        auto account = e->unpack_shard_account(addr.workchain, addr.addr, shard_account, Now).move_as_ok();
+        e->emulate_transaction(std::move(account), msg, Now, 0, block::transaction::Transaction::tr_ord).ensure();
+        ++cnt;
+      }
+      emulations += cnt;
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  LOG(PLAIN) << (shared ? "shared config: " : "own configs:   ") << threads_cnt << " threads, "
+             << td::format::as_time(created_at - started_at) << " to create emulators, "
+             << static_cast<size_t>(static_cast<double>(emulations.load()) / duration) << " emulations/s";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  if (argc < 2) {
+    LOG(PLAIN) << "usage: " << argv[0] << " <config-params.boc> [max-threads]";
+    return 2;
+  }
+  auto config_params = vm::std_boc_deserialize(td::read_file(td::CSlice(argv[1])).move_as_ok()).move_as_ok();
+  size_t max_threads = std::max(td::thread::hardware_concurrency(), 1u);
+  if (argc > 2) {
+    max_threads = td::to_integer<size_t>(td::Slice(argv[2]));
+  }
+
+  // Deploy a wallet and then emulate simple transfers to it
+  ton::WalletV3::InitData init_data;
+  init_data.public_key = td::Ed25519::generate_private_key().move_as_ok().get_public_key().move_as_ok().as_octet_string();
+  init_data.wallet_id = 239;
+  auto wallet = ton::WalletV3::create(init_data, 2);
+  auto addr = wallet->get_address();
+  emulator::TransactionEmulator deployer(emulator::SharedCache::get_config(config_params).move_as_ok());
+  deployer.set_unixtime(Now);
+  auto deploy =
+      deployer
+          .emulate_transaction(deployer.unpack_shard_account(addr.workchain, addr.addr, {}, Now).move_as_ok(),
+                               make_message(addr, 10 * Ton, ton::GenericAccount::get_init_state(wallet->get_state())),
+                               Now, 0, block::transaction::Transaction::tr_ord)
+          .move_as_ok();
+  auto shard_account = emulator::TransactionEmulator::pack_shard_account(
+      dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*deploy).account);
+  auto msg = make_message(addr, Ton, {});
+
+  for (size_t threads_cnt = 1; threads_cnt <= max_threads; threads_cnt *= 2) {
+    run(config_params, false, threads_cnt, shard_account, addr, msg);
+    run(config_params, true, threads_cnt, shard_account, addr, msg);
+  }
+  return 0;
+}
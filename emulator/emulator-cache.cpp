@@ -0,0 +1,96 @@
+#include "emulator-cache.h"
+
+#include <map>
+#include <mutex>
+
+namespace emulator {
+
+namespace {
+
+template <class T>
+class Table {
+ public:
+  std::shared_ptr<const T> get(const td::Bits256& hash) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = entries_.find(hash);
+    return it == entries_.end() ? nullptr : it->second.lock();
+  }
+
+  // Returns the object stored by another thread if it was decoded concurrently
+  std::shared_ptr<const T> put(const td::Bits256& hash, std::shared_ptr<const T> value) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto& entry = entries_[hash];
+    if (auto existing = entry.lock()) {
+      return existing;
+    }
+    entry = value;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.expired()) {
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return value;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::map<td::Bits256, std::weak_ptr<const T>> entries_;
+};
+
+Table<block::Config>& configs() {
+  static Table<block::Config> table;
+  return table;
+}
+
+Table<vm::Dictionary>& libraries() {
+  static Table<vm::Dictionary> table;
+  return table;
+}
+
+}  // namespace
+
+td::Result<block::Config> SharedCache::decode_config(td::Ref<vm::Cell> config_params_cell) {
+  auto config_dict = std::make_unique<vm::Dictionary>(config_params_cell, 32);
+  auto config_addr_cell = config_dict->lookup_ref(td::BitArray<32>::zero());
+  if (config_addr_cell.is_null()) {
+    return td::Status::Error("Can't find config address (param 0) is missing in config params");
+  }
+  auto config_addr_cs = vm::load_cell_slice(std::move(config_addr_cell));
+  if (config_addr_cs.size() != 0x100) {
+    return td::Status::Error(PSLICE() << "configuration parameter 0 with config address has wrong size");
+  }
+  ton::StdSmcAddress config_addr;
+  config_addr_cs.fetch_bits_to(config_addr);
+  auto global_config =
+      block::Config(config_params_cell, std::move(config_addr),
+                    block::Config::needWorkchainInfo | block::Config::needSpecialSmc | block::Config::needCapabilities);
+  TRY_STATUS_PREFIX(global_config.unpack(), "Can't unpack config params: ");
+  return global_config;
+}
+
+td::Result<std::shared_ptr<const block::Config>> SharedCache::get_config(td::Ref<vm::Cell> config_params) {
+  if (config_params.is_null()) {
+    return td::Status::Error("Config params cell is null");
+  }
+  td::Bits256 hash = config_params->get_hash().bits();
+  if (auto config = configs().get(hash)) {
+    return config;
+  }
+  TRY_RESULT(config, decode_config(std::move(config_params)));
+  return configs().put(hash, std::make_shared<const block::Config>(std::move(config)));
+}
+
+std::shared_ptr<const vm::Dictionary> SharedCache::get_libraries(td::Ref<vm::Cell> libs_root) {
+  if (libs_root.is_null()) {
+    return std::make_shared<const vm::Dictionary>(256);
+  }
+  td::Bits256 hash = libs_root->get_hash().bits();
+  if (auto libs = libraries().get(hash)) {
+    return libs;
+  }
+  return libraries().put(hash, std::make_shared<const vm::Dictionary>(std::move(libs_root), 256));
+}
+
+}  // namespace emulator
@@ -0,0 +1,23 @@
+#pragma once
+#include "crypto/vm/cells.h"
+#include "crypto/vm/dict.h"
+#include "block/mc-config.h"
+
+#include <memory>
+
+namespace emulator {
+
+// Process-wide cache of decoded configs and library dictionaries, looked up by the hash of the root cell.
+// Returned objects are never changed and may be used by any number of emulators at once, from any thread.
+// An entry lives while some emulator holds it, so emulators created from the same config (e.g. one emulator
+// per worker thread) share one block::Config and one set of library cells instead of decoding their own copies.
+// Library cells are not parsed here, the VM looks them up in the dictionary only when a contract needs them.
+class SharedCache {
+ public:
+  static td::Result<std::shared_ptr<const block::Config>> get_config(td::Ref<vm::Cell> config_params);
+  static std::shared_ptr<const vm::Dictionary> get_libraries(td::Ref<vm::Cell> libs_root);
+
+  static td::Result<block::Config> decode_config(td::Ref<vm::Cell> config_params);
+};
+
+}  // namespace emulator
@@ -6,6 +6,7 @@
 #include "td/utils/Variant.h"
 #include "td/utils/overloaded.h"
 #include "transaction-emulator.h"
+#include "emulator-cache.h"
 #include "tvm-emulator.hpp"
 #include "crypto/vm/stack.hpp"
 #include "crypto/vm/memo.h"
@@ -64,212 +65,133 @@ const char *external_not_accepted_response(std::string&& vm_log, int vm_exit_cod
 
 #define ERROR_RESPONSE(error) return error_response(error)
 
-td::Result<block::Config> decode_config(const char* config_boc) {
+// Config objects given out by emulator_config_create* hold a reference to the shared decoded config
+using ConfigHandle = std::shared_ptr<const block::Config>;
+
+td::Result<std::shared_ptr<const block::Config>> shared_config(const char *config_boc) {
   TRY_RESULT_PREFIX(config_params_cell, boc_b64_to_cell(config_boc), "Can't deserialize config params boc: ");
-  auto config_dict = std::make_unique<vm::Dictionary>(config_params_cell, 32);
-  auto config_addr_cell = config_dict->lookup_ref(td::BitArray<32>::zero());
-  if (config_addr_cell.is_null()) {
-    return td::Status::Error("Can't find config address (param 0) is missing in config params");
-  }
-  auto config_addr_cs = vm::load_cell_slice(std::move(config_addr_cell));
-  if (config_addr_cs.size() != 0x100) {
-    return td::Status::Error(PSLICE() << "configuration parameter 0 with config address has wrong size");
-  }
-  ton::StdSmcAddress config_addr;
-  config_addr_cs.fetch_bits_to(config_addr);
-  auto global_config = block::Config(config_params_cell, std::move(config_addr), block::Config::needWorkchainInfo | block::Config::needSpecialSmc | block::Config::needCapabilities);
-  TRY_STATUS_PREFIX(global_config.unpack(), "Can't unpack config params: ");
-  return global_config;
+  return emulator::SharedCache::get_config(std::move(config_params_cell));
 }
 
-void *transaction_emulator_create(const char *config_params_boc, int vm_log_verbosity) {
-  auto global_config_res = decode_config(config_params_boc);
-  if (global_config_res.is_error()) {
-    LOG(ERROR) << global_config_res.move_as_error().message();
-    return nullptr;
-  }
-  auto global_config = std::make_shared<block::Config>(global_config_res.move_as_ok());
-  return new emulator::TransactionEmulator(std::move(global_config), vm_log_verbosity);
+td::Ref<vm::Cell> shard_account_cell(const block::Account &account) {
+  return emulator::TransactionEmulator::pack_shard_account(account);
 }
 
-void *emulator_config_create(const char *config_params_boc) {
-  auto config = decode_config(config_params_boc);
-  if (config.is_error()) {
-    LOG(ERROR) << "Error decoding config: " << config.move_as_error();
-    return nullptr;
-  }
-  return new block::Config(config.move_as_ok());
-}
-
-const char *transaction_emulator_emulate_transaction(void *transaction_emulator, const char *shard_account_boc, const char *message_boc) {
-  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
-  
-  auto message_cell_r = boc_b64_to_cell(message_boc);
-  if (message_cell_r.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Can't deserialize message boc: " << message_cell_r.move_as_error());
-  }
-  auto message_cell = message_cell_r.move_as_ok();
+td::Result<std::unique_ptr<emulator::TransactionEmulator::EmulationResult>> emulate_transaction(
+    emulator::TransactionEmulator *emulator, td::Ref<vm::Cell> shard_account_cell, td::Ref<vm::Cell> message_cell) {
   auto message_cs = vm::load_cell_slice(message_cell);
   int msg_tag = block::gen::t_CommonMsgInfo.get_tag(message_cs);
 
-  auto shard_account_cell = boc_b64_to_cell(shard_account_boc);
-  if (shard_account_cell.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Can't deserialize shard account boc: " << shard_account_cell.move_as_error());
-  }
-  auto shard_account_slice = vm::load_cell_slice(shard_account_cell.ok_ref());
+  auto shard_account_slice = vm::load_cell_slice(shard_account_cell);
   block::gen::ShardAccount::Record shard_account;
   if (!tlb::unpack(shard_account_slice, shard_account)) {
-    ERROR_RESPONSE(PSTRING() << "Can't unpack shard account cell");
+    return td::Status::Error("Can't unpack shard account cell");
   }
 
   td::Ref<vm::CellSlice> addr_slice;
   auto account_slice = vm::load_cell_slice(shard_account.account);
-  bool account_exists = block::gen::t_Account.get_tag(account_slice) == block::gen::Account::account;
   if (block::gen::t_Account.get_tag(account_slice) == block::gen::Account::account_none) {
     if (msg_tag == block::gen::CommonMsgInfo::ext_in_msg_info) {
       block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
       if (!tlb::unpack(message_cs, info)) {
-        ERROR_RESPONSE(PSTRING() <<  "Can't unpack inbound external message");
+        return td::Status::Error("Can't unpack inbound external message");
       }
       addr_slice = std::move(info.dest);
     }
     else if (msg_tag == block::gen::CommonMsgInfo::int_msg_info) {
       block::gen::CommonMsgInfo::Record_int_msg_info info;
       if (!tlb::unpack(message_cs, info)) {
-          ERROR_RESPONSE(PSTRING() << "Can't unpack inbound internal message");
+          return td::Status::Error("Can't unpack inbound internal message");
       }
       addr_slice = std::move(info.dest);
     } else {
-      ERROR_RESPONSE(PSTRING() << "Only ext in and int message are supported");
+      return td::Status::Error("Only ext in and int message are supported");
     }
   } else if (block::gen::t_Account.get_tag(account_slice) == block::gen::Account::account) {
     block::gen::Account::Record_account account_record;
     if (!tlb::unpack(account_slice, account_record)) {
-      ERROR_RESPONSE(PSTRING() << "Can't unpack account cell");
+      return td::Status::Error("Can't unpack account cell");
     }
     addr_slice = std::move(account_record.addr);
   } else {
-    ERROR_RESPONSE(PSTRING() << "Can't parse account cell");
+    return td::Status::Error("Can't parse account cell");
   }
   ton::WorkchainId wc;
   ton::StdSmcAddress addr;
   if (!block::tlb::t_MsgAddressInt.extract_std_address(addr_slice, wc, addr)) {
-    ERROR_RESPONSE(PSTRING() << "Can't extract account address");
+    return td::Status::Error("Can't extract account address");
   }
 
-  auto account = block::Account(wc, addr.bits());
   ton::UnixTime now = emulator->get_unixtime();
   if (!now) {
     now = (unsigned)std::time(nullptr);
   }
-  bool is_special = wc == ton::masterchainId && emulator->get_config().is_special_smartcontract(addr);
-  if (account_exists) {
-    if (!account.unpack(vm::load_cell_slice_ref(shard_account_cell.move_as_ok()), now, is_special)) {
-      ERROR_RESPONSE(PSTRING() << "Can't unpack shard account");
-    }
-  } else {
-    if (!account.init_new(now)) {
-      ERROR_RESPONSE(PSTRING() << "Can't init new account");
-    }
-    account.last_trans_lt_ = shard_account.last_trans_lt;
-    account.last_trans_hash_ = shard_account.last_trans_hash;
-  }
+  TRY_RESULT(account, emulator->unpack_shard_account(wc, addr, std::move(shard_account_cell), now));
 
-  auto result = emulator->emulate_transaction(std::move(account), message_cell, now, 0, block::transaction::Transaction::tr_ord);
+  auto result = emulator->emulate_transaction(std::move(account), std::move(message_cell), now, 0, block::transaction::Transaction::tr_ord);
   if (result.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Emulate transaction failed: " << result.move_as_error());
+    return td::Status::Error(PSLICE() << "Emulate transaction failed: " << result.move_as_error());
   }
-  auto emulation_result = result.move_as_ok();
-
-  auto external_not_accepted = dynamic_cast<emulator::TransactionEmulator::EmulationExternalNotAccepted *>(emulation_result.get());
-  if (external_not_accepted) {
-    return external_not_accepted_response(std::move(external_not_accepted->vm_log), external_not_accepted->vm_exit_code, 
-                                          external_not_accepted->elapsed_time);
-  }
-
-  auto emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess&>(*emulation_result);
-  auto trans_boc_b64 = cell_to_boc_b64(std::move(emulation_success.transaction));
-  if (trans_boc_b64.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Can't serialize Transaction to boc " << trans_boc_b64.move_as_error());
-  }
-
-  auto new_shard_account_cell = vm::CellBuilder().store_ref(emulation_success.account.total_state)
-                               .store_bits(emulation_success.account.last_trans_hash_.as_bitslice())
-                               .store_long(emulation_success.account.last_trans_lt_).finalize();
-  auto new_shard_account_boc_b64 = cell_to_boc_b64(std::move(new_shard_account_cell));
-  if (new_shard_account_boc_b64.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Can't serialize ShardAccount to boc " << new_shard_account_boc_b64.move_as_error());
-  }
-
-  td::optional<td::string> actions_boc_b64;
-  if (emulation_success.actions.not_null()) {
-    auto actions_boc_b64_result = cell_to_boc_b64(std::move(emulation_success.actions));
-    if (actions_boc_b64_result.is_error()) {
-      ERROR_RESPONSE(PSTRING() << "Can't serialize actions list cell to boc " << actions_boc_b64_result.move_as_error());
-    }
-    actions_boc_b64 = actions_boc_b64_result.move_as_ok();
-  }
-
-  return success_response(trans_boc_b64.move_as_ok(), new_shard_account_boc_b64.move_as_ok(), std::move(emulation_success.vm_log), 
-                          std::move(actions_boc_b64), emulation_success.elapsed_time);
+  return result.move_as_ok();
 }
 
-const char *transaction_emulator_emulate_tick_tock_transaction(void *transaction_emulator, const char *shard_account_boc, bool is_tock) {
-  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
-  
-  auto shard_account_cell = boc_b64_to_cell(shard_account_boc);
-  if (shard_account_cell.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Can't deserialize shard account boc: " << shard_account_cell.move_as_error());
-  }
-  auto shard_account_slice = vm::load_cell_slice(shard_account_cell.ok_ref());
+td::Result<std::unique_ptr<emulator::TransactionEmulator::EmulationResult>> emulate_tick_tock_transaction(
+    emulator::TransactionEmulator *emulator, td::Ref<vm::Cell> shard_account_cell, bool is_tock) {
+  auto shard_account_slice = vm::load_cell_slice(shard_account_cell);
   block::gen::ShardAccount::Record shard_account;
   if (!tlb::unpack(shard_account_slice, shard_account)) {
-    ERROR_RESPONSE(PSTRING() << "Can't unpack shard account cell");
+    return td::Status::Error("Can't unpack shard account cell");
   }
 
   td::Ref<vm::CellSlice> addr_slice;
   auto account_slice = vm::load_cell_slice(shard_account.account);
   if (block::gen::t_Account.get_tag(account_slice) == block::gen::Account::account_none) {
-    ERROR_RESPONSE(PSTRING() <<  "Can't run tick/tock transaction on account_none");
+    return td::Status::Error("Can't run tick/tock transaction on account_none");
   }
   block::gen::Account::Record_account account_record;
   if (!tlb::unpack(account_slice, account_record)) {
-    ERROR_RESPONSE(PSTRING() << "Can't unpack account cell");
+    return td::Status::Error("Can't unpack account cell");
   }
   addr_slice = std::move(account_record.addr);
   ton::WorkchainId wc;
   ton::StdSmcAddress addr;
   if (!block::tlb::t_MsgAddressInt.extract_std_address(addr_slice, wc, addr)) {
-    ERROR_RESPONSE(PSTRING() << "Can't extract account address");
+    return td::Status::Error("Can't extract account address");
   }
 
-  auto account = block::Account(wc, addr.bits());
   ton::UnixTime now = emulator->get_unixtime();
   if (!now) {
     now = (unsigned)std::time(nullptr);
   }
-  bool is_special = wc == ton::masterchainId && emulator->get_config().is_special_smartcontract(addr);
-  if (!account.unpack(vm::load_cell_slice_ref(shard_account_cell.move_as_ok()), now, is_special)) {
-    ERROR_RESPONSE(PSTRING() << "Can't unpack shard account");
-  }
+  TRY_RESULT(account, emulator->unpack_shard_account(wc, addr, std::move(shard_account_cell), now));
 
   auto trans_type = is_tock ? block::transaction::Transaction::tr_tock : block::transaction::Transaction::tr_tick;
   auto result = emulator->emulate_transaction(std::move(account), {}, now, 0, trans_type);
   if (result.is_error()) {
-    ERROR_RESPONSE(PSTRING() << "Emulate transaction failed: " << result.move_as_error());
+    return td::Status::Error(PSLICE() << "Emulate transaction failed: " << result.move_as_error());
+  }
+  return result.move_as_ok();
+}
+
+const char *emulation_response(td::Result<std::unique_ptr<emulator::TransactionEmulator::EmulationResult>> result) {
+  if (result.is_error()) {
+    ERROR_RESPONSE(result.move_as_error().message().str());
   }
   auto emulation_result = result.move_as_ok();
 
-  auto emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess&>(*emulation_result);
+  auto external_not_accepted = dynamic_cast<emulator::TransactionEmulator::EmulationExternalNotAccepted *>(emulation_result.get());
+  if (external_not_accepted) {
+    return external_not_accepted_response(std::move(external_not_accepted->vm_log), external_not_accepted->vm_exit_code, 
+                                          external_not_accepted->elapsed_time);
+  }
+
+  auto &emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess&>(*emulation_result);
   auto trans_boc_b64 = cell_to_boc_b64(std::move(emulation_success.transaction));
   if (trans_boc_b64.is_error()) {
     ERROR_RESPONSE(PSTRING() << "Can't serialize Transaction to boc " << trans_boc_b64.move_as_error());
   }
 
-  auto new_shard_account_cell = vm::CellBuilder().store_ref(emulation_success.account.total_state)
-                               .store_bits(emulation_success.account.last_trans_hash_.as_bitslice())
-                               .store_long(emulation_success.account.last_trans_lt_).finalize();
-  auto new_shard_account_boc_b64 = cell_to_boc_b64(std::move(new_shard_account_cell));
+  auto new_shard_account_boc_b64 = cell_to_boc_b64(shard_account_cell(emulation_success.account));
   if (new_shard_account_boc_b64.is_error()) {
     ERROR_RESPONSE(PSTRING() << "Can't serialize ShardAccount to boc " << new_shard_account_boc_b64.move_as_error());
   }
@@ -287,6 +209,50 @@ const char *transaction_emulator_emulate_tick_tock_transaction(void *transaction
                           std::move(actions_boc_b64), emulation_success.elapsed_time);
 }
 
+void *transaction_emulator_create(const char *config_params_boc, int vm_log_verbosity) {
+  auto global_config_res = shared_config(config_params_boc);
+  if (global_config_res.is_error()) {
+    LOG(ERROR) << global_config_res.move_as_error().message();
+    return nullptr;
+  }
+  return new emulator::TransactionEmulator(global_config_res.move_as_ok(), vm_log_verbosity);
+}
+
+void *emulator_config_create(const char *config_params_boc) {
+  auto config = shared_config(config_params_boc);
+  if (config.is_error()) {
+    LOG(ERROR) << "Error decoding config: " << config.move_as_error();
+    return nullptr;
+  }
+  return new ConfigHandle(config.move_as_ok());
+}
+
+const char *transaction_emulator_emulate_transaction(void *transaction_emulator, const char *shard_account_boc, const char *message_boc) {
+  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
+  
+  auto message_cell = boc_b64_to_cell(message_boc);
+  if (message_cell.is_error()) {
+    ERROR_RESPONSE(PSTRING() << "Can't deserialize message boc: " << message_cell.move_as_error());
+  }
+  auto shard_account_cell = boc_b64_to_cell(shard_account_boc);
+  if (shard_account_cell.is_error()) {
+    ERROR_RESPONSE(PSTRING() << "Can't deserialize shard account boc: " << shard_account_cell.move_as_error());
+  }
+
+  return emulation_response(emulate_transaction(emulator, shard_account_cell.move_as_ok(), message_cell.move_as_ok()));
+}
+
+const char *transaction_emulator_emulate_tick_tock_transaction(void *transaction_emulator, const char *shard_account_boc, bool is_tock) {
+  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
+  
+  auto shard_account_cell = boc_b64_to_cell(shard_account_boc);
+  if (shard_account_cell.is_error()) {
+    ERROR_RESPONSE(PSTRING() << "Can't deserialize shard account boc: " << shard_account_cell.move_as_error());
+  }
+
+  return emulation_response(emulate_tick_tock_transaction(emulator, shard_account_cell.move_as_ok(), is_tock));
+}
+
 bool transaction_emulator_set_unixtime(void *transaction_emulator, uint32_t unixtime) {
   auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
 
@@ -334,27 +300,21 @@ bool transaction_emulator_set_ignore_chksig(void *transaction_emulator, bool ign
 bool transaction_emulator_set_config(void *transaction_emulator, const char* config_boc) {
   auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
 
-  auto global_config_res = decode_config(config_boc);
+  auto global_config_res = shared_config(config_boc);
   if (global_config_res.is_error()) {
     LOG(ERROR) << global_config_res.move_as_error().message();
     return false;
   }
 
-  emulator->set_config(std::make_shared<block::Config>(global_config_res.move_as_ok()));
+  emulator->set_config(global_config_res.move_as_ok());
 
   return true;
 }
 
-void config_deleter(block::Config* ptr) {
-    // We do not delete the config object, since ownership management is delegated to the caller
-}
-
 bool transaction_emulator_set_config_object(void *transaction_emulator, void* config) {
   auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
-  
-  std::shared_ptr<block::Config> config_ptr(static_cast<block::Config *>(config), config_deleter);
-  
-  emulator->set_config(config_ptr);
+
+  emulator->set_config(*static_cast<ConfigHandle *>(config));
 
   return true;
 }
@@ -368,7 +328,7 @@ bool transaction_emulator_set_libs(void *transaction_emulator, const char* shard
       LOG(ERROR) << "Can't deserialize shardchain libraries boc: " << shardchain_libs_cell.move_as_error();
       return false;
     }
-    emulator->set_libs(vm::Dictionary(shardchain_libs_cell.move_as_ok(), 256));
+    emulator->set_libs(::emulator::SharedCache::get_libraries(shardchain_libs_cell.move_as_ok()));
   }
 
   return true;
@@ -439,13 +399,12 @@ void *tvm_emulator_create(const char *code, const char *data, int vm_log_verbosi
 }
 
 bool tvm_emulator_set_libraries(void *tvm_emulator, const char *libs_boc) {
-  vm::Dictionary libs{256};
   auto libs_cell = boc_b64_to_cell(libs_boc);
   if (libs_cell.is_error()) {
     LOG(ERROR) << "Can't deserialize libraries boc: " << libs_cell.move_as_error();
     return false;
   }
-  libs = vm::Dictionary(libs_cell.move_as_ok(), 256);
+  auto libs = *emulator::SharedCache::get_libraries(libs_cell.move_as_ok());
 
   auto emulator = static_cast<emulator::TvmEmulator *>(tvm_emulator);
   emulator->set_libraries(std::move(libs));
@@ -551,8 +510,7 @@ bool tvm_emulator_set_extra_currencies(void *tvm_emulator, const char *extra_cur
 
 bool tvm_emulator_set_config_object(void* tvm_emulator, void* config) {
   auto emulator = static_cast<emulator::TvmEmulator *>(tvm_emulator);
-  auto global_config = std::shared_ptr<block::Config>(static_cast<block::Config *>(config), config_deleter);
-  emulator->set_config(global_config);
+  emulator->set_config(*static_cast<ConfigHandle *>(config));
   return true;
 }
 
@@ -769,7 +727,7 @@ void tvm_emulator_destroy(void *tvm_emulator) {
 }
 
 void emulator_config_destroy(void *config) {
-  delete static_cast<block::Config *>(config);
+  delete static_cast<ConfigHandle *>(config);
 }
 
 const char* emulator_version() {
@@ -780,3 +738,195 @@ const char* emulator_version() {
   obj.leave();
   return strdup(version_json.string_builder().as_cslice().c_str());
 }
+
+td::Ref<vm::Cell> *new_cell_handle(td::Ref<vm::Cell> cell) {
+  if (cell.is_null()) {
+    return nullptr;
+  }
+  return new td::Ref<vm::Cell>(std::move(cell));
+}
+
+td::Ref<vm::Cell> cell_from_handle(void *cell) {
+  if (cell == nullptr) {
+    return {};
+  }
+  return *static_cast<td::Ref<vm::Cell> *>(cell);
+}
+
+void *emulator_cell_create(const char *boc, uint32_t len) {
+  auto cell = vm::std_boc_deserialize(td::Slice(boc, len));
+  if (cell.is_error()) {
+    LOG(ERROR) << "Can't deserialize boc: " << cell.move_as_error();
+    return nullptr;
+  }
+  return new_cell_handle(cell.move_as_ok());
+}
+
+const char *emulator_cell_serialize(void *cell, uint32_t *len) {
+  auto boc = vm::std_boc_serialize(cell_from_handle(cell), vm::BagOfCells::Mode::WithCRC32C);
+  if (boc.is_error()) {
+    LOG(ERROR) << "Can't serialize cell: " << boc.move_as_error();
+    return nullptr;
+  }
+  auto data = boc.move_as_ok();
+  char *res = static_cast<char *>(malloc(data.size()));
+  memcpy(res, data.data(), data.size());
+  *len = static_cast<uint32_t>(data.size());
+  return res;
+}
+
+bool emulator_cell_get_hash(void *cell, char *hash) {
+  auto cell_ref = cell_from_handle(cell);
+  if (cell_ref.is_null()) {
+    return false;
+  }
+  td::MutableSlice(hash, 32).copy_from(cell_ref->get_hash().as_slice());
+  return true;
+}
+
+void emulator_cell_destroy(void *cell) {
+  delete static_cast<td::Ref<vm::Cell> *>(cell);
+}
+
+void *emulator_config_create_from_cell(void *config_params_cell) {
+  auto cell = cell_from_handle(config_params_cell);
+  if (cell.is_null()) {
+    LOG(ERROR) << "Config params cell is null";
+    return nullptr;
+  }
+  auto config = emulator::SharedCache::get_config(std::move(cell));
+  if (config.is_error()) {
+    LOG(ERROR) << "Error decoding config: " << config.move_as_error();
+    return nullptr;
+  }
+  return new ConfigHandle(config.move_as_ok());
+}
+
+bool transaction_emulator_set_libs_cell(void *transaction_emulator, void *libs_cell) {
+  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
+  emulator->set_libs(::emulator::SharedCache::get_libraries(cell_from_handle(libs_cell)));
+  return true;
+}
+
+emulator_transaction_result *transaction_result(
+    td::Result<std::unique_ptr<emulator::TransactionEmulator::EmulationResult>> result) {
+  auto res = new emulator_transaction_result{};
+  if (result.is_error()) {
+    res->error = strdup(result.error().message().c_str());
+    return res;
+  }
+  auto emulation_result = result.move_as_ok();
+  res->vm_log = strdup(emulation_result->vm_log.c_str());
+  res->elapsed_time = emulation_result->elapsed_time;
+
+  auto external_not_accepted = dynamic_cast<emulator::TransactionEmulator::EmulationExternalNotAccepted *>(emulation_result.get());
+  if (external_not_accepted) {
+    res->error = strdup("External message not accepted by smart contract");
+    res->external_not_accepted = true;
+    res->vm_exit_code = external_not_accepted->vm_exit_code;
+    return res;
+  }
+
+  auto &emulation_success = dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*emulation_result);
+  res->success = true;
+  res->transaction = new_cell_handle(std::move(emulation_success.transaction));
+  res->shard_account = new_cell_handle(shard_account_cell(emulation_success.account));
+  res->actions = new_cell_handle(std::move(emulation_success.actions));
+  return res;
+}
+
+emulator_transaction_result *transaction_emulator_emulate_transaction_cells(void *transaction_emulator, void *shard_account_cell, void *message_cell) {
+  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
+  auto shard_account = cell_from_handle(shard_account_cell);
+  auto message = cell_from_handle(message_cell);
+  if (shard_account.is_null() || message.is_null()) {
+    return transaction_result(td::Status::Error("Shard account or message cell is null"));
+  }
+  return transaction_result(emulate_transaction(emulator, std::move(shard_account), std::move(message)));
+}
+
+emulator_transaction_result *transaction_emulator_emulate_tick_tock_transaction_cells(void *transaction_emulator, void *shard_account_cell, bool is_tock) {
+  auto emulator = static_cast<emulator::TransactionEmulator *>(transaction_emulator);
+  auto shard_account = cell_from_handle(shard_account_cell);
+  if (shard_account.is_null()) {
+    return transaction_result(td::Status::Error("Shard account cell is null"));
+  }
+  return transaction_result(emulate_tick_tock_transaction(emulator, std::move(shard_account), is_tock));
+}
+
+void emulator_transaction_result_destroy(emulator_transaction_result *result) {
+  if (result == nullptr) {
+    return;
+  }
+  free(const_cast<char *>(result->error));
+  free(const_cast<char *>(result->vm_log));
+  emulator_cell_destroy(result->transaction);
+  emulator_cell_destroy(result->shard_account);
+  emulator_cell_destroy(result->actions);
+  delete result;
+}
+
+void *tvm_emulator_create_from_cells(void *code_cell, void *data_cell, int vm_log_verbosity) {
+  auto code = cell_from_handle(code_cell);
+  auto data = cell_from_handle(data_cell);
+  if (code.is_null() || data.is_null()) {
+    LOG(ERROR) << "Code or data cell is null";
+    return nullptr;
+  }
+  auto emulator = new emulator::TvmEmulator(std::move(code), std::move(data));
+  emulator->set_vm_verbosity_level(vm_log_verbosity);
+  return emulator;
+}
+
+bool tvm_emulator_set_libraries_cell(void *tvm_emulator, void *libs_cell) {
+  auto emulator = static_cast<emulator::TvmEmulator *>(tvm_emulator);
+  emulator->set_libraries(vm::Dictionary(*::emulator::SharedCache::get_libraries(cell_from_handle(libs_cell))));
+  return true;
+}
+
+emulator_get_method_result *tvm_emulator_run_get_method_cells(void *tvm_emulator, int method_id, void *stack_cell) {
+  auto res = new emulator_get_method_result{};
+  auto stack_root = cell_from_handle(stack_cell);
+  if (stack_root.is_null()) {
+    res->error = strdup("Stack cell is null");
+    return res;
+  }
+  auto stack_cs = vm::load_cell_slice(std::move(stack_root));
+  td::Ref<vm::Stack> stack;
+  if (!vm::Stack::deserialize_to(stack_cs, stack)) {
+    res->error = strdup("Couldn't deserialize stack");
+    return res;
+  }
+
+  auto emulator = static_cast<emulator::TvmEmulator *>(tvm_emulator);
+  auto result = emulator->run_get_method(method_id, stack);
+
+  vm::FakeVmStateLimits fstate(3500);  // limit recursive (de)serialization calls
+  vm::VmStateInterface::Guard guard(&fstate);
+
+  vm::CellBuilder stack_cb;
+  if (!result.stack->serialize(stack_cb)) {
+    res->error = strdup("Couldn't serialize stack");
+    return res;
+  }
+  res->success = true;
+  res->vm_exit_code = result.code;
+  res->gas_used = result.gas_used;
+  res->stack = new_cell_handle(stack_cb.finalize());
+  res->vm_log = strdup(result.vm_log.c_str());
+  if (result.missing_library) {
+    res->has_missing_library = true;
+    td::MutableSlice(res->missing_library, 32).copy_from(result.missing_library.value().as_slice());
+  }
+  return res;
+}
+
+void emulator_get_method_result_destroy(emulator_get_method_result *result) {
+  if (result == nullptr) {
+    return;
+  }
+  free(const_cast<char *>(result->error));
+  free(const_cast<char *>(result->vm_log));
+  emulator_cell_destroy(result->stack);
+  delete result;
+}
@@ -17,7 +17,8 @@ extern "C" {
 EMULATOR_EXPORT void *transaction_emulator_create(const char *config_params_boc, int vm_log_verbosity);
 
 /**
- * @brief Creates Config object from base64 encoded BoC
+ * @brief Creates Config object from base64 encoded BoC. Config objects created from the same config share one
+ * decoded config, which stays alive while some Config object or emulator uses it
  * @param config_params_boc Base64 encoded BoC serialized Config dictionary (Hashmap 32 ^Cell)
  * @return Pointer to Config object or nullptr in case of error
  */
@@ -320,6 +321,148 @@ EMULATOR_EXPORT void emulator_config_destroy(void *config);
  */
 EMULATOR_EXPORT const char* emulator_version();
 
+/*
+ * Binary API.
+ * The functions below take and return cells as opaque handles instead of base64 encoded BoCs, and return results
+ * as structs instead of JSON. A cell handle holds a deserialized cell: it can be passed to any number of calls
+ * (e.g. the new shard account of one emulation can be used as the input of the next one) and must be destroyed
+ * with emulator_cell_destroy. Raw BoCs are converted to handles and back with emulator_cell_create and
+ * emulator_cell_serialize. Config and libraries are also set from handles and stay parsed between emulations.
+ */
+
+/**
+ * @brief Deserialize BoC with a single root into cell handle
+ * @param boc BoC bytes (not base64 encoded)
+ * @param len Length of boc
+ * @return Cell handle or nullptr in case of error
+ */
+EMULATOR_EXPORT void *emulator_cell_create(const char *boc, uint32_t len);
+
+/**
+ * @brief Serialize cell to BoC
+ * @param cell Cell handle
+ * @param len Pointer where the length of the result is stored
+ * @return BoC bytes allocated with malloc, or nullptr in case of error
+ */
+EMULATOR_EXPORT const char *emulator_cell_serialize(void *cell, uint32_t *len);
+
+/**
+ * @brief Get representation hash of cell
+ * @param cell Cell handle
+ * @param hash Buffer of 32 bytes for the hash
+ * @return true in case of success, false in case of error
+ */
+EMULATOR_EXPORT bool emulator_cell_get_hash(void *cell, char *hash);
+
+/**
+ * @brief Destroy cell handle
+ * @param cell Cell handle
+ */
+EMULATOR_EXPORT void emulator_cell_destroy(void *cell);
+
+/**
+ * @brief Creates Config object from cell, sharing the decoded config like emulator_config_create
+ * @param config_params_cell Cell handle of Config dictionary (Hashmap 32 ^Cell)
+ * @return Pointer to Config object or nullptr in case of error
+ */
+EMULATOR_EXPORT void *emulator_config_create_from_cell(void *config_params_cell);
+
+/**
+ * @brief Set libraries for emulation
+ * @param transaction_emulator Pointer to TransactionEmulator object
+ * @param libs_cell Cell handle of shared libraries dictionary (HashmapE 256 ^Cell)
+ * @return true in case of success, false in case of error
+ */
+EMULATOR_EXPORT bool transaction_emulator_set_libs_cell(void *transaction_emulator, void *libs_cell);
+
+/**
+ * @brief Result of transaction emulation.
+ * On success, transaction, shard_account and actions are cell handles owned by the result. To keep a handle
+ * after the result is destroyed, copy it and set the field to nullptr.
+ */
+typedef struct {
+  bool success;
+  const char *error;           // Error description, nullptr on success
+  bool external_not_accepted;  // External message was not accepted, vm_exit_code is set
+  int vm_exit_code;
+  void *transaction;    // Transaction
+  void *shard_account;  // New ShardAccount
+  void *actions;        // Compute phase actions (OutList n), nullptr if there are none
+  const char *vm_log;
+  double elapsed_time;
+} emulator_transaction_result;
+
+/**
+ * @brief Emulate transaction
+ * @param transaction_emulator Pointer to TransactionEmulator object
+ * @param shard_account_cell Cell handle of ShardAccount
+ * @param message_cell Cell handle of inbound Message (internal or external)
+ * @return Result to be destroyed with emulator_transaction_result_destroy
+ */
+EMULATOR_EXPORT emulator_transaction_result *transaction_emulator_emulate_transaction_cells(void *transaction_emulator, void *shard_account_cell, void *message_cell);
+
+/**
+ * @brief Emulate tick tock transaction
+ * @param transaction_emulator Pointer to TransactionEmulator object
+ * @param shard_account_cell Cell handle of ShardAccount of special account
+ * @param is_tock True for tock transactions, false for tick
+ * @return Result to be destroyed with emulator_transaction_result_destroy
+ */
+EMULATOR_EXPORT emulator_transaction_result *transaction_emulator_emulate_tick_tock_transaction_cells(void *transaction_emulator, void *shard_account_cell, bool is_tock);
+
+/**
+ * @brief Destroy transaction emulation result together with the cell handles it owns
+ * @param result Result of transaction emulation
+ */
+EMULATOR_EXPORT void emulator_transaction_result_destroy(emulator_transaction_result *result);
+
+/**
+ * @brief Create TVM emulator
+ * @param code_cell Cell handle of smart contract code
+ * @param data_cell Cell handle of smart contract data
+ * @param vm_log_verbosity Verbosity level of VM log
+ * @return Pointer to TVM emulator object or nullptr in case of error
+ */
+EMULATOR_EXPORT void *tvm_emulator_create_from_cells(void *code_cell, void *data_cell, int vm_log_verbosity);
+
+/**
+ * @brief Set libraries for TVM emulator
+ * @param tvm_emulator Pointer to TVM emulator
+ * @param libs_cell Cell handle of libraries dictionary (HashmapE 256 ^Cell)
+ * @return true in case of success, false in case of error
+ */
+EMULATOR_EXPORT bool tvm_emulator_set_libraries_cell(void *tvm_emulator, void *libs_cell);
+
+/**
+ * @brief Result of get method.
+ * On success, stack is a cell handle owned by the result.
+ */
+typedef struct {
+  bool success;
+  const char *error;  // Error description, nullptr on success
+  int vm_exit_code;
+  int64_t gas_used;
+  void *stack;  // Resulting stack (VmStack)
+  const char *vm_log;
+  bool has_missing_library;
+  char missing_library[32];  // Hash of the missing library if has_missing_library is set
+} emulator_get_method_result;
+
+/**
+ * @brief Run get method
+ * @param tvm_emulator Pointer to TVM emulator
+ * @param method_id Integer method id
+ * @param stack_cell Cell handle of stack (VmStack)
+ * @return Result to be destroyed with emulator_get_method_result_destroy
+ */
+EMULATOR_EXPORT emulator_get_method_result *tvm_emulator_run_get_method_cells(void *tvm_emulator, int method_id, void *stack_cell);
+
+/**
+ * @brief Destroy get method result together with the cell handles it owns
+ * @param result Result of get method
+ */
+EMULATOR_EXPORT void emulator_get_method_result_destroy(emulator_get_method_result *result);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
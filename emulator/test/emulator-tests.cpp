@@ -13,6 +13,8 @@
 #include "smc-envelope/WalletV3.h"
 
 #include "emulator/emulator-extern.h"
+#include "emulator/transaction-emulator.h"
+#include "emulator/emulator-cache.h"
 
 // testnet config as of 27.06.24
 const char *config_boc = "te6cckICAl8AAQAANecAAAIBIAABAAICAtgAAwAEAgL1AA0ADgIBIAAFAAYCAUgCPgI/AgEgAAcACAIBSAAJAAoCASAAHgAfAgEgAGUAZgIBSAALAAwCAWoA0gDTAQFI"
@@ -163,6 +165,56 @@ const char *config_boc = "te6cckICAl8AAQAANecAAAIBIAABAAICAtgAAwAEAgL1AA0ADgIBIA
 
 constexpr td::int64 Ton = 1000000000;
 
+// Internal message with 10 TON and init state of the wallet
+td::Ref<vm::Cell> make_deploy_message(const ton::WalletV3 &wallet, uint32_t utime) {
+  block::gen::Message::Record message;
+  block::gen::CommonMsgInfo::Record_int_msg_info msg_info;
+  msg_info.ihr_disabled = true;
+  msg_info.bounce = false;
+  msg_info.bounced = false;
+  {
+    block::gen::MsgAddressInt::Record_addr_std src;
+    src.anycast = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+    src.workchain_id = 0;
+    src.address = td::Bits256();
+    tlb::csr_pack(msg_info.src, src);
+  }
+  {
+    block::gen::MsgAddressInt::Record_addr_std dest;
+    dest.anycast = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+    dest.workchain_id = wallet.get_address().workchain;
+    dest.address =  wallet.get_address().addr;
+    tlb::csr_pack(msg_info.dest, dest);
+  }
+  {
+    block::CurrencyCollection cc{10 * Ton};
+    cc.pack_to(msg_info.value);
+  }
+  {
+    vm::CellBuilder cb;
+    block::tlb::t_Grams.store_integer_value(cb, td::BigInt256(int(0.03 * Ton)));
+    msg_info.fwd_fee = cb.as_cellslice_ref();
+  }
+  {
+    vm::CellBuilder cb;
+    block::tlb::t_Grams.store_integer_value(cb, td::BigInt256(0));
+    msg_info.ihr_fee = cb.as_cellslice_ref();
+  }
+  msg_info.created_lt = 0;
+  msg_info.created_at = static_cast<uint32_t>(utime);
+  tlb::csr_pack(message.info, msg_info);
+  message.init = vm::CellBuilder()
+                        .store_ones(1)
+                        .store_zeroes(1)
+                        .append_cellslice(vm::load_cell_slice(ton::GenericAccount::get_init_state(wallet.get_state())))
+                        .as_cellslice_ref();
+  message.body = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
+
+  td::Ref<vm::Cell> int_msg;
+  tlb::type_pack_cell(int_msg, block::gen::t_Message_Any, message);
+  return int_msg;
+}
+
 TEST(Emulator, wallet_int_and_ext_msg) {
   td::Ed25519::PrivateKey priv_key = td::Ed25519::generate_private_key().move_as_ok();
   auto pub_key = priv_key.get_public_key().move_as_ok();
@@ -188,54 +240,7 @@ TEST(Emulator, wallet_int_and_ext_msg) {
     auto none_shard_account_cell = vm::CellBuilder().store_ref(account_root).store_bits(td::Bits256::zero().as_bitslice()).store_long(0).finalize();
     auto none_shard_account_boc = td::base64_encode(std_boc_serialize(none_shard_account_cell).move_as_ok());
 
-    td::Ref<vm::Cell> int_msg;
-    {
-      block::gen::Message::Record message;
-      block::gen::CommonMsgInfo::Record_int_msg_info msg_info;
-      msg_info.ihr_disabled = true;
-      msg_info.bounce = false;
-      msg_info.bounced = false;
-      {
-        block::gen::MsgAddressInt::Record_addr_std src;
-        src.anycast = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
-        src.workchain_id = 0;
-        src.address = td::Bits256();;
-        tlb::csr_pack(msg_info.src, src);
-      }
-      {
-        block::gen::MsgAddressInt::Record_addr_std dest;
-        dest.anycast = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
-        dest.workchain_id = address.workchain;
-        dest.address =  address.addr;
-        tlb::csr_pack(msg_info.dest, dest);
-      }
-      {
-        block::CurrencyCollection cc{10 * Ton};
-        cc.pack_to(msg_info.value);
-      }
-      {
-        vm::CellBuilder cb;
-        block::tlb::t_Grams.store_integer_value(cb, td::BigInt256(int(0.03 * Ton)));
-        msg_info.fwd_fee = cb.as_cellslice_ref();
-      }
-      {
-        vm::CellBuilder cb;
-        block::tlb::t_Grams.store_integer_value(cb, td::BigInt256(0));
-        msg_info.ihr_fee = cb.as_cellslice_ref();
-      }
-      msg_info.created_lt = 0;
-      msg_info.created_at = static_cast<uint32_t>(utime);
-      tlb::csr_pack(message.info, msg_info);
-      message.init = vm::CellBuilder()
-                            .store_ones(1)
-                            .store_zeroes(1)
-                            .append_cellslice(vm::load_cell_slice(ton::GenericAccount::get_init_state(wallet->get_state())))
-                            .as_cellslice_ref();
-      message.body = vm::CellBuilder().store_zeroes(1).as_cellslice_ref();
-
-      tlb::type_pack_cell(int_msg, block::gen::t_Message_Any, message);
-    }
-
+    auto int_msg = make_deploy_message(*wallet, utime);
     CHECK(int_msg.not_null());
 
     auto int_msg_boc = td::base64_encode(std_boc_serialize(int_msg).move_as_ok());
@@ -455,3 +460,310 @@ TEST(Emulator, tvm_emulator_extra_currencies) {
   CHECK(ec_balance[100] == 20000);
   CHECK(ec_balance[200] == 1);
 }
+
+TEST(Emulator, wallet_cells_api) {
+  td::Ed25519::PrivateKey priv_key = td::Ed25519::generate_private_key().move_as_ok();
+  auto pub_key = priv_key.get_public_key().move_as_ok();
+  ton::WalletV3::InitData init_data;
+  init_data.public_key = pub_key.as_octet_string();
+  init_data.wallet_id = 239;
+  auto wallet = ton::WalletV3::create(init_data, 2);
+  auto address = wallet->get_address();
+
+  auto to_handle = [](td::Ref<vm::Cell> cell) {
+    auto boc = std_boc_serialize(cell).move_as_ok();
+    void *handle = emulator_cell_create(boc.as_slice().data(), static_cast<uint32_t>(boc.size()));
+    CHECK(handle);
+    return handle;
+  };
+  auto from_handle = [](void *handle) {
+    uint32_t len;
+    const char *boc = emulator_cell_serialize(handle, &len);
+    CHECK(boc);
+    auto cell = vm::std_boc_deserialize(td::Slice(boc, len)).move_as_ok();
+    free(const_cast<char *>(boc));
+    return cell;
+  };
+
+  auto config_cell = vm::std_boc_deserialize(td::base64_decode(td::Slice(config_boc)).move_as_ok()).move_as_ok();
+  void *config_handle = to_handle(config_cell);
+  void *config = emulator_config_create_from_cell(config_handle);
+  CHECK(config);
+  emulator_cell_destroy(config_handle);
+
+  void *emulator = transaction_emulator_create(config_boc, 0);
+  CHECK(transaction_emulator_set_config_object(emulator, config));
+  const uint64_t lt = 42000000000;
+  CHECK(transaction_emulator_set_lt(emulator, lt));
+  const uint32_t utime = 1337;
+  transaction_emulator_set_unixtime(emulator, utime);
+
+  td::Ref<vm::Cell> account_root;
+  block::gen::Account().cell_pack_account_none(account_root);
+  void *shard_account = to_handle(vm::CellBuilder()
+                                      .store_ref(account_root)
+                                      .store_bits(td::Bits256::zero().as_bitslice())
+                                      .store_long(0)
+                                      .finalize());
+  void *int_msg = to_handle(make_deploy_message(*wallet, utime));
+  auto int_res = transaction_emulator_emulate_transaction_cells(emulator, shard_account, int_msg);
+  CHECK(int_res->success);
+  CHECK(int_res->error == nullptr);
+  char trans_hash[32];
+  CHECK(emulator_cell_get_hash(int_res->transaction, trans_hash));
+  block::gen::Transaction::Record trans;
+  CHECK(tlb::unpack_cell(from_handle(int_res->transaction), trans));
+  CHECK(trans.account_addr == address.addr);
+  CHECK(trans.lt == lt);
+  CHECK(trans.now == utime);
+  emulator_cell_destroy(shard_account);
+  emulator_cell_destroy(int_msg);
+
+  // The new shard account is passed to the next emulation as is
+  shard_account = int_res->shard_account;
+  int_res->shard_account = nullptr;
+  emulator_transaction_result_destroy(int_res);
+  block::gen::ShardAccount::Record shard_account_record;
+  CHECK(tlb::unpack_cell(from_handle(shard_account), shard_account_record));
+  CHECK(shard_account_record.last_trans_hash == td::Bits256(td::Slice(trans_hash, 32).ubegin()));
+  CHECK(shard_account_record.last_trans_lt == lt);
+
+  auto ext_body = wallet->make_a_gift_message(priv_key, utime + 60, {ton::WalletV3::Gift{block::StdAddress(0, ton::StdSmcAddress()), 1 * Ton}});
+  CHECK(ext_body.is_ok());
+  void *ext_msg = to_handle(ton::GenericAccount::create_ext_message(address, {}, ext_body.move_as_ok()));
+  auto ext_res = transaction_emulator_emulate_transaction_cells(emulator, shard_account, ext_msg);
+  CHECK(ext_res->success);
+  CHECK(ext_res->actions);
+  block::gen::Transaction::Record ext_trans;
+  CHECK(tlb::unpack_cell(from_handle(ext_res->transaction), ext_trans));
+  CHECK(ext_trans.outmsg_cnt == 1);
+  emulator_transaction_result_destroy(ext_res);
+
+  auto bad_res = transaction_emulator_emulate_transaction_cells(emulator, shard_account, nullptr);
+  CHECK(!bad_res->success);
+  CHECK(bad_res->error != nullptr);
+  emulator_transaction_result_destroy(bad_res);
+
+  emulator_cell_destroy(ext_msg);
+  emulator_cell_destroy(shard_account);
+  transaction_emulator_destroy(emulator);
+  emulator_config_destroy(config);
+
+  void *code = to_handle(ton::SmartContractCode::get_code(ton::SmartContractCode::Type::WalletV3, 2));
+  void *data = to_handle(ton::WalletV3::get_init_data(init_data));
+  void *tvm_emulator = tvm_emulator_create_from_cells(code, data, 0);
+  CHECK(tvm_emulator);
+  emulator_cell_destroy(code);
+  emulator_cell_destroy(data);
+  char addr_buffer[49] = {0};
+  CHECK(address.rserialize_to(addr_buffer));
+  CHECK(tvm_emulator_set_c7(tvm_emulator, addr_buffer, utime, 10 * Ton, std::string(64, 'F').c_str(), nullptr));
+  vm::CellBuilder stack_cb;
+  CHECK(td::make_ref<vm::Stack>()->serialize(stack_cb));
+  void *stack = to_handle(stack_cb.finalize());
+  unsigned method_id = (td::crc16("seqno") & 0xffff) | 0x10000;
+  auto get_res = tvm_emulator_run_get_method_cells(tvm_emulator, method_id, stack);
+  CHECK(get_res->success);
+  CHECK(get_res->vm_exit_code == 0);
+  CHECK(!get_res->has_missing_library);
+  td::Ref<vm::Stack> stack_res;
+  auto stack_res_cs = vm::load_cell_slice(from_handle(get_res->stack));
+  CHECK(vm::Stack::deserialize_to(stack_res_cs, stack_res));
+  CHECK(stack_res->depth() == 1);
+  CHECK(stack_res.write().pop_int()->to_long() == init_data.seqno);
+  emulator_get_method_result_destroy(get_res);
+  emulator_cell_destroy(stack);
+  tvm_emulator_destroy(tvm_emulator);
+}
+
+// Traces emulated with different numbers of threads must be the same
+void check_same_trace(const emulator::TransactionEmulator::TraceNode &a,
+                      const emulator::TransactionEmulator::TraceNode &b) {
+  CHECK(a.addr == b.addr);
+  CHECK(a.depth == b.depth);
+  CHECK(a.transaction.is_null() == b.transaction.is_null());
+  if (a.transaction.not_null()) {
+    CHECK(a.transaction->get_hash() == b.transaction->get_hash());
+  }
+  CHECK(a.gas_used == b.gas_used);
+  CHECK(a.children.size() == b.children.size());
+  for (size_t i = 0; i < a.children.size(); ++i) {
+    check_same_trace(*a.children[i], *b.children[i]);
+  }
+}
+
+TEST(Emulator, wallet_trace) {
+  td::Ed25519::PrivateKey priv_key = td::Ed25519::generate_private_key().move_as_ok();
+  auto pub_key = priv_key.get_public_key().move_as_ok();
+  ton::WalletV3::InitData init_data;
+  init_data.public_key = pub_key.as_octet_string();
+  init_data.wallet_id = 239;
+  auto wallet = ton::WalletV3::create(init_data, 2);
+  auto address = wallet->get_address();
+
+  auto config_cell = vm::std_boc_deserialize(td::base64_decode(td::Slice(config_boc)).move_as_ok()).move_as_ok();
+  auto config_addr_cs = vm::load_cell_slice(vm::Dictionary(config_cell, 32).lookup_ref(td::BitArray<32>::zero()));
+  ton::StdSmcAddress config_addr;
+  CHECK(config_addr_cs.fetch_bits_to(config_addr));
+  auto config = std::make_shared<block::Config>(
+      config_cell, config_addr,
+      block::Config::needWorkchainInfo | block::Config::needSpecialSmc | block::Config::needCapabilities);
+  CHECK(config->unpack().is_ok());
+
+  emulator::TransactionEmulator emulator(config);
+  const uint64_t lt = 42000000000;
+  const uint32_t utime = 1337;
+  emulator.set_lt(lt);
+  emulator.set_unixtime(utime);
+
+  auto r_account = emulator.unpack_shard_account(address.workchain, address.addr, {}, utime);
+  CHECK(r_account.is_ok());
+  auto deploy = emulator.emulate_transaction(r_account.move_as_ok(), make_deploy_message(*wallet, utime), utime, 0,
+                                             block::transaction::Transaction::tr_ord);
+  CHECK(deploy.is_ok());
+  auto wallet_shard_account = emulator::TransactionEmulator::pack_shard_account(
+      dynamic_cast<emulator::TransactionEmulator::EmulationSuccess &>(*deploy.ok()).account);
+
+  // The gift goes to an account that does not exist and bounces back to the wallet
+  auto ext_body = wallet->make_a_gift_message(priv_key, utime + 60, {ton::WalletV3::Gift{block::StdAddress(0, ton::StdSmcAddress()), 1 * Ton}});
+  CHECK(ext_body.is_ok());
+  auto ext_msg = ton::GenericAccount::create_ext_message(address, {}, ext_body.move_as_ok());
+  int provider_calls = 0;
+  auto get_shard_account = [&](ton::WorkchainId wc, const ton::StdSmcAddress &addr) -> td::Result<td::Ref<vm::Cell>> {
+    ++provider_calls;
+    if (wc == address.workchain && addr == address.addr) {
+      return wallet_shard_account;
+    }
+    return td::Ref<vm::Cell>();
+  };
+
+  emulator::TransactionEmulator::TraceLimits limits;
+  auto r_trace = emulator.emulate_trace(ext_msg, get_shard_account, limits);
+  CHECK(r_trace.is_ok());
+  auto trace = r_trace.move_as_ok();
+  CHECK(provider_calls == 2);
+  CHECK(!trace.truncated);
+  CHECK(trace.transactions == 3);
+  CHECK(trace.shard_accounts.size() == 2);
+  auto &root = *trace.root;
+  CHECK(root.transaction.not_null());
+  CHECK(root.gas_used > 0);
+  CHECK(root.total_fees.not_null() && td::sgn(root.total_fees) > 0);
+  CHECK(trace.total_gas >= root.gas_used);
+  CHECK(root.children.size() == 1);
+  auto &transfer = *root.children[0];
+  CHECK(transfer.transaction.not_null());
+  CHECK(transfer.addr == ton::StdSmcAddress());
+  CHECK(transfer.depth == 1);
+  CHECK(transfer.children.size() == 1);
+  auto &bounce = *transfer.children[0];
+  CHECK(bounce.transaction.not_null());
+  CHECK(bounce.addr == address.addr);
+  CHECK(bounce.children.empty());
+  block::gen::Transaction::Record root_trans, bounce_trans;
+  CHECK(tlb::unpack_cell(root.transaction, root_trans) && tlb::unpack_cell(bounce.transaction, bounce_trans));
+  CHECK(bounce_trans.prev_trans_lt == root_trans.lt);
+  CHECK(bounce_trans.lt > root_trans.lt);
+
+  // Same trace on several threads, cut after the first hop
+  limits.threads = 4;
+  limits.max_depth = 2;
+  provider_calls = 0;
+  r_trace = emulator.emulate_trace(ext_msg, get_shard_account, limits);
+  CHECK(r_trace.is_ok());
+  auto short_trace = r_trace.move_as_ok();
+  CHECK(short_trace.truncated);
+  CHECK(short_trace.transactions == 2);
+  CHECK(short_trace.root->transaction->get_hash() == root.transaction->get_hash());
+  CHECK(short_trace.root->children[0]->transaction->get_hash() == transfer.transaction->get_hash());
+  auto &cut = *short_trace.root->children[0]->children[0];
+  CHECK(cut.transaction.is_null());
+  CHECK(!cut.error.empty());
+
+  // Two gifts to different accounts make a level of two accounts, which are run on separate threads
+  ton::StdSmcAddress other_addr = ton::StdSmcAddress::zero();
+  other_addr.as_slice()[31] = 1;
+  std::vector<ton::WalletV3::Gift> gifts{ton::WalletV3::Gift{block::StdAddress(0, ton::StdSmcAddress()), 1 * Ton},
+                                         ton::WalletV3::Gift{block::StdAddress(0, other_addr), 1 * Ton}};
+  ext_body = wallet->make_a_gift_message(priv_key, utime + 60, gifts);
+  CHECK(ext_body.is_ok());
+  auto two_gifts_msg = ton::GenericAccount::create_ext_message(address, {}, ext_body.move_as_ok());
+  limits = {};
+  r_trace = emulator.emulate_trace(two_gifts_msg, get_shard_account, limits);
+  CHECK(r_trace.is_ok());
+  auto serial_trace = r_trace.move_as_ok();
+  CHECK(!serial_trace.truncated);
+  CHECK(serial_trace.transactions == 5);
+  CHECK(serial_trace.shard_accounts.size() == 3);
+  CHECK(serial_trace.root->children.size() == 2);
+  CHECK(serial_trace.root->children[0]->addr != serial_trace.root->children[1]->addr);
+
+  limits.threads = 4;
+  r_trace = emulator.emulate_trace(two_gifts_msg, get_shard_account, limits);
+  CHECK(r_trace.is_ok());
+  auto parallel_trace = r_trace.move_as_ok();
+  CHECK(!parallel_trace.truncated);
+  CHECK(parallel_trace.transactions == serial_trace.transactions);
+  CHECK(parallel_trace.total_gas == serial_trace.total_gas);
+  check_same_trace(*serial_trace.root, *parallel_trace.root);
+  CHECK(parallel_trace.shard_accounts.size() == serial_trace.shard_accounts.size());
+  for (auto &p : serial_trace.shard_accounts) {
+    auto it = parallel_trace.shard_accounts.find(p.first);
+    CHECK(it != parallel_trace.shard_accounts.end());
+    CHECK(it->second->get_hash() == p.second->get_hash());
+  }
+
+  // A message that can not be processed at all is reported as an error
+  CHECK(emulator.emulate_trace(td::Ref<vm::Cell>(), get_shard_account, limits).is_error());
+}
+
+TEST(Emulator, shared_cache) {
+  auto config_cell = vm::std_boc_deserialize(td::base64_decode(td::Slice(config_boc)).move_as_ok()).move_as_ok();
+  auto config = emulator::SharedCache::get_config(config_cell);
+  CHECK(config.is_ok());
+  // Another copy of the same BoC gives the same object
+  auto config_copy = vm::std_boc_deserialize(td::base64_decode(td::Slice(config_boc)).move_as_ok()).move_as_ok();
+  auto config2 = emulator::SharedCache::get_config(config_copy);
+  CHECK(config2.is_ok());
+  CHECK(config.ok().get() == config2.ok().get());
+  CHECK(emulator::SharedCache::get_config(td::Ref<vm::Cell>()).is_error());
+
+  vm::Dictionary libs{256};
+  auto lib = vm::CellBuilder().store_long(239, 32).finalize();
+  CHECK(libs.set_ref(lib->get_hash().bits(), 256, lib));
+  auto libs_root = libs.get_root_cell();
+  auto shared_libs = emulator::SharedCache::get_libraries(libs_root);
+  CHECK(shared_libs == emulator::SharedCache::get_libraries(libs_root));
+  CHECK(shared_libs->get_root_cell()->get_hash() == libs_root->get_hash());
+
+  // Entries are dropped when no emulator uses them
+  std::weak_ptr<const vm::Dictionary> weak = shared_libs;
+  shared_libs = nullptr;
+  CHECK(weak.expired());
+  CHECK(emulator::SharedCache::get_libraries(libs_root)->get_root_cell().not_null());
+
+  void *emulator1 = transaction_emulator_create(config_boc, 0);
+  void *emulator2 = transaction_emulator_create(config_boc, 0);
+  CHECK(&static_cast<emulator::TransactionEmulator *>(emulator1)->get_config() ==
+        &static_cast<emulator::TransactionEmulator *>(emulator2)->get_config());
+
+  // Config objects of the C API share the decoded config too
+  void *config1 = emulator_config_create(config_boc);
+  auto config_copy_boc = std_boc_serialize(config_copy).move_as_ok();
+  void *config_cell_handle =
+      emulator_cell_create(config_copy_boc.as_slice().data(), static_cast<uint32_t>(config_copy_boc.size()));
+  void *config2_obj = emulator_config_create_from_cell(config_cell_handle);
+  emulator_cell_destroy(config_cell_handle);
+  CHECK(config1 && config2_obj);
+  CHECK(transaction_emulator_set_config_object(emulator1, config1));
+  CHECK(transaction_emulator_set_config_object(emulator2, config2_obj));
+  CHECK(&static_cast<emulator::TransactionEmulator *>(emulator1)->get_config() == config.ok().get());
+  CHECK(&static_cast<emulator::TransactionEmulator *>(emulator2)->get_config() == config.ok().get());
+  // Emulators keep the config after the Config objects are destroyed
+  emulator_config_destroy(config1);
+  emulator_config_destroy(config2_obj);
+  CHECK(static_cast<emulator::TransactionEmulator *>(emulator1)->get_config().get_global_version() ==
+        config.ok()->get_global_version());
+  transaction_emulator_destroy(emulator1);
+  transaction_emulator_destroy(emulator2);
+}
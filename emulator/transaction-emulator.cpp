@@ -3,6 +3,9 @@
 #include "crypto/common/refcnt.hpp"
 #include "vm/vm.h"
 #include "tdutils/td/utils/Time.h"
+#include "tdutils/td/utils/port/thread.h"
+
+#include <atomic>
 
 using td::Ref;
 using namespace std::string_literals;
@@ -43,7 +46,7 @@ td::Result<std::unique_ptr<TransactionEmulator::EmulationResult>> TransactionEmu
     }
     account.block_lt = lt - lt % block::ConfigInfo::get_lt_align();
 
-    compute_phase_cfg.libraries = std::make_unique<vm::Dictionary>(libraries_);
+    compute_phase_cfg.libraries = std::make_unique<vm::Dictionary>(*libraries_);
     compute_phase_cfg.ignore_chksig = ignore_chksig_;
     compute_phase_cfg.with_vm_log = true;
     compute_phase_cfg.vm_log_verbosity = vm_log_verbosity_;
@@ -74,8 +77,13 @@ td::Result<std::unique_ptr<TransactionEmulator::EmulationResult>> TransactionEmu
       return td::Status::Error(PSLICE() << "cannot commit new transaction for smart contract");
     }
 
-    return std::make_unique<TransactionEmulator::EmulationSuccess>(std::move(trans_root), std::move(account), 
+    auto success = std::make_unique<TransactionEmulator::EmulationSuccess>(std::move(trans_root), std::move(account),
       std::move(trans->compute_phase->vm_log), std::move(trans->compute_phase->actions), elapsed);
+    success->out_msgs = std::move(trans->out_msgs);
+    success->gas_used = trans->gas_used();
+    success->vm_exit_code = trans->compute_phase->exit_code;
+    success->total_fees = trans->total_fees.grams;
+    return success;
 }
 
 td::Result<TransactionEmulator::EmulationSuccess> TransactionEmulator::emulate_transaction(block::Account&& account, td::Ref<vm::Cell> original_trans) {
@@ -169,6 +177,233 @@ td::Result<TransactionEmulator::EmulationChain> TransactionEmulator::emulate_tra
   return TransactionEmulator::EmulationChain{ std::move(emulated_transactions), std::move(account) };
 }
 
+namespace {
+
+bool extract_msg_dest(td::Ref<vm::Cell> msg, ton::WorkchainId& wc, ton::StdSmcAddress& addr, ton::LogicalTime& lt) {
+  auto cs = vm::load_cell_slice(msg);
+  switch (block::gen::t_CommonMsgInfo.get_tag(cs)) {
+    case block::gen::CommonMsgInfo::int_msg_info: {
+      block::gen::CommonMsgInfo::Record_int_msg_info info;
+      if (!tlb::unpack(cs, info)) {
+        return false;
+      }
+      lt = info.created_lt;
+      return block::tlb::t_MsgAddressInt.extract_std_address(info.dest, wc, addr);
+    }
+    case block::gen::CommonMsgInfo::ext_in_msg_info: {
+      block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
+      if (!tlb::unpack(cs, info)) {
+        return false;
+      }
+      lt = 0;
+      return block::tlb::t_MsgAddressInt.extract_std_address(info.dest, wc, addr);
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+td::Result<TransactionEmulator::EmulationTrace> TransactionEmulator::emulate_trace(
+    td::Ref<vm::Cell> msg_root, const AccountProvider& get_shard_account, TraceLimits limits) {
+  using AccountId = std::pair<ton::WorkchainId, ton::StdSmcAddress>;
+  struct Pending {
+    TraceNode* node;
+    ton::LogicalTime lt;
+  };
+  struct Group {
+    block::Account* account;
+    std::vector<Pending> msgs;
+  };
+
+  ton::UnixTime utime = unixtime_ ? unixtime_ : (unsigned)std::time(nullptr);
+  TRY_STATUS(vm::init_vm(debug_enabled_));
+
+  EmulationTrace res;
+  res.root = std::make_unique<TraceNode>();
+  res.root->in_msg = std::move(msg_root);
+  ton::LogicalTime root_lt;
+  if (res.root->in_msg.is_null() ||
+      !extract_msg_dest(res.root->in_msg, res.root->workchain, res.root->addr, root_lt)) {
+    return td::Status::Error("Only ext in and int message are supported");
+  }
+  // Explicit lt of the first transaction is set with set_lt() as for a single transaction
+  root_lt = 0;
+
+  std::map<AccountId, block::Account> accounts;
+  std::vector<Pending> level{{res.root.get(), root_lt}};
+  while (!level.empty()) {
+    int depth = level[0].node->depth;
+    size_t allowed = limits.max_transactions - std::min(limits.max_transactions, res.transactions);
+    if (depth >= limits.max_depth || res.total_gas >= limits.max_gas || allowed == 0) {
+      for (auto& p : level) {
+        p.node->error = "trace limits exceeded";
+      }
+      res.truncated = true;
+      break;
+    }
+    if (level.size() > allowed) {
+      for (size_t i = allowed; i < level.size(); ++i) {
+        level[i].node->error = "trace limits exceeded";
+      }
+      level.resize(allowed);
+      res.truncated = true;
+    }
+
+    // Messages to one account are processed by one worker in the order of creation within the level
+    std::vector<Group> groups;
+    std::map<AccountId, size_t> group_idx;
+    for (auto& p : level) {
+      AccountId id{p.node->workchain, p.node->addr};
+      auto it = group_idx.find(id);
+      if (it != group_idx.end()) {
+        groups[it->second].msgs.push_back(p);
+        continue;
+      }
+      auto acc_it = accounts.find(id);
+      if (acc_it == accounts.end()) {
+        auto r_unpacked = [&]() -> td::Result<block::Account> {
+          TRY_RESULT(shard_account, get_shard_account(id.first, id.second));
+          return unpack_shard_account(id.first, id.second, std::move(shard_account), utime);
+        }();
+        if (r_unpacked.is_error()) {
+          if (p.node == res.root.get()) {
+            return r_unpacked.move_as_error_prefix("cannot get account: ");
+          }
+          p.node->error = PSTRING() << "cannot get account: " << r_unpacked.error();
+          continue;
+        }
+        acc_it = accounts.emplace(id, r_unpacked.move_as_ok()).first;
+      }
+      group_idx.emplace(id, groups.size());
+      groups.push_back(Group{&acc_it->second, {p}});
+    }
+
+    td::Status root_status;
+    auto run_group = [&](Group& group) {
+      for (auto& p : group.msgs) {
+        auto S = emulate_trace_node(*p.node, *group.account, utime, p.lt);
+        if (S.is_error()) {
+          p.node->error = S.message().str();
+          if (p.node == res.root.get()) {
+            root_status = std::move(S);
+          }
+        }
+      }
+    };
+    size_t threads = std::min<size_t>(std::max(limits.threads, 1), groups.size());
+    if (threads <= 1) {
+      for (auto& group : groups) {
+        run_group(group);
+      }
+    } else {
+      std::atomic<size_t> next_group{0};
+      std::vector<td::thread> workers;
+      for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&] {
+          for (size_t j = next_group++; j < groups.size(); j = next_group++) {
+            run_group(groups[j]);
+          }
+        });
+      }
+      for (auto& worker : workers) {
+        worker.join();
+      }
+    }
+
+    TRY_STATUS(std::move(root_status));
+    std::vector<Pending> next_level;
+    for (auto& p : level) {
+      if (p.node->transaction.not_null()) {
+        ++res.transactions;
+        res.total_gas += p.node->gas_used;
+      }
+      for (auto& child : p.node->children) {
+        ton::LogicalTime created_lt;
+        if (extract_msg_dest(child->in_msg, child->workchain, child->addr, created_lt)) {
+          next_level.push_back(Pending{child.get(), created_lt + 1});
+        } else {
+          child->error = "cannot extract message destination";
+        }
+      }
+    }
+    level = std::move(next_level);
+  }
+  for (auto& [id, account] : accounts) {
+    if (account.total_state.not_null()) {
+      res.shard_accounts.emplace(id, pack_shard_account(account));
+    }
+  }
+  return res;
+}
+
+td::Status TransactionEmulator::emulate_trace_node(TraceNode& node, block::Account& account, ton::UnixTime utime,
+                                                   ton::LogicalTime lt) {
+  TRY_RESULT(emulation, emulate_transaction(block::Account(account), node.in_msg, utime, lt,
+                                            block::transaction::Transaction::tr_ord));
+  node.vm_log = std::move(emulation->vm_log);
+  if (auto not_accepted = dynamic_cast<EmulationExternalNotAccepted*>(emulation.get())) {
+    node.vm_exit_code = not_accepted->vm_exit_code;
+    node.error = "external message was not accepted";
+    return td::Status::OK();
+  }
+  auto& success = dynamic_cast<EmulationSuccess&>(*emulation);
+  node.transaction = std::move(success.transaction);
+  node.gas_used = success.gas_used;
+  node.vm_exit_code = success.vm_exit_code;
+  node.total_fees = std::move(success.total_fees);
+  account = std::move(success.account);
+  for (auto& msg : success.out_msgs) {
+    if (block::gen::t_CommonMsgInfo.get_tag(vm::load_cell_slice(msg)) == block::gen::CommonMsgInfo::int_msg_info) {
+      auto child = std::make_unique<TraceNode>();
+      child->in_msg = std::move(msg);
+      child->depth = node.depth + 1;
+      node.children.push_back(std::move(child));
+    } else {
+      node.ext_out_msgs.push_back(std::move(msg));
+    }
+  }
+  return td::Status::OK();
+}
+
+td::Result<block::Account> TransactionEmulator::unpack_shard_account(ton::WorkchainId wc,
+                                                                     const ton::StdSmcAddress& addr,
+                                                                     td::Ref<vm::Cell> shard_account_cell,
+                                                                     ton::UnixTime now) {
+  auto account = block::Account(wc, addr.cbits());
+  bool account_exists = false;
+  block::gen::ShardAccount::Record shard_account;
+  if (shard_account_cell.not_null()) {
+    if (!tlb::unpack_cell(shard_account_cell, shard_account)) {
+      return td::Status::Error("Can't unpack shard account cell");
+    }
+    account_exists =
+        block::gen::t_Account.get_tag(vm::load_cell_slice(shard_account.account)) == block::gen::Account::account;
+  }
+  bool is_special = wc == ton::masterchainId && config_->is_special_smartcontract(addr);
+  if (account_exists) {
+    if (!account.unpack(vm::load_cell_slice_ref(std::move(shard_account_cell)), now, is_special)) {
+      return td::Status::Error("Can't unpack shard account");
+    }
+  } else {
+    if (!account.init_new(now)) {
+      return td::Status::Error("Can't init new account");
+    }
+    if (shard_account_cell.not_null()) {
+      account.last_trans_lt_ = shard_account.last_trans_lt;
+      account.last_trans_hash_ = shard_account.last_trans_hash;
+    }
+  }
+  return account;
+}
+
+td::Ref<vm::Cell> TransactionEmulator::pack_shard_account(const block::Account& account) {
+  return vm::CellBuilder().store_ref(account.total_state)
+                          .store_bits(account.last_trans_hash_.as_bitslice())
+                          .store_long(account.last_trans_lt_).finalize();
+}
+
 bool TransactionEmulator::check_state_update(const block::Account& account, const block::gen::Transaction::Record& trans) {
   block::gen::HASH_UPDATE::Record hash_update;
   return tlb::type_unpack_cell(trans.state_update, block::gen::t_HASH_UPDATE_Account, hash_update) &&
@@ -262,12 +497,16 @@ void TransactionEmulator::set_ignore_chksig(bool ignore_chksig) {
   ignore_chksig_ = ignore_chksig;
 }
 
-void TransactionEmulator::set_config(std::shared_ptr<block::Config> config) {
+void TransactionEmulator::set_config(std::shared_ptr<const block::Config> config) {
   config_ = std::move(config);
 }
 
 void TransactionEmulator::set_libs(vm::Dictionary &&libs) {
-  libraries_ = std::forward<vm::Dictionary>(libs);
+  libraries_ = std::make_shared<const vm::Dictionary>(std::move(libs));
+}
+
+void TransactionEmulator::set_libs(std::shared_ptr<const vm::Dictionary> libs) {
+  libraries_ = std::move(libs);
 }
 
 void TransactionEmulator::set_debug_enabled(bool debug_enabled) {
@@ -7,10 +7,13 @@
 #include "block/block-parse.h"
 #include "block/mc-config.h"
 
+#include <functional>
+#include <map>
+
 namespace emulator {
 class TransactionEmulator {
-  std::shared_ptr<block::Config> config_;
-  vm::Dictionary libraries_;
+  std::shared_ptr<const block::Config> config_;
+  std::shared_ptr<const vm::Dictionary> libraries_;
   int vm_log_verbosity_;
   ton::UnixTime unixtime_;
   ton::LogicalTime lt_;
@@ -20,8 +23,8 @@ class TransactionEmulator {
   td::Ref<vm::Tuple> prev_blocks_info_;
 
 public:
-  TransactionEmulator(std::shared_ptr<block::Config> config, int vm_log_verbosity = 0) :
-    config_(std::move(config)), libraries_(256), vm_log_verbosity_(vm_log_verbosity),
+  TransactionEmulator(std::shared_ptr<const block::Config> config, int vm_log_verbosity = 0) :
+    config_(std::move(config)), libraries_(std::make_shared<const vm::Dictionary>(256)), vm_log_verbosity_(vm_log_verbosity),
     unixtime_(0), lt_(0), rand_seed_(td::BitArray<256>::zero()), ignore_chksig_(false), debug_enabled_(false) {
   }
 
@@ -37,6 +40,10 @@ public:
     td::Ref<vm::Cell> transaction;
     block::Account account;
     td::Ref<vm::Cell> actions;
+    std::vector<td::Ref<vm::Cell>> out_msgs;
+    td::uint64 gas_used{0};
+    int vm_exit_code{0};
+    td::RefInt256 total_fees;
 
     EmulationSuccess(td::Ref<vm::Cell> transaction_, block::Account account_, std::string vm_log_, td::Ref<vm::Cell> actions_, double elapsed_time_) :
       EmulationResult(vm_log_, elapsed_time_), transaction(transaction_), account(account_) , actions(actions_)
@@ -56,6 +63,43 @@ public:
     block::Account account;
   };
 
+  // Limits of a trace started by one message. Gas is checked between levels of the trace (all transactions
+  // at the same depth are run together), so the last level may go over max_gas.
+  struct TraceLimits {
+    int max_depth{16};  // number of levels, the initial message is level 0
+    td::uint64 max_gas{100000000};
+    size_t max_transactions{1000};
+    int threads{1};
+  };
+
+  struct TraceNode {
+    td::Ref<vm::Cell> in_msg;
+    ton::WorkchainId workchain{ton::workchainInvalid};
+    ton::StdSmcAddress addr;
+    int depth{0};
+    td::Ref<vm::Cell> transaction;  // null if the message was not processed, `error` tells why
+    td::uint64 gas_used{0};
+    int vm_exit_code{0};
+    td::RefInt256 total_fees;
+    std::string vm_log;
+    std::string error;
+    std::vector<td::Ref<vm::Cell>> ext_out_msgs;
+    std::vector<std::unique_ptr<TraceNode>> children;  // internal outbound messages in the order of creation
+  };
+
+  struct EmulationTrace {
+    std::unique_ptr<TraceNode> root;
+    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, td::Ref<vm::Cell>> shard_accounts;  // reached accounts
+    td::uint64 total_gas{0};
+    size_t transactions{0};
+    bool truncated{false};  // some messages were not processed because of the limits
+  };
+
+  // Returns ShardAccount of the given address, null cell if the account does not exist.
+  // Always called from the thread that runs emulate_trace, once per account.
+  using AccountProvider =
+      std::function<td::Result<td::Ref<vm::Cell>>(ton::WorkchainId, const ton::StdSmcAddress&)>;
+
   const block::Config& get_config() {
     return *config_;
   }
@@ -70,17 +114,31 @@ public:
   td::Result<EmulationSuccess> emulate_transaction(block::Account&& account, td::Ref<vm::Cell> original_trans);
   td::Result<EmulationChain> emulate_transactions_chain(block::Account&& account, std::vector<td::Ref<vm::Cell>>&& original_transactions);
 
+  // Emulates the message and all messages caused by it, breadth-first. Transactions of different accounts
+  // at the same depth run in parallel on up to limits.threads threads. An error is returned only if the
+  // initial message can not be processed, errors of later transactions are stored in their nodes.
+  // Messages to one account are processed level by level, not in created_lt order as in a block: a message
+  // of a deeper level always comes after the messages of the previous one, even if it was created earlier.
+  td::Result<EmulationTrace> emulate_trace(td::Ref<vm::Cell> msg_root, const AccountProvider& get_shard_account,
+                                           TraceLimits limits);
+
+  td::Result<block::Account> unpack_shard_account(ton::WorkchainId wc, const ton::StdSmcAddress& addr,
+                                                  td::Ref<vm::Cell> shard_account, ton::UnixTime now);
+  static td::Ref<vm::Cell> pack_shard_account(const block::Account& account);
+
   void set_unixtime(ton::UnixTime unixtime);
   void set_lt(ton::LogicalTime lt);
   void set_rand_seed(td::BitArray<256>& rand_seed);
   void set_ignore_chksig(bool ignore_chksig);
-  void set_config(std::shared_ptr<block::Config> config);
+  void set_config(std::shared_ptr<const block::Config> config);
   void set_libs(vm::Dictionary &&libs);
+  void set_libs(std::shared_ptr<const vm::Dictionary> libs);
   void set_debug_enabled(bool debug_enabled);
   void set_prev_blocks_info(td::Ref<vm::Tuple> prev_blocks_info);
 
 private:
   bool check_state_update(const block::Account& account, const block::gen::Transaction::Record& trans);
+  td::Status emulate_trace_node(TraceNode& node, block::Account& account, ton::UnixTime utime, ton::LogicalTime lt);
 
   td::Result<std::unique_ptr<block::transaction::Transaction>> create_transaction(
                                                          td::Ref<vm::Cell> msg_root, block::Account* acc,
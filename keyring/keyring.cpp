@@ -22,6 +22,10 @@
 #include "td/utils/port/path.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/Random.h"
+#include "td/utils/as.h"
+
+#include <algorithm>
+#include <thread>
 
 namespace ton {
 
@@ -32,9 +36,18 @@ KeyringImpl::PrivateKeyDescr::PrivateKeyDescr(PrivateKey private_key, bool is_te
   auto D = private_key.create_decryptor_async();
   D.ensure();
   decryptor_sign = D.move_as_ok();
-  D = private_key.create_decryptor_async();
-  D.ensure();
-  decryptor_decrypt = D.move_as_ok();
+}
+
+td::actor::ActorId<DecryptorAsync> KeyringImpl::PrivateKeyDescr::get_decryptor(td::uint64 shard_key) {
+  if (decryptors_decrypt.empty()) {
+    size_t workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, max_decrypt_workers());
+    for (size_t i = 0; i < workers; ++i) {
+      auto D = private_key.create_decryptor_async();
+      D.ensure();
+      decryptors_decrypt.push_back(D.move_as_ok());
+    }
+  }
+  return decryptors_decrypt[shard_key % decryptors_decrypt.size()].get();
 }
 
 void KeyringImpl::start_up() {
@@ -185,8 +198,23 @@ void KeyringImpl::decrypt_message(PublicKeyHash key_hash, td::BufferSlice data,
   if (S.is_error()) {
     promise.set_error(S.move_as_error());
   } else {
-    td::actor::send_closure(S.move_as_ok()->decryptor_decrypt, &DecryptorAsync::decrypt, std::move(data),
-                            std::move(promise));
+    // The sender is not known here. Encrypted messages start with the sender's ephemeral public key, which is
+    // random, so such messages are spread between the workers uniformly
+    td::uint64 shard_key = data.size() >= 8 ? td::as<td::uint64>(data.data()) : 0;
+    auto decryptor = S.move_as_ok()->get_decryptor(shard_key);
+    td::actor::send_closure(decryptor, &DecryptorAsync::decrypt, std::move(data), std::move(promise));
+  }
+}
+
+void KeyringImpl::decrypt_message_in_place(PublicKeyHash key_hash, td::BufferSlice data,
+                                           td::uint64 shard_key, td::Promise<td::BufferSlice> promise) {
+  auto S = load_key(key_hash);
+
+  if (S.is_error()) {
+    promise.set_error(S.move_as_error());
+  } else {
+    auto decryptor = S.move_as_ok()->get_decryptor(shard_key);
+    td::actor::send_closure(decryptor, &DecryptorAsync::decrypt_in_place, std::move(data), std::move(promise));
   }
 }
 
@@ -43,6 +43,10 @@ class Keyring : public td::actor::Actor {
                              td::Promise<std::vector<td::Result<td::BufferSlice>>> promise) = 0;
 
   virtual void decrypt_message(PublicKeyHash key_hash, td::BufferSlice data, td::Promise<td::BufferSlice> promise) = 0;
+  // Same, but the message is decrypted inside `data` (see Decryptor::decrypt_in_place).
+  // Messages with the same shard_key (e.g. from the same sender) are decrypted by the same worker, in order
+  virtual void decrypt_message_in_place(PublicKeyHash key_hash, td::BufferSlice data, td::uint64 shard_key,
+                                        td::Promise<td::BufferSlice> promise) = 0;
 
   virtual void export_all_private_keys(td::Promise<std::vector<PrivateKey>> promise) = 0;
 
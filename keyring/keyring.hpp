@@ -31,13 +31,20 @@ class KeyringImpl : public Keyring {
  private:
   struct PrivateKeyDescr {
     td::actor::ActorOwn<DecryptorAsync> decryptor_sign;
-    td::actor::ActorOwn<DecryptorAsync> decryptor_decrypt;
+    // Created on first use; messages are spread between them by a shard key (see get_decryptor)
+    std::vector<td::actor::ActorOwn<DecryptorAsync>> decryptors_decrypt;
     PublicKey public_key;
     PrivateKey private_key;
     bool is_temp;
     PrivateKeyDescr(PrivateKey private_key, bool is_temp);
+
+    td::actor::ActorId<DecryptorAsync> get_decryptor(td::uint64 shard_key);
   };
 
+  static constexpr size_t max_decrypt_workers() {
+    return 8;
+  }
+
  public:
   void start_up() override;
 
@@ -56,6 +63,8 @@ class KeyringImpl : public Keyring {
                      td::Promise<std::vector<td::Result<td::BufferSlice>>> promise) override;
 
   void decrypt_message(PublicKeyHash key_hash, td::BufferSlice data, td::Promise<td::BufferSlice> promise) override;
+  void decrypt_message_in_place(PublicKeyHash key_hash, td::BufferSlice data, td::uint64 shard_key,
+                                td::Promise<td::BufferSlice> promise) override;
 
   void export_all_private_keys(td::Promise<std::vector<PrivateKey>> promise) override;
 
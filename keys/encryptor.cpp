@@ -73,10 +73,25 @@ td::Status EncryptorEd25519::check_signature(td::Slice message, td::Slice signat
 }
 
 td::Result<td::BufferSlice> DecryptorEd25519::decrypt(td::Slice data) {
-  if (data.size() < td::Ed25519::PublicKey::LENGTH + 32) {
+  if (data.size() < header_size()) {
     return td::Status::Error(ErrorCode::protoviolation, "message is too short");
   }
+  td::BufferSlice res(data.size() - header_size());
+  TRY_STATUS(decrypt_to(data, res.as_slice()));
+  return std::move(res);
+}
 
+td::Result<td::BufferSlice> DecryptorEd25519::decrypt_in_place(td::BufferSlice data) {
+  if (data.size() < header_size()) {
+    return td::Status::Error(ErrorCode::protoviolation, "message is too short");
+  }
+  auto res = data.from_slice(data.as_slice().substr(header_size()));
+  TRY_STATUS(decrypt_to(data.as_slice(), res.as_slice()));
+  return std::move(res);
+}
+
+// `to` may be the encrypted part of `data` itself
+td::Status DecryptorEd25519::decrypt_to(td::Slice data, td::MutableSlice to) {
   td::Slice pub = data.substr(0, td::Ed25519::PublicKey::LENGTH);
   data.remove_prefix(td::Ed25519::PublicKey::LENGTH);
 
@@ -95,20 +110,17 @@ td::Result<td::BufferSlice> DecryptorEd25519::decrypt(td::Slice data) {
   iv.as_mutable_slice().copy_from(digest.substr(0, 4));
   iv.as_mutable_slice().substr(4).copy_from(td::Slice(shared_secret).substr(20, 12));
 
-  td::BufferSlice res(data.size());
-
   td::AesCtrState ctr;
   ctr.init(key, iv);
-  ctr.encrypt(data, res.as_slice());
+  ctr.encrypt(data, to);
 
   td::UInt256 real_digest;
-  td::sha256(res.as_slice(), as_slice(real_digest));
+  td::sha256(to, as_slice(real_digest));
 
   if (as_slice(real_digest) != digest) {
     return td::Status::Error(ErrorCode::protoviolation, "sha256 mismatch after decryption");
   }
-
-  return std::move(res);
+  return td::Status::OK();
 }
 
 td::Result<td::BufferSlice> DecryptorEd25519::sign(td::Slice data) {
@@ -143,7 +155,22 @@ td::Result<td::BufferSlice> DecryptorAES::decrypt(td::Slice data) {
   if (data.size() < 32) {
     return td::Status::Error(ErrorCode::protoviolation, "message is too short");
   }
+  td::BufferSlice res(data.size() - 32);
+  TRY_STATUS(decrypt_to(data, res.as_slice()));
+  return std::move(res);
+}
+
+td::Result<td::BufferSlice> DecryptorAES::decrypt_in_place(td::BufferSlice data) {
+  if (data.size() < 32) {
+    return td::Status::Error(ErrorCode::protoviolation, "message is too short");
+  }
+  auto res = data.from_slice(data.as_slice().substr(32));
+  TRY_STATUS(decrypt_to(data.as_slice(), res.as_slice()));
+  return std::move(res);
+}
 
+// `to` may be the encrypted part of `data` itself
+td::Status DecryptorAES::decrypt_to(td::Slice data, td::MutableSlice to) {
   td::Slice digest = data.substr(0, 32);
   data.remove_prefix(32);
 
@@ -155,20 +182,17 @@ td::Result<td::BufferSlice> DecryptorAES::decrypt(td::Slice data) {
   iv.as_mutable_slice().copy_from(digest.substr(0, 4));
   iv.as_mutable_slice().substr(4).copy_from(shared_secret_.as_slice().substr(20, 12));
 
-  td::BufferSlice res(data.size());
-
   td::AesCtrState ctr;
   ctr.init(key, iv);
-  ctr.encrypt(data, res.as_slice());
+  ctr.encrypt(data, to);
 
   td::UInt256 real_digest;
-  td::sha256(res.as_slice(), as_slice(real_digest));
+  td::sha256(to, as_slice(real_digest));
 
   if (as_slice(real_digest) != digest) {
     return td::Status::Error(ErrorCode::protoviolation, "sha256 mismatch after decryption");
   }
-
-  return std::move(res);
+  return td::Status::OK();
 }
 
 std::vector<td::Result<td::BufferSlice>> Decryptor::sign_batch(std::vector<td::Slice> data) {
@@ -36,6 +36,11 @@ class Encryptor {
 class Decryptor {
  public:
   virtual td::Result<td::BufferSlice> decrypt(td::Slice data) = 0;
+  // Decrypts the message inside its own buffer and returns a slice of it, so the caller must not keep other views
+  // of the buffer
+  virtual td::Result<td::BufferSlice> decrypt_in_place(td::BufferSlice data) {
+    return decrypt(data.as_slice());
+  }
   virtual td::Result<td::BufferSlice> sign(td::Slice data) = 0;
   virtual std::vector<td::Result<td::BufferSlice>> sign_batch(std::vector<td::Slice> data);
   virtual ~Decryptor() = default;
@@ -71,6 +76,9 @@ class DecryptorAsync : public td::actor::Actor {
   auto decrypt(td::BufferSlice data) {
     return decryptor_->decrypt(data.as_slice());
   }
+  auto decrypt_in_place(td::BufferSlice data) {
+    return decryptor_->decrypt_in_place(std::move(data));
+  }
   auto sign(td::BufferSlice data) {
     return decryptor_->sign(data.as_slice());
   }
@@ -91,8 +91,14 @@ class DecryptorEd25519 : public Decryptor {
  private:
   td::Ed25519::PrivateKey pk_;
 
+  static constexpr size_t header_size() {
+    return td::Ed25519::PublicKey::LENGTH + 32;
+  }
+  td::Status decrypt_to(td::Slice data, td::MutableSlice to);
+
  public:
   td::Result<td::BufferSlice> decrypt(td::Slice data) override;
+  td::Result<td::BufferSlice> decrypt_in_place(td::BufferSlice data) override;
   td::Result<td::BufferSlice> sign(td::Slice data) override;
   DecryptorEd25519(const td::Bits256& key) : pk_(td::SecureString(as_slice(key))) {
   }
@@ -145,11 +151,14 @@ class DecryptorAES : public Decryptor {
  private:
   td::Bits256 shared_secret_;
 
+  td::Status decrypt_to(td::Slice data, td::MutableSlice to);
+
  public:
   ~DecryptorAES() override {
     shared_secret_.set_zero_s();
   }
   td::Result<td::BufferSlice> decrypt(td::Slice data) override;
+  td::Result<td::BufferSlice> decrypt_in_place(td::BufferSlice data) override;
   td::Result<td::BufferSlice> sign(td::Slice data) override {
     return td::Status::Error("can no sign channel messages");
   }
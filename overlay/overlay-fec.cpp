@@ -25,52 +25,130 @@ namespace ton {
 namespace overlay {
 
 void OverlayOutboundFecBroadcast::alarm() {
-  for (td::uint32 i = 0; i < 4; i++) {
-    auto X = encoder_->gen_symbol(seqno_++);
+  for (td::uint32 i = 0; i < symbols_per_alarm() && !ready_symbols_.empty(); i++) {
+    auto X = std::move(ready_symbols_.front());
+    ready_symbols_.pop_front();
     CHECK(X.data.size() <= 1000);
     td::actor::send_closure(overlay_, &OverlayImpl::send_new_fec_broadcast_part, local_id_, data_hash_,
                             fec_type_.size(), flags_, std::move(X.data), X.id, fec_type_, date_);
+    seqno_++;
   }
 
-  alarm_timestamp() = td::Timestamp::in(delay_);
-
   if (seqno_ >= to_send_) {
     stop();
+    return;
   }
+  generate_symbols();
+  alarm_timestamp() = td::Timestamp::in(delay_);
 }
 
 void OverlayOutboundFecBroadcast::start_up() {
-  encoder_->prepare_more_symbols();
-  alarm();
+  data_hash_ = td::sha256_bits256(data_);
+  td::actor::send_closure(manager_, &OverlayManager::get_fec_encoder, data_hash_, symbol_size_, std::move(data_),
+                          [SelfId = actor_id(this)](td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R) {
+                            td::actor::send_closure(SelfId, &OverlayOutboundFecBroadcast::got_encoder, std::move(R));
+                          });
+}
+
+void OverlayOutboundFecBroadcast::got_encoder(td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R) {
+  if (R.is_error()) {
+    LOG(WARNING) << "failed to create fec encoder: " << R.move_as_error();
+    stop();
+    return;
+  }
+  encoder_ = R.move_as_ok();
+  generate_symbols();
+}
+
+void OverlayOutboundFecBroadcast::generate_symbols() {
+  if (gen_pending_ > 0 || next_gen_seqno_ >= to_send_ || ready_symbols_.size() >= gen_batch_size() / 2) {
+    return;
+  }
+  td::uint32 count = std::min(gen_batch_size(), to_send_ - next_gen_seqno_);
+  size_t parts = (count + gen_part_size() - 1) / gen_part_size();
+  gen_parts_.clear();
+  gen_parts_.resize(parts);
+  gen_pending_ = parts;
+  for (size_t i = 0; i < parts; i++) {
+    td::uint32 first = next_gen_seqno_ + static_cast<td::uint32>(i) * gen_part_size();
+    td::uint32 part_size = std::min(gen_part_size(), next_gen_seqno_ + count - first);
+    td::actor::create_actor<OverlayFecSymbolGenerator>(
+        "bcastgen", encoder_, first, part_size,
+        [SelfId = actor_id(this), i, part_size](td::Result<std::vector<td::fec::Symbol>> R) {
+          td::actor::send_closure(SelfId, &OverlayOutboundFecBroadcast::got_symbols, i, part_size, std::move(R));
+        })
+        .release();
+  }
+  next_gen_seqno_ += count;
+}
+
+void OverlayOutboundFecBroadcast::got_symbols(size_t part, td::uint32 part_size,
+                                              td::Result<std::vector<td::fec::Symbol>> R) {
+  CHECK(part < gen_parts_.size());
+  if (R.is_error()) {
+    // The symbols of the failed part are skipped, they are counted as sent so that the broadcast still finishes
+    LOG(WARNING) << "failed to generate fec symbols: " << R.move_as_error();
+    seqno_ += part_size;
+  } else {
+    gen_parts_[part] = R.move_as_ok();
+  }
+  if (--gen_pending_ > 0) {
+    return;
+  }
+  for (auto &v : gen_parts_) {
+    for (auto &X : v) {
+      ready_symbols_.push_back(std::move(X));
+    }
+  }
+  gen_parts_.clear();
+  if (!alarm_timestamp()) {
+    alarm();
+  }
 }
 
 OverlayOutboundFecBroadcast::OverlayOutboundFecBroadcast(td::BufferSlice data, td::uint32 flags,
                                                          td::actor::ActorId<OverlayImpl> overlay,
+                                                         td::actor::ActorId<OverlayManager> manager,
                                                          PublicKeyHash local_id, double speed_multiplier)
     : flags_(flags) {
   delay_ /= speed_multiplier;
   CHECK(data.size() <= (1 << 27));
   local_id_ = local_id;
   overlay_ = std::move(overlay);
+  manager_ = std::move(manager);
   date_ = static_cast<td::int32>(td::Clocks::system());
   to_send_ = (static_cast<td::uint32>(data.size()) / symbol_size_ + 1) * 2;
 
-  data_hash_ = td::sha256_bits256(data);
-
   fec_type_ = td::fec::RaptorQEncoder::Parameters{data.size(), symbol_size_, 0};
-  auto E = fec_type_.create_encoder(std::move(data));
-  E.ensure();
-  encoder_ = E.move_as_ok();
+  data_ = std::move(data);
 }
 
 td::actor::ActorId<OverlayOutboundFecBroadcast> OverlayOutboundFecBroadcast::create(
-    td::BufferSlice data, td::uint32 flags, td::actor::ActorId<OverlayImpl> overlay, PublicKeyHash local_id,
-    double speed_multiplier) {
-  return td::actor::create_actor<OverlayOutboundFecBroadcast>(
-             td::actor::ActorOptions().with_name("bcast"), std::move(data), flags, overlay, local_id, speed_multiplier)
+    td::BufferSlice data, td::uint32 flags, td::actor::ActorId<OverlayImpl> overlay,
+    td::actor::ActorId<OverlayManager> manager, PublicKeyHash local_id, double speed_multiplier) {
+  return td::actor::create_actor<OverlayOutboundFecBroadcast>(td::actor::ActorOptions().with_name("bcast"),
+                                                              std::move(data), flags, overlay, manager, local_id,
+                                                              speed_multiplier)
       .release();
 }
 
+void OverlayFecEncoderPrecalc::start_up() {
+  std::shared_ptr<td::fec::RaptorQEncoder> encoder = td::fec::RaptorQEncoder::create(std::move(data_), symbol_size_);
+  encoder->prepare_more_symbols();
+  promise_.set_value(std::move(encoder));
+  stop();
+}
+
+void OverlayFecSymbolGenerator::start_up() {
+  std::vector<td::fec::Symbol> res;
+  res.reserve(count_);
+  for (td::uint32 i = 0; i < count_; i++) {
+    res.push_back(encoder_->gen_symbol(first_seqno_ + i));
+  }
+  promise_.set_value(std::move(res));
+  stop();
+}
+
 }  // namespace overlay
 
 }  // namespace ton
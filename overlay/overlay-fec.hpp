@@ -22,6 +22,8 @@
 #include "fec/fec.h"
 #include "overlay.h"
 
+#include <deque>
+
 namespace ton {
 
 namespace overlay {
@@ -39,21 +41,78 @@ class OverlayOutboundFecBroadcast : public td::actor::Actor {
   td::uint32 flags_ = 0;
   double delay_ = 0.010;
   td::int32 date_;
-  std::unique_ptr<td::fec::Encoder> encoder_;
+  td::BufferSlice data_;
+  std::shared_ptr<td::fec::RaptorQEncoder> encoder_;
   td::actor::ActorId<OverlayImpl> overlay_;
+  td::actor::ActorId<OverlayManager> manager_;
   fec::FecType fec_type_;
 
+  // Symbols are generated ahead in batches, each batch is split between several generators
+  std::deque<td::fec::Symbol> ready_symbols_;
+  td::uint32 next_gen_seqno_ = 0;
+  std::vector<std::vector<td::fec::Symbol>> gen_parts_;
+  size_t gen_pending_ = 0;
+
+  static constexpr td::uint32 symbols_per_alarm() {
+    return 4;
+  }
+  static constexpr td::uint32 gen_batch_size() {
+    return 256;
+  }
+  static constexpr td::uint32 gen_part_size() {
+    return 64;
+  }
+
+  void got_encoder(td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R);
+  void generate_symbols();
+  void got_symbols(size_t part, td::uint32 part_size, td::Result<std::vector<td::fec::Symbol>> R);
+
  public:
   static td::actor::ActorId<OverlayOutboundFecBroadcast> create(td::BufferSlice data, td::uint32 flags,
                                                                 td::actor::ActorId<OverlayImpl> overlay,
+                                                                td::actor::ActorId<OverlayManager> manager,
                                                                 PublicKeyHash local_id, double speed_multiplier = 1.0);
   OverlayOutboundFecBroadcast(td::BufferSlice data, td::uint32 flags, td::actor::ActorId<OverlayImpl> overlay,
-                              PublicKeyHash local_id, double speed_multiplier = 1.0);
+                              td::actor::ActorId<OverlayManager> manager, PublicKeyHash local_id,
+                              double speed_multiplier = 1.0);
 
   void alarm() override;
   void start_up() override;
 };
 
+// Creates a RaptorQ encoder and runs its precalculation
+class OverlayFecEncoderPrecalc : public td::actor::Actor {
+ public:
+  OverlayFecEncoderPrecalc(td::BufferSlice data, td::uint32 symbol_size,
+                           td::Promise<std::shared_ptr<td::fec::RaptorQEncoder>> promise)
+      : data_(std::move(data)), symbol_size_(symbol_size), promise_(std::move(promise)) {
+  }
+
+  void start_up() override;
+
+ private:
+  td::BufferSlice data_;
+  td::uint32 symbol_size_;
+  td::Promise<std::shared_ptr<td::fec::RaptorQEncoder>> promise_;
+};
+
+// Generates symbols [first_seqno, first_seqno + count) of a prepared encoder
+class OverlayFecSymbolGenerator : public td::actor::Actor {
+ public:
+  OverlayFecSymbolGenerator(std::shared_ptr<td::fec::RaptorQEncoder> encoder, td::uint32 first_seqno,
+                            td::uint32 count, td::Promise<std::vector<td::fec::Symbol>> promise)
+      : encoder_(std::move(encoder)), first_seqno_(first_seqno), count_(count), promise_(std::move(promise)) {
+  }
+
+  void start_up() override;
+
+ private:
+  std::shared_ptr<td::fec::RaptorQEncoder> encoder_;
+  td::uint32 first_seqno_;
+  td::uint32 count_;
+  td::Promise<std::vector<td::fec::Symbol>> promise_;
+};
+
 }  // namespace overlay
 
 }  // namespace ton
@@ -20,6 +20,7 @@
 #include "auto/tl/ton_api.h"
 #include "auto/tl/ton_api.hpp"
 #include "overlay.h"
+#include "overlay-fec.hpp"
 
 #include "adnl/utils.hpp"
 #include "td/actor/actor.h"
@@ -428,6 +429,81 @@ void OverlayManager::start_up() {
   }
 }
 
+void OverlayManager::get_fec_encoder(td::Bits256 data_hash, td::uint32 symbol_size, td::BufferSlice data,
+                                     td::Promise<std::shared_ptr<td::fec::RaptorQEncoder>> promise) {
+  FecEncoderKey key{data_hash, symbol_size};
+  auto it = fec_encoders_.find(key);
+  if (it != fec_encoders_.end()) {
+    it->second.expire_at = td::Timestamp::in(fec_encoder_ttl());
+    if (it->second.encoder) {
+      promise.set_value(std::shared_ptr<td::fec::RaptorQEncoder>(it->second.encoder));
+    } else {
+      it->second.promises.push_back(std::move(promise));
+    }
+    return;
+  }
+  if (fec_encoders_.size() >= max_fec_encoders()) {
+    auto to_erase = fec_encoders_.end();
+    for (auto it2 = fec_encoders_.begin(); it2 != fec_encoders_.end(); ++it2) {
+      if (it2->second.encoder && (to_erase == fec_encoders_.end() ||
+                                  it2->second.expire_at.at() < to_erase->second.expire_at.at())) {
+        to_erase = it2;
+      }
+    }
+    if (to_erase == fec_encoders_.end()) {
+      // All cached encoders are still being calculated: the cache does not grow, this encoder is not shared
+      td::actor::create_actor<OverlayFecEncoderPrecalc>("fecprecalc", std::move(data), symbol_size, std::move(promise))
+          .release();
+      return;
+    }
+    fec_encoders_.erase(to_erase);
+  }
+  auto &entry = fec_encoders_[key];
+  entry.expire_at = td::Timestamp::in(fec_encoder_ttl());
+  entry.promises.push_back(std::move(promise));
+  td::actor::create_actor<OverlayFecEncoderPrecalc>(
+      "fecprecalc", std::move(data), symbol_size,
+      [SelfId = actor_id(this), key](td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R) {
+        td::actor::send_closure(SelfId, &OverlayManager::got_fec_encoder, key, std::move(R));
+      })
+      .release();
+}
+
+void OverlayManager::got_fec_encoder(FecEncoderKey key, td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R) {
+  auto it = fec_encoders_.find(key);
+  if (it == fec_encoders_.end()) {
+    return;
+  }
+  auto promises = std::move(it->second.promises);
+  if (R.is_error()) {
+    fec_encoders_.erase(it);
+    for (auto &promise : promises) {
+      promise.set_error(R.error().clone());
+    }
+    return;
+  }
+  it->second.encoder = R.move_as_ok();
+  it->second.expire_at = td::Timestamp::in(fec_encoder_ttl());
+  alarm_timestamp().relax(it->second.expire_at);
+  for (auto &promise : promises) {
+    promise.set_value(std::shared_ptr<td::fec::RaptorQEncoder>(it->second.encoder));
+  }
+}
+
+void OverlayManager::alarm() {
+  for (auto it = fec_encoders_.begin(); it != fec_encoders_.end();) {
+    if (!it->second.encoder) {
+      // Precalculation is not finished yet
+      ++it;
+    } else if (it->second.expire_at.is_in_past()) {
+      it = fec_encoders_.erase(it);
+    } else {
+      alarm_timestamp().relax(it->second.expire_at);
+      ++it;
+    }
+  }
+}
+
 void OverlayManager::save_to_db(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay_id,
                                 std::vector<OverlayNode> nodes) {
   if (!with_db_) {
@@ -29,6 +29,12 @@
 #include "overlays.h"
 #include "overlay-id.hpp"
 
+namespace td {
+namespace fec {
+class RaptorQEncoder;
+}  // namespace fec
+}  // namespace td
+
 namespace ton {
 
 namespace overlay {
@@ -111,6 +117,12 @@ class OverlayManager : public Overlays {
 
   void forget_peer(adnl::AdnlNodeIdShort local_id, OverlayIdShort overlay, adnl::AdnlNodeIdShort peer_id) override;
 
+  // Returns a precalculated RaptorQ encoder for an outbound fec broadcast. Encoders are shared between overlays,
+  // so the same data sent to several overlays is encoded only once
+  void get_fec_encoder(td::Bits256 data_hash, td::uint32 symbol_size, td::BufferSlice data,
+                       td::Promise<std::shared_ptr<td::fec::RaptorQEncoder>> promise);
+  void alarm() override;
+
   struct PrintId {};
 
   PrintId print_id() const {
@@ -134,6 +146,22 @@ class OverlayManager : public Overlays {
   bool with_db_ = false;
   DbType db_;
 
+  using FecEncoderKey = std::pair<td::Bits256, td::uint32>;
+  struct FecEncoder {
+    std::shared_ptr<td::fec::RaptorQEncoder> encoder;
+    std::vector<td::Promise<std::shared_ptr<td::fec::RaptorQEncoder>>> promises;
+    td::Timestamp expire_at;
+  };
+  std::map<FecEncoderKey, FecEncoder> fec_encoders_;
+
+  static constexpr double fec_encoder_ttl() {
+    return 30.0;
+  }
+  static constexpr size_t max_fec_encoders() {
+    return 16;
+  }
+  void got_fec_encoder(FecEncoderKey key, td::Result<std::shared_ptr<td::fec::RaptorQEncoder>> R);
+
   class AdnlCallback : public adnl::Adnl::Callback {
    public:
     void receive_message(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::BufferSlice data) override {
@@ -491,7 +491,7 @@ void OverlayImpl::send_broadcast_fec(PublicKeyHash send_as, td::uint32 flags, td
     VLOG(OVERLAY_WARNING) << "broadcast source certificate is invalid";
     return;
   }
-  OverlayOutboundFecBroadcast::create(std::move(data), flags, actor_id(this), send_as,
+  OverlayOutboundFecBroadcast::create(std::move(data), flags, actor_id(this), manager_, send_as,
                                       opts_.broadcast_speed_multiplier_);
 }
 
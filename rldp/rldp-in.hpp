@@ -93,6 +93,8 @@ class RldpIn : public RldpImpl {
                        ton_api::rldp_query &message);
   void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                        ton_api::rldp_answer &message);
+  void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                       ton_api::rldp_queryStriped &message);
   void receive_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                        td::BufferSlice data);
 
@@ -223,6 +223,12 @@ void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort
   }
 }
 
+void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                             ton_api::rldp_queryStriped &message) {
+  // Striped queries are sent only over RLDP2
+  VLOG(RLDP_INFO) << "dropping striped query " << message.query_id_ << " from " << source;
+}
+
 void RldpIn::transfer_completed(TransferId transfer_id) {
   senders_.erase(transfer_id);
   VLOG(RLDP_DEBUG) << "rldp: completed transfer " << transfer_id << "; " << senders_.size() << " out transfer pending ";
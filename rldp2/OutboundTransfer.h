@@ -26,6 +26,30 @@
 
 namespace ton {
 namespace rldp2 {
+// One of several senders of the same data. The sender of stripe k out of n sends symbols k, k + n, k + 2n, ...
+// of each part, so the receiver may decode a part from any mix of symbols received from different senders.
+// Acks still use contiguous per-sender seqnos, so each sender runs its own congestion control.
+struct Stripe {
+  td::uint32 index{0};
+  td::uint32 count{1};
+
+  static constexpr td::uint32 max_count() {
+    return 16;
+  }
+  bool is_valid() const {
+    return count >= 1 && count <= max_count() && index < count;
+  }
+  td::uint32 symbol_id(td::uint32 seqno) const {
+    return seqno * count + index;
+  }
+  bool has_symbol(td::uint32 symbol_id) const {
+    return symbol_id % count == index;
+  }
+  td::uint32 seqno(td::uint32 symbol_id) const {
+    return symbol_id / count;
+  }
+};
+
 struct OutboundTransfer {
  public:
   struct Part {
@@ -34,10 +58,13 @@ struct OutboundTransfer {
     ton::fec::FecType fec_type;
   };
 
-  OutboundTransfer(td::BufferSlice data) : data_(std::move(data)) {
+  explicit OutboundTransfer(td::BufferSlice data, Stripe stripe = {}) : data_(std::move(data)), stripe_(stripe) {
   }
 
   size_t total_size() const;
+  const Stripe &stripe() const {
+    return stripe_;
+  }
   std::map<td::uint32, Part> &parts(const RldpSender::Config &config);
   void drop_part(td::uint32 part_i);
   Part *get_part(td::uint32 part_i);
@@ -45,6 +72,7 @@ struct OutboundTransfer {
 
  private:
   td::BufferSlice data_;
+  Stripe stripe_;
   std::map<td::uint32, Part> parts_;
   td::uint32 next_part_{0};
 
@@ -32,6 +32,8 @@
 
 #include "td/actor//actor.h"
 
+#include <tuple>
+
 namespace ton {
 namespace rldp2 {
 void RldpConnection::add_limit(td::Timestamp timeout, Limit limit) {
@@ -61,6 +63,7 @@ void RldpConnection::drop_limits(TransferId id) {
 
 void RldpConnection::on_inbound_completed(TransferId transfer_id, td::Timestamp now) {
   inbound_transfers_.erase(transfer_id);
+  striped_inbound_transfers_.erase(transfer_id);
   completed_set_.insert(transfer_id);
   completed_queue_.push(CompletedId{transfer_id, now.in(20)});
   while (completed_queue_.size() > 128 && completed_queue_.front().timeout.is_in_past(now)) {
@@ -73,8 +76,12 @@ td::Timestamp RldpConnection::loop_limits(td::Timestamp now) {
     auto *limit = static_cast<Limit *>(limits_heap_.pop());
     auto error = td::Status::Error(ErrorCode::timeout, "timeout");
     if (limit->is_inbound) {
+      // Striped transfers are timed out by the caller, which decodes them
+      bool is_striped = striped_inbound_transfers_.count(limit->transfer_id) > 0;
       on_inbound_completed(limit->transfer_id, now);
-      to_receive_.emplace_back(limit->transfer_id, std::move(error));
+      if (!is_striped) {
+        to_receive_.emplace_back(limit->transfer_id, std::move(error));
+      }
     } else {
       auto it = outbound_transfers_.find(limit->transfer_id);
       if (it != outbound_transfers_.end()) {
@@ -102,6 +109,30 @@ void RldpConnection::set_receive_limits(TransferId transfer_id, td::Timestamp ti
   add_limit(timeout, limit);
 }
 
+void RldpConnection::set_receive_stripe(TransferId transfer_id, Stripe stripe) {
+  CHECK(stripe.is_valid());
+  striped_inbound_transfers_[transfer_id].stripe = stripe;
+}
+
+void RldpConnection::on_striped_part_decoded(TransferId transfer_id, td::uint32 part_i) {
+  auto it = striped_inbound_transfers_.find(transfer_id);
+  if (it == striped_inbound_transfers_.end()) {
+    return;
+  }
+  it->second.parts.erase(part_i);
+  if (it->second.decoded_parts.insert(part_i).second) {
+    send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_complete>(transfer_id, part_i));
+  }
+}
+
+void RldpConnection::finish_striped(TransferId transfer_id) {
+  if (striped_inbound_transfers_.count(transfer_id) == 0) {
+    return;
+  }
+  drop_limits(transfer_id);
+  on_inbound_completed(transfer_id, td::Timestamp::now());
+}
+
 RldpConnection::RldpConnection() {
   bdw_stats_.on_update(td::Timestamp::now(), 0);
 
@@ -109,7 +140,7 @@ RldpConnection::RldpConnection() {
   bdw_stats_.windowed_max_bdw = 10;
 }
 
-void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Timestamp timeout) {
+void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Timestamp timeout, Stripe stripe) {
   if (transfer_id.is_zero()) {
     td::Random::secure_bytes(transfer_id.as_slice());
   } else {
@@ -126,7 +157,7 @@ void RldpConnection::send(TransferId transfer_id, td::BufferSlice data, td::Time
     limit.is_inbound = false;
     add_limit(timeout, limit);
   }
-  outbound_transfers_.emplace(transfer_id, OutboundTransfer{std::move(data)});
+  outbound_transfers_.emplace(transfer_id, OutboundTransfer{std::move(data), stripe});
 }
 
 void RldpConnection::receive_raw(td::BufferSlice packet) {
@@ -177,12 +208,29 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
   for (auto &inbound : inbound_transfers_) {
     alarm_timestamp.relax(run(inbound.first, inbound.second));
   }
+  for (auto &striped : striped_inbound_transfers_) {
+    for (auto &part : striped.second.parts) {
+      alarm_timestamp.relax(run(striped.first, part.first, part.second));
+    }
+  }
 
   alarm_timestamp.relax(loop_limits(td::Timestamp::now()));
 
+  // The callback may complete striped transfers, so symbols are taken out before it is called
+  std::vector<std::tuple<TransferId, td::uint64, std::vector<StripedSymbol>>> to_receive_striped;
+  for (auto &striped : striped_inbound_transfers_) {
+    if (!striped.second.received.empty()) {
+      to_receive_striped.emplace_back(striped.first, striped.second.total_size, std::move(striped.second.received));
+      striped.second.received.clear();
+    }
+  }
+
   for (auto &data : to_receive_) {
     callback.receive(data.first, std::move(data.second));
   }
+  for (auto &striped : to_receive_striped) {
+    callback.receive_striped(std::get<0>(striped), std::get<1>(striped), std::move(std::get<2>(striped)));
+  }
   for (auto &raw : to_send_raw_) {
     callback.send_raw(std::move(raw));
   }
@@ -197,22 +245,27 @@ td::Timestamp RldpConnection::run(ConnectionCallback &callback) {
 }
 
 td::Timestamp RldpConnection::run(const TransferId &transfer_id, InboundTransfer &inbound) {
+  td::Timestamp wakeup_at;
+  for (auto &it : inbound.parts()) {
+    wakeup_at.relax(run(transfer_id, it.first, it.second.receiver));
+  }
+  return wakeup_at;
+}
+
+td::Timestamp RldpConnection::run(const TransferId &transfer_id, td::uint32 part_i, RldpReceiver &receiver) {
   td::Timestamp wakeup_at;
   bool has_actions = true;
   while (has_actions) {
     has_actions = false;
-    for (auto &it : inbound.parts()) {
-      auto &inbound = it.second;
-      inbound.receiver.next_action(td::Timestamp::now())
-          .visit(td::overloaded([&](const RldpReceiver::ActionWait &wait) { wakeup_at.relax(wait.wait_till); },
-                                [&](const RldpReceiver::ActionSendAck &send) {
-                                  send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_confirm>(
-                                      transfer_id, it.first, send.ack.max_seqno, send.ack.received_mask,
-                                      send.ack.received_count));
-                                  inbound.receiver.on_ack_sent(td::Timestamp::now());
-                                  has_actions = true;
-                                }));
-    }
+    receiver.next_action(td::Timestamp::now())
+        .visit(td::overloaded([&](const RldpReceiver::ActionWait &wait) { wakeup_at.relax(wait.wait_till); },
+                              [&](const RldpReceiver::ActionSendAck &send) {
+                                send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_confirm>(
+                                    transfer_id, part_i, send.ack.max_seqno, send.ack.received_mask,
+                                    send.ack.received_count));
+                                receiver.on_ack_sent(td::Timestamp::now());
+                                has_actions = true;
+                              }));
   }
   return wakeup_at;
 }
@@ -236,13 +289,13 @@ td::optional<td::Timestamp> RldpConnection::step(const TransferId &transfer_id,
     bool was_send = false;
     action.visit(td::overloaded(
         [&](const RldpSender::ActionSend &send) {
-          auto seqno = send.seqno - 1;
-          if (part.encoder->get_info().ready_symbol_count <= seqno) {
+          auto symbol_id = outbound.stripe().symbol_id(send.seqno - 1);
+          if (part.encoder->get_info().ready_symbol_count <= symbol_id) {
             part.encoder->prepare_more_symbols();
           }
-          auto symbol = part.encoder->gen_symbol(seqno).data;
+          auto symbol = part.encoder->gen_symbol(symbol_id).data;
           send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_messagePart>(
-              transfer_id, part.fec_type.tl(), it.first, outbound.total_size(), seqno, std::move(symbol)));
+              transfer_id, part.fec_type.tl(), it.first, outbound.total_size(), symbol_id, std::move(symbol)));
           if (!send.is_probe) {
             pacer_.send(1, now);
           }
@@ -298,6 +351,12 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
     return;
   }
 
+  auto striped_it = striped_inbound_transfers_.find(transfer_id);
+  if (striped_it != striped_inbound_transfers_.end()) {
+    receive_striped_part(transfer_id, striped_it->second, part, total_size, r_fec_type.move_as_ok());
+    return;
+  }
+
   auto it = inbound_transfers_.find(transfer_id);
   if (it == inbound_transfers_.end()) {
     if (!has_limit) {
@@ -337,6 +396,37 @@ void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_messagePart &part) {
   }
 }
 
+void RldpConnection::receive_striped_part(const TransferId &transfer_id, StripedInboundTransfer &striped,
+                                          ton::ton_api::rldp2_messagePart &part, td::uint64 total_size,
+                                          ton::fec::FecType fec_type) {
+  auto symbol_id = static_cast<td::uint32>(part.seqno_);
+  if (part.seqno_ < 0 || part.part_ < 0 || !striped.stripe.has_symbol(symbol_id)) {
+    return;
+  }
+  auto part_i = static_cast<td::uint32>(part.part_);
+  if (striped.decoded_parts.count(part_i) > 0) {
+    send_packet(ton::create_serialize_tl_object<ton::ton_api::rldp2_complete>(transfer_id, part_i));
+    return;
+  }
+  if (striped.total_size == 0) {
+    striped.total_size = total_size;
+  } else if (striped.total_size != total_size) {
+    return;
+  }
+  auto it = striped.parts.find(part_i);
+  if (it == striped.parts.end()) {
+    // Parts are opened in order, same as in InboundTransfer::get_part, so that the decoder accepts every acked symbol
+    if (part_i != striped.next_part || striped.parts.size() >= 20) {
+      return;
+    }
+    striped.next_part++;
+    it = striped.parts.emplace(part_i, RldpReceiver(RldpSender::Config())).first;
+  }
+  if (it->second.on_received(striped.stripe.seqno(symbol_id) + 1, td::Timestamp::now())) {
+    striped.received.push_back(StripedSymbol{part_i, std::move(fec_type), {symbol_id, std::move(part.data_)}});
+  }
+}
+
 void RldpConnection::receive_raw_obj(ton::ton_api::rldp2_complete &complete) {
   auto transfer_id = complete.transfer_id_;
   auto it = outbound_transfers_.find(transfer_id);
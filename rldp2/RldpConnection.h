@@ -37,6 +37,13 @@
 namespace ton {
 namespace rldp2 {
 using TransferId = td::Bits256;
+
+struct StripedSymbol {
+  td::uint32 part;
+  ton::fec::FecType fec_type;
+  td::fec::Symbol symbol;
+};
+
 class ConnectionCallback {
  public:
   virtual ~ConnectionCallback() {
@@ -44,6 +51,9 @@ class ConnectionCallback {
   virtual void send_raw(td::BufferSlice small_datagram) = 0;
   virtual void receive(TransferId transfer_id, td::Result<td::BufferSlice> r_data) = 0;
   virtual void on_sent(TransferId transfer_id, td::Result<td::Unit> state) = 0;
+  // New symbols of a striped inbound transfer. They are decoded by the caller together with the other stripes
+  virtual void receive_striped(TransferId transfer_id, td::uint64 total_size, std::vector<StripedSymbol> symbols) {
+  }
 };
 
 class RldpConnection {
@@ -51,8 +61,13 @@ class RldpConnection {
   RldpConnection();
   RldpConnection(RldpConnection &&other) = delete;
   RldpConnection &operator=(RldpConnection &&other) = delete;
-  void send(TransferId tranfer_id, td::BufferSlice data, td::Timestamp timeout = td::Timestamp::never());
+  void send(TransferId tranfer_id, td::BufferSlice data, td::Timestamp timeout = td::Timestamp::never(),
+            Stripe stripe = {});
   void set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size);
+  // Symbols of the inbound transfer are acked, but not decoded: they are passed to ConnectionCallback::receive_striped
+  void set_receive_stripe(TransferId transfer_id, Stripe stripe);
+  void on_striped_part_decoded(TransferId transfer_id, td::uint32 part_i);
+  void finish_striped(TransferId transfer_id);
 
   void receive_raw(td::BufferSlice packet);
 
@@ -72,6 +87,16 @@ class RldpConnection {
   td::uint32 in_flight_count_{0};
   std::map<TransferId, InboundTransfer> inbound_transfers_;
 
+  struct StripedInboundTransfer {
+    Stripe stripe;
+    td::uint64 total_size{0};
+    td::uint32 next_part{0};
+    std::map<td::uint32, RldpReceiver> parts;
+    std::set<td::uint32> decoded_parts;
+    std::vector<StripedSymbol> received;
+  };
+  std::map<TransferId, StripedInboundTransfer> striped_inbound_transfers_;
+
   struct Limit : public td::HeapNode {
     TransferId transfer_id;
     td::uint64 max_size;
@@ -114,6 +139,7 @@ class RldpConnection {
   };
 
   td::Timestamp run(const TransferId &transfer_id, InboundTransfer &inbound);
+  td::Timestamp run(const TransferId &transfer_id, td::uint32 part_i, RldpReceiver &receiver);
   struct Guard {
     td::uint32 &in_flight_count;
     const RldpSender &sender;
@@ -129,6 +155,8 @@ class RldpConnection {
   td::optional<td::Timestamp> step(const TransferId &transfer_id, OutboundTransfer &outbound, td::Timestamp now);
 
   void receive_raw_obj(ton::ton_api::rldp2_messagePart &part);
+  void receive_striped_part(const TransferId &transfer_id, StripedInboundTransfer &striped,
+                            ton::ton_api::rldp2_messagePart &part, td::uint64 total_size, ton::fec::FecType fec_type);
 
   void receive_raw_obj(ton::ton_api::rldp2_complete &part);
 
@@ -0,0 +1,324 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "adnl/adnl-network-simulator.h"
+#include "adnl/adnl-test-loopback-implementation.h"
+#include "adnl/adnl.h"
+#include "keyring/keyring.h"
+#include "rldp2/rldp.h"
+
+#include "td/fec/fec.h"
+#include "td/utils/format.h"
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+using ton::adnl::AdnlNodeIdShort;
+using ton::adnl::SimulatedLink;
+using ton::adnl::SimulatedLinkProfile;
+using ton::adnl::SimulatedNetworkManager;
+using ton::adnl::SimulatedPacketQueue;
+
+struct Percentiles {
+  double p50, p90, p99;
+};
+
+Percentiles get_percentiles(std::vector<double> v) {
+  CHECK(!v.empty());
+  std::sort(v.begin(), v.end());
+  auto get = [&](double p) { return v[std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())))]; };
+  return {get(0.5), get(0.9), get(0.99)};
+}
+
+td::StringBuilder &operator<<(td::StringBuilder &sb, const Percentiles &p) {
+  return sb << "p50=" << td::format::as_time(p.p50) << " p90=" << td::format::as_time(p.p90)
+            << " p99=" << td::format::as_time(p.p99);
+}
+
+// Adnl and Rldp actors over SimulatedNetworkManager. The scheduler skips timeouts: when no actor has work, the clock
+// jumps to the nearest alarm (a packet delivery or an RLDP2 timer) instead of sleeping, so seconds of simulated
+// transfer take only the CPU time needed to process them. That CPU time still passes on the same clock, so the
+// results repeat up to it. Keys are derived from the seed, and so are the links between them
+class RldpSimulation {
+ public:
+  RldpSimulation(std::string db_root, td::uint64 seed)
+      : db_root_(std::move(db_root)), rnd_(seed), scheduler_({0}, true) {
+    td::rmrf(db_root_).ignore();
+    td::mkdir(db_root_).ensure();
+    scheduler_.run_in_context([&] {
+      keyring_ = ton::keyring::Keyring::create(db_root_);
+      network_ = td::actor::create_actor<SimulatedNetworkManager>("simulated net", seed);
+      adnl_ = ton::adnl::Adnl::create(db_root_, keyring_.get());
+      rldp_ = ton::rldp2::Rldp::create(adnl_.get());
+      td::actor::send_closure(adnl_, &ton::adnl::Adnl::register_network_manager, network_.get());
+    });
+  }
+
+  struct Result {
+    std::vector<double> times;
+    td::uint64 sent_bytes;
+  };
+
+  // Transfers answers of `size` bytes from `stripes` peers holding the same data. Each scenario uses new nodes,
+  // so their links get the current profile
+  td::Result<Result> run(SimulatedLinkProfile profile, size_t stripes, size_t transfers, size_t size) {
+    td::BufferSlice answer(size);
+    rnd_.bytes(answer.as_slice());
+    AdnlNodeIdShort src;
+    std::vector<AdnlNodeIdShort> dsts;
+    scheduler_.run_in_context([&] {
+      td::actor::send_closure(network_, &SimulatedNetworkManager::set_default_profile, profile);
+      src = add_node().compute_short_id();
+      for (size_t i = 0; i < stripes; i++) {
+        auto full_id = add_node();
+        auto id = full_id.compute_short_id();
+        td::actor::send_closure(adnl_, &ton::adnl::Adnl::add_peer, src, full_id, addr_list_);
+        td::actor::send_closure(adnl_, &ton::adnl::Adnl::subscribe, id, "bench",
+                                std::make_unique<Server>(answer.clone()));
+        dsts.push_back(id);
+      }
+    });
+
+    Result res;
+    for (size_t i = 0; i < transfers; i++) {
+      td::optional<td::Result<td::BufferSlice>> r_answer;
+      auto start = td::Time::now();
+      scheduler_.run_in_context([&] {
+        auto promise = td::PromiseCreator::lambda([&](td::Result<td::BufferSlice> R) { r_answer = std::move(R); });
+        auto timeout = td::Timestamp::in(600.0);
+        if (stripes == 1) {
+          td::actor::send_closure(rldp_, &ton::rldp2::Rldp::send_query_ex, src, dsts[0], "bench", std::move(promise),
+                                  timeout, td::BufferSlice("bench"), size + 1024);
+        } else {
+          td::actor::send_closure(rldp_, &ton::rldp2::Rldp::send_query_multipath, src, dsts, "bench",
+                                  std::move(promise), timeout, td::BufferSlice("bench"), size + 1024);
+        }
+      });
+      run_until([&] { return bool(r_answer); });
+      TRY_RESULT(received, r_answer.unwrap());
+      if (received.as_slice() != answer.as_slice()) {
+        return td::Status::Error("data mismatch");
+      }
+      res.times.push_back(td::Time::now() - start);
+    }
+
+    res.sent_bytes = 0;
+    size_t pending = dsts.size();
+    scheduler_.run_in_context([&] {
+      for (auto &id : dsts) {
+        td::actor::send_closure(network_, &SimulatedNetworkManager::get_link_stats, id, src,
+                                td::PromiseCreator::lambda([&](td::Result<SimulatedLink::Stats> R) {
+                                  res.sent_bytes += R.ok().bytes;
+                                  pending--;
+                                }));
+      }
+    });
+    run_until([&] { return pending == 0; });
+    return res;
+  }
+
+  void close() {
+    td::rmrf(db_root_).ignore();
+  }
+
+ private:
+  class Server : public ton::adnl::Adnl::Callback {
+   public:
+    explicit Server(td::BufferSlice answer) : answer_(std::move(answer)) {
+    }
+    void receive_message(AdnlNodeIdShort src, AdnlNodeIdShort dst, td::BufferSlice data) override {
+    }
+    void receive_query(AdnlNodeIdShort src, AdnlNodeIdShort dst, td::BufferSlice data,
+                       td::Promise<td::BufferSlice> promise) override {
+      promise.set_value(answer_.clone());
+    }
+
+   private:
+    td::BufferSlice answer_;
+  };
+
+  std::string db_root_;
+  td::Random::Xorshift128plus rnd_;
+  td::actor::Scheduler scheduler_;
+  td::actor::ActorOwn<ton::keyring::Keyring> keyring_;
+  td::actor::ActorOwn<SimulatedNetworkManager> network_;
+  td::actor::ActorOwn<ton::adnl::Adnl> adnl_;
+  td::actor::ActorOwn<ton::rldp2::Rldp> rldp_;
+  ton::adnl::AdnlAddressList addr_list_ = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
+
+  ton::adnl::AdnlNodeIdFull add_node() {
+    td::Bits256 key;
+    rnd_.bytes(key.as_slice());
+    auto pk = ton::PrivateKey{ton::privkeys::Ed25519{key}};
+    auto full_id = ton::adnl::AdnlNodeIdFull{pk.compute_public_key()};
+    td::actor::send_closure(keyring_, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
+    td::actor::send_closure(adnl_, &ton::adnl::Adnl::add_id, full_id, addr_list_, td::uint8(0));
+    td::actor::send_closure(rldp_, &ton::rldp2::Rldp::add_id, full_id.compute_short_id());
+    return full_id;
+  }
+
+  template <class F>
+  void run_until(F &&ready) {
+    while (!ready()) {
+      scheduler_.run(1);
+    }
+  }
+};
+
+struct NamedProfile {
+  td::Slice name;
+  SimulatedLinkProfile profile;
+};
+
+std::vector<NamedProfile> profiles() {
+  return {{"lan", SimulatedLinkProfile::lan()},
+          {"wan", SimulatedLinkProfile::wan()},
+          {"lossy_wan", SimulatedLinkProfile::lossy_wan()},
+          {"mobile", SimulatedLinkProfile::mobile()}};
+}
+
+void run_rldp2_benchmark(td::uint64 seed, size_t transfers, size_t size) {
+  LOG(PLAIN) << "RLDP2 transfers: " << transfers << " x " << td::format::as_size(size);
+  RldpSimulation simulation("tmp-dir-benchmark-rldp2", seed);
+  for (auto &p : profiles()) {
+    for (size_t stripes : {1, 2, 4}) {
+      auto r_result = simulation.run(p.profile, stripes, transfers, size);
+      if (r_result.is_error()) {
+        LOG(ERROR) << p.name << " stripes=" << stripes << ": " << r_result.error();
+        continue;
+      }
+      auto result = r_result.move_as_ok();
+      double total_time = 0;
+      for (auto time : result.times) {
+        total_time += time;
+      }
+      auto received_bytes = static_cast<double>(size * transfers);
+      LOG(PLAIN) << p.name << " stripes=" << stripes
+                 << " goodput=" << td::format::as_size(static_cast<td::uint64>(received_bytes / total_time)) << "/s "
+                 << get_percentiles(result.times) << " overhead="
+                 << td::StringBuilder::FixedDouble(static_cast<double>(result.sent_bytes) / received_bytes - 1, 3);
+    }
+  }
+  simulation.close();
+}
+
+// One-hop FEC broadcast: the source sends the same stream of RaptorQ symbols to every receiver over its own link,
+// until it learns that the receiver has decoded the data (after one more link delay, as overlay's fec.completed).
+// No RldpConnection is involved, so the clock is fully virtual and the results depend only on the seed
+void run_fec_broadcast_benchmark(td::uint64 seed, size_t receivers, size_t size) {
+  constexpr size_t symbol_size = 768;
+  LOG(PLAIN) << "FEC broadcast: " << td::format::as_size(size) << " to " << receivers << " receivers";
+  for (auto &p : profiles()) {
+    td::Random::Xorshift128plus rnd(seed);
+    td::BufferSlice data(size);
+    rnd.bytes(data.as_slice());
+    auto encoder = td::fec::RaptorQEncoder::create(data.clone(), symbol_size);
+    encoder->prepare_more_symbols();
+    auto parameters = encoder->get_parameters();
+
+    struct Receiver {
+      std::unique_ptr<SimulatedLink> link;
+      std::unique_ptr<td::fec::RaptorQDecoder> decoder;
+      td::uint32 next_symbol = 0;
+      size_t received = 0;
+      double next_send_at = 0;
+      td::optional<double> completed_at;
+    };
+    std::vector<Receiver> rs(receivers);
+    SimulatedPacketQueue<std::pair<size_t, td::fec::Symbol>> in_flight;
+    double now = 0;
+    for (auto &r : rs) {
+      r.link = std::make_unique<SimulatedLink>(p.profile, rnd());
+      r.decoder = td::fec::RaptorQDecoder::create(parameters);
+    }
+    // The source paces symbols at the link bandwidth, so that the bottleneck queue does not overflow
+    double interval = p.profile.bandwidth > 0 ? static_cast<double>(symbol_size) / p.profile.bandwidth : 1e-5;
+
+    size_t stopped = 0;
+    while (stopped < receivers) {
+      td::Timestamp wakeup_at;
+      for (size_t i = 0; i < receivers; i++) {
+        auto &r = rs[i];
+        if (r.completed_at && r.completed_at.value() + p.profile.delay <= now &&
+            r.next_send_at != std::numeric_limits<double>::infinity()) {
+          r.next_send_at = std::numeric_limits<double>::infinity();
+          stopped++;
+        }
+        while (r.next_send_at <= now) {
+          auto symbol = encoder->gen_symbol(r.next_symbol++);
+          auto r_at = r.link->send(now, symbol.data.size());
+          if (r_at) {
+            in_flight.push(r_at.unwrap(), std::make_pair(i, std::move(symbol)));
+          }
+          r.next_send_at += interval;
+        }
+        if (r.next_send_at != std::numeric_limits<double>::infinity()) {
+          wakeup_at.relax(td::Timestamp::at(r.next_send_at));
+        }
+        if (r.completed_at && r.next_send_at != std::numeric_limits<double>::infinity()) {
+          wakeup_at.relax(td::Timestamp::at(r.completed_at.value() + p.profile.delay));
+        }
+      }
+      in_flight.deliver(now, [&](std::pair<size_t, td::fec::Symbol> packet) {
+        auto &r = rs[packet.first];
+        if (r.completed_at) {
+          return;
+        }
+        r.received++;
+        r.decoder->add_symbol(std::move(packet.second)).ensure();
+        if (r.decoder->may_try_decode() && r.decoder->try_decode(false).is_ok()) {
+          r.completed_at = now;
+        }
+      });
+      wakeup_at.relax(in_flight.next_at());
+      now = std::max(now, wakeup_at.at());
+    }
+
+    std::vector<double> times;
+    td::uint64 sent = 0;
+    size_t received = 0;
+    for (auto &r : rs) {
+      times.push_back(r.completed_at.value());
+      sent += r.link->stats().packets;
+      received += r.received;
+    }
+    auto needed = static_cast<double>(parameters.symbols_count * receivers);
+    LOG(PLAIN) << p.name << " " << get_percentiles(times)
+               << " sent/needed=" << td::StringBuilder::FixedDouble(static_cast<double>(sent) / needed, 3)
+               << " received/needed=" << td::StringBuilder::FixedDouble(static_cast<double>(received) / needed, 3);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  td::uint64 seed = 1;
+  if (argc > 1) {
+    seed = td::to_integer<td::uint64>(td::Slice(argv[1]));
+  }
+  LOG(PLAIN) << "seed=" << seed;
+  run_rldp2_benchmark(seed, 20, 1 << 20);
+  run_fec_broadcast_benchmark(seed, 16, 256 << 10);
+  return 0;
+}
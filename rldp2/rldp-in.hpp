@@ -26,6 +26,8 @@
 
 #include "td/utils/List.h"
 
+#include "OutboundTransfer.h"
+
 #include <map>
 #include <set>
 
@@ -74,8 +76,11 @@ class RldpIn : public RldpImpl {
   void send_query_ex(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, std::string name,
                      td::Promise<td::BufferSlice> promise, td::Timestamp timeout, td::BufferSlice data,
                      td::uint64 max_answer_size) override;
+  void send_query_multipath(adnl::AdnlNodeIdShort src, std::vector<adnl::AdnlNodeIdShort> dsts, std::string name,
+                            td::Promise<td::BufferSlice> promise, td::Timestamp timeout, td::BufferSlice data,
+                            td::uint64 max_answer_size) override;
   void answer_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::Timestamp timeout,
-                    adnl::AdnlQueryId query_id, TransferId transfer_id, td::BufferSlice data);
+                    adnl::AdnlQueryId query_id, TransferId transfer_id, td::BufferSlice data, Stripe stripe);
 
   void receive_message_part(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, td::BufferSlice data);
 
@@ -83,6 +88,8 @@ class RldpIn : public RldpImpl {
                        ton_api::rldp_message &message);
   void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                        ton_api::rldp_query &message);
+  void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                       ton_api::rldp_queryStriped &message);
   void process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                        ton_api::rldp_answer &message);
   void receive_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
@@ -99,6 +106,9 @@ class RldpIn : public RldpImpl {
 
  private:
   std::unique_ptr<adnl::Adnl::Callback> make_adnl_callback();
+  void deliver_query(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                     adnl::AdnlQueryId query_id, td::int64 max_answer_size, td::int32 timeout, td::BufferSlice data,
+                     Stripe stripe);
 
   td::actor::ActorId<adnl::AdnlPeerTable> adnl_;
 
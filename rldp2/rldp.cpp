@@ -27,19 +27,36 @@ namespace ton {
 
 namespace rldp2 {
 
+class RldpStripedReceiver;
+
 class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback {
  public:
   RldpConnectionActor(td::actor::ActorId<RldpIn> rldp, adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst,
                       td::actor::ActorId<adnl::Adnl> adnl)
       : rldp_(std::move(rldp)), src_(src), dst_(dst), adnl_(std::move(adnl)){};
 
-  void send(TransferId transfer_id, td::BufferSlice query, td::Timestamp timeout = td::Timestamp::never()) {
-    connection_.send(transfer_id, std::move(query), timeout);
+  void send(TransferId transfer_id, td::BufferSlice query, td::Timestamp timeout, Stripe stripe) {
+    connection_.send(transfer_id, std::move(query), timeout, stripe);
     yield();
   }
   void set_receive_limits(TransferId transfer_id, td::Timestamp timeout, td::uint64 max_size) {
     connection_.set_receive_limits(transfer_id, timeout, max_size);
   }
+  void set_receive_stripe(TransferId transfer_id, Stripe stripe, td::actor::ActorId<RldpStripedReceiver> receiver,
+                          td::Timestamp timeout) {
+    connection_.set_receive_stripe(transfer_id, stripe);
+    striped_receivers_[transfer_id] = StripedReceiver{std::move(receiver), timeout};
+    alarm_timestamp().relax(timeout);
+  }
+  void on_striped_part_decoded(TransferId transfer_id, td::uint32 part_i) {
+    connection_.on_striped_part_decoded(transfer_id, part_i);
+    yield();
+  }
+  void finish_striped(TransferId transfer_id) {
+    connection_.finish_striped(transfer_id);
+    striped_receivers_.erase(transfer_id);
+    yield();
+  }
   void receive_raw(td::BufferSlice data) {
     connection_.receive_raw(std::move(data));
     yield();
@@ -54,9 +71,24 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
   adnl::AdnlNodeIdShort dst_;
   td::actor::ActorId<adnl::Adnl> adnl_;
   RldpConnection connection_;
+  struct StripedReceiver {
+    td::actor::ActorId<RldpStripedReceiver> receiver;
+    td::Timestamp timeout;
+  };
+  std::map<TransferId, StripedReceiver> striped_receivers_;
 
   void loop() override {
     alarm_timestamp() = connection_.run(*this);
+    // The receiver finishes the transfer itself, but it may have stopped before this connection learned about it
+    for (auto it = striped_receivers_.begin(); it != striped_receivers_.end();) {
+      if (it->second.timeout.is_in_past()) {
+        connection_.finish_striped(it->first);
+        it = striped_receivers_.erase(it);
+      } else {
+        alarm_timestamp().relax(it->second.timeout);
+        ++it;
+      }
+    }
   }
 
   void send_raw(td::BufferSlice data) override {
@@ -68,8 +100,105 @@ class RldpConnectionActor : public td::actor::Actor, private ConnectionCallback
   void on_sent(TransferId transfer_id, td::Result<td::Unit> state) override {
     send_closure(rldp_, &RldpIn::on_sent, transfer_id, std::move(state));
   }
+  void receive_striped(TransferId transfer_id, td::uint64 total_size, std::vector<StripedSymbol> symbols) override;
 };
 
+// Decodes an answer from the stripes received over several connections
+class RldpStripedReceiver : public td::actor::Actor {
+ public:
+  struct Path {
+    td::actor::ActorId<RldpConnectionActor> connection;
+    TransferId transfer_id;
+  };
+
+  RldpStripedReceiver(td::actor::ActorId<RldpIn> rldp, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                      td::uint64 max_size, td::Timestamp timeout)
+      : rldp_(std::move(rldp)), local_id_(local_id), transfer_id_(transfer_id), max_size_(max_size), timeout_(timeout) {
+  }
+
+  void add_path(adnl::AdnlNodeIdShort source, td::actor::ActorId<RldpConnectionActor> connection,
+                TransferId transfer_id) {
+    if (paths_.empty()) {
+      source_ = source;
+    }
+    paths_.push_back(Path{std::move(connection), transfer_id});
+  }
+
+  void receive_symbols(TransferId transfer_id, td::uint64 total_size, std::vector<StripedSymbol> symbols) {
+    if (!inbound_) {
+      if (total_size > max_size_) {
+        finish(td::Status::Error(ErrorCode::protoviolation, "too big transfer"));
+        return;
+      }
+      inbound_.emplace(total_size);
+    }
+    if (total_size != inbound_.value().total_size()) {
+      VLOG(RLDP_INFO) << "total size mismatch in striped transfer " << transfer_id;
+      return;
+    }
+    auto &inbound = inbound_.value();
+    for (auto &symbol : symbols) {
+      auto r_part = inbound.get_part(symbol.part, symbol.fec_type);
+      if (r_part.is_error()) {
+        finish(r_part.move_as_error());
+        return;
+      }
+      auto part = r_part.move_as_ok();
+      if (!part || part->decoder->add_symbol(std::move(symbol.symbol)).is_error()) {
+        continue;
+      }
+      if (part->decoder->may_try_decode()) {
+        auto r_data = part->decoder->try_decode(false);
+        if (r_data.is_ok()) {
+          inbound.finish_part(symbol.part, r_data.move_as_ok().data);
+          for (auto &path : paths_) {
+            td::actor::send_closure(path.connection, &RldpConnectionActor::on_striped_part_decoded, path.transfer_id,
+                                    symbol.part);
+          }
+        }
+      }
+    }
+    auto o_res = inbound.try_finish();
+    if (o_res) {
+      finish(o_res.unwrap());
+    }
+  }
+
+ private:
+  td::actor::ActorId<RldpIn> rldp_;
+  adnl::AdnlNodeIdShort local_id_;
+  adnl::AdnlNodeIdShort source_;
+  TransferId transfer_id_;
+  td::uint64 max_size_;
+  td::Timestamp timeout_;
+  std::vector<Path> paths_;
+  td::optional<InboundTransfer> inbound_;
+
+  void start_up() override {
+    alarm_timestamp() = timeout_;
+  }
+  void alarm() override {
+    finish(td::Status::Error(ErrorCode::timeout, "timeout"));
+  }
+
+  void finish(td::Result<td::BufferSlice> r_data) {
+    for (auto &path : paths_) {
+      td::actor::send_closure(path.connection, &RldpConnectionActor::finish_striped, path.transfer_id);
+    }
+    td::actor::send_closure(rldp_, &RldpIn::receive_message, source_, local_id_, transfer_id_, std::move(r_data));
+    stop();
+  }
+};
+
+void RldpConnectionActor::receive_striped(TransferId transfer_id, td::uint64 total_size,
+                                          std::vector<StripedSymbol> symbols) {
+  auto it = striped_receivers_.find(transfer_id);
+  if (it != striped_receivers_.end()) {
+    send_closure(it->second.receiver, &RldpStripedReceiver::receive_symbols, transfer_id, total_size,
+                 std::move(symbols));
+  }
+}
+
 namespace {
 TransferId get_random_transfer_id() {
   TransferId transfer_id;
@@ -93,7 +222,7 @@ void RldpIn::send_message_ex(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort ds
   auto B = serialize_tl_object(create_tl_object<ton_api::rldp_message>(id, std::move(data)), true);
 
   auto transfer_id = get_random_transfer_id();
-  send_closure(create_connection(src, dst), &RldpConnectionActor::send, transfer_id, std::move(B), timeout);
+  send_closure(create_connection(src, dst), &RldpConnectionActor::send, transfer_id, std::move(B), timeout, Stripe{});
 }
 
 void RldpIn::send_query_ex(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, std::string name,
@@ -109,16 +238,55 @@ void RldpIn::send_query_ex(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst,
   auto transfer_id = get_random_transfer_id();
   auto response_transfer_id = get_responce_transfer_id(transfer_id);
   send_closure(connection, &RldpConnectionActor::set_receive_limits, response_transfer_id, timeout, max_answer_size);
-  send_closure(connection, &RldpConnectionActor::send, transfer_id, std::move(B), timeout);
+  send_closure(connection, &RldpConnectionActor::send, transfer_id, std::move(B), timeout, Stripe{});
 
   queries_.emplace(response_transfer_id, std::move(promise));
 }
 
+void RldpIn::send_query_multipath(adnl::AdnlNodeIdShort src, std::vector<adnl::AdnlNodeIdShort> dsts,
+                                  std::string name, td::Promise<td::BufferSlice> promise, td::Timestamp timeout,
+                                  td::BufferSlice data, td::uint64 max_answer_size) {
+  if (dsts.size() <= 1) {
+    if (dsts.empty()) {
+      promise.set_error(td::Status::Error(ErrorCode::error, "no destinations"));
+      return;
+    }
+    send_query_ex(src, dsts[0], std::move(name), std::move(promise), timeout, std::move(data), max_answer_size);
+    return;
+  }
+  if (dsts.size() > Stripe::max_count()) {
+    dsts.resize(Stripe::max_count());
+  }
+  auto date = static_cast<td::uint32>(timeout.at_unix()) + 1;
+  auto receiver_transfer_id = get_random_transfer_id();
+  auto receiver = td::actor::create_actor<RldpStripedReceiver>("RldpStripedReceiver", actor_id(this), src,
+                                                               receiver_transfer_id, max_answer_size, timeout)
+                      .release();
+  auto count = static_cast<td::uint32>(dsts.size());
+  // All stripes answer the same query
+  auto query_id = adnl::AdnlQuery::random_query_id();
+  for (td::uint32 i = 0; i < count; i++) {
+    auto B = serialize_tl_object(create_tl_object<ton_api::rldp_queryStriped>(query_id, max_answer_size, date, i,
+                                                                              count, data.clone()),
+                                 true);
+    auto connection = create_connection(src, dsts[i]);
+    auto transfer_id = get_random_transfer_id();
+    auto response_transfer_id = get_responce_transfer_id(transfer_id);
+    td::actor::send_closure(receiver, &RldpStripedReceiver::add_path, dsts[i], connection, response_transfer_id);
+    send_closure(connection, &RldpConnectionActor::set_receive_limits, response_transfer_id, timeout, max_answer_size);
+    send_closure(connection, &RldpConnectionActor::set_receive_stripe, response_transfer_id, Stripe{i, count},
+                 receiver, timeout);
+    send_closure(connection, &RldpConnectionActor::send, transfer_id, std::move(B), timeout, Stripe{});
+  }
+
+  queries_.emplace(receiver_transfer_id, std::move(promise));
+}
+
 void RldpIn::answer_query(adnl::AdnlNodeIdShort src, adnl::AdnlNodeIdShort dst, td::Timestamp timeout,
-                          adnl::AdnlQueryId query_id, TransferId transfer_id, td::BufferSlice data) {
+                          adnl::AdnlQueryId query_id, TransferId transfer_id, td::BufferSlice data, Stripe stripe) {
   auto B = serialize_tl_object(create_tl_object<ton_api::rldp_answer>(query_id, std::move(data)), true);
 
-  send_closure(create_connection(src, dst), &RldpConnectionActor::send, transfer_id, std::move(B), timeout);
+  send_closure(create_connection(src, dst), &RldpConnectionActor::send, transfer_id, std::move(B), timeout, stripe);
 }
 
 void RldpIn::receive_message_part(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, td::BufferSlice data) {
@@ -172,24 +340,42 @@ void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort
 
 void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
                              ton_api::rldp_query &message) {
+  deliver_query(source, local_id, transfer_id, message.query_id_, message.max_answer_size_, message.timeout_,
+                std::move(message.data_), Stripe{});
+}
+
+void RldpIn::process_message(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                             ton_api::rldp_queryStriped &message) {
+  Stripe stripe{static_cast<td::uint32>(message.stripe_), static_cast<td::uint32>(message.stripes_)};
+  if (message.stripe_ < 0 || message.stripes_ < 0 || !stripe.is_valid()) {
+    VLOG(RLDP_NOTICE) << "rldp query failed: invalid stripe " << message.stripe_ << "/" << message.stripes_;
+    return;
+  }
+  deliver_query(source, local_id, transfer_id, message.query_id_, message.max_answer_size_, message.timeout_,
+                std::move(message.data_), stripe);
+}
+
+void RldpIn::deliver_query(adnl::AdnlNodeIdShort source, adnl::AdnlNodeIdShort local_id, TransferId transfer_id,
+                           adnl::AdnlQueryId query_id, td::int64 max_answer_size, td::int32 timeout,
+                           td::BufferSlice data, Stripe stripe) {
   auto P = td::PromiseCreator::lambda([SelfId = actor_id(this), source, local_id,
-                                       timeout = td::Timestamp::at_unix(message.timeout_), query_id = message.query_id_,
-                                       max_answer_size = static_cast<td::uint64>(message.max_answer_size_),
-                                       transfer_id](td::Result<td::BufferSlice> R) {
+                                       timeout = td::Timestamp::at_unix(timeout), query_id,
+                                       max_answer_size = static_cast<td::uint64>(max_answer_size), transfer_id,
+                                       stripe](td::Result<td::BufferSlice> R) {
     if (R.is_ok()) {
       auto data = R.move_as_ok();
       if (data.size() > max_answer_size) {
         VLOG(RLDP_NOTICE) << "rldp query failed: answer too big";
       } else {
         td::actor::send_closure(SelfId, &RldpIn::answer_query, local_id, source, timeout, query_id,
-                                transfer_id ^ TransferId::ones(), std::move(data));
+                                transfer_id ^ TransferId::ones(), std::move(data), stripe);
       }
     } else {
       VLOG(RLDP_NOTICE) << "rldp query failed: " << R.move_as_error();
     }
   });
   VLOG(RLDP_DEBUG) << "delivering rldp query";
-  td::actor::send_closure(adnl_, &adnl::AdnlPeerTable::deliver_query, source, local_id, std::move(message.data_),
+  td::actor::send_closure(adnl_, &adnl::AdnlPeerTable::deliver_query, source, local_id, std::move(data),
                           std::move(P));
 }
 
@@ -39,6 +39,12 @@ class Rldp : public adnl::AdnlSenderInterface {
 
   virtual void set_default_mtu(td::uint64 mtu) = 0;
 
+  // Sends the query to several peers holding the same data. Each of them answers with its own stripe
+  // of FEC symbols, and the answer is decoded from the symbols received from all of them
+  virtual void send_query_multipath(adnl::AdnlNodeIdShort src, std::vector<adnl::AdnlNodeIdShort> dsts,
+                                    std::string name, td::Promise<td::BufferSlice> promise, td::Timestamp timeout,
+                                    td::BufferSlice data, td::uint64 max_answer_size) = 0;
+
   static td::actor::ActorOwn<Rldp> create(td::actor::ActorId<adnl::Adnl> adnl);
 };
 
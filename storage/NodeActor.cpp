@@ -25,6 +25,7 @@
 #include "td/utils/Enumerator.h"
 #include "td/utils/tests.h"
 #include "td/utils/overloaded.h"
+#include "td/utils/port/thread.h"
 #include "tl-utils/tl-utils.hpp"
 #include "auto/tl/ton_api.hpp"
 #include "td/actor/MultiPromise.h"
@@ -164,6 +165,7 @@ void NodeActor::recheck_parts(Torrent::PartsRange range) {
   CHECK(torrent_.inited_info());
   for (size_t i = range.begin; i < range.end; ++i) {
     if (parts_.parts[i].ready && !torrent_.is_piece_ready(i)) {
+      upload_cache_.clear();
       parts_helper_.on_self_part_not_ready(i);
       parts_.parts[i].ready = false;
     } else if (!parts_.parts[i].ready && torrent_.is_piece_ready(i)) {
@@ -477,6 +479,7 @@ void NodeActor::load_from(td::optional<TorrentMeta> meta, std::string files_path
 
 void NodeActor::copy_to_new_root_dir(std::string new_root_dir, td::Promise<td::Unit> promise) {
   TRY_STATUS_PROMISE(promise, torrent_.copy_to(new_root_dir));
+  upload_cache_.clear();
   db_store_torrent();
   promise.set_result(td::Unit());
 }
@@ -525,38 +528,72 @@ void NodeActor::loop_queries() {
   if (!should_download_) {
     return;
   }
-  for (auto &it : peers_) {
-    auto peer_token = it.second.peer_token;
-    auto &state = it.second.state;
-    if (!state->peer_state_ready_) {
-      parts_helper_.set_peer_limit(peer_token, 0);
-      continue;
-    }
-    if (!state->peer_state_.load().will_upload) {
-      parts_helper_.set_peer_limit(peer_token, 0);
-      continue;
+  auto piece_size = torrent_.get_info().piece_size;
+  bool has_free_slots = false;
+  auto update_limits = [&] {
+    has_free_slots = false;
+    for (auto &it : peers_) {
+      auto peer_token = it.second.peer_token;
+      auto &state = it.second.state;
+      if (!state->peer_state_ready_ || !state->peer_state_.load().will_upload) {
+        parts_helper_.set_peer_limit(peer_token, 0);
+        continue;
+      }
+      // Pipeline length is adapted to the bandwidth-delay product of the peer
+      size_t limit = it.second.pipeline.get_limit(it.second.download_speed.speed(), piece_size);
+      size_t active = state->node_queries_active_.size();
+      td::uint32 free_slots = active < limit ? td::narrow_cast<td::uint32>(limit - active) : 0;
+      parts_helper_.set_peer_limit(peer_token, free_slots);
+      has_free_slots |= free_slots > 0;
     }
-    parts_helper_.set_peer_limit(
-        peer_token, td::narrow_cast<td::uint32>(MAX_PEER_TOTAL_QUERIES - state->node_queries_active_.size()));
-  }
-
-  auto parts = parts_helper_.get_rarest_parts(MAX_TOTAL_QUERIES);
-  for (auto &part : parts) {
-    auto it = peers_.find(part.peer_id);
-    CHECK(it != peers_.end());
-    auto &state = it->second.state;
-    CHECK(state->peer_state_ready_);
-    CHECK(state->peer_state_.load().will_upload);
-    CHECK(state->node_queries_active_.size() < MAX_PEER_TOTAL_QUERIES);
-    auto part_id = part.part_id;
-    if (state->node_queries_active_.insert(static_cast<td::uint32>(part_id)).second) {
-      state->node_queries_.add_element(static_cast<td::uint32>(part_id));
+  };
+  auto send_queries = [&](const std::vector<PartsHelper::RarePart> &parts) {
+    for (auto &part : parts) {
+      auto it = peers_.find(part.peer_id);
+      CHECK(it != peers_.end());
+      auto &state = it->second.state;
+      CHECK(state->peer_state_ready_);
+      CHECK(state->peer_state_.load().will_upload);
+      auto part_id = static_cast<PartId>(part.part_id);
+      if (!state->node_queries_active_.insert(part_id).second) {
+        continue;
+      }
+      state->node_queries_.add_element(part_id);
+      it->second.pipeline.on_query_sent(part_id);
+      parts_helper_.lock_part(part_id);
+      parts_.total_queries++;
+      parts_.parts[part_id].queries++;
+      state->notify_peer();
     }
-    parts_helper_.lock_part(part_id);
-    parts_.total_queries++;
-    parts_.parts[part_id].query_to_peer = part.peer_id;
-    state->notify_peer();
+  };
+
+  update_limits();
+  if (!has_free_slots || parts_.total_queries >= MAX_TOTAL_QUERIES) {
+    return;
+  }
+  auto parts = parts_helper_.get_rarest_parts(MAX_TOTAL_QUERIES - parts_.total_queries);
+  send_queries(parts);
+  if (parts_.total_queries >= MAX_TOTAL_QUERIES) {
+    return;
   }
+
+  // Every wanted part is already queried, but some peers are idle: duplicate the outstanding queries.
+  // This way the last parts are not waiting for the slowest peer.
+  if (parts_helper_.has_unqueried_parts()) {
+    return;
+  }
+  update_limits();
+  if (!has_free_slots || parts_.total_queries == 0) {
+    return;
+  }
+  parts = parts_helper_.get_endgame_parts(MAX_TOTAL_QUERIES - parts_.total_queries, MAX_PART_QUERIES,
+                                          [&](PeerId peer_id, PartsHelper::PartId part_id) {
+                                            auto it = peers_.find(peer_id);
+                                            return it == peers_.end() ||
+                                                   it->second.state->node_queries_active_.count(
+                                                       static_cast<PartId>(part_id)) > 0;
+                                          });
+  send_queries(parts);
 }
 
 void NodeActor::loop_get_peers() {
@@ -614,23 +651,18 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
     should_notify_peer = true;
   }
 
-  std::vector<std::pair<td::uint32, td::Result<PeerState::Part>>> results;
+  std::vector<std::pair<td::uint32, td::Result<td::BufferSlice>>> results;
   for (td::uint32 part_id : state->peer_queries_.read()) {
     should_notify_peer = true;
-    auto res = [&]() -> td::Result<PeerState::Part> {
+    auto res = [&]() -> td::Result<td::BufferSlice> {
       if (!node_state.will_upload || !should_upload_) {
         return td::Status::Error("Won't upload");
       }
-      TRY_RESULT(proof, torrent_.get_piece_proof(part_id));
-      TRY_RESULT(data, torrent_.get_piece_data(part_id));
-      PeerState::Part res;
-      TRY_RESULT(proof_serialized, vm::std_boc_serialize(std::move(proof)));
-      res.proof = std::move(proof_serialized);
-      res.data = td::BufferSlice(std::move(data));
-      td::uint64 size = res.data.size();
+      TRY_RESULT(answer, upload_cache_.get_piece_answer(torrent_, peer_id, part_id));
+      td::uint64 size = answer.size();
       upload_speed_.add(size);
       peer.upload_speed.add(size);
-      return std::move(res);
+      return std::move(answer);
     }();
     results.emplace_back(part_id, std::move(res));
   }
@@ -642,7 +674,12 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
     if (!state->node_queries_active_.count(part_id)) {
       continue;
     }
+    peer.pipeline.on_query_finished(part_id, p.second.is_ok());
+    bool already_ready = parts_.parts[part_id].ready;
     auto r_unit = p.second.move_fmap([&](PeerState::Part part) -> td::Result<td::Unit> {
+      if (already_ready) {
+        return td::Unit();
+      }
       TRY_RESULT(proof, vm::std_boc_deserialize(part.proof));
       TRY_STATUS(torrent_.add_piece(part_id, part.data.as_slice(), std::move(proof)));
       update_pieces_in_db(part_id, part_id + 1);
@@ -651,12 +688,12 @@ void NodeActor::loop_peer(const PeerId &peer_id, Peer &peer) {
       return td::Unit();
     });
 
-    parts_.parts[part_id].query_to_peer = {};
+    parts_.parts[part_id].queries--;
     parts_.total_queries--;
     state->node_queries_active_.erase(part_id);
     parts_helper_.unlock_part(part_id);
 
-    if (r_unit.is_ok()) {
+    if (r_unit.is_ok() && !already_ready) {
       on_part_ready(part_id);
     }
   }
@@ -676,6 +713,8 @@ void NodeActor::on_part_ready(PartId part_id) {
   parts_helper_.on_self_part_ready(part_id);
   CHECK(!parts_.parts[part_id].ready);
   parts_.parts[part_id].ready = true;
+  // Duplicate queries from endgame can't be cancelled, the peer sends the part anyway. They keep their pipeline slots
+  // until the answer arrives, the answer is then ignored.
   for (auto &peer : peers_) {
     // TODO: notify only peer want_download_count == 0
     peer.second.state->notify_peer();
@@ -918,6 +957,8 @@ void NodeActor::load_from_db(std::shared_ptr<db::DbType> db, td::Bits256 hash, t
         options.root_dir = std::move(root_dir_);
         options.in_memory = false;
         options.validate = false;
+        options.hash_threads = Torrent::max_hash_threads();
+        options.hash_progress = Torrent::track_hash_progress(PSTRING() << "Checking torrent " << hash_.to_hex());
         if (meta_str) {
           TRY_RESULT(meta, TorrentMeta::deserialize(meta_str.value().as_slice()));
           options.validate = true;
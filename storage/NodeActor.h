@@ -22,8 +22,10 @@
 #include "LoadSpeed.h"
 #include "PartsHelper.h"
 #include "PeerActor.h"
+#include "QueryPipeline.h"
 #include "Torrent.h"
 #include "SpeedLimiter.h"
+#include "UploadCache.h"
 
 #include "td/utils/Random.h"
 #include "td/utils/Variant.h"
@@ -139,13 +141,14 @@ class NodeActor : public td::actor::Actor {
     std::shared_ptr<PeerState> state;
     PartsHelper::PeerToken peer_token;
     LoadSpeed download_speed, upload_speed;
+    QueryPipeline pipeline;
   };
 
   std::map<PeerId, Peer> peers_;
 
   struct PartsSet {
     struct Info {
-      td::optional<PeerId> query_to_peer;
+      td::uint32 queries{0};
       bool ready{false};
     };
     size_t total_queries{0};
@@ -156,6 +159,7 @@ class NodeActor : public td::actor::Actor {
   PartsHelper parts_helper_;
   std::vector<PartId> ready_parts_;
   LoadSpeed download_speed_, upload_speed_;
+  UploadCache upload_cache_;
 
   td::Timestamp next_get_peers_at_;
   bool has_get_peers_{false};
@@ -189,8 +193,9 @@ class NodeActor : public td::actor::Actor {
 
   void loop_start_stop_peers();
 
-  static constexpr size_t MAX_TOTAL_QUERIES = 20;
-  static constexpr size_t MAX_PEER_TOTAL_QUERIES = 5;
+  static constexpr size_t MAX_TOTAL_QUERIES = 512;
+  // In endgame a part is queried from at most this number of peers at once
+  static constexpr td::uint32 MAX_PART_QUERIES = 2;
   void loop_queries();
   void loop_get_peers();
   void got_peers(td::Result<std::vector<PeerId>> r_peers);
@@ -23,10 +23,13 @@
 #include "td/utils/Random.h"
 #include "td/utils/Status.h"
 
+#include <map>
+#include <set>
+
 namespace ton {
 struct PartsHelper {
  public:
-  explicit PartsHelper(size_t parts_count = 0) : parts_(parts_count), peers_(64) {
+  explicit PartsHelper(size_t parts_count = 0) : parts_(parts_count), unqueried_parts_(parts_count), peers_(64) {
     peers_[0].is_valid = true;
   }
   using PartId = size_t;
@@ -35,6 +38,7 @@ struct PartsHelper {
   void init_parts_count(size_t parts_count) {
     CHECK(parts_.empty());
     parts_.resize(parts_count);
+    unqueried_parts_ = parts_count;
   }
   PeerToken register_self() {
     return self_token_;
@@ -86,15 +90,23 @@ struct PartsHelper {
     part->peers_count++;
   }
 
+  // A part is locked while there are active queries for it. In endgame a part can be queried from several peers.
   void lock_part(PartId part_id) {
     auto *part = get_part(part_id);
-    CHECK(!part->is_locked);
-    part->is_locked = true;
+    bool was_unqueried = is_unqueried(*part);
+    part->queries++;
+    update_unqueried(was_unqueried, *part);
   }
   void unlock_part(PartId part_id) {
     auto *part = get_part(part_id);
-    CHECK(part->is_locked);
-    part->is_locked = false;
+    CHECK(part->queries > 0);
+    bool was_unqueried = is_unqueried(*part);
+    part->queries--;
+    update_unqueried(was_unqueried, *part);
+  }
+  // Returns true if some wanted part is neither ready nor queried from any peer
+  bool has_unqueried_parts() const {
+    return unqueried_parts_ > 0;
   }
 
   void set_part_priority(PartId part_id, td::uint8 priority) {
@@ -103,7 +115,9 @@ struct PartsHelper {
       return;
     }
     change_key(part_id, part->rnd, part->peers_count, part->peers_count, part->priority, priority);
+    bool was_unqueried = is_unqueried(*part);
     part->priority = priority;
+    update_unqueried(was_unqueried, *part);
   }
 
   td::uint8 get_part_priority(PartId part_id) {
@@ -118,7 +132,9 @@ struct PartsHelper {
     }
     auto part = get_part(part_id);
     CHECK(!part->is_ready);
+    bool was_unqueried = is_unqueried(*part);
     part->is_ready = true;
+    update_unqueried(was_unqueried, *part);
     for (auto &peer : peers_) {
       if (peer.ready_parts.get(part_id)) {
         peer.want_download_count--;
@@ -135,6 +151,7 @@ struct PartsHelper {
     auto part = get_part(part_id);
     CHECK(part->is_ready);
     part->is_ready = false;
+    update_unqueried(false, *part);
     for (auto &peer : peers_) {
       if (peer.ready_parts.get(part_id)) {
         peer.want_download_count++;
@@ -180,11 +197,12 @@ struct PartsHelper {
     }
 
     std::vector<RarePart> res;
+    std::set<PartId> chosen;
     while (res.size() < max_count && !its.empty()) {
       auto it = *its.begin();
       its.erase(its.begin());
       auto part_id = it.begin->part_id;
-      if ((res.empty() || res.back().part_id != part_id) && !get_part(part_id)->is_locked) {
+      if (get_part(part_id)->queries == 0 && chosen.insert(part_id).second) {
         res.push_back({part_id, it.peer_id});
         CHECK(get_peer(register_peer(it.peer_id))->ready_parts.get(part_id));
         it.limit--;
@@ -198,6 +216,39 @@ struct PartsHelper {
     return res;
   }
 
+  // Endgame: parts that are already queried, but not ready yet, are queried from other peers too.
+  // Returns up to peer.limit such parts for each peer, rarest first. Parts with max_queries active queries and
+  // parts that are already queried from the peer (is_queried(peer_id, part_id)) are skipped.
+  template <class F>
+  std::vector<RarePart> get_endgame_parts(size_t max_count, td::uint32 max_queries, F &&is_queried) {
+    std::vector<RarePart> res;
+    std::map<PartId, td::uint32> new_queries;
+    for (auto &peer : peers_) {
+      if (!peer.is_valid || peer.peer_id == 0) {
+        continue;
+      }
+      td::uint32 limit = peer.limit;
+      for (auto it = peer.rarest_parts.begin(); it != peer.rarest_parts.end() && limit > 0; ++it) {
+        if (res.size() >= max_count) {
+          return res;
+        }
+        auto part_id = it->part_id;
+        auto queries = get_part(part_id)->queries;
+        if (queries == 0) {
+          continue;
+        }
+        auto &cnt = new_queries[part_id];
+        if (queries + cnt >= max_queries || is_queried(peer.peer_id, part_id)) {
+          continue;
+        }
+        cnt++;
+        limit--;
+        res.push_back({part_id, peer.peer_id});
+      }
+    }
+    return res;
+  }
+
   td::uint32 get_want_download_count(PeerToken peer_token) {
     return get_peer(peer_token, false)->want_download_count;
   }
@@ -209,7 +260,7 @@ struct PartsHelper {
   PeerToken self_token_{0};
   size_t parts_count_;
   struct Part {
-    bool is_locked{false};
+    td::uint32 queries{0};
     bool is_ready{false};
     td::uint8 priority{1};
     td::uint32 rnd{0};
@@ -242,11 +293,28 @@ struct PartsHelper {
   };
 
   std::vector<Part> parts_;
+  // Number of parts with is_unqueried(part)
+  size_t unqueried_parts_{0};
   std::vector<Peer> peers_;
   td::uint32 next_peer_token_{1};
   std::map<PeerId, PeerToken> peer_id_to_token_;
   std::vector<PeerToken> free_peer_tokens_;
 
+  static bool is_unqueried(const Part &part) {
+    return !part.is_ready && part.priority != 0 && part.queries == 0;
+  }
+  void update_unqueried(bool was_unqueried, const Part &part) {
+    bool now_unqueried = is_unqueried(part);
+    if (was_unqueried != now_unqueried) {
+      if (now_unqueried) {
+        unqueried_parts_++;
+      } else {
+        CHECK(unqueried_parts_ > 0);
+        unqueried_parts_--;
+      }
+    }
+  }
+
   Part *get_part(PartId part_id) {
     CHECK(part_id < parts_.size());
     return &parts_[part_id];
@@ -389,19 +389,19 @@ void PeerActor::loop_peer_get_piece() {
     if (promise_it == peer_get_piece_.end()) {
       continue;
     }
-    td::Promise<PeerState::Part> promise =
-        [i = p.first, promise = std::move(promise_it->second.promise)](td::Result<PeerState::Part> R) mutable {
+    td::Promise<td::BufferSlice> promise =
+        [i = p.first, promise = std::move(promise_it->second.promise)](td::Result<td::BufferSlice> R) mutable {
           LOG(DEBUG) << "Responding to getPiece " << i << ": " << (R.is_ok() ? "OK" : R.error().to_string());
-          promise.set_result(R.move_map([](PeerState::Part part) {
-            return create_serialize_tl_object<ton_api::storage_piece>(std::move(part.proof), std::move(part.data));
-          }));
+          promise.set_result(std::move(R));
         };
     if (p.second.is_error()) {
       promise.set_error(p.second.move_as_error());
     } else {
-      auto part = p.second.move_as_ok();
-      auto size = (double)part.data.size();
-      td::Promise<td::Unit> P = promise.wrap([part = std::move(part)](td::Unit) mutable { return std::move(part); });
+      // Serialized storage.piece, shared with the upload cache of the node
+      auto answer = p.second.move_as_ok();
+      auto size = (double)answer.size();
+      td::Promise<td::Unit> P =
+          promise.wrap([answer = std::move(answer)](td::Unit) mutable { return std::move(answer); });
       if (state_->speed_limiters_.upload.empty()) {
         P.set_result(td::Unit());
       } else {
@@ -116,7 +116,7 @@ struct PeerState {
 
   std::set<PartId> peer_queries_active_; // Peer only
   MessageBuffer<PartId> peer_queries_; // Peer -> Node
-  MessageBuffer<std::pair<PartId, td::Result<Part>>> peer_queries_results_; // Node -> Peer
+  MessageBuffer<std::pair<PartId, td::Result<td::BufferSlice>>> peer_queries_results_; // Node -> Peer, storage.piece
 
   // Peer -> Node
   MessageBuffer<PartId> peer_ready_parts_;
@@ -0,0 +1,56 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "QueryPipeline.h"
+
+#include <cmath>
+
+namespace ton {
+void QueryPipeline::on_query_sent(PartId part_id, td::Timestamp now) {
+  sent_at_[part_id] = now;
+}
+
+void QueryPipeline::on_query_finished(PartId part_id, bool success, td::Timestamp now) {
+  auto it = sent_at_.find(part_id);
+  if (it == sent_at_.end()) {
+    return;
+  }
+  double rtt = now.at() - it->second.at();
+  sent_at_.erase(it);
+  if (!success) {
+    return;
+  }
+  if (min_rtt_ < 0 || rtt <= min_rtt_ || min_rtt_at_.at() + RTT_WINDOW < now.at()) {
+    min_rtt_ = rtt;
+    min_rtt_at_ = now;
+  }
+}
+
+size_t QueryPipeline::get_limit(double speed, td::uint64 piece_size) const {
+  if (min_rtt_ < 0 || piece_size == 0) {
+    return MIN_QUERIES;
+  }
+  double in_flight = std::ceil(2.0 * speed * min_rtt_ / (double)piece_size) + 1.0;
+  if (in_flight < (double)MIN_QUERIES) {
+    return MIN_QUERIES;
+  }
+  if (in_flight > (double)MAX_QUERIES) {
+    return MAX_QUERIES;
+  }
+  return (size_t)in_flight;
+}
+}  // namespace ton
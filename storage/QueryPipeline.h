@@ -0,0 +1,50 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PeerState.h"
+
+#include "td/utils/Time.h"
+
+#include <map>
+
+namespace ton {
+// Chooses the number of parallel piece queries to one peer.
+// To keep the link busy, speed * rtt bytes must be in flight. Query latency grows when queries wait in the peer's
+// queue, so rtt is estimated as the minimal latency observed during the last RTT_WINDOW seconds.
+// The pipeline is twice as long as needed, so it grows while the download speed is limited by the pipeline itself.
+class QueryPipeline {
+ public:
+  void on_query_sent(PartId part_id, td::Timestamp now = td::Timestamp::now());
+  void on_query_finished(PartId part_id, bool success, td::Timestamp now = td::Timestamp::now());
+  size_t get_limit(double speed, td::uint64 piece_size) const;
+  // Negative if there is no estimate yet
+  double get_rtt() const {
+    return min_rtt_;
+  }
+
+  static constexpr size_t MIN_QUERIES = 5;
+  static constexpr size_t MAX_QUERIES = 64;
+  static constexpr double RTT_WINDOW = 10.0;
+
+ private:
+  std::map<PartId, td::Timestamp> sent_at_;
+  double min_rtt_{-1.0};
+  td::Timestamp min_rtt_at_;
+};
+}  // namespace ton
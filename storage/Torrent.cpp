@@ -24,6 +24,13 @@
 #include "td/utils/port/Stat.h"
 #include "td/utils/tl_helpers.h"
 #include "td/utils/port/path.h"
+#include "td/utils/port/thread.h"
+#include "td/utils/ScopeGuard.h"
+#include "td/utils/Time.h"
+#include "td/utils/optional.h"
+
+#include <atomic>
+#include <mutex>
 
 namespace ton {
 
@@ -54,7 +61,7 @@ td::Result<Torrent> Torrent::open(Options options, TorrentMeta meta) {
     res.set_root_dir(options.root_dir);
   }
   if (options.validate) {
-    res.validate();
+    TRY_STATUS_PREFIX(res.validate(options.hash_threads, options.hash_progress), "Failed to validate torrent: ");
   }
   return std::move(res);
 }
@@ -77,12 +84,17 @@ struct IterateInfo {
 
 template <class F>
 td::Status Torrent::iterate_piece(Info::PieceInfo piece, F &&f) {
-  auto chunk_it = std::lower_bound(chunks_.begin(), chunks_.end(), piece.offset, [](auto &chunk, auto &piece_offset) {
+  return iterate_piece_chunks(chunks_, piece, std::forward<F>(f));
+}
+
+template <class F>
+td::Status Torrent::iterate_piece_chunks(std::vector<ChunkState> &chunks, Info::PieceInfo piece, F &&f) {
+  auto chunk_it = std::lower_bound(chunks.begin(), chunks.end(), piece.offset, [](auto &chunk, auto &piece_offset) {
     return chunk.offset + chunk.size <= piece_offset;
   });
 
   td::uint64 size = 0;
-  for (; chunk_it != chunks_.end(); chunk_it++) {
+  for (; chunk_it != chunks.end(); chunk_it++) {
     if (chunk_it->offset >= piece.offset + piece.size) {
       break;
     }
@@ -189,9 +201,172 @@ std::string Torrent::get_stats_str() const {
   return sb.as_cslice().str();
 }
 
-void Torrent::validate() {
+namespace {
+// Extra hashing threads that are running now, in all torrents
+std::atomic<size_t> hash_threads_in_use{0};
+
+size_t acquire_hash_threads(size_t wanted) {
+  size_t limit = Torrent::max_hash_threads() - 1;
+  size_t in_use = hash_threads_in_use.load();
+  while (true) {
+    size_t got = td::min(wanted, in_use < limit ? limit - in_use : 0);
+    if (got == 0 || hash_threads_in_use.compare_exchange_weak(in_use, in_use + got)) {
+      return got;
+    }
+  }
+}
+}  // namespace
+
+size_t Torrent::max_hash_threads() {
+  return td::max(td::thread::hardware_concurrency(), 1u);
+}
+
+td::Status Torrent::hash_pieces(const Info &info, std::vector<ChunkState> &chunks, size_t threads, bool stop_on_error,
+                                const HashProgress &progress, const std::function<void(PieceHashes)> &on_batch) {
+  struct Worker {
+    td::BufferSlice buf;
+    ChunkState::Cache cache;
+    PieceHashes hashes;
+    td::Status error;
+  };
+  // Each worker reads its part of a batch with large reads and hashes it.
+  // Batches are aligned subtrees of the merkle tree, so that a batch can be checked against a proof on its own.
+  const td::uint64 read_size = 4 << 20;
+  size_t extra_threads = acquire_hash_threads(td::max<size_t>(threads, 1) - 1);
+  SCOPE_EXIT {
+    hash_threads_in_use -= extra_threads;
+  };
+  threads = extra_threads + 1;
+  td::uint64 batch_size = 1;
+  while (batch_size < td::max<td::uint64>(1, read_size / info.piece_size) * threads) {
+    batch_size *= 2;
+  }
+  const td::uint64 worker_pieces = (batch_size + threads - 1) / threads;
+  std::vector<Worker> workers(threads);
+  for (auto &w : workers) {
+    w.buf = td::BufferSlice(info.piece_size);
+    w.cache.slice = td::BufferSlice(td::max<td::uint64>(read_size, info.piece_size));
+  }
+
+  auto hash_range = [&](Worker &w, td::uint64 begin, td::uint64 end) {
+    for (td::uint64 piece_i = begin; piece_i < end; piece_i++) {
+      auto piece = info.get_piece_info(piece_i);
+      td::Sha256State sha256;
+      sha256.init();
+      bool skipped = false;
+      auto is_ok = iterate_piece_chunks(chunks, piece, [&](auto it, auto info) {
+        if (!it->data) {
+          skipped = true;
+          return td::Status::Error("No such file");
+        }
+        if (!it->has_piece(info.chunk_offset, info.size)) {
+          return td::Status::Error("Don't have piece");
+        }
+        auto dest = w.buf.as_slice().truncate(info.size);
+        TRY_STATUS(it->get_piece(dest, info.chunk_offset, &w.cache));
+        sha256.feed(dest);
+        return td::Status::OK();
+      });
+      if (is_ok.is_error()) {
+        if (stop_on_error) {
+          w.error = is_ok.move_as_error_prefix(PSTRING() << "Failed to read piece " << piece_i << ": ");
+          return;
+        }
+        LOG_IF(ERROR, !skipped) << "Failed: " << is_ok;
+        continue;
+      }
+      td::Bits256 hash;
+      sha256.extract(hash.as_slice());
+      w.hashes.emplace_back(piece_i, hash);
+    }
+  };
+
+  td::uint64 pieces_count = info.pieces_count();
+  for (td::uint64 begin = 0; begin < pieces_count; begin += batch_size) {
+    auto range = [&](size_t i) {
+      return std::make_pair(td::min(pieces_count, begin + worker_pieces * i),
+                            td::min(pieces_count, begin + worker_pieces * (i + 1)));
+    };
+    std::vector<td::thread> batch_threads;
+    for (size_t i = 1; i < threads && range(i).first < range(i).second; i++) {
+      batch_threads.emplace_back([&, i] { hash_range(workers[i], range(i).first, range(i).second); });
+    }
+    hash_range(workers[0], range(0).first, range(0).second);
+    for (auto &t : batch_threads) {
+      t.join();
+    }
+
+    PieceHashes batch;
+    for (auto &w : workers) {
+      TRY_STATUS(std::move(w.error));
+      batch.insert(batch.end(), w.hashes.begin(), w.hashes.end());
+      w.hashes.clear();
+    }
+    on_batch(std::move(batch));
+    if (progress) {
+      progress(td::min(pieces_count, begin + batch_size), pieces_count);
+    }
+  }
+  return td::Status::OK();
+}
+
+namespace {
+std::mutex hashing_jobs_mutex;
+std::map<td::uint64, Torrent::HashingJob> hashing_jobs;
+td::uint64 next_hashing_job_id = 0;
+
+class HashProgressTracker {
+ public:
+  explicit HashProgressTracker(std::string title) : title_(std::move(title)) {
+  }
+  ~HashProgressTracker() {
+    if (id_) {
+      std::lock_guard<std::mutex> guard(hashing_jobs_mutex);
+      hashing_jobs.erase(id_.value());
+    }
+  }
+
+  void on_progress(td::uint64 ready, td::uint64 total) {
+    {
+      std::lock_guard<std::mutex> guard(hashing_jobs_mutex);
+      if (!id_) {
+        id_ = next_hashing_job_id++;
+        hashing_jobs[id_.value()].title = title_;
+      }
+      auto &job = hashing_jobs[id_.value()];
+      job.hashed_pieces = ready;
+      job.total_pieces = total;
+    }
+    if (ready == total || next_log_at_.is_in_past()) {
+      LOG(INFO) << title_ << ": hashed " << ready << "/" << total << " pieces";
+      next_log_at_ = td::Timestamp::in(5.0);
+    }
+  }
+
+ private:
+  std::string title_;
+  td::optional<td::uint64> id_;
+  td::Timestamp next_log_at_ = td::Timestamp::in(5.0);
+};
+}  // namespace
+
+Torrent::HashProgress Torrent::track_hash_progress(std::string title) {
+  auto tracker = std::make_shared<HashProgressTracker>(std::move(title));
+  return [tracker](td::uint64 ready, td::uint64 total) { tracker->on_progress(ready, total); };
+}
+
+std::vector<Torrent::HashingJob> Torrent::get_hashing_jobs() {
+  std::lock_guard<std::mutex> guard(hashing_jobs_mutex);
+  std::vector<HashingJob> res;
+  for (auto &p : hashing_jobs) {
+    res.push_back(p.second);
+  }
+  return res;
+}
+
+td::Status Torrent::validate(size_t threads, const HashProgress &progress) {
   if (!inited_info_ || !header_) {
-    return;
+    return td::Status::OK();
   }
 
   std::fill(piece_is_ready_.begin(), piece_is_ready_.end(), false);
@@ -208,11 +383,19 @@ void Torrent::validate() {
     init_chunk_data(chunk);
   }
 
-  std::vector<td::UInt256> hashes;
-  std::vector<std::pair<size_t, td::Bits256>> pieces;
-
-  auto flush = [&] {
-    for (size_t piece_i : merkle_tree_.add_pieces(std::move(pieces))) {
+  // Pieces under a pruned node of the proof can be checked only all together, they are checked in the end
+  PieceHashes unchecked;
+  auto flush = [&](PieceHashes pieces) {
+    auto ok_pieces = merkle_tree_.add_pieces(pieces);
+    if (ok_pieces.size() != pieces.size()) {
+      std::set<size_t> ok(ok_pieces.begin(), ok_pieces.end());
+      for (auto &p : pieces) {
+        if (!ok.count(p.first)) {
+          unchecked.push_back(p);
+        }
+      }
+    }
+    for (size_t piece_i : ok_pieces) {
       auto piece = info_.get_piece_info(piece_i);
       iterate_piece(piece, [&](auto it, auto info) {
         it->ready_size += info.size;
@@ -226,40 +409,14 @@ void Torrent::validate() {
       CHECK(not_ready_piece_count_);
       not_ready_piece_count_--;
     }
-    hashes.clear();
-    pieces.clear();
   };
-
-  td::BufferSlice buf(info_.piece_size);
-  ChunkState::Cache cache;
-  cache.slice = td::BufferSlice(td::max(8u << 20, info_.piece_size));
-  for (size_t piece_i = 0; piece_i < info_.pieces_count(); piece_i++) {
-    auto piece = info_.get_piece_info(piece_i);
-    td::Sha256State sha256;
-    sha256.init();
-    bool skipped = false;
-    auto is_ok = iterate_piece(piece, [&](auto it, auto info) {
-      if (!it->data) {
-        skipped = true;
-        return td::Status::Error("No such file");
-      }
-      if (!it->has_piece(info.chunk_offset, info.size)) {
-        return td::Status::Error("Don't have piece");
-      }
-      auto dest = buf.as_slice().truncate(info.size);
-      TRY_STATUS(it->get_piece(dest, info.chunk_offset, &cache));
-      sha256.feed(dest);
-      return td::Status::OK();
-    });
-    if (is_ok.is_error()) {
-      LOG_IF(ERROR, !skipped) << "Failed: " << is_ok;
-      continue;
-    }
-    td::Bits256 hash;
-    sha256.extract(hash.as_slice());
-    pieces.emplace_back(piece_i, hash);
+  TRY_STATUS(hash_pieces(info_, chunks_, threads, false, progress, flush));
+  if (!unchecked.empty()) {
+    auto rest = std::move(unchecked);
+    unchecked.clear();
+    flush(std::move(rest));
   }
-  flush();
+  return td::Status::OK();
 }
 
 td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
@@ -280,13 +437,38 @@ td::Result<std::string> Torrent::get_piece_data(td::uint64 piece_i) {
   if (it2 != in_memory_pieces_.end()) {
     return it2->second.data;
   }
-  auto piece = info_.get_piece_info(piece_i);
+  std::string res(info_.get_piece_info(piece_i).size, '\0');
+  TRY_STATUS(read_piece(piece_i, res));
+  return res;
+}
 
-  std::string res(piece.size, '\0');
-  iterate_piece(piece, [&](auto it, auto info) {
-    return it->get_piece(td::MutableSlice(res).substr(info.piece_offset, info.size), info.chunk_offset);
+td::Status Torrent::read_piece(td::uint64 piece_i, td::MutableSlice dest) {
+  if (!inited_info_) {
+    return td::Status::Error("Torrent info not inited");
+  }
+  if (piece_i >= info_.pieces_count()) {
+    return td::Status::Error("Piece idx is too big");
+  }
+  if (!piece_is_ready_[piece_i]) {
+    return td::Status::Error("Piece is not ready");
+  }
+  auto piece = info_.get_piece_info(piece_i);
+  if (dest.size() != piece.size) {
+    return td::Status::Error("Invalid piece size");
+  }
+  auto it = pending_pieces_.find(piece_i);
+  if (it != pending_pieces_.end()) {
+    dest.copy_from(it->second);
+    return td::Status::OK();
+  }
+  auto it2 = in_memory_pieces_.find(piece_i);
+  if (it2 != in_memory_pieces_.end()) {
+    dest.copy_from(it2->second.data);
+    return td::Status::OK();
+  }
+  return iterate_piece(piece, [&](auto it, auto info) {
+    return it->get_piece(dest.substr(info.piece_offset, info.size), info.chunk_offset);
   });
-  return res;
 }
 
 td::Result<td::Ref<vm::Cell>> Torrent::get_piece_proof(td::uint64 piece_i) {
@@ -24,6 +24,7 @@
 #include "td/utils/buffer.h"
 #include "td/db/utils/BlobView.h"
 
+#include <functional>
 #include <map>
 #include <set>
 
@@ -33,18 +34,37 @@ class Torrent {
   class Creator;
   friend class Creator;
   using Info = TorrentInfo;
+  // Called with the number of hashed pieces and the total number of pieces
+  using HashProgress = std::function<void(td::uint64, td::uint64)>;
 
   struct Options {
     std::string root_dir;
     bool in_memory{false};
     bool validate{false};
+    size_t hash_threads{1};
+    HashProgress hash_progress;
   };
 
   // creation
   static td::Result<Torrent> open(Options options, td::Bits256 hash);
   static td::Result<Torrent> open(Options options, TorrentMeta meta);
   static td::Result<Torrent> open(Options options, td::Slice meta_str);
-  void validate();
+  // Checks hashes of all pieces that are present on disk. Pieces are read in large blocks and hashed on up to `threads`
+  // threads, merkle tree is updated after each batch of pieces.
+  td::Status validate(size_t threads = 1, const HashProgress &progress = {});
+  // Number of hashing threads to request for a torrent. Threads of all concurrent validations and creations are
+  // taken from one budget of this size, so the calling thread may end up hashing alone.
+  static size_t max_hash_threads();
+  struct HashingJob {
+    std::string title;
+    td::uint64 hashed_pieces{0};
+    td::uint64 total_pieces{0};
+  };
+  // Progress callback that logs hashing progress at most once in a few seconds. The job is listed in
+  // get_hashing_jobs() from the first call until the last copy of the callback is destroyed
+  static HashProgress track_hash_progress(std::string title);
+  // Validations and creations of all torrents that are hashing pieces now
+  static std::vector<HashingJob> get_hashing_jobs();
 
   std::string get_stats_str() const;
 
@@ -52,6 +72,8 @@ class Torrent {
 
   // get piece and proof
   td::Result<std::string> get_piece_data(td::uint64 piece_i);
+  // Reads a ready piece into dest, dest.size() must be equal to the size of the piece
+  td::Status read_piece(td::uint64 piece_i, td::MutableSlice dest);
   td::Result<td::Ref<vm::Cell>> get_piece_proof(td::uint64 piece_i);
 
   // add piece (with an optional proof)
@@ -233,6 +255,14 @@ class Torrent {
   td::Status init_chunk_data(ChunkState &chunk);
   template <class F>
   td::Status iterate_piece(Info::PieceInfo piece, F &&f);
+  template <class F>
+  static td::Status iterate_piece_chunks(std::vector<ChunkState> &chunks, Info::PieceInfo piece, F &&f);
+  using PieceHashes = std::vector<std::pair<size_t, td::Bits256>>;
+  // Hashes all pieces by batches and passes hashes of each batch to on_batch in the order of pieces.
+  // Pieces that can't be read are skipped, unless stop_on_error is set.
+  // Up to threads - 1 extra threads are taken from the budget shared by all torrents, see max_hash_threads().
+  static td::Status hash_pieces(const Info &info, std::vector<ChunkState> &chunks, size_t threads, bool stop_on_error,
+                                const HashProgress &progress, const std::function<void(PieceHashes)> &on_batch);
   void add_pending_pieces();
 
   td::Status add_pending_piece(td::uint64 piece_i, td::Slice data);
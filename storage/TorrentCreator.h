@@ -35,6 +35,10 @@ class Torrent::Creator {
     td::optional<std::string> dir_name;
 
     std::string description;
+
+    // Pieces are hashed on this number of threads
+    size_t threads{1};
+    HashProgress progress;
   };
 
   // If path is a file create a torrent with one file in it.
@@ -0,0 +1,144 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "UploadCache.h"
+
+#include "auto/tl/ton_api.h"
+#include "vm/boc.h"
+
+namespace ton {
+template <class T>
+T *UploadCache::Lru<T>::get(td::uint64 key) {
+  auto it = values_.find(key);
+  if (it == values_.end()) {
+    return nullptr;
+  }
+  order_.splice(order_.end(), order_, it->second.second);
+  return &it->second.first;
+}
+
+template <class T>
+void UploadCache::Lru<T>::put(td::uint64 key, T value, size_t max_size) {
+  auto it = values_.find(key);
+  if (it != values_.end()) {
+    it->second.first = std::move(value);
+    order_.splice(order_.end(), order_, it->second.second);
+    return;
+  }
+  while (values_.size() >= max_size && !order_.empty()) {
+    values_.erase(order_.front());
+    order_.pop_front();
+  }
+  values_.emplace(key, std::make_pair(std::move(value), order_.insert(order_.end(), key)));
+}
+
+td::Result<td::BufferSlice> UploadCache::get_piece_answer(Torrent &torrent, PeerId peer_id, td::uint64 piece_i) {
+  auto last_piece = last_piece_.get(peer_id);
+  bool sequential = last_piece && *last_piece + 1 == piece_i;
+  last_piece_.put(peer_id, piece_i, MAX_PEERS);
+
+  td::BufferSlice res;
+  if (auto answer = answers_.get(piece_i)) {
+    res = answer->clone();
+  } else {
+    TRY_RESULT_ASSIGN(res, build_answer(torrent, piece_i));
+    if (sequential) {
+      answers_.put(piece_i, res.clone(), MAX_ANSWERS);
+    }
+  }
+  if (sequential) {
+    read_ahead(torrent, piece_i + 1);
+  }
+  return std::move(res);
+}
+
+void UploadCache::clear() {
+  answers_.clear();
+  proofs_.clear();
+}
+
+td::Result<td::BufferSlice> UploadCache::serialize_piece_answer(Torrent &torrent, td::uint64 piece_i,
+                                                                td::Slice proof) {
+  // storage.piece proof:bytes data:bytes = storage.Piece;
+  // Same as create_serialize_tl_object<ton_api::storage_piece>, but the data is read directly into the answer
+  auto bytes_header_size = [](size_t len) -> size_t { return len < 254 ? 1 : 4; };
+  auto padding = [&](size_t len) -> size_t { return (4 - (bytes_header_size(len) + len) % 4) % 4; };
+  auto store_bytes_header = [&](td::MutableSlice &dest, size_t len) {
+    if (len < 254) {
+      dest[0] = static_cast<char>(len);
+    } else {
+      CHECK(len < (1 << 24));
+      dest[0] = static_cast<char>(254);
+      dest[1] = static_cast<char>(len & 255);
+      dest[2] = static_cast<char>((len >> 8) & 255);
+      dest[3] = static_cast<char>(len >> 16);
+    }
+    dest.remove_prefix(bytes_header_size(len));
+  };
+
+  size_t data_size = torrent.get_info().get_piece_info(piece_i).size;
+  td::BufferSlice res(4 + bytes_header_size(proof.size()) + proof.size() + padding(proof.size()) +
+                      bytes_header_size(data_size) + data_size + padding(data_size));
+  auto dest = res.as_slice();
+  td::int32 id = ton_api::storage_piece::ID;
+  dest.copy_from(td::Slice(reinterpret_cast<const char *>(&id), 4));
+  dest.remove_prefix(4);
+  store_bytes_header(dest, proof.size());
+  dest.copy_from(proof);
+  dest.remove_prefix(proof.size());
+  dest.substr(0, padding(proof.size())).fill_zero();
+  dest.remove_prefix(padding(proof.size()));
+  store_bytes_header(dest, data_size);
+  TRY_STATUS(torrent.read_piece(piece_i, dest.substr(0, data_size)));
+  dest.remove_prefix(data_size);
+  CHECK(dest.size() == padding(data_size));
+  dest.fill_zero();
+  return std::move(res);
+}
+
+td::Result<td::BufferSlice> UploadCache::get_proof(Torrent &torrent, td::uint64 piece_i) {
+  if (auto proof = proofs_.get(piece_i)) {
+    return proof->clone();
+  }
+  TRY_RESULT(proof, torrent.get_piece_proof(piece_i));
+  TRY_RESULT(proof_serialized, vm::std_boc_serialize(std::move(proof)));
+  proofs_.put(piece_i, proof_serialized.clone(), MAX_PROOFS);
+  return std::move(proof_serialized);
+}
+
+td::Result<td::BufferSlice> UploadCache::build_answer(Torrent &torrent, td::uint64 piece_i) {
+  TRY_RESULT(proof, get_proof(torrent, piece_i));
+  return serialize_piece_answer(torrent, piece_i, proof);
+}
+
+void UploadCache::read_ahead(Torrent &torrent, td::uint64 piece_i) {
+  auto pieces_count = torrent.get_info().pieces_count();
+  for (td::uint64 i = piece_i; i < piece_i + READ_AHEAD && i < pieces_count; i++) {
+    if (!torrent.is_piece_ready(i)) {
+      break;
+    }
+    if (answers_.get(i)) {
+      continue;
+    }
+    auto r_answer = build_answer(torrent, i);
+    if (r_answer.is_error()) {
+      break;
+    }
+    answers_.put(i, r_answer.move_as_ok(), MAX_ANSWERS);
+  }
+}
+}  // namespace ton
@@ -0,0 +1,69 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PeerState.h"
+#include "Torrent.h"
+
+#include <list>
+#include <map>
+
+namespace ton {
+// Builds serialized storage.piece answers for peers.
+// Piece data is read from disk directly into the buffer of the answer, so serving a piece takes one copy of its data.
+// Serialized proofs of recently served pieces are cached. When a peer downloads pieces in order, the next pieces are
+// read ahead, their answers are kept in the cache and are shared by all peers that request them.
+class UploadCache {
+ public:
+  td::Result<td::BufferSlice> get_piece_answer(Torrent &torrent, PeerId peer_id, td::uint64 piece_i);
+  // Must be called when pieces become not ready or the files of the torrent are moved
+  void clear();
+
+  static td::Result<td::BufferSlice> serialize_piece_answer(Torrent &torrent, td::uint64 piece_i, td::Slice proof);
+
+  static constexpr size_t MAX_ANSWERS = 32;
+  static constexpr size_t MAX_PROOFS = 4096;
+  static constexpr td::uint64 READ_AHEAD = 8;
+  // Last requested piece is remembered for this many recently active peers
+  static constexpr size_t MAX_PEERS = 256;
+
+ private:
+  template <class T>
+  class Lru {
+   public:
+    T *get(td::uint64 key);
+    void put(td::uint64 key, T value, size_t max_size);
+    void clear() {
+      order_.clear();
+      values_.clear();
+    }
+
+   private:
+    std::list<td::uint64> order_;
+    std::map<td::uint64, std::pair<T, std::list<td::uint64>::iterator>> values_;
+  };
+
+  Lru<td::BufferSlice> answers_;
+  Lru<td::BufferSlice> proofs_;
+  Lru<td::uint64> last_piece_;  // by PeerId
+
+  td::Result<td::BufferSlice> get_proof(Torrent &torrent, td::uint64 piece_i);
+  td::Result<td::BufferSlice> build_answer(Torrent &torrent, td::uint64 piece_i);
+  void read_ahead(Torrent &torrent, td::uint64 piece_i);
+};
+}  // namespace ton
@@ -24,8 +24,25 @@
 #include "common/delay.h"
 #include "td/actor/MultiPromise.h"
 
+#include <set>
+
 namespace ton {
 
+// Masterchain blocks are created every ~5 seconds, contract states can't change more often
+static const double CHECK_ROUND_INTERVAL = 5.0;
+static const size_t CHECK_ROUND_MAX_QUERIES = 16;
+
+static const td::Slice PROOF_KEY_PREFIX = "proof";
+
+static std::string proof_db_key(const td::Bits256& microchunk_hash, td::uint64 offset) {
+  std::string key = PROOF_KEY_PREFIX.str();
+  key += microchunk_hash.as_slice().str();
+  for (int i = 56; i >= 0; i -= 8) {
+    key += (char)(offset >> i);
+  }
+  return key;
+}
+
 td::Result<ProviderParams> ProviderParams::create(const tl_object_ptr<ton_api::storage_daemon_provider_params>& obj) {
   ProviderParams p;
   p.accept_new_contracts = obj->accept_new_contracts_;
@@ -141,7 +158,11 @@ void StorageProvider::start_up() {
       r_tree.ensure();
       auto tree = r_tree.move_as_ok();
       if (tree) {
-        contract.microchunk_tree = std::make_shared<MicrochunkTree>(vm::std_boc_deserialize(tree->data_).move_as_ok());
+        contract.microchunk_tree = find_microchunk_tree(contract.microchunk_hash);
+        if (contract.microchunk_tree == nullptr) {
+          contract.microchunk_tree =
+              std::make_shared<MicrochunkTree>(vm::std_boc_deserialize(tree->data_).move_as_ok());
+        }
       }
 
       LOG(INFO) << "Loaded contract from db: " << address.to_string() << ", torrent=" << contract.torrent_hash.to_hex()
@@ -170,6 +191,8 @@ void StorageProvider::start_up() {
     }
   }
   LOG(INFO) << "Loaded contracts from db";
+  db_load_proof_cache();
+  gc_proof_cache();
 
   alarm();
 }
@@ -235,13 +258,35 @@ void StorageProvider::db_store_config() {
 }
 
 void StorageProvider::alarm() {
-  for (auto& p : contracts_) {
-    if (p.second.check_next_proof_at && p.second.check_next_proof_at.is_in_past()) {
-      p.second.check_next_proof_at = td::Timestamp::never();
-      check_next_proof(p.first, p.second);
+  // A round in progress re-arms the alarm when it is over
+  if (!check_round_) {
+    if (next_check_round_at_.is_in_past()) {
+      next_check_round_at_ = td::Timestamp::in(CHECK_ROUND_INTERVAL);
+      start_check_round();
     }
-    alarm_timestamp().relax(p.second.check_next_proof_at);
+    alarm_timestamp().relax(next_check_round_at_);
+  }
+
+  if (td::Time::now() - cur_query_stats_.started_at >= 3600.0) {
+    LOG(INFO) << "Storage provider: " << contracts_.size() << " contracts, "
+              << prev_query_stats_.queries + cur_query_stats_.queries << " liteserver queries in the last "
+              << td::format::as_time(td::Time::now() - prev_query_stats_.started_at) << " ("
+              << get_queries_per_contract_hour() << " per contract per hour)";
+    prev_query_stats_ = cur_query_stats_;
+    cur_query_stats_ = QueryStats();
   }
+  alarm_timestamp().relax(td::Timestamp::at(cur_query_stats_.started_at + 3600.0));
+}
+
+void StorageProvider::add_queries(td::uint64 count) {
+  cur_query_stats_.queries += count;
+  total_queries_ += count;
+}
+
+double StorageProvider::get_queries_per_contract_hour() const {
+  double period = std::max(td::Time::now() - prev_query_stats_.started_at, 60.0);
+  td::uint64 queries = prev_query_stats_.queries + cur_query_stats_.queries;
+  return (double)queries / period * 3600.0 / (double)std::max<size_t>(contracts_.size(), 1);
 }
 
 void StorageProvider::process_transaction(tl_object_ptr<tonlib_api::raw_transaction> transaction) {
@@ -283,6 +328,7 @@ void StorageProvider::process_transaction(tl_object_ptr<tonlib_api::raw_transact
 
 void StorageProvider::on_new_storage_contract(ContractAddress address, td::Promise<td::Unit> promise, int max_retries) {
   LOG(INFO) << "Processing new storage contract: " << address.to_string();
+  add_queries();
   get_storage_contract_data(
       address, tonlib_client_,
       [SelfId = actor_id(this), address, promise = std::move(promise),
@@ -385,6 +431,73 @@ void StorageProvider::db_update_microchunk_tree(const ContractAddress& address)
   db_->commit_transaction().ensure();
 }
 
+void StorageProvider::db_load_proof_cache() {
+  std::string end = PROOF_KEY_PREFIX.str();
+  end.back()++;
+  db_->for_each_in_range(PROOF_KEY_PREFIX, end, [&](td::Slice key, td::Slice value) -> td::Status {
+    if (key.size() != PROOF_KEY_PREFIX.size() + 32 + 8 || !td::begins_with(key, PROOF_KEY_PREFIX)) {
+      return td::Status::OK();
+    }
+    key.remove_prefix(PROOF_KEY_PREFIX.size());
+    td::Bits256 microchunk_hash(key.ubegin());
+    td::uint64 offset = 0;
+    for (size_t i = 32; i < 40; ++i) {
+      offset = (offset << 8) | key.ubegin()[i];
+    }
+    auto r_proof = vm::std_boc_deserialize(value);
+    if (r_proof.is_error()) {
+      LOG(WARNING) << "Invalid proof in db: " << r_proof.move_as_error();
+      return td::Status::OK();
+    }
+    proof_cache_[{microchunk_hash, offset}] = r_proof.move_as_ok();
+    return td::Status::OK();
+  }).ensure();
+  LOG(INFO) << "Loaded " << proof_cache_.size() << " proofs from db";
+}
+
+void StorageProvider::db_update_proof(const td::Bits256& microchunk_hash, td::uint64 offset,
+                                      td::Ref<vm::Cell> proof) {
+  LOG(DEBUG) << "db_update_proof " << microchunk_hash.to_hex() << " " << offset;
+  db_->begin_transaction().ensure();
+  std::string key = proof_db_key(microchunk_hash, offset);
+  if (proof.is_null()) {
+    db_->erase(key).ensure();
+  } else {
+    db_->set(key, vm::std_boc_serialize(proof).move_as_ok().as_slice()).ensure();
+  }
+  db_->commit_transaction().ensure();
+}
+
+void StorageProvider::gc_proof_cache() {
+  std::set<std::pair<td::Bits256, td::uint64>> needed;
+  // Trees of contracts that were not checked since the start: any proof may be needed
+  std::set<td::Bits256> unknown;
+  for (const auto& p : contracts_) {
+    if (p.second.next_proof) {
+      needed.emplace(p.second.microchunk_hash, p.second.next_proof.value());
+    } else {
+      unknown.insert(p.second.microchunk_hash);
+    }
+  }
+  for (auto it = proof_cache_.begin(); it != proof_cache_.end();) {
+    if (needed.count(it->first) || unknown.count(it->first.first)) {
+      ++it;
+    } else {
+      db_update_proof(it->first.first, it->first.second, {});
+      it = proof_cache_.erase(it);
+    }
+  }
+}
+
+std::shared_ptr<MicrochunkTree> StorageProvider::find_microchunk_tree(const td::Bits256& microchunk_hash) const {
+  for (const auto& p : contracts_) {
+    if (p.second.microchunk_hash == microchunk_hash && p.second.microchunk_tree != nullptr) {
+      return p.second.microchunk_tree;
+    }
+  }
+  return nullptr;
+}
+
 void StorageProvider::init_new_storage_contract(ContractAddress address, StorageContract& contract) {
   CHECK(contract.state == StorageContract::st_downloading);
   td::actor::send_closure(storage_manager_, &StorageManager::add_torrent_by_hash, contract.torrent_hash, "", false,
@@ -408,7 +521,7 @@ void StorageProvider::init_new_storage_contract(ContractAddress address, Storage
   td::actor::send_closure(
       storage_manager_, &StorageManager::wait_for_completion, contract.torrent_hash,
       [SelfId = actor_id(this), address, hash = contract.torrent_hash, microchunk_hash = contract.microchunk_hash,
-       manager = storage_manager_](td::Result<td::Unit> R) {
+       manager = storage_manager_, tree = find_microchunk_tree(contract.microchunk_hash)](td::Result<td::Unit> R) {
         if (R.is_error()) {
           LOG(WARNING) << "Failed to download torrent " << hash.to_hex() << ": " << R.move_as_error();
           td::actor::send_closure(SelfId, &StorageProvider::do_close_storage_contract, address);
@@ -417,19 +530,23 @@ void StorageProvider::init_new_storage_contract(ContractAddress address, Storage
         LOG(DEBUG) << "Downloaded torrent " << hash;
         td::actor::send_closure(
             manager, &StorageManager::with_torrent, hash,
-            [SelfId, address, hash, microchunk_hash](td::Result<NodeActor::NodeState> R) {
-              auto r_microchunk_tree = [&]() -> td::Result<MicrochunkTree> {
+            [SelfId, address, hash, microchunk_hash, tree](td::Result<NodeActor::NodeState> R) {
+              auto r_microchunk_tree = [&]() -> td::Result<std::shared_ptr<MicrochunkTree>> {
                 TRY_RESULT(state, std::move(R));
                 Torrent& torrent = state.torrent;
                 if (!torrent.is_completed() || torrent.get_included_size() != torrent.get_info().file_size) {
                   return td::Status::Error("unknown error");
                 }
+                if (tree != nullptr) {
+                  // Another contract stores the same file
+                  return tree;
+                }
                 LOG(DEBUG) << "Building microchunk tree for " << hash;
-                TRY_RESULT(tree, MicrochunkTree::Builder::build_for_torrent(torrent));
-                if (tree.get_root_hash() != microchunk_hash) {
+                TRY_RESULT(new_tree, MicrochunkTree::Builder::build_for_torrent(torrent));
+                if (new_tree.get_root_hash() != microchunk_hash) {
                   return td::Status::Error("microchunk tree hash mismatch");
                 }
-                return tree;
+                return std::make_shared<MicrochunkTree>(std::move(new_tree));
               }();
               if (r_microchunk_tree.is_error()) {
                 LOG(WARNING) << "Failed to download torrent " << hash.to_hex() << ": " << R.move_as_error();
@@ -442,7 +559,7 @@ void StorageProvider::init_new_storage_contract(ContractAddress address, Storage
       });
 }
 
-void StorageProvider::downloaded_torrent(ContractAddress address, MicrochunkTree microchunk_tree) {
+void StorageProvider::downloaded_torrent(ContractAddress address, std::shared_ptr<MicrochunkTree> microchunk_tree) {
   auto it = contracts_.find(address);
   if (it == contracts_.end()) {
     LOG(WARNING) << "Contract " << address.to_string() << " does not exist anymore";
@@ -452,7 +569,7 @@ void StorageProvider::downloaded_torrent(ContractAddress address, MicrochunkTree
   LOG(INFO) << "Finished downloading torrent " << contract.torrent_hash.to_hex() << " for contract "
             << address.to_string();
   contract.state = StorageContract::st_downloaded;
-  contract.microchunk_tree = std::make_shared<MicrochunkTree>(std::move(microchunk_tree));
+  contract.microchunk_tree = std::move(microchunk_tree);
   db_update_microchunk_tree(address);
   db_update_storage_contract(address, false);
   after_contract_downloaded(address);
@@ -474,6 +591,7 @@ void StorageProvider::after_contract_downloaded(ContractAddress address, td::Tim
                             }
                             LOG(DEBUG) << "Set active upload: OK";
                           });
+  add_queries();
   get_storage_contract_data(address, tonlib_client_,
                             [=, SelfId = actor_id(this)](td::Result<StorageContractData> R) mutable {
                               if (R.is_error()) {
@@ -532,7 +650,7 @@ void StorageProvider::activated_storage_contract(ContractAddress address) {
   auto& contract = it->second;
   contract.state = StorageContract::st_active;
   db_update_storage_contract(address, false);
-  alarm_timestamp().relax(contract.check_next_proof_at = td::Timestamp::in(1.0));
+  contract.check_next_proof_at = td::Timestamp::now();
 }
 
 void StorageProvider::do_close_storage_contract(ContractAddress address) {
@@ -568,6 +686,7 @@ void StorageProvider::send_close_storage_contract(ContractAddress address) {
 }
 
 void StorageProvider::check_storage_contract_deleted(ContractAddress address, td::Timestamp retry_false_until) {
+  add_queries();
   check_contract_exists(address, tonlib_client_, [=, SelfId = actor_id(this)](td::Result<bool> R) {
     if (R.is_error()) {
       delay_action(
@@ -617,18 +736,77 @@ void StorageProvider::storage_contract_deleted(ContractAddress address) {
   db_update_storage_contract(address, true);
 }
 
-void StorageProvider::check_next_proof(ContractAddress address, StorageContract& contract) {
-  if (contract.state != StorageContract::st_active) {
+void StorageProvider::start_check_round() {
+  std::vector<ContractAddress> queue;
+  for (const auto& p : contracts_) {
+    if (p.second.state == StorageContract::st_active && p.second.check_next_proof_at &&
+        p.second.check_next_proof_at.is_in_past()) {
+      queue.push_back(p.first);
+    }
+  }
+  if (queue.empty()) {
     return;
   }
-  CHECK(contract.microchunk_tree != nullptr);
-  get_storage_contract_data(
-      address, tonlib_client_, [SelfId = actor_id(this), address](td::Result<StorageContractData> R) {
-        td::actor::send_closure(SelfId, &StorageProvider::got_next_proof_info, address, std::move(R));
-      });
+  check_round_ = CheckRound();
+  check_round_.value().queue = std::move(queue);
+  add_queries();
+  get_last_block([SelfId = actor_id(this)](td::Result<BlockIdExt> R) {
+    td::actor::send_closure(SelfId, &StorageProvider::got_check_round_block, std::move(R));
+  });
+}
+
+void StorageProvider::got_check_round_block(td::Result<BlockIdExt> R) {
+  CHECK(check_round_);
+  if (R.is_error()) {
+    LOG(WARNING) << "Failed to get last masterchain block: " << R.move_as_error();
+    check_round_ = {};
+    alarm_timestamp().relax(next_check_round_at_);
+    return;
+  }
+  BlockIdExt block_id = R.move_as_ok();
+  if (block_id.seqno() <= last_checked_seqno_) {
+    // Contracts could not change since the previous round
+    check_round_ = {};
+    alarm_timestamp().relax(next_check_round_at_);
+    return;
+  }
+  last_checked_seqno_ = block_id.seqno();
+  auto& round = check_round_.value();
+  round.block_id = block_id;
+  LOG(DEBUG) << "Checking " << round.queue.size() << " storage contracts at " << block_id.to_str();
+  check_round_send_queries();
+}
+
+void StorageProvider::check_round_send_queries() {
+  CHECK(check_round_);
+  auto& round = check_round_.value();
+  while (round.in_flight < CHECK_ROUND_MAX_QUERIES && !round.queue.empty()) {
+    ContractAddress address = round.queue.back();
+    round.queue.pop_back();
+    auto it = contracts_.find(address);
+    if (it == contracts_.end() || it->second.state != StorageContract::st_active) {
+      continue;
+    }
+    it->second.check_next_proof_at = td::Timestamp::never();
+    ++round.in_flight;
+    add_queries();
+    get_contract_data(address, round.block_id, [SelfId = actor_id(this), address](td::Result<StorageContractData> R) {
+      td::actor::send_closure(SelfId, &StorageProvider::got_next_proof_info, address, std::move(R));
+    });
+  }
+  if (round.in_flight == 0) {
+    finish_check_round();
+  }
 }
 
 void StorageProvider::got_next_proof_info(ContractAddress address, td::Result<StorageContractData> R) {
+  CHECK(check_round_);
+  --check_round_.value().in_flight;
+  process_next_proof_info(address, std::move(R));
+  check_round_send_queries();
+}
+
+void StorageProvider::process_next_proof_info(ContractAddress address, td::Result<StorageContractData> R) {
   auto it = contracts_.find(address);
   if (it == contracts_.end() || it->second.state != StorageContract::st_active) {
     return;
@@ -636,12 +814,15 @@ void StorageProvider::got_next_proof_info(ContractAddress address, td::Result<St
   auto& contract = it->second;
   if (R.is_error()) {
     LOG(ERROR) << "get_next_proof_info for " << address.to_string() << ": " << R.move_as_error();
+    add_queries();
     check_contract_exists(address, tonlib_client_, [SelfId = actor_id(this), address](td::Result<bool> R) {
       td::actor::send_closure(SelfId, &StorageProvider::got_contract_exists, address, std::move(R));
     });
     return;
   }
   auto data = R.move_as_ok();
+  td::uint64 l = data.next_proof / MicrochunkTree::MICROCHUNK_SIZE * MicrochunkTree::MICROCHUNK_SIZE;
+  contract.next_proof = l;
   if (data.balance->sgn() == 0) {
     LOG(INFO) << "Balance of contract " << address.to_string() << " is zero, closing";
     do_close_storage_contract(address);
@@ -651,25 +832,76 @@ void StorageProvider::got_next_proof_info(ContractAddress address, td::Result<St
   if (now < send_at) {
     LOG(DEBUG) << "Will send proof in " << send_at - now << "s (last_proof_time=" << data.last_proof_time
                << ", max_span=" << data.max_span << ")";
-    alarm_timestamp().relax(contract.check_next_proof_at = td::Timestamp::in(send_at - now + 2));
+    contract.check_next_proof_at = td::Timestamp::in(send_at - now + 2);
     return;
   }
 
   LOG(INFO) << "Sending proof for " << address.to_string() << ": next_proof=" << data.next_proof
             << ", max_span=" << data.max_span << ", last_proof_time=" << data.last_proof_time << " ("
             << now - data.last_proof_time << "s ago)";
+  auto cached = proof_cache_.find({contract.microchunk_hash, l});
+  if (cached != proof_cache_.end()) {
+    LOG(DEBUG) << "Using cached proof for " << address.to_string();
+    send_next_proof(address, cached->second);
+    return;
+  }
+  CHECK(contract.microchunk_tree != nullptr);
+  check_round_.value().proofs[contract.torrent_hash].push_back(
+      CheckRound::ProofRequest{address, contract.microchunk_hash, l, contract.microchunk_tree});
+}
+
+void StorageProvider::finish_check_round() {
+  CHECK(check_round_);
+  auto proofs = std::move(check_round_.value().proofs);
+  check_round_ = {};
+  gc_proof_cache();
+  alarm_timestamp().relax(next_check_round_at_);
+  for (auto& p : proofs) {
+    build_proofs(p.first, std::move(p.second),
+                 [SelfId = actor_id(this)](
+                     td::Result<std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>>> R) {
+                   if (R.is_error()) {
+                     LOG(ERROR) << "Failed to build proofs: " << R.move_as_error();
+                     return;
+                   }
+                   td::actor::send_closure(SelfId, &StorageProvider::got_proofs, R.move_as_ok());
+                 });
+  }
+}
+
+void StorageProvider::get_last_block(td::Promise<BlockIdExt> promise) {
+  get_last_masterchain_block(tonlib_client_, std::move(promise));
+}
+
+void StorageProvider::get_contract_data(ContractAddress address, BlockIdExt block_id,
+                                        td::Promise<StorageContractData> promise) {
+  get_storage_contract_data(address, tonlib_client_, block_id, std::move(promise));
+}
+
+void StorageProvider::build_proofs(
+    td::Bits256 torrent_hash, std::vector<CheckRound::ProofRequest> requests,
+    td::Promise<std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>>> promise) {
   td::actor::send_closure(
-      storage_manager_, &StorageManager::with_torrent, contract.torrent_hash,
-      [=, SelfId = actor_id(this), tree = contract.microchunk_tree](td::Result<NodeActor::NodeState> R) {
-        if (R.is_error()) {
-          LOG(ERROR) << "Missing torrent for " << address.to_string();
-          return;
+      storage_manager_, &StorageManager::with_torrent, torrent_hash,
+      [requests = std::move(requests), promise = std::move(promise)](td::Result<NodeActor::NodeState> R) mutable {
+        std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>> result;
+        std::map<std::pair<td::Bits256, td::uint64>, td::Ref<vm::Cell>> built;
+        for (auto& req : requests) {
+          td::Result<td::Ref<vm::Cell>> r_proof;
+          auto key = std::make_pair(req.microchunk_hash, req.offset);
+          if (R.is_error()) {
+            r_proof = R.error().clone();
+          } else if (built.count(key)) {
+            r_proof = built[key];
+          } else {
+            r_proof = req.tree->get_proof(req.offset, req.offset + MicrochunkTree::MICROCHUNK_SIZE, R.ok().torrent);
+            if (r_proof.is_ok()) {
+              built[key] = r_proof.ok();
+            }
+          }
+          result.emplace_back(std::move(req), std::move(r_proof));
         }
-        auto state = R.move_as_ok();
-        td::uint64 l = data.next_proof / MicrochunkTree::MICROCHUNK_SIZE * MicrochunkTree::MICROCHUNK_SIZE;
-        td::uint64 r = l + MicrochunkTree::MICROCHUNK_SIZE;
-        auto proof = tree->get_proof(l, r, state.torrent);
-        td::actor::send_closure(SelfId, &StorageProvider::got_next_proof, address, std::move(proof));
+        promise.set_value(std::move(result));
       });
 }
 
@@ -681,37 +913,57 @@ void StorageProvider::got_contract_exists(ContractAddress address, td::Result<bo
   auto& contract = it->second;
   if (R.is_error()) {
     LOG(ERROR) << "Check contract exists for " << address.to_string() << ": " << R.move_as_error();
-    alarm_timestamp().relax(contract.check_next_proof_at = td::Timestamp::in(10.0));
+    contract.check_next_proof_at = td::Timestamp::in(10.0);
     return;
   }
   if (R.ok()) {
-    alarm_timestamp().relax(contract.check_next_proof_at = td::Timestamp::in(10.0));
+    contract.check_next_proof_at = td::Timestamp::in(10.0);
     return;
   }
   storage_contract_deleted(address);
 }
 
-void StorageProvider::got_next_proof(ContractAddress address, td::Result<td::Ref<vm::Cell>> R) {
-  if (R.is_error()) {
-    LOG(ERROR) << "Failed to build proof: " << R.move_as_error();
+void StorageProvider::got_proofs(
+    std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>> proofs) {
+  for (auto& p : proofs) {
+    const CheckRound::ProofRequest& req = p.first;
+    if (p.second.is_error()) {
+      LOG(ERROR) << "Failed to build proof for " << req.address.to_string() << ": " << p.second.move_as_error();
+      sent_next_proof(req.address);
+      continue;
+    }
+    td::Ref<vm::Cell> proof = p.second.move_as_ok();
+    auto key = std::make_pair(req.microchunk_hash, req.offset);
+    if (!proof_cache_.count(key)) {
+      proof_cache_[key] = proof;
+      db_update_proof(req.microchunk_hash, req.offset, proof);
+    }
+    send_next_proof(req.address, std::move(proof));
+  }
+}
+
+void StorageProvider::send_next_proof(ContractAddress address, td::Ref<vm::Cell> proof) {
+  auto it = contracts_.find(address);
+  if (it == contracts_.end() || it->second.state != StorageContract::st_active) {
     return;
   }
-  LOG(INFO) << "Got proof, sending";
+  send_proof(address, std::move(proof), [SelfId = actor_id(this), address](td::Result<td::Unit> R) {
+    if (R.is_error()) {
+      LOG(ERROR) << "Failed to send proof message: " << R.move_as_error();
+    } else {
+      LOG(DEBUG) << "Proof for " << address.to_string() << " was sent";
+    }
+    td::actor::send_closure(SelfId, &StorageProvider::sent_next_proof, address);
+  });
+}
 
+void StorageProvider::send_proof(ContractAddress address, td::Ref<vm::Cell> proof, td::Promise<td::Unit> promise) {
   vm::CellBuilder b;
   b.store_long(0x419d5d4d, 32);  // const op::proof_storage = 0x419d5d4d;
   b.store_long(0, 64);           // query_id
-  b.store_ref(R.move_as_ok());
+  b.store_ref(std::move(proof));
   td::actor::send_closure(contract_wrapper_, &FabricContractWrapper::send_internal_message, address,
-                          td::make_refint(100'000'000), b.as_cellslice(),
-                          [SelfId = actor_id(this), address](td::Result<td::Unit> R) {
-                            if (R.is_error()) {
-                              LOG(ERROR) << "Failed to send proof message: " << R.move_as_error();
-                            } else {
-                              LOG(DEBUG) << "Proof for " << address.to_string() << " was sent";
-                            }
-                            td::actor::send_closure(SelfId, &StorageProvider::sent_next_proof, address);
-                          });
+                          td::make_refint(100'000'000), b.as_cellslice(), std::move(promise));
 }
 
 void StorageProvider::sent_next_proof(ContractAddress address) {
@@ -720,7 +972,7 @@ void StorageProvider::sent_next_proof(ContractAddress address) {
     return;
   }
   auto& contract = it->second;
-  alarm_timestamp().relax(contract.check_next_proof_at = td::Timestamp::in(30.0));
+  contract.check_next_proof_at = td::Timestamp::in(30.0);
 }
 
 void StorageProvider::get_provider_info(bool with_balances, bool with_contracts,
@@ -735,6 +987,7 @@ void StorageProvider::get_provider_info(bool with_balances, bool with_contracts,
   result->contracts_count_ = (int)contracts_.size();
   result->contracts_total_size_ = contracts_total_size_;
   if (with_balances) {
+    add_queries();
     get_contract_balance(main_address_, tonlib_client_, ig.get_promise().wrap([result](td::RefInt256 balance) {
       result->balance_ = balance->to_dec_string();
       return td::Unit();
@@ -774,6 +1027,7 @@ void StorageProvider::get_provider_info(bool with_balances, bool with_contracts,
                                 });
       }
       if (with_balances) {
+        add_queries(2);
         get_contract_balance(p.first, tonlib_client_,
                              [i, result, promise = ig.get_promise()](td::Result<td::RefInt256> R) mutable {
                                if (R.is_ok()) {
@@ -796,6 +1050,11 @@ void StorageProvider::get_provider_info(bool with_balances, bool with_contracts,
   }
 }
 
+void StorageProvider::get_provider_stats(td::Promise<tl_object_ptr<ton_api::storage_daemon_providerStats>> promise) {
+  promise.set_result(create_tl_object<ton_api::storage_daemon_providerStats>(total_queries_,
+                                                                            get_queries_per_contract_hour()));
+}
+
 void StorageProvider::set_provider_config(Config config, td::Promise<td::Unit> promise) {
   config_ = config;
   LOG(INFO) << "Changing provider config: max_contracts=" << config_.max_contracts
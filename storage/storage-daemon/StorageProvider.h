@@ -61,12 +61,13 @@ class StorageProvider : public td::actor::Actor {
 
   void get_provider_info(bool with_balances, bool with_contracts,
                          td::Promise<tl_object_ptr<ton_api::storage_daemon_providerInfo>> promise);
+  void get_provider_stats(td::Promise<tl_object_ptr<ton_api::storage_daemon_providerStats>> promise);
   void set_provider_config(Config config, td::Promise<td::Unit> promise);
   void withdraw(ContractAddress address, td::Promise<td::Unit> promise);
   void send_coins(ContractAddress dest, td::RefInt256 amount, std::string message, td::Promise<td::Unit> promise);
   void close_storage_contract(ContractAddress address, td::Promise<td::Unit> promise);
 
- private:
+ protected:
   ContractAddress main_address_;
   std::string db_root_;
   td::actor::ActorId<tonlib::TonlibClientWrapper> tonlib_client_;
@@ -90,14 +91,55 @@ class StorageProvider : public td::actor::Actor {
     td::uint32 max_span = 0;
     td::RefInt256 rate = td::zero_refint();
 
-    // TODO: Compute and store only one tree for duplicating torrents
+    // Contracts with the same microchunk hash share one tree
     std::shared_ptr<MicrochunkTree> microchunk_tree;
 
     td::Timestamp check_next_proof_at = td::Timestamp::never();
+    // Offset of the chunk that the contract expects to be proven, as of the last check (unknown after restart)
+    td::optional<td::uint64> next_proof;
   };
   std::map<ContractAddress, StorageContract> contracts_;
   td::uint64 contracts_total_size_ = 0;
 
+  // Contracts are checked in rounds: contracts that are due are fetched together, at most once per masterchain block,
+  // with a limited number of queries in flight. Proofs are built after the round, one storage query per torrent.
+  struct CheckRound {
+    BlockIdExt block_id;
+    std::vector<ContractAddress> queue;
+    size_t in_flight = 0;
+    struct ProofRequest {
+      ContractAddress address;
+      td::Bits256 microchunk_hash;
+      td::uint64 offset;
+      std::shared_ptr<MicrochunkTree> tree;
+    };
+    std::map<td::Bits256, std::vector<ProofRequest>> proofs;
+  };
+  td::optional<CheckRound> check_round_;
+  td::Timestamp next_check_round_at_ = td::Timestamp::now();
+  BlockSeqno last_checked_seqno_ = 0;
+
+  // Proofs by (microchunk hash, offset). They are kept in db until the contracts request another chunk,
+  // so a proof is not rebuilt after failed transactions or restarts.
+  std::map<std::pair<td::Bits256, td::uint64>, td::Ref<vm::Cell>> proof_cache_;
+
+  // Liteserver queries made to monitor contracts, in the current hour and in the previous one
+  struct QueryStats {
+    double started_at = td::Time::now();
+    td::uint64 queries = 0;
+  };
+  QueryStats cur_query_stats_, prev_query_stats_;
+  td::uint64 total_queries_ = 0;
+
+  // Chain and torrent access of check rounds. Tests replace them to run rounds without liteservers and torrents
+  virtual void get_last_block(td::Promise<BlockIdExt> promise);
+  virtual void get_contract_data(ContractAddress address, BlockIdExt block_id,
+                                 td::Promise<StorageContractData> promise);
+  virtual void build_proofs(
+      td::Bits256 torrent_hash, std::vector<CheckRound::ProofRequest> requests,
+      td::Promise<std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>>> promise);
+  virtual void send_proof(ContractAddress address, td::Ref<vm::Cell> proof, td::Promise<td::Unit> promise);
+
   void process_transaction(tl_object_ptr<tonlib_api::raw_transaction> transaction);
 
   void db_store_state();
@@ -108,7 +150,7 @@ class StorageProvider : public td::actor::Actor {
   void on_new_storage_contract(ContractAddress address, td::Promise<td::Unit> promise, int max_retries = 10);
   void on_new_storage_contract_cont(ContractAddress address, StorageContractData data, td::Promise<td::Unit> promise);
   void init_new_storage_contract(ContractAddress address, StorageContract& contract);
-  void downloaded_torrent(ContractAddress address, MicrochunkTree microchunk_tree);
+  void downloaded_torrent(ContractAddress address, std::shared_ptr<MicrochunkTree> microchunk_tree);
   void after_contract_downloaded(ContractAddress address, td::Timestamp retry_until = td::Timestamp::in(30.0),
                                  td::Timestamp retry_false_until = td::Timestamp::never());
   void activate_contract_cont(ContractAddress address);
@@ -119,11 +161,25 @@ class StorageProvider : public td::actor::Actor {
   void send_close_storage_contract(ContractAddress address);
   void storage_contract_deleted(ContractAddress address);
 
-  void check_next_proof(ContractAddress address, StorageContract& contract);
+  std::shared_ptr<MicrochunkTree> find_microchunk_tree(const td::Bits256& microchunk_hash) const;
+
+  void start_check_round();
+  void got_check_round_block(td::Result<BlockIdExt> R);
+  void check_round_send_queries();
+  void finish_check_round();
   void got_next_proof_info(ContractAddress address, td::Result<StorageContractData> R);
+  void process_next_proof_info(ContractAddress address, td::Result<StorageContractData> R);
   void got_contract_exists(ContractAddress address, td::Result<bool> R);
-  void got_next_proof(ContractAddress address, td::Result<td::Ref<vm::Cell>> R);
+  void got_proofs(std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>> proofs);
+  void send_next_proof(ContractAddress address, td::Ref<vm::Cell> proof);
   void sent_next_proof(ContractAddress address);
+
+  void db_load_proof_cache();
+  void db_update_proof(const td::Bits256& microchunk_hash, td::uint64 offset, td::Ref<vm::Cell> proof);
+  void gc_proof_cache();
+
+  void add_queries(td::uint64 count = 1);
+  double get_queries_per_contract_hour() const;
 };
 
 }  // namespace ton
\ No newline at end of file
@@ -32,14 +32,44 @@ static void smc_forget(td::actor::ActorId<tonlib::TonlibClientWrapper> client, t
                           });
 }
 
+static void smc_load(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                     BlockIdExt block_id, td::Promise<tonlib_api::object_ptr<tonlib_api::smc_info>> promise) {
+  auto query =
+      create_tl_object<tonlib_api::smc_load>(create_tl_object<tonlib_api::accountAddress>(address.to_string()));
+  if (!block_id.is_valid()) {
+    td::actor::send_closure(client, &tonlib::TonlibClientWrapper::send_request<tonlib_api::smc_load>, std::move(query),
+                            std::move(promise));
+    return;
+  }
+  auto with_block = create_tl_object<tonlib_api::withBlock>(
+      create_tl_object<tonlib_api::ton_blockIdExt>(block_id.id.workchain, block_id.id.shard, block_id.id.seqno,
+                                                   block_id.root_hash.as_slice().str(),
+                                                   block_id.file_hash.as_slice().str()),
+      std::move(query));
+  td::actor::send_closure(
+      client, &tonlib::TonlibClientWrapper::send_request<tonlib_api::withBlock>, std::move(with_block),
+      promise.wrap(
+          [](tonlib_api::object_ptr<tonlib_api::Object> obj) -> td::Result<tl_object_ptr<tonlib_api::smc_info>> {
+            if (obj->get_id() != tonlib_api::smc_info::ID) {
+              return td::Status::Error("Unexpected response to smc.load");
+            }
+            return move_tl_object_as<tonlib_api::smc_info>(std::move(obj));
+          }));
+}
+
 void run_get_method(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client, std::string method,
                     std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>> args,
                     td::Promise<std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>>> promise) {
+  run_get_method(address, client, BlockIdExt{}, std::move(method), std::move(args), std::move(promise));
+}
+
+void run_get_method(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                    BlockIdExt block_id, std::string method,
+                    std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>> args,
+                    td::Promise<std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>>> promise) {
   LOG(DEBUG) << "Running get method " << method << " on " << address.to_string();
-  auto query =
-      create_tl_object<tonlib_api::smc_load>(create_tl_object<tonlib_api::accountAddress>(address.to_string()));
-  td::actor::send_closure(
-      client, &tonlib::TonlibClientWrapper::send_request<tonlib_api::smc_load>, std::move(query),
+  smc_load(
+      address, client, block_id,
       [client, method = std::move(method), args = std::move(args),
        promise = std::move(promise)](td::Result<tonlib_api::object_ptr<tonlib_api::smc_info>> R) mutable {
         TRY_RESULT_PROMISE(promise, obj, std::move(R));
@@ -92,6 +122,21 @@ void get_contract_balance(ContractAddress address, td::actor::ActorId<tonlib::To
       }));
 }
 
+void get_last_masterchain_block(td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                                td::Promise<BlockIdExt> promise) {
+  auto query = create_tl_object<tonlib_api::blocks_getMasterchainInfo>();
+  td::actor::send_closure(
+      client, &tonlib::TonlibClientWrapper::send_request<tonlib_api::blocks_getMasterchainInfo>, std::move(query),
+      promise.wrap([](tonlib_api::object_ptr<tonlib_api::blocks_masterchainInfo> r) -> td::Result<BlockIdExt> {
+        if (r->last_ == nullptr || r->last_->root_hash_.size() != 32 || r->last_->file_hash_.size() != 32) {
+          return td::Status::Error("Invalid masterchain block id");
+        }
+        return BlockIdExt(r->last_->workchain_, r->last_->shard_, r->last_->seqno_,
+                          td::Bits256(td::Slice(r->last_->root_hash_).ubegin()),
+                          td::Bits256(td::Slice(r->last_->file_hash_).ubegin()));
+      }));
+}
+
 FabricContractWrapper::FabricContractWrapper(ContractAddress address,
                                              td::actor::ActorId<tonlib::TonlibClientWrapper> client,
                                              td::actor::ActorId<keyring::Keyring> keyring,
@@ -466,8 +511,13 @@ td::Ref<vm::Cell> create_new_contract_message_body(td::Ref<vm::Cell> info, td::B
 
 void get_storage_contract_data(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
                                td::Promise<StorageContractData> promise) {
+  get_storage_contract_data(address, client, BlockIdExt{}, std::move(promise));
+}
+
+void get_storage_contract_data(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                               BlockIdExt block_id, td::Promise<StorageContractData> promise) {
   run_get_method(
-      address, client, "get_storage_contract_data", {},
+      address, client, block_id, "get_storage_contract_data", {},
       promise.wrap([](std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>> stack) -> td::Result<StorageContractData> {
         if (stack.size() < 11) {
           return td::Status::Error("Too few entries");
@@ -60,10 +60,17 @@ struct ContractAddress {
 void run_get_method(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client, std::string method,
                     std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>> args,
                     td::Promise<std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>>> promise);
+// Same, but the state of the contract is taken at the given block (if it is valid)
+void run_get_method(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                    BlockIdExt block_id, std::string method,
+                    std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>> args,
+                    td::Promise<std::vector<tl_object_ptr<tonlib_api::tvm_StackEntry>>> promise);
 void check_contract_exists(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
                            td::Promise<bool> promise);
 void get_contract_balance(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
                           td::Promise<td::RefInt256> promise);
+void get_last_masterchain_block(td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                                td::Promise<BlockIdExt> promise);
 
 class FabricContractWrapper : public td::actor::Actor {
  public:
@@ -182,5 +189,7 @@ struct StorageContractData {
 
 void get_storage_contract_data(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
                                td::Promise<StorageContractData> promise);
+void get_storage_contract_data(ContractAddress address, td::actor::ActorId<tonlib::TonlibClientWrapper> client,
+                               BlockIdExt block_id, td::Promise<StorageContractData> promise);
 
 }  // namespace ton
\ No newline at end of file
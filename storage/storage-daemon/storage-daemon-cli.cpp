@@ -652,6 +652,16 @@ class StorageDaemonCli : public td::actor::Actor {
         return td::Status::Error("Unexpected token");
       }
       return execute_set_speed_limits(download, upload);
+    } else if (tokens[0] == "hashing-progress") {
+      bool json = false;
+      for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "--json") {
+          json = true;
+          continue;
+        }
+        return td::Status::Error(PSTRING() << "Unexpected argument " << tokens[i]);
+      }
+      return execute_get_hashing_progress(json);
     } else if (tokens[0] == "new-contract-message") {
       td::Bits256 hash;
       std::string file;
@@ -801,6 +811,16 @@ class StorageDaemonCli : public td::actor::Actor {
         }
       }
       return execute_get_provider_info(with_balances, with_contracts, json);
+    } else if (tokens[0] == "get-provider-stats") {
+      bool json = false;
+      for (size_t i = 1; i < tokens.size(); ++i) {
+        if (tokens[i] == "--json") {
+          json = true;
+          continue;
+        }
+        return td::Status::Error(PSTRING() << "Unexpected argument " << tokens[i]);
+      }
+      return execute_get_provider_stats(json);
     } else if (tokens[0] == "set-provider-config") {
       if (tokens.size() == 1) {
         return td::Status::Error("No parameters specified");
@@ -928,6 +948,8 @@ class StorageDaemonCli : public td::actor::Actor {
           << "set-speed-limits [--download x] [--upload x]\tSet global limits for download and upload speed\n";
       td::TerminalIO::out() << "\t--download x\tDownload speed limit in bytes/s, or \"unlimited\"\n";
       td::TerminalIO::out() << "\t--upload x\tUpload speed limit in bytes/s, or \"unlimited\"\n";
+      td::TerminalIO::out() << "hashing-progress [--json]\tShow torrents that are being checked or created\n";
+      td::TerminalIO::out() << "\t--json\tOutput in json\n";
       td::TerminalIO::out() << "new-contract-message <bag> <file> [--query-id id] --provider <provider>\tCreate "
                                "\"new contract message\" for storage provider. Saves message body to <file>.\n";
       td::TerminalIO::out() << "\t<provider>\tAddress of storage provider account to take parameters from.\n";
@@ -963,6 +985,8 @@ class StorageDaemonCli : public td::actor::Actor {
       td::TerminalIO::out() << "\t--contracts\tPrint list of storage contracts\n";
       td::TerminalIO::out() << "\t--balances\tPrint balances of the main contract and storage contracts\n";
       td::TerminalIO::out() << "\t--json\tOutput in json\n";
+      td::TerminalIO::out() << "get-provider-stats [--json]\tPrint liteserver queries made by storage provider\n";
+      td::TerminalIO::out() << "\t--json\tOutput in json\n";
       td::TerminalIO::out()
           << "set-provider-config [--max-contracts x] [--max-total-size x]\tSet configuration parameters\n";
       td::TerminalIO::out() << "\t--max-contracts\tMaximal number of storage contracts\n";
@@ -1419,6 +1443,45 @@ class StorageDaemonCli : public td::actor::Actor {
     return td::Status::OK();
   }
 
+  td::Status execute_get_hashing_progress(bool json) {
+    auto query = create_tl_object<ton_api::storage_daemon_getHashingProgress>();
+    send_query(std::move(query),
+               [=, SelfId = actor_id(this)](td::Result<tl_object_ptr<ton_api::storage_daemon_hashingProgress>> R) {
+                 if (R.is_error()) {
+                   return;
+                 }
+                 if (json) {
+                   print_json(R.ok());
+                   td::actor::send_closure(SelfId, &StorageDaemonCli::command_finished, td::Status::OK());
+                   return;
+                 }
+                 auto obj = R.move_as_ok();
+                 if (obj->jobs_.empty()) {
+                   td::TerminalIO::out() << "No torrents are being hashed\n";
+                 } else {
+                   std::vector<std::vector<std::string>> table;
+                   table.push_back({"Job", "Pieces", "Ready"});
+                   for (auto& job : obj->jobs_) {
+                     std::vector<std::string> row;
+                     row.push_back(job->title_);
+                     row.push_back(PSTRING() << job->hashed_pieces_ << "/" << job->total_pieces_);
+                     if (job->total_pieces_ > 0) {
+                       char buf[10];
+                       snprintf(buf, sizeof(buf), "%5.1f%%",
+                                (double)job->hashed_pieces_ / (double)job->total_pieces_ * 100);
+                       row.push_back(buf);
+                     } else {
+                       row.push_back("???");
+                     }
+                     table.push_back(std::move(row));
+                   }
+                   print_table(table, {0});
+                 }
+                 td::actor::send_closure(SelfId, &StorageDaemonCli::command_finished, td::Status::OK());
+               });
+    return td::Status::OK();
+  }
+
   td::Status execute_new_contract_message(td::Bits256 hash, std::string file, td::uint64 query_id,
                                           td::optional<std::string> provider_address, td::optional<std::string> rate,
                                           td::optional<td::uint32> max_span) {
@@ -1647,6 +1710,27 @@ class StorageDaemonCli : public td::actor::Actor {
     return td::Status::OK();
   }
 
+  td::Status execute_get_provider_stats(bool json) {
+    auto query = create_tl_object<ton_api::storage_daemon_getProviderStats>();
+    send_query(std::move(query),
+               [=, SelfId = actor_id(this)](td::Result<tl_object_ptr<ton_api::storage_daemon_providerStats>> R) {
+                 if (R.is_error()) {
+                   return;
+                 }
+                 if (json) {
+                   print_json(R.ok());
+                   td::actor::send_closure(SelfId, &StorageDaemonCli::command_finished, td::Status::OK());
+                   return;
+                 }
+                 auto stats = R.move_as_ok();
+                 td::TerminalIO::out() << "Liteserver queries: " << stats->liteserver_queries_ << " ("
+                                       << td::StringBuilder::FixedDouble(stats->queries_per_contract_hour_, 2)
+                                       << " per contract per hour)\n";
+                 td::actor::send_closure(SelfId, &StorageDaemonCli::command_finished, td::Status::OK());
+               });
+    return td::Status::OK();
+  }
+
   td::Status execute_set_provider_config(OptionalProviderConfig new_config) {
     auto query_get = create_tl_object<ton_api::storage_daemon_getProviderInfo>(false, false);
     send_query(std::move(query_get), [SelfId = actor_id(this), new_config = std::move(new_config)](
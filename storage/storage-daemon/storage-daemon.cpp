@@ -20,6 +20,7 @@
 #include "td/utils/OptionParser.h"
 #include "td/utils/port/path.h"
 #include "td/utils/port/signals.h"
+#include "td/utils/port/thread.h"
 #include "td/utils/port/user.h"
 #include "td/utils/port/IPAddress.h"
 #include "td/utils/Random.h"
@@ -100,6 +101,8 @@ class StorageDaemon : public td::actor::Actor {
     manager_ = td::actor::create_actor<StorageManager>("storage", local_id_, db_root_ + "/torrent",
                                                        td::make_unique<Callback>(actor_id(this)), client_mode_,
                                                        adnl_.get(), rldp_.get(), overlays_.get());
+    // Torrents are checked while they are loaded from db, the control interface reports the progress meanwhile
+    init_control_interface();
   }
 
   td::Status load_global_config() {
@@ -210,7 +213,7 @@ class StorageDaemon : public td::actor::Actor {
         LOG(WARNING) << "Storage provider account is not set, it can be set in storage-daemon-cli";
       }
     }
-    init_control_interface();
+    inited_storage_manager_ = true;
   }
 
   void init_control_interface() {
@@ -273,6 +276,10 @@ class StorageDaemon : public td::actor::Actor {
       return;
     }
     auto f = F.move_as_ok();
+    if (!inited_storage_manager_ && f->get_id() != ton_api::storage_daemon_getHashingProgress::ID) {
+      promise.set_error(td::Status::Error("Torrents are being loaded, try again later"));
+      return;
+    }
     LOG(DEBUG) << "Running control query " << f->get_id();
     ton_api::downcast_call(*f, [&](auto &obj) { run_control_query(obj, std::move(promise)); });
   }
@@ -294,6 +301,8 @@ class StorageDaemon : public td::actor::Actor {
           Torrent::Creator::Options options;
           options.piece_size = 128 * 1024;
           options.description = std::move(query.description_);
+          options.threads = Torrent::max_hash_threads();
+          options.progress = Torrent::track_hash_progress(PSTRING() << "Creating torrent from " << query.path_);
           TRY_RESULT_PROMISE(promise, torrent, Torrent::Creator::create_from_path(std::move(options), query.path_));
           td::Bits256 hash = torrent.get_hash();
           td::actor::send_closure(manager, &StorageManager::add_torrent, std::move(torrent), false, query.allow_upload_,
@@ -558,6 +567,15 @@ class StorageDaemon : public td::actor::Actor {
     promise.set_result(create_serialize_tl_object<ton_api::storage_daemon_success>());
   }
 
+  void run_control_query(ton_api::storage_daemon_getHashingProgress &query, td::Promise<td::BufferSlice> promise) {
+    std::vector<tl_object_ptr<ton_api::storage_daemon_hashingJob>> jobs;
+    for (auto &job : Torrent::get_hashing_jobs()) {
+      jobs.push_back(create_tl_object<ton_api::storage_daemon_hashingJob>(std::move(job.title), job.hashed_pieces,
+                                                                          job.total_pieces));
+    }
+    promise.set_result(create_serialize_tl_object<ton_api::storage_daemon_hashingProgress>(std::move(jobs)));
+  }
+
   void run_control_query(ton_api::storage_daemon_getNewContractMessage &query, td::Promise<td::BufferSlice> promise) {
     td::Promise<std::pair<td::RefInt256, td::uint32>> P =
         [promise = std::move(promise), hash = query.hash_, query_id = query.query_id_,
@@ -753,6 +771,17 @@ class StorageDaemon : public td::actor::Actor {
                             }));
   }
 
+  void run_control_query(ton_api::storage_daemon_getProviderStats &query, td::Promise<td::BufferSlice> promise) {
+    if (provider_.empty()) {
+      promise.set_error(td::Status::Error("No storage provider"));
+      return;
+    }
+    td::actor::send_closure(provider_, &StorageProvider::get_provider_stats,
+                            promise.wrap([](tl_object_ptr<ton_api::storage_daemon_providerStats> stats) {
+                              return serialize_tl_object(stats, true);
+                            }));
+  }
+
   void run_control_query(ton_api::storage_daemon_setProviderConfig &query, td::Promise<td::BufferSlice> promise) {
     if (provider_.empty()) {
       promise.set_error(td::Status::Error("No storage provider"));
@@ -916,6 +945,7 @@ class StorageDaemon : public td::actor::Actor {
   td::actor::ActorOwn<adnl::AdnlExtServer> ext_server_;
 
   td::actor::ActorOwn<StorageManager> manager_;
+  bool inited_storage_manager_ = false;
 
   td::actor::ActorOwn<tonlib::TonlibClientWrapper> tonlib_client_;
   td::actor::ActorOwn<StorageProvider> provider_;
@@ -0,0 +1,210 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "storage-daemon/StorageProvider.h"
+
+#include "td/actor/actor.h"
+#include "td/db/MemoryKeyValue.h"
+#include "td/utils/tests.h"
+
+#include "vm/cells/CellBuilder.h"
+
+namespace {
+
+using ton::ContractAddress;
+using ton::MicrochunkTree;
+
+constexpr size_t CONTRACTS = 20;
+constexpr size_t MAX_QUERIES = 16;
+
+struct RoundLog {
+  int blocks = 0;
+  size_t queries = 0;
+  size_t max_in_flight = 0;
+  // Torrent and number of requested proofs of every build_proofs call
+  std::vector<std::pair<td::Bits256, size_t>> builds;
+  std::map<ContractAddress, std::vector<td::Bits256>> sent;
+  size_t cached_proofs = 0;
+  size_t stored_proofs = 0;
+};
+
+td::Bits256 make_hash(td::uint8 x) {
+  td::Bits256 hash = td::Bits256::zero();
+  hash.as_slice()[0] = x;
+  return hash;
+}
+
+// Contract i stores torrent i % 2 and is asked to prove chunk (i / 2) % 3, so every proof is wanted by several
+// contracts of the torrent
+ContractAddress contract_address(size_t i) {
+  return ContractAddress(ton::basechainId, make_hash(static_cast<td::uint8>(i + 1)));
+}
+
+// The provider wraps every db update in a transaction, updates of MemoryKeyValue are applied at once anyway
+class MemoryDb : public td::MemoryKeyValue {
+ public:
+  td::Status begin_transaction() override {
+    return td::Status::OK();
+  }
+  td::Status commit_transaction() override {
+    return td::Status::OK();
+  }
+};
+
+// A provider over CONTRACTS active contracts with stand-ins for liteservers, torrents and the provider wallet.
+// Runs two check rounds: in the second one the first contract asks for another chunk and the rest reuse the proofs
+class TestProvider : public ton::StorageProvider {
+ public:
+  TestProvider(RoundLog &log, td::Promise<td::Unit> promise)
+      : StorageProvider(ContractAddress(), "", {}, {}, {}), log_(log), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    db_ = std::make_unique<MemoryDb>();
+    for (size_t i = 0; i < CONTRACTS; ++i) {
+      StorageContract &contract = contracts_[contract_address(i)];
+      contract.torrent_hash = make_hash(static_cast<td::uint8>(100 + i % 2));
+      contract.microchunk_hash = make_hash(static_cast<td::uint8>(200 + i % 2));
+      contract.created_time = 0;
+      contract.state = StorageContract::st_active;
+      contract.microchunk_tree = std::make_shared<MicrochunkTree>();
+      contract.check_next_proof_at = td::Timestamp::now();
+    }
+    alarm();
+  }
+
+ protected:
+  void get_last_block(td::Promise<ton::BlockIdExt> promise) override {
+    ++log_.blocks;
+    promise.set_value(ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, static_cast<ton::BlockSeqno>(log_.blocks),
+                                      td::Bits256::zero(), td::Bits256::zero()});
+  }
+
+  void get_contract_data(ContractAddress address, ton::BlockIdExt block_id,
+                         td::Promise<ton::StorageContractData> promise) override {
+    ++log_.queries;
+    size_t i = address.addr.as_slice()[0] - 1;
+    ton::StorageContractData data;
+    data.active = true;
+    data.balance = td::make_refint(1'000'000'000);
+    data.microchunk_hash = contracts_[address].microchunk_hash;
+    data.next_proof = (i == 0 && second_round_ ? 3 : (i / 2) % 3) * MicrochunkTree::MICROCHUNK_SIZE;
+    data.max_span = 3600;
+    data.last_proof_time = 0;
+    answers_.emplace_back(std::move(promise), std::move(data));
+    log_.max_in_flight = std::max(log_.max_in_flight, answers_.size());
+    // Answers come later, so the round has to keep its queries in flight
+    td::actor::send_closure_later(actor_id(this), &TestProvider::answer);
+  }
+
+  void build_proofs(
+      td::Bits256 torrent_hash, std::vector<CheckRound::ProofRequest> requests,
+      td::Promise<std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>>> promise) override {
+    log_.builds.emplace_back(torrent_hash, requests.size());
+    std::vector<std::pair<CheckRound::ProofRequest, td::Result<td::Ref<vm::Cell>>>> result;
+    for (auto &req : requests) {
+      auto proof = vm::CellBuilder().store_bytes(req.microchunk_hash.as_slice()).store_long(req.offset, 64).finalize();
+      result.emplace_back(std::move(req), std::move(proof));
+    }
+    promise.set_value(std::move(result));
+  }
+
+  void send_proof(ContractAddress address, td::Ref<vm::Cell> proof, td::Promise<td::Unit> promise) override {
+    log_.sent[address].push_back(td::Bits256(proof->get_hash().bits()));
+    promise.set_value(td::Unit());
+    if (++sent_ == CONTRACTS) {
+      td::actor::send_closure_later(actor_id(this), &TestProvider::start_second_round);
+    } else if (sent_ == 2 * CONTRACTS) {
+      log_.cached_proofs = proof_cache_.size();
+      log_.stored_proofs = db_->count("proof").move_as_ok();
+      promise_.set_value(td::Unit());
+      stop();
+    }
+  }
+
+ private:
+  RoundLog &log_;
+  td::Promise<td::Unit> promise_;
+  std::vector<std::pair<td::Promise<ton::StorageContractData>, ton::StorageContractData>> answers_;
+  size_t sent_ = 0;
+  bool second_round_ = false;
+
+  void answer() {
+    if (answers_.empty()) {
+      return;
+    }
+    auto p = std::move(answers_.front());
+    answers_.erase(answers_.begin());
+    p.first.set_value(std::move(p.second));
+  }
+
+  void start_second_round() {
+    second_round_ = true;
+    for (auto &p : contracts_) {
+      p.second.check_next_proof_at = td::Timestamp::now();
+    }
+    next_check_round_at_ = td::Timestamp::now();
+    alarm();
+  }
+};
+
+RoundLog run_provider() {
+  RoundLog log;
+  td::actor::Scheduler scheduler({1});
+  scheduler.run_in_context([&] {
+    td::actor::create_actor<TestProvider>("provider", log, [](td::Result<td::Unit> R) {
+      R.ensure();
+      td::actor::SchedulerContext::get()->stop();
+    }).release();
+  });
+  scheduler.run();
+  scheduler.stop();
+  return log;
+}
+
+}  // namespace
+
+TEST(StorageProvider, CheckRounds) {
+  auto log = run_provider();
+
+  // One block and one state query per contract in every round, with a bounded number of queries in flight
+  ASSERT_EQ(2, log.blocks);
+  ASSERT_EQ(2 * CONTRACTS, log.queries);
+  ASSERT_EQ(MAX_QUERIES, log.max_in_flight);
+
+  // First round: one build per torrent. Second round: only the new chunk of the first contract is built
+  ASSERT_EQ(3u, log.builds.size());
+  std::map<td::Bits256, size_t> first_round;
+  for (size_t i = 0; i < 2; ++i) {
+    first_round[log.builds[i].first] += log.builds[i].second;
+  }
+  ASSERT_EQ(2u, first_round.size());
+  ASSERT_EQ(CONTRACTS / 2, first_round[make_hash(100)]);
+  ASSERT_EQ(CONTRACTS / 2, first_round[make_hash(101)]);
+  ASSERT_TRUE(log.builds[2].first == make_hash(100));
+  ASSERT_EQ(1u, log.builds[2].second);
+
+  // Contracts that ask for the same chunk twice get the cached proof again
+  ASSERT_EQ(CONTRACTS, log.sent.size());
+  for (size_t i = 0; i < CONTRACTS; ++i) {
+    auto &sent = log.sent[contract_address(i)];
+    ASSERT_EQ(2u, sent.size());
+    ASSERT_EQ(i != 0, sent[0] == sent[1]);
+  }
+  // Proofs of three chunks of each torrent and the new one are cached and stored in db
+  ASSERT_EQ(7u, log.cached_proofs);
+  ASSERT_EQ(7u, log.stored_proofs);
+}
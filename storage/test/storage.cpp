@@ -60,6 +60,7 @@
 #include "PeerState.h"
 #include "Torrent.h"
 #include "TorrentCreator.h"
+#include "UploadCache.h"
 
 #include "NodeActor.h"
 #include "PeerActor.h"
@@ -998,7 +999,7 @@ TEST(Torrent, Meta) {
       new_torrent.add_piece(piece_i, std::move(piece_data), std::move(piece_proof)).ensure();
     }
     CHECK(new_torrent.is_completed());
-    new_torrent.validate();
+    new_torrent.validate().ensure();
     CHECK(new_torrent.is_completed());
     for (auto &name_data : files) {
       ASSERT_EQ(name_data.buffer.to_buffer_slice().move_as_ok(),
@@ -1027,7 +1028,7 @@ TEST(Torrent, OneFile) {
     options.root_dir = "first/";
     auto other_torrent = ton::Torrent::open(options, meta).move_as_ok();
     CHECK(!other_torrent.is_completed());
-    other_torrent.validate();
+    other_torrent.validate().ensure();
     CHECK(other_torrent.is_completed());
     CHECK(td::read_file("first/hello.txt").move_as_ok() == "Hello world!");
   }
@@ -1045,6 +1046,86 @@ TEST(Torrent, OneFile) {
   }
 };
 
+TEST(Torrent, HashThreads) {
+  td::rmrf("hash_threads").ignore();
+  td::mkdir("hash_threads").ensure();
+
+  // Several batches of pieces, the last one is not full
+  td::Random::Xorshift128plus rnd(123);
+  std::string data(20 * (1 << 20) + 12345, '\0');
+  for (auto &c : data) {
+    c = static_cast<char>(rnd());
+  }
+  td::write_file("hash_threads/data.bin", data).ensure();
+
+  ton::Torrent::Creator::Options options;
+  options.piece_size = 1024;
+  auto torrent = ton::Torrent::Creator::create_from_path(options, "hash_threads/data.bin").move_as_ok();
+  td::uint64 last_progress = 0;
+  options.threads = 2;
+  options.progress = [&](td::uint64 ready, td::uint64 total) {
+    CHECK(ready > last_progress && ready <= total);
+    last_progress = ready;
+  };
+  auto torrent2 = ton::Torrent::Creator::create_from_path(options, "hash_threads/data.bin").move_as_ok();
+  CHECK(torrent.get_hash() == torrent2.get_hash());
+  ASSERT_EQ(torrent.get_info().pieces_count(), last_progress);
+
+  for (bool with_proof : {true, false}) {
+    auto meta = ton::TorrentMeta::deserialize(torrent.get_meta().serialize()).move_as_ok();
+    if (!with_proof) {
+      meta.root_proof = {};
+    }
+    ton::Torrent::Options open_options;
+    open_options.root_dir = "hash_threads/";
+    auto other_torrent = ton::Torrent::open(open_options, meta).move_as_ok();
+    other_torrent.validate(3).ensure();
+    ASSERT_EQ(torrent.get_info().pieces_count(), other_torrent.get_ready_parts_count());
+    other_torrent.enable_write_to_files();
+    CHECK(other_torrent.is_completed());
+  }
+  td::rmrf("hash_threads").ignore();
+};
+
+TEST(Torrent, HashingJobs) {
+  ASSERT_TRUE(ton::Torrent::get_hashing_jobs().empty());
+  auto progress = ton::Torrent::track_hash_progress("Checking torrent");
+  // The job is listed once hashing starts
+  ASSERT_TRUE(ton::Torrent::get_hashing_jobs().empty());
+  progress(16, 64);
+  auto copy = progress;
+  copy(32, 64);
+  auto jobs = ton::Torrent::get_hashing_jobs();
+  ASSERT_EQ(1u, jobs.size());
+  ASSERT_EQ("Checking torrent", jobs[0].title);
+  ASSERT_EQ(32u, jobs[0].hashed_pieces);
+  ASSERT_EQ(64u, jobs[0].total_pieces);
+  progress = {};
+  ASSERT_EQ(1u, ton::Torrent::get_hashing_jobs().size());
+  copy = {};
+  ASSERT_TRUE(ton::Torrent::get_hashing_jobs().empty());
+}
+
+TEST(Torrent, UploadCache) {
+  td::Random::Xorshift128plus rnd(123);
+  for (int test_i = 0; test_i < 20; test_i++) {
+    auto torrent = create_random_torrent(rnd).torrent.unwrap();
+    ton::UploadCache cache;
+    auto pieces_count = torrent.get_info().pieces_count();
+    for (td::uint64 piece_i = 0; piece_i < pieces_count; piece_i++) {
+      auto proof = vm::std_boc_serialize(torrent.get_piece_proof(piece_i).move_as_ok()).move_as_ok();
+      auto expected = ton::create_serialize_tl_object<ton::ton_api::storage_piece>(
+          std::move(proof), td::BufferSlice(torrent.get_piece_data(piece_i).move_as_ok()));
+      // Sequential and random requests from two peers
+      ASSERT_EQ(expected.as_slice(), cache.get_piece_answer(torrent, 1, piece_i).move_as_ok().as_slice());
+      auto other_i = rnd.fast64(0, pieces_count - 1);
+      auto answer = cache.get_piece_answer(torrent, 2, other_i).move_as_ok();
+      auto piece = ton::fetch_tl_object<ton::ton_api::storage_piece>(answer, true).move_as_ok();
+      ASSERT_EQ(torrent.get_piece_data(other_i).move_as_ok(), piece->data_.as_slice());
+    }
+  }
+}
+
 TEST(Torrent, PartsHelper) {
   int parts_count = 100;
   ton::PartsHelper parts(parts_count);
@@ -1069,223 +1150,292 @@ TEST(Torrent, PartsHelper) {
   ASSERT_EQ(3u, parts.get_rarest_parts(10).size());
 }
 
+TEST(Torrent, PartsHelperEndgame) {
+  ton::PartsHelper parts(3);
+  auto a_token = parts.register_peer(1);
+  auto b_token = parts.register_peer(2);
+  for (size_t part_id = 0; part_id < 3; part_id++) {
+    parts.on_peer_part_ready(a_token, part_id);
+    parts.on_peer_part_ready(b_token, part_id);
+  }
+  ASSERT_TRUE(parts.has_unqueried_parts());
+
+  parts.set_peer_limit(a_token, 2);
+  auto queried = parts.get_rarest_parts(10);
+  ASSERT_EQ(2u, queried.size());
+  std::set<size_t> unqueried{0, 1, 2};
+  for (auto &part : queried) {
+    parts.lock_part(part.part_id);
+    unqueried.erase(part.part_id);
+  }
+  ASSERT_EQ(1u, unqueried.size());
+  auto last_part = *unqueried.begin();
+  ASSERT_TRUE(parts.has_unqueried_parts());
+  // Parts that are not wanted don't count
+  parts.set_part_priority(last_part, 0);
+  ASSERT_TRUE(!parts.has_unqueried_parts());
+  parts.set_part_priority(last_part, 1);
+  ASSERT_TRUE(parts.has_unqueried_parts());
+  parts.lock_part(last_part);
+  ASSERT_TRUE(!parts.has_unqueried_parts());
+
+  // Every part is queried from peer 1, peer 2 duplicates the queries
+  parts.set_peer_limit(a_token, 0);
+  parts.set_peer_limit(b_token, 10);
+  auto duplicated =
+      parts.get_endgame_parts(10, 2, [](ton::PeerId peer_id, size_t part_id) { return peer_id == 1; });
+  ASSERT_EQ(3u, duplicated.size());
+  for (auto &part : duplicated) {
+    ASSERT_EQ(2u, part.peer_id);
+  }
+
+  parts.on_self_part_ready(0);
+  parts.unlock_part(0);
+  ASSERT_TRUE(!parts.has_unqueried_parts());
+  parts.on_self_part_not_ready(0);
+  ASSERT_TRUE(parts.has_unqueried_parts());
+}
+
 void print_debug(ton::Torrent *torrent) {
   LOG(ERROR) << torrent->get_stats_str();
 }
 
-TEST(Torrent, Peer) {
-  class PeerManager : public td::actor::Actor {
-   public:
-    void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
-      send_closure(get_outbound_channel(src), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
-    }
+class PeerManager : public td::actor::Actor {
+ public:
+  explicit PeerManager(NetChannel::Options channel_options) : channel_options_(channel_options) {
+  }
 
-    void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(get_inbound_channel(dst), &NetChannel::send, query.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
-    }
+  void send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Promise<td::BufferSlice> promise) {
+    send_closure(get_outbound_channel(src), &NetChannel::send, query.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_query, src, dst, std::move(query)));
+  }
 
-    void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
-      auto it = peers_.find(std::make_pair(dst, src));
-      if (it == peers_.end()) {
-        LOG(ERROR) << "No such peer";
-        auto node_it = nodes_.find(dst);
-        if (node_it == nodes_.end()) {
-          LOG(ERROR) << "Unknown query destination";
-          promise.set_error(td::Status::Error("Unknown query destination"));
-          return;
-        }
-        send_closure(node_it->second, &ton::NodeActor::start_peer, src,
-                     [promise = std::move(promise),
-                      query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
-                       TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
-                       send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
-                     });
+  void do_send_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    send_closure(get_inbound_channel(dst), &NetChannel::send, query.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::execute_query, src, dst, std::move(query)));
+  }
+
+  void execute_query(ton::PeerId src, ton::PeerId dst, td::BufferSlice query, td::Result<td::Unit> res,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    promise = promise.send_closure(actor_id(this), &PeerManager::send_response, src, dst);
+    auto it = peers_.find(std::make_pair(dst, src));
+    if (it == peers_.end()) {
+      LOG(ERROR) << "No such peer";
+      auto node_it = nodes_.find(dst);
+      if (node_it == nodes_.end()) {
+        LOG(ERROR) << "Unknown query destination";
+        promise.set_error(td::Status::Error("Unknown query destination"));
         return;
       }
-      send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+      send_closure(node_it->second, &ton::NodeActor::start_peer, src,
+                   [promise = std::move(promise),
+                    query = std::move(query)](td::Result<td::actor::ActorId<ton::PeerActor>> r_peer) mutable {
+                     TRY_RESULT_PROMISE(promise, peer, std::move(r_peer));
+                     send_closure(peer, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+                   });
+      return;
     }
+    send_closure(it->second, &ton::PeerActor::execute_query, std::move(query), std::move(promise));
+  }
 
-    void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
-                       td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, response, std::move(r_response));
-      send_closure(get_outbound_channel(dst), &NetChannel::send, response.size(),
-                   promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
-    }
+  void send_response(ton::PeerId src, ton::PeerId dst, td::Result<td::BufferSlice> r_response,
+                     td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, response, std::move(r_response));
+    send_closure(get_outbound_channel(dst), &NetChannel::send, response.size(),
+                 promise.send_closure(actor_id(this), &PeerManager::do_send_response, src, dst, std::move(response)));
+  }
 
-    void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                          td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      send_closure(
-          get_inbound_channel(src), &NetChannel::send, response.size(),
-          promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
-    }
+  void do_send_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                        td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    send_closure(
+        get_inbound_channel(src), &NetChannel::send, response.size(),
+        promise.send_closure(actor_id(this), &PeerManager::do_execute_response, src, dst, std::move(response)));
+  }
 
-    void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
-                             td::Promise<td::BufferSlice> promise) {
-      TRY_RESULT_PROMISE(promise, x, std::move(res));
-      (void)x;
-      promise.set_value(std::move(response));
-    }
+  void do_execute_response(ton::PeerId src, ton::PeerId dst, td::BufferSlice response, td::Result<td::Unit> res,
+                           td::Promise<td::BufferSlice> promise) {
+    TRY_RESULT_PROMISE(promise, x, std::move(res));
+    (void)x;
+    promise.set_value(std::move(response));
+  }
 
-    void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
-      peers_[std::make_pair(src, dst)] = std::move(peer);
-    }
+  void register_peer(ton::PeerId src, ton::PeerId dst, td::actor::ActorId<ton::PeerActor> peer) {
+    peers_[std::make_pair(src, dst)] = std::move(peer);
+  }
 
-    void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
-      nodes_[src] = std::move(node);
+  void register_node(ton::PeerId src, td::actor::ActorId<ton::NodeActor> node) {
+    nodes_[src] = std::move(node);
+  }
+  ~PeerManager() {
+    for (auto &it : inbound_channel_) {
+      LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
-    ~PeerManager() {
-      for (auto &it : inbound_channel_) {
-        LOG(ERROR) << it.first << " received " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
-      for (auto &it : outbound_channel_) {
-        LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
-      }
+    for (auto &it : outbound_channel_) {
+      LOG(ERROR) << it.first << " sent " << td::format::as_size(it.second.get_actor_unsafe().total_sent());
     }
+  }
 
-   private:
-    std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
-    std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
-    std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+ private:
+  std::map<std::pair<ton::PeerId, ton::PeerId>, td::actor::ActorId<ton::PeerActor>> peers_;
+  std::map<ton::PeerId, td::actor::ActorId<ton::NodeActor>> nodes_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> inbound_channel_;
+  std::map<ton::PeerId, td::actor::ActorOwn<NetChannel>> outbound_channel_;
+
+  NetChannel::Options channel_options_;
+  td::actor::ActorOwn<Sleep> sleep_;
+  void start_up() override {
+    sleep_ = Sleep::create();
+  }
 
-    td::actor::ActorOwn<Sleep> sleep_;
-    void start_up() override {
-      sleep_ = Sleep::create();
+  td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
+    auto &res = outbound_channel_[peer_id];
+    if (res.empty()) {
+      res = NetChannel::create(channel_options_, sleep_.get());
+    }
+    return res.get();
+  }
+  td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
+    auto &res = inbound_channel_[peer_id];
+    if (res.empty()) {
+      res = NetChannel::create(channel_options_, sleep_.get());
     }
+    return res.get();
+  }
+};
 
-    td::actor::ActorId<NetChannel> get_outbound_channel(ton::PeerId peer_id) {
-      auto &res = outbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
+class PeerCreator : public ton::NodeActor::NodeCallback {
+ public:
+  PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
+      : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
+  }
+  void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
+    auto peers = peers_;
+    promise.set_value(std::move(peers));
+  }
+  void register_self(td::actor::ActorId<ton::NodeActor> self) override {
+    self_ = self;
+    send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
+  }
+  td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
+                                                  std::shared_ptr<ton::PeerState> state) override {
+    class PeerCallback : public ton::PeerActor::Callback {
+     public:
+      PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
+          : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
       }
-      return res.get();
-    }
-    td::actor::ActorId<NetChannel> get_inbound_channel(ton::PeerId peer_id) {
-      auto &res = inbound_channel_[peer_id];
-      if (res.empty()) {
-        NetChannel::Options options;
-        options.speed = 1000 * MegaByte;
-        options.buffer = 1000 * MegaByte;
-        options.rtt = 0;
-        res = NetChannel::create(options, sleep_.get());
+      void register_self(td::actor::ActorId<ton::PeerActor> self) override {
+        self_ = std::move(self);
+        send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
+      }
+      void send_query(td::uint64 query_id, td::BufferSlice query) override {
+        CHECK(!self_.empty());
+        class X : public td::actor::Actor {
+         public:
+          void start_up() override {
+            //LOG(ERROR) << "start";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+          void tear_down() override {
+            //LOG(ERROR) << "finish";
+          }
+          void alarm() override {
+            //LOG(FATAL) << "WTF?";
+            alarm_timestamp() = td::Timestamp::in(4);
+          }
+        };
+        send_closure(
+            peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
+            [self = self_, query_id,
+             tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
+                auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
       }
-      return res.get();
-    }
-  };
 
-  class PeerCreator : public ton::NodeActor::NodeCallback {
-   public:
-    PeerCreator(td::actor::ActorId<PeerManager> peer_manager, ton::PeerId self_id, std::vector<ton::PeerId> peers)
-        : peer_manager_(std::move(peer_manager)), peers_(std::move(peers)), self_id_(self_id) {
-    }
-    void get_peers(ton::PeerId src, td::Promise<std::vector<ton::PeerId>> promise) override {
-      auto peers = peers_;
-      promise.set_value(std::move(peers));
-    }
-    void register_self(td::actor::ActorId<ton::NodeActor> self) override {
-      self_ = self;
-      send_closure(peer_manager_, &PeerManager::register_node, self_id_, self_);
-    }
-    td::actor::ActorOwn<ton::PeerActor> create_peer(ton::PeerId self_id, ton::PeerId peer_id,
-                                                    std::shared_ptr<ton::PeerState> state) override {
-      class PeerCallback : public ton::PeerActor::Callback {
-       public:
-        PeerCallback(ton::PeerId self_id, ton::PeerId peer_id, td::actor::ActorId<PeerManager> peer_manager)
-            : self_id_{self_id}, peer_id_{peer_id}, peer_manager_(peer_manager) {
-        }
-        void register_self(td::actor::ActorId<ton::PeerActor> self) override {
-          self_ = std::move(self);
-          send_closure(peer_manager_, &PeerManager::register_peer, self_id_, peer_id_, self_);
-        }
-        void send_query(td::uint64 query_id, td::BufferSlice query) override {
-          CHECK(!self_.empty());
-          class X : public td::actor::Actor {
-           public:
-            void start_up() override {
-              //LOG(ERROR) << "start";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-            void tear_down() override {
-              //LOG(ERROR) << "finish";
-            }
-            void alarm() override {
-              //LOG(FATAL) << "WTF?";
-              alarm_timestamp() = td::Timestamp::in(4);
-            }
-          };
-          send_closure(
-              peer_manager_, &PeerManager::send_query, self_id_, peer_id_, std::move(query),
-              [self = self_, query_id,
-               tmp = td::actor::create_actor<X>(PSLICE() << self_id_ << "->" << peer_id_ << " : " << query_id)](
-                  auto x) { promise_send_closure(self, &ton::PeerActor::on_query_result, query_id)(std::move(x)); });
-        }
+     private:
+      ton::PeerId self_id_;
+      ton::PeerId peer_id_;
+      td::actor::ActorId<ton::PeerActor> self_;
+      td::actor::ActorId<PeerManager> peer_manager_;
+    };
 
-       private:
-        ton::PeerId self_id_;
-        ton::PeerId peer_id_;
-        td::actor::ActorId<ton::PeerActor> self_;
-        td::actor::ActorId<PeerManager> peer_manager_;
-      };
+    return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
+                                                   td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
+                                                   std::move(state));
+  }
 
-      return td::actor::create_actor<ton::PeerActor>(PSLICE() << "ton::PeerActor " << self_id << "->" << peer_id,
-                                                     td::make_unique<PeerCallback>(self_id, peer_id, peer_manager_),
-                                                     std::move(state));
-    }
+ private:
+  td::actor::ActorId<PeerManager> peer_manager_;
+  std::vector<ton::PeerId> peers_;
+  ton::PeerId self_id_;
+  td::actor::ActorId<ton::NodeActor> self_;
+};
 
-   private:
-    td::actor::ActorId<PeerManager> peer_manager_;
-    std::vector<ton::PeerId> peers_;
-    ton::PeerId self_id_;
-    td::actor::ActorId<ton::NodeActor> self_;
-  };
+class TorrentCallback : public ton::NodeActor::Callback {
+ public:
+  TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
+      : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
+  }
 
-  class TorrentCallback : public ton::NodeActor::Callback {
-   public:
-    TorrentCallback(std::shared_ptr<td::Destructor> stop_watcher, std::shared_ptr<td::Destructor> complete_watcher)
-        : stop_watcher_(stop_watcher), complete_watcher_(complete_watcher) {
-    }
+  void on_completed() override {
+    complete_watcher_.reset();
+  }
 
-    void on_completed() override {
-      complete_watcher_.reset();
-    }
+  void on_closed(ton::Torrent torrent) override {
+    CHECK(torrent.is_completed());
+    //TODO: validate torrent
+    stop_watcher_.reset();
+  }
 
-    void on_closed(ton::Torrent torrent) override {
-      CHECK(torrent.is_completed());
-      //TODO: validate torrent
-      stop_watcher_.reset();
-    }
+ private:
+  std::shared_ptr<td::Destructor> stop_watcher_;
+  std::shared_ptr<td::Destructor> complete_watcher_;
+};
 
-   private:
-    std::shared_ptr<td::Destructor> stop_watcher_;
-    std::shared_ptr<td::Destructor> complete_watcher_;
-  };
+struct StatsActor : public td::actor::Actor {
+ public:
+  StatsActor(td::actor::ActorId<ton::NodeActor> node_actor) : node_actor_(node_actor) {
+  }
+
+ private:
+  td::actor::ActorId<ton::NodeActor> node_actor_;
+  void start_up() override {
+    alarm_timestamp() = td::Timestamp::in(1);
+  }
+  void alarm() override {
+    send_closure(node_actor_, &ton::NodeActor::with_torrent, [](td::Result<ton::NodeActor::NodeState> r_state) {
+      if (r_state.is_error()) {
+        return;
+      }
+      print_debug(&r_state.ok().torrent);
+    });
+    alarm_timestamp() = td::Timestamp::in(4);
+  }
+};
 
+// Node 1 seeds a random torrent, other nodes download it. Each node knows peers_per_node random peers.
+struct SwarmOptions {
   size_t peers_n = 20;
+  size_t peers_per_node = 2;
   td::uint64 file_size = 200 * MegaByte;
+  NetChannel::Options channel =
+      NetChannel::Options().with_speed(1000 * MegaByte).with_buffer(1000 * MegaByte).with_rtt(0);
+};
+
+// Returns the time it took for all nodes to download the torrent
+double run_swarm(const SwarmOptions &swarm) {
+  size_t peers_n = swarm.peers_n;
+  td::uint64 file_size = swarm.file_size;
   td::Random::Xorshift128plus rnd(123);
   LOG(INFO) << "Start create random_torrent of size " << file_size;
   auto torrent = create_random_torrent(rnd, file_size, 128 * KiloByte).torrent.unwrap();
   LOG(INFO) << "Random torrent is created";
 
-  std::vector<ton::PeerId> peers;
-  for (size_t i = 1; i <= peers_n; i++) {
-    peers.push_back(i);
-  }
   auto gen_peers = [&](size_t self_id, size_t n) {
     std::vector<ton::PeerId> peers;
     if (n > peers_n - 1) {
@@ -1305,27 +1455,6 @@ TEST(Torrent, Peer) {
     return peers;
   };
 
-  struct StatsActor : public td::actor::Actor {
-   public:
-    StatsActor(td::actor::ActorId<ton::NodeActor> node_actor) : node_actor_(node_actor) {
-    }
-
-   private:
-    td::actor::ActorId<ton::NodeActor> node_actor_;
-    void start_up() override {
-      alarm_timestamp() = td::Timestamp::in(1);
-    }
-    void alarm() override {
-      send_closure(node_actor_, &ton::NodeActor::with_torrent, [](td::Result<ton::NodeActor::NodeState> r_state) {
-        if (r_state.is_error()) {
-          return;
-        }
-        print_debug(&r_state.ok().torrent);
-      });
-      alarm_timestamp() = td::Timestamp::in(4);
-    }
-  };
-
   auto info = torrent.get_info();
 
   auto stop_watcher = td::create_shared_destructor([] { td::actor::SchedulerContext::get()->stop(); });
@@ -1335,11 +1464,12 @@ TEST(Torrent, Peer) {
   td::actor::Scheduler scheduler({0}, true);
 
   scheduler.run_in_context([&] {
-    auto peer_manager = td::actor::create_actor<PeerManager>("PeerManager");
+    auto peer_manager = td::actor::create_actor<PeerManager>("PeerManager", swarm.channel);
     guard->push_back(td::actor::create_actor<ton::NodeActor>(
         "Node#1", 1, std::move(torrent),
         td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
-        td::make_unique<PeerCreator>(peer_manager.get(), 1, gen_peers(1, 2)), nullptr, ton::SpeedLimiters{}));
+        td::make_unique<PeerCreator>(peer_manager.get(), 1, gen_peers(1, swarm.peers_per_node)), nullptr,
+        ton::SpeedLimiters{}));
     for (size_t i = 2; i <= peers_n; i++) {
       ton::Torrent::Options options;
       options.in_memory = true;
@@ -1347,7 +1477,7 @@ TEST(Torrent, Peer) {
       auto node_actor = td::actor::create_actor<ton::NodeActor>(
           PSLICE() << "Node#" << i, i, std::move(other_torrent),
           td::make_unique<TorrentCallback>(stop_watcher, complete_watcher),
-          td::make_unique<PeerCreator>(peer_manager.get(), i, gen_peers(i, 2)),
+          td::make_unique<PeerCreator>(peer_manager.get(), i, gen_peers(i, swarm.peers_per_node)),
           nullptr, ton::SpeedLimiters{});
 
       if (i == 3) {
@@ -1360,5 +1490,23 @@ TEST(Torrent, Peer) {
   stop_watcher.reset();
   guard.reset();
   complete_watcher.reset();
+  double started_at = td::Time::now();
   scheduler.run();
+  return td::Time::now() - started_at;
+}
+
+TEST(Torrent, Peer) {
+  run_swarm(SwarmOptions());
+}
+
+TEST(Torrent, PeerHighLatency) {
+  // One seeder and high-latency links: the download speed is limited by the number of queries in flight
+  SwarmOptions swarm;
+  swarm.peers_n = 8;
+  swarm.peers_per_node = 7;
+  swarm.file_size = 32 * MegaByte;
+  swarm.channel = NetChannel::Options().with_speed(20 * MegaByte).with_buffer(1000 * MegaByte).with_rtt(0.05);
+  auto elapsed = run_swarm(swarm);
+  LOG(ERROR) << "Swarm of " << swarm.peers_n << " nodes downloaded " << td::format::as_size(swarm.file_size)
+             << " in " << td::format::as_time(elapsed);
 }
@@ -235,14 +235,78 @@ class FecBenchmark : public td::Benchmark {
 template <template <class T, size_t size> class O, size_t size = 256 * 8>
 void bench_simd() {
   bench(O<td::Simd_null, size>("baseline"));
-#if TD_SSSE3
-  bench(O<td::Simd_sse, size>("SSE"));
+#if TD_SSE3
+  if (td::Simd_sse::is_supported()) {
+    bench(O<td::Simd_sse, size>("SSE"));
+  }
 #endif
 #if TD_AVX2
-  bench(O<td::Simd_avx, size>("AVX"));
+  if (td::Simd_avx::is_supported()) {
+    bench(O<td::Simd_avx, size>("AVX"));
+  }
+#endif
+#if TD_AVX512
+  if (td::Simd_avx512::is_supported()) {
+    bench(O<td::Simd_avx512, size>("AVX-512"));
+  }
+#endif
+#if TD_GFNI
+  if (td::Simd_gfni::is_supported()) {
+    bench(O<td::Simd_gfni, size>("GFNI"));
+  }
 #endif
 }
 
+// Encoding and decoding speed for symbol sizes used by overlay broadcasts and RLDP transfers
+void run_symbol_size_benchmark() {
+  constexpr size_t TARGET_TOTAL_BYTES = 64 * 1024 * 1024;
+  fprintf(stderr, "GF(256) kernels: %s\n", td::Simd::get_name().c_str());
+  for (size_t symbol_size : {768, 1024}) {
+    for (size_t data_size : {64 << 10, 512 << 10, 2 << 20, 8 << 20}) {
+      td::BufferSlice data(data_size);
+      td::Random::Xorshift128plus rnd(123);
+      for (auto &c : data.as_slice()) {
+        c = static_cast<td::uint8>(rnd());
+      }
+      auto iterations = td::max<size_t>(TARGET_TOTAL_BYTES / data_size, 1);
+
+      double encode_time = 0;
+      double decode_time = 0;
+      for (size_t i = 0; i < iterations; i++) {
+        double start = td::Time::now();
+        auto encoder = td::fec::RaptorQEncoder::create(data.clone(), symbol_size);
+        auto parameters = encoder->get_parameters();
+        std::vector<td::fec::Symbol> symbols;
+        // Drop every 5th source symbol, so that the decoder has to use repair symbols
+        for (td::uint32 j = 0; symbols.size() < parameters.symbols_count + 2; j++) {
+          if (j < parameters.symbols_count && j % 5 == 0) {
+            continue;
+          }
+          if (encoder->get_info().ready_symbol_count <= j) {
+            encoder->prepare_more_symbols();
+          }
+          symbols.push_back(encoder->gen_symbol(j));
+        }
+        double encoded = td::Time::now();
+
+        auto decoder = td::fec::RaptorQDecoder::create(parameters);
+        for (auto &symbol : symbols) {
+          decoder->add_symbol(std::move(symbol));
+        }
+        auto r_data = decoder->try_decode(false);
+        double decoded = td::Time::now();
+        LOG_CHECK(r_data.is_ok() && r_data.ok().data.as_slice() == data.as_slice()) << "Decoding failed";
+
+        encode_time += encoded - start;
+        decode_time += decoded - encoded;
+      }
+      double total_mb = static_cast<double>(data_size) * static_cast<double>(iterations) / 1024 / 1024;
+      fprintf(stderr, "symbol size = %d, data size = %dKB: encode %.1lfMB/s, decode %.1lfMB/s\n", (int)symbol_size,
+              (int)(data_size >> 10), total_mb / encode_time, total_mb / decode_time);
+    }
+  }
+}
+
 void run_encode_benchmark() {
   constexpr size_t TARGET_TOTAL_BYTES = 100 * 1024 * 1024;
   constexpr size_t SYMBOLS_COUNT[11] = {10, 100, 250, 500, 1000, 2000, 4000, 10000, 20000, 40000, 56403};
@@ -278,6 +342,7 @@ void run_encode_benchmark() {
 int main(void) {
   SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
   run_encode_benchmark();
+  run_symbol_size_benchmark();
   bench_simd<Simd_gf256_mul, 32>();
   bench_simd<Simd_gf256_add_mul, 32>();
   bench_simd<Simd_gf256_add, 32>();
@@ -0,0 +1,366 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+
+    Copyright 2017-2020 Telegram Systems LLP
+*/
+#include "td/fec/algebra/Simd.h"
+
+#include <array>
+
+#if TD_AVX2 || TD_AVX512
+#include <immintrin.h> /* avx2, avx512, gfni */
+#elif TD_SSE3
+#include <tmmintrin.h> /* ssse3 */
+#endif
+
+namespace td {
+
+#if TD_SSE3
+bool Simd_sse::is_supported() {
+#if TD_FEC_SIMD_DISPATCH
+  return __builtin_cpu_supports("ssse3");
+#else
+  return true;
+#endif
+}
+
+TD_FEC_TARGET("ssse3") void Simd_sse::gf256_add(void *a, const void *b, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  DCHECK(is_aligned_pointer(b));
+  __m128i *ap128 = reinterpret_cast<__m128i *>(a);
+  const __m128i *bp128 = reinterpret_cast<const __m128i *>(b);
+  for (size_t idx = 0; idx < size; idx += 16) {
+    _mm_storeu_si128(ap128, _mm_xor_si128(_mm_loadu_si128(ap128), _mm_loadu_si128(bp128)));
+    ap128++;
+    bp128++;
+  }
+}
+
+TD_FEC_TARGET("ssse3") void Simd_sse::gf256_mul(void *a, uint8 u, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i urow_hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
+  const __m128i urow_lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
+
+  __m128i *ap128 = reinterpret_cast<__m128i *>(a);
+  for (size_t idx = 0; idx < size; idx += 16) {
+    __m128i ax = _mm_loadu_si128(ap128);
+    __m128i lo = _mm_and_si128(ax, mask);
+    ax = _mm_srli_epi64(ax, 4);
+    __m128i hi = _mm_and_si128(ax, mask);
+    lo = _mm_shuffle_epi8(urow_lo, lo);
+    hi = _mm_shuffle_epi8(urow_hi, hi);
+
+    _mm_storeu_si128(ap128, _mm_xor_si128(lo, hi));
+    ap128++;
+  }
+}
+
+TD_FEC_TARGET("ssse3") void Simd_sse::gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  DCHECK(is_aligned_pointer(b));
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i urow_hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Octet::OctMulHi[u]));
+  const __m128i urow_lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Octet::OctMulLo[u]));
+
+  __m128i *ap128 = reinterpret_cast<__m128i *>(a);
+  const __m128i *bp128 = reinterpret_cast<const __m128i *>(b);
+  for (size_t idx = 0; idx < size; idx += 16) {
+    __m128i bx = _mm_loadu_si128(bp128++);
+    __m128i lo = _mm_and_si128(bx, mask);
+    bx = _mm_srli_epi64(bx, 4);
+    __m128i hi = _mm_and_si128(bx, mask);
+    lo = _mm_shuffle_epi8(urow_lo, lo);
+    hi = _mm_shuffle_epi8(urow_hi, hi);
+
+    _mm_storeu_si128(ap128, _mm_xor_si128(_mm_loadu_si128(ap128), _mm_xor_si128(lo, hi)));
+    ap128++;
+  }
+}
+#endif  // SSSE3
+
+#if TD_AVX2
+namespace {
+TD_FEC_TARGET("avx2") inline __m256i avx_get_mask(const uint32 mask) {
+  // abcd -> abcd * 8
+  __m256i vmask(_mm256_set1_epi32(mask));
+
+  // abcd * 8 -> aaaaaaaabbbbbbbbccccccccdddddddd
+  const __m256i shuffle(
+      _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101, 0x0202020202020202, 0x0303030303030303));
+  vmask = _mm256_shuffle_epi8(vmask, shuffle);
+
+  const __m256i bit_mask(_mm256_set1_epi64x(0x7fbfdfeff7fbfdfe));
+  vmask = _mm256_or_si256(vmask, bit_mask);
+  return _mm256_and_si256(_mm256_cmpeq_epi8(vmask, _mm256_set1_epi64x(-1)), _mm256_set1_epi8(1));
+}
+
+TD_FEC_TARGET("avx2") inline __m256i avx_mul(__m256i x, __m256i urow_lo, __m256i urow_hi) {
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  __m256i lo = _mm256_and_si256(x, mask);
+  x = _mm256_srli_epi64(x, 4);
+  __m256i hi = _mm256_and_si256(x, mask);
+  lo = _mm256_shuffle_epi8(urow_lo, lo);
+  hi = _mm256_shuffle_epi8(urow_hi, hi);
+  return _mm256_xor_si256(lo, hi);
+}
+
+TD_FEC_TARGET("avx2") inline __m256i avx_load_row(const uint8 *row) {
+  return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i *>(row)));
+}
+}  // namespace
+
+bool Simd_avx::is_supported() {
+#if TD_FEC_SIMD_DISPATCH
+  return __builtin_cpu_supports("avx2");
+#else
+  return true;
+#endif
+}
+
+TD_FEC_TARGET("avx2") void Simd_avx::gf256_add(void *a, const void *b, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  DCHECK(is_aligned_pointer(b));
+  __m256i *ap256 = reinterpret_cast<__m256i *>(a);
+  const __m256i *bp256 = reinterpret_cast<const __m256i *>(b);
+  for (size_t idx = 0; idx < size; idx += 32) {
+    _mm256_storeu_si256(ap256, _mm256_xor_si256(_mm256_loadu_si256(ap256), _mm256_loadu_si256(bp256)));
+    ap256++;
+    bp256++;
+  }
+}
+
+TD_FEC_TARGET("avx2") void Simd_avx::gf256_from_gf2(void *a, const void *b, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  DCHECK(size % 4 == 0);
+  __m256i *ap256 = reinterpret_cast<__m256i *>(a);
+  const uint32 *bp = reinterpret_cast<const uint32 *>(b);
+  size /= 4;
+  for (size_t i = 0; i < size; i++, bp++, ap256++) {
+    _mm256_store_si256(ap256, avx_get_mask(*bp));
+  }
+}
+
+TD_FEC_TARGET("avx2") void Simd_avx::gf256_mul(void *a, uint8 u, size_t size) {
+  const __m256i urow_hi = avx_load_row(Octet::OctMulHi[u]);
+  const __m256i urow_lo = avx_load_row(Octet::OctMulLo[u]);
+
+  __m256i *ap256 = reinterpret_cast<__m256i *>(a);
+  for (size_t idx = 0; idx < size; idx += 32) {
+    _mm256_store_si256(ap256, avx_mul(_mm256_load_si256(ap256), urow_lo, urow_hi));
+    ap256++;
+  }
+}
+
+TD_FEC_TARGET("avx2") void Simd_avx::gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  const __m256i urow_hi = avx_load_row(Octet::OctMulHi[u]);
+  const __m256i urow_lo = avx_load_row(Octet::OctMulLo[u]);
+
+  __m256i *ap256 = reinterpret_cast<__m256i *>(a);
+  const __m256i *bp256 = reinterpret_cast<const __m256i *>(b);
+  for (size_t idx = 0; idx < size; idx += 32) {
+    __m256i prod = avx_mul(_mm256_load_si256(bp256++), urow_lo, urow_hi);
+    _mm256_store_si256(ap256, _mm256_xor_si256(_mm256_load_si256(ap256), prod));
+    ap256++;
+  }
+}
+#endif  // AVX2
+
+// Sizes are multiples of 32 and pointers are only 32-aligned, so 512-bit kernels use unaligned loads and finish
+// with at most one 256-bit step
+
+#if TD_AVX512
+namespace {
+// GCC 12 implements unmasked _mm512_srli_epi64, _mm512_broadcast_i32x4 and _mm512_castsi512_si256 through an
+// intentionally uninitialized variable and reports it with -Wmaybe-uninitialized. Zero-masked forms with a full mask
+// compile to the same instructions; 256-bit tails build their own 256-bit constants
+TD_FEC_TARGET("avx512bw") inline __m512i avx512_mul(__m512i x, __m512i urow_lo, __m512i urow_hi) {
+  const __m512i mask = _mm512_set1_epi8(0x0f);
+  __m512i lo = _mm512_and_si512(x, mask);
+  x = _mm512_maskz_srli_epi64(static_cast<__mmask8>(0xff), x, 4);
+  __m512i hi = _mm512_and_si512(x, mask);
+  lo = _mm512_shuffle_epi8(urow_lo, lo);
+  hi = _mm512_shuffle_epi8(urow_hi, hi);
+  return _mm512_xor_si512(lo, hi);
+}
+
+TD_FEC_TARGET("avx512bw") inline __m512i avx512_load_row(const uint8 *row) {
+  return _mm512_maskz_broadcast_i32x4(static_cast<__mmask16>(0xffff),
+                                      _mm_load_si128(reinterpret_cast<const __m128i *>(row)));
+}
+}  // namespace
+
+bool Simd_avx512::is_supported() {
+  return __builtin_cpu_supports("avx512bw");
+}
+
+TD_FEC_TARGET("avx512bw") void Simd_avx512::gf256_add(void *a, const void *b, size_t size) {
+  DCHECK(is_aligned_pointer(a));
+  DCHECK(is_aligned_pointer(b));
+  uint8 *ap = reinterpret_cast<uint8 *>(a);
+  const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+  size_t idx = 0;
+  for (; idx + 64 <= size; idx += 64) {
+    _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), _mm512_loadu_si512(bp + idx)));
+  }
+  if (idx < size) {
+    auto *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+    _mm256_store_si256(ap256, _mm256_xor_si256(_mm256_load_si256(ap256),
+                                               _mm256_load_si256(reinterpret_cast<const __m256i *>(bp + idx))));
+  }
+}
+
+TD_FEC_TARGET("avx512bw") void Simd_avx512::gf256_mul(void *a, uint8 u, size_t size) {
+  const __m512i urow_hi = avx512_load_row(Octet::OctMulHi[u]);
+  const __m512i urow_lo = avx512_load_row(Octet::OctMulLo[u]);
+
+  uint8 *ap = reinterpret_cast<uint8 *>(a);
+  size_t idx = 0;
+  for (; idx + 64 <= size; idx += 64) {
+    _mm512_storeu_si512(ap + idx, avx512_mul(_mm512_loadu_si512(ap + idx), urow_lo, urow_hi));
+  }
+  if (idx < size) {
+    auto *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+    _mm256_store_si256(ap256, avx_mul(_mm256_load_si256(ap256), avx_load_row(Octet::OctMulLo[u]),
+                                      avx_load_row(Octet::OctMulHi[u])));
+  }
+}
+
+TD_FEC_TARGET("avx512bw") void Simd_avx512::gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  const __m512i urow_hi = avx512_load_row(Octet::OctMulHi[u]);
+  const __m512i urow_lo = avx512_load_row(Octet::OctMulLo[u]);
+
+  uint8 *ap = reinterpret_cast<uint8 *>(a);
+  const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+  size_t idx = 0;
+  for (; idx + 64 <= size; idx += 64) {
+    __m512i prod = avx512_mul(_mm512_loadu_si512(bp + idx), urow_lo, urow_hi);
+    _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), prod));
+  }
+  if (idx < size) {
+    auto *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+    __m256i prod = avx_mul(_mm256_load_si256(reinterpret_cast<const __m256i *>(bp + idx)),
+                           avx_load_row(Octet::OctMulLo[u]), avx_load_row(Octet::OctMulHi[u]));
+    _mm256_store_si256(ap256, _mm256_xor_si256(_mm256_load_si256(ap256), prod));
+  }
+}
+#endif  // AVX512
+
+#if TD_GFNI
+namespace {
+constexpr uint8 gf256_mul_slow(uint8 a, uint8 b) {
+  uint8 res = 0;
+  for (int i = 0; i < 8; i++) {
+    if (b & (1 << i)) {
+      res ^= a;
+    }
+    a = static_cast<uint8>((a << 1) ^ (a & 0x80 ? 0x1d : 0));
+  }
+  return res;
+}
+
+// GF2P8AFFINEQB computes bit i of the result as parity(x & byte 7 - i of the matrix)
+constexpr std::array<uint64, 256> gfni_make_matrices() {
+  std::array<uint64, 256> res{};
+  for (int u = 0; u < 256; u++) {
+    uint64 matrix = 0;
+    for (int i = 0; i < 8; i++) {
+      uint64 row = 0;
+      for (int k = 0; k < 8; k++) {
+        uint8 column = gf256_mul_slow(static_cast<uint8>(u), static_cast<uint8>(1 << k));
+        row |= static_cast<uint64>((column >> i) & 1) << k;
+      }
+      matrix |= row << (8 * (7 - i));
+    }
+    res[u] = matrix;
+  }
+  return res;
+}
+
+constexpr std::array<uint64, 256> gfni_matrices = gfni_make_matrices();
+}  // namespace
+
+bool Simd_gfni::is_supported() {
+  return __builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx512bw");
+}
+
+TD_FEC_TARGET("gfni,avx512bw") void Simd_gfni::gf256_mul(void *a, uint8 u, size_t size) {
+  const __m512i matrix = _mm512_set1_epi64(static_cast<long long>(gfni_matrices[u]));
+
+  uint8 *ap = reinterpret_cast<uint8 *>(a);
+  size_t idx = 0;
+  for (; idx + 64 <= size; idx += 64) {
+    _mm512_storeu_si512(ap + idx, _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(ap + idx), matrix, 0));
+  }
+  if (idx < size) {
+    auto *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+    const __m256i matrix256 = _mm256_set1_epi64x(static_cast<long long>(gfni_matrices[u]));
+    _mm256_store_si256(ap256, _mm256_gf2p8affine_epi64_epi8(_mm256_load_si256(ap256), matrix256, 0));
+  }
+}
+
+TD_FEC_TARGET("gfni,avx512bw") void Simd_gfni::gf256_add_mul(void *a, const void *b, uint8 u, size_t size) {
+  const __m512i matrix = _mm512_set1_epi64(static_cast<long long>(gfni_matrices[u]));
+
+  uint8 *ap = reinterpret_cast<uint8 *>(a);
+  const uint8 *bp = reinterpret_cast<const uint8 *>(b);
+  size_t idx = 0;
+  for (; idx + 64 <= size; idx += 64) {
+    __m512i prod = _mm512_gf2p8affine_epi64_epi8(_mm512_loadu_si512(bp + idx), matrix, 0);
+    _mm512_storeu_si512(ap + idx, _mm512_xor_si512(_mm512_loadu_si512(ap + idx), prod));
+  }
+  if (idx < size) {
+    auto *ap256 = reinterpret_cast<__m256i *>(ap + idx);
+    const __m256i matrix256 = _mm256_set1_epi64x(static_cast<long long>(gfni_matrices[u]));
+    __m256i prod =
+        _mm256_gf2p8affine_epi64_epi8(_mm256_load_si256(reinterpret_cast<const __m256i *>(bp + idx)), matrix256, 0);
+    _mm256_store_si256(ap256, _mm256_xor_si256(_mm256_load_si256(ap256), prod));
+  }
+}
+#endif  // GFNI
+
+#if TD_FEC_SIMD_DISPATCH
+namespace {
+template <class SimdT>
+Simd_dispatch::Kernels make_kernels() {
+  return {SimdT::get_name(), &SimdT::gf256_add, &SimdT::gf256_mul, &SimdT::gf256_add_mul, &SimdT::gf256_from_gf2};
+}
+
+Simd_dispatch::Kernels choose_kernels() {
+  __builtin_cpu_init();
+  if (Simd_gfni::is_supported()) {
+    return make_kernels<Simd_gfni>();
+  }
+  if (Simd_avx512::is_supported()) {
+    return make_kernels<Simd_avx512>();
+  }
+  if (Simd_avx::is_supported()) {
+    return make_kernels<Simd_avx>();
+  }
+  if (Simd_sse::is_supported()) {
+    return make_kernels<Simd_sse>();
+  }
+  return make_kernels<Simd_null>();
+}
+}  // namespace
+
+const Simd_dispatch::Kernels &Simd_dispatch::get_kernels() {
+  static const Kernels kernels = choose_kernels();
+  return kernels;
+}
+#endif
+
+}  // namespace td
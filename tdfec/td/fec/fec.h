@@ -123,6 +123,7 @@ class RaptorQEncoder : public Encoder {
  public:
   static std::unique_ptr<RaptorQEncoder> create(BufferSlice data, size_t max_symbol_size);
 
+  // May be called concurrently once prepare_more_symbols has finished
   Symbol gen_symbol(uint32 id) override;
 
   Info get_info() const override;
@@ -51,7 +51,7 @@ Encoder::Info Encoder::get_info() const {
   return res;
 }
 
-Status Encoder::gen_symbol(uint32 id, MutableSlice slice) {
+Status Encoder::gen_symbol(uint32 id, MutableSlice slice) const {
   if (id < p_.K) {
     slice.copy_from(first_symbols_.symbols()[id].data);
     return Status::OK();
@@ -59,7 +59,7 @@ Status Encoder::gen_symbol(uint32 id, MutableSlice slice) {
   if (!has_precalc()) {
     return Status::Error("Precalc is not finished");
   }
-  (*raw_encoder_).gen_symbol(id + p_.K_padded - p_.K, slice);
+  raw_encoder_.value().gen_symbol(id + p_.K_padded - p_.K, slice);
   return Status::OK();
 }
 
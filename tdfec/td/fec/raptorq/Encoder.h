@@ -45,7 +45,8 @@ class Encoder {
   static std::unique_ptr<Encoder> create(size_t symbol_size, RawEncoder raw_encoder);
 
   Encoder(Rfc::Parameters p, size_t symbol_size, BufferSlice data, optional<RawEncoder> raw_encoder = {});
-  Status gen_symbol(uint32 id, MutableSlice slice);
+  // May be called concurrently. Repair symbols are available only after precalc
+  Status gen_symbol(uint32 id, MutableSlice slice) const;
   Parameters get_parameters() const;
   Info get_info() const;
 
@@ -22,9 +22,10 @@ namespace td {
 namespace raptorq {
 void RawEncoder::gen_symbol(uint32 id, MutableSlice to) const {
   CHECK(to.size() == symbol_size());
-  d_.set_zero();
-  p_.encoding_row_for_each(p_.get_encoding_row(id), [&](auto row) { d_.row_add(0, C_.row(row)); });
-  to.copy_from(d_.row(0).truncate(symbol_size()));
+  MatrixGF256 d{1, symbol_size()};
+  d.set_zero();
+  p_.encoding_row_for_each(p_.get_encoding_row(id), [&](auto row) { d.row_add(0, C_.row(row)); });
+  to.copy_from(d.row(0).truncate(symbol_size()));
 }
 }  // namespace raptorq
 }  // namespace td
@@ -25,18 +25,18 @@ namespace td {
 namespace raptorq {
 class RawEncoder {
  public:
-  RawEncoder(Rfc::Parameters p, MatrixGF256 C) : p_(p), C_(std::move(C)), d_{1, symbol_size()} {
+  RawEncoder(Rfc::Parameters p, MatrixGF256 C) : p_(p), C_(std::move(C)) {
   }
 
   size_t symbol_size() const {
     return C_.cols();
   }
+  // May be called concurrently
   void gen_symbol(uint32 id, MutableSlice to) const;
 
  private:
   Rfc::Parameters p_;
   MatrixGF256 C_;
-  mutable MatrixGF256 d_;
 };
 }  // namespace raptorq
 }  // namespace td
@@ -25,6 +25,7 @@
 #include "LibRaptorQ.h"
 #endif
 #include "td/utils/tests.h"
+#include "td/utils/port/thread.h"
 
 #include <string>
 td::Slice get_long_string() {
@@ -65,6 +66,9 @@ TEST(Fec, Simd) {
     auto save_d = [&] { save_str(td::Slice(d, a_size * 8).str()); };
 
     auto run = [&](auto simd) {
+      if (!simd.is_supported()) {
+        return;
+      }
       LOG(ERROR) << simd.get_name();
       std::memcpy(a, a_copy, a_size);
       simd.gf256_add(a, b, a_size);
@@ -95,6 +99,12 @@ TEST(Fec, Simd) {
 #endif
 #if TD_AVX2
     run(td::Simd_avx());
+#endif
+#if TD_AVX512
+    run(td::Simd_avx512());
+#endif
+#if TD_GFNI
+    run(td::Simd_gfni());
 #endif
     run(td::Simd());
   }
@@ -225,6 +235,38 @@ TEST(Fec, RaptorQFull) {
   fec_test<td::fec::RaptorQEncoder, td::fec::RaptorQDecoder>(data, max_symbol_size);
 }
 
+TEST(Fec, RaptorQConcurrentSymbols) {
+  const size_t max_symbol_size = 768;
+  std::string data = td::rand_string('a', 'z', max_symbol_size * 1000);
+  auto encoder = td::fec::RaptorQEncoder::create(td::BufferSlice(data), max_symbol_size);
+  encoder->prepare_more_symbols();
+
+  const td::uint32 symbols_count = 4000;
+  std::vector<td::fec::Symbol> expected;
+  for (td::uint32 i = 0; i < symbols_count; i++) {
+    expected.push_back(encoder->gen_symbol(i));
+  }
+
+  const td::uint32 threads_n = 4;
+  std::vector<std::vector<td::fec::Symbol>> generated(threads_n);
+  std::vector<td::thread> threads;
+  for (td::uint32 t = 0; t < threads_n; t++) {
+    threads.emplace_back([&, t] {
+      for (td::uint32 i = t; i < symbols_count; i += threads_n) {
+        generated[t].push_back(encoder->gen_symbol(i));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (td::uint32 t = 0; t < threads_n; t++) {
+    for (auto &symbol : generated[t]) {
+      ASSERT_EQ(expected[symbol.id].data.as_slice(), symbol.data.as_slice());
+    }
+  }
+}
+
 #if USE_LIBRAPTORQ
 TEST(Fec, RaptorQEncoder) {
   const size_t max_symbol_size = 200;
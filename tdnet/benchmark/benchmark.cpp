@@ -0,0 +1,156 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/actor/actor.h"
+
+#include "td/net/UdpServer.h"
+
+#include "td/utils/logging.h"
+#include "td/utils/misc.h"
+#include "td/utils/OptionParser.h"
+#include "td/utils/Time.h"
+
+#include <atomic>
+
+namespace {
+
+struct BenchmarkOptions {
+  td::int32 port = 23400;
+  td::uint64 packets = 200000;
+  size_t packet_size = 1024;
+  double timeout = 30.0;
+};
+
+// Sends packets from one UdpServer to another over loopback and measures the receive rate
+void run_udp_benchmark(td::actor::Scheduler &scheduler, const BenchmarkOptions &bench, td::Slice name,
+                       td::UdpBatchOptions options, td::int32 port) {
+  class Callback : public td::UdpServer::Callback {
+   public:
+    Callback(std::atomic<td::uint64> &received, std::atomic<double> &last_received_at)
+        : received_(received), last_received_at_(last_received_at) {
+    }
+    void on_udp_message(td::UdpMessage message) override {
+      if (message.error.is_ok()) {
+        last_received_at_ = td::Time::now();
+        received_++;
+      }
+    }
+
+   private:
+    std::atomic<td::uint64> &received_;
+    std::atomic<double> &last_received_at_;
+  };
+  std::atomic<td::uint64> received{0}, sender_received{0};
+  std::atomic<double> last_received_at{0.0}, sender_last_received_at{0.0};
+  td::IPAddress dst_addr;
+  dst_addr.init_ipv4_port("127.0.0.1", port + 1).ensure();
+  td::actor::ActorOwn<td::UdpServer> sender, receiver;
+  scheduler.run_in_context([&] {
+    sender = td::UdpServer::create("bench-udp-sender", port,
+                                   std::make_unique<Callback>(sender_received, sender_last_received_at), options)
+                 .move_as_ok();
+    receiver = td::UdpServer::create("bench-udp-receiver", port + 1,
+                                     std::make_unique<Callback>(received, last_received_at), options)
+                   .move_as_ok();
+  });
+  double start = td::Time::now();
+  scheduler.run_in_context([&] {
+    for (td::uint64 i = 0; i < bench.packets; i++) {
+      td::actor::send_closure(sender, &td::UdpServer::send,
+                              td::UdpMessage{dst_addr, td::BufferSlice{bench.packet_size}, {}});
+    }
+  });
+  auto timeout = td::Timestamp::in(bench.timeout);
+  auto idle = td::Timestamp::in(1.0);
+  td::uint64 last_received = 0;
+  while (scheduler.run(0.1)) {
+    if (received == bench.packets || timeout.is_in_past()) {
+      break;
+    }
+    if (received != last_received) {
+      last_received = received;
+      idle = td::Timestamp::in(1.0);
+    } else if (idle.is_in_past()) {
+      break;
+    }
+  }
+  double time = last_received_at - start;
+  LOG(PLAIN) << "UDP loopback, " << name << ": received " << received << "/" << bench.packets << " packets of "
+             << bench.packet_size << " bytes, " << (time > 0 ? (double)received / time : 0.0) << " packets/s";
+  scheduler.run_in_context([&] {
+    sender.reset();
+    receiver.reset();
+  });
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  BenchmarkOptions bench;
+  td::OptionParser p;
+  p.set_description("Loopback UDP throughput with different batching modes (recvmmsg/sendmmsg, GSO, GRO)");
+  p.add_checked_option('p', "port", "first of the local ports to use, two ports per mode (default: 23400)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(bench.port, td::to_integer_safe<td::uint16>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('n', "packets", "packets to send in each mode (default: 200000)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT_ASSIGN(bench.packets, td::to_integer_safe<td::uint64>(arg));
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('s', "packet-size", "size of a packet in bytes (default: 1024)",
+                       [&](td::Slice arg) -> td::Status {
+                         TRY_RESULT(size, td::to_integer_safe<td::uint32>(arg));
+                         if (size == 0 || size > 1500) {
+                           return td::Status::Error("packet size should be in range [1..1500]");
+                         }
+                         bench.packet_size = size;
+                         return td::Status::OK();
+                       });
+  p.add_checked_option('t', "timeout", "max time for each mode in seconds (default: 30)",
+                       [&](td::Slice arg) -> td::Status {
+                         bench.timeout = td::to_double(arg);
+                         if (bench.timeout <= 0.0) {
+                           return td::Status::Error("timeout should be positive");
+                         }
+                         return td::Status::OK();
+                       });
+  auto status = p.run(argc, argv);
+  if (status.is_error()) {
+    LOG(ERROR) << status.error();
+    LOG(ERROR) << p;
+    return 1;
+  }
+
+  td::actor::Scheduler scheduler({2});
+  td::int32 port = bench.port;
+  auto run = [&](td::Slice name, size_t batch_size, bool gso, bool gro) {
+    td::UdpBatchOptions options;
+    options.batch_size = batch_size;
+    options.gso = gso;
+    options.gro = gro;
+    run_udp_benchmark(scheduler, bench, name, options, port);
+    port += 2;
+  };
+  run("batch=1", 1, false, false);
+  run("batch=16", 16, false, false);
+  run("batch=64", 64, false, false);
+  run("batch=64 gso", 64, true, false);
+  run("batch=64 gso gro", 64, true, true);
+  return 0;
+}
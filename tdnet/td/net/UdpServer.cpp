@@ -33,9 +33,9 @@ class UdpServerImpl : public UdpServer {
  public:
   void send(td::UdpMessage &&message) override;
   static td::actor::ActorOwn<UdpServerImpl> create(td::Slice name, td::UdpSocketFd fd,
-                                                   std::unique_ptr<Callback> callback);
+                                                   std::unique_ptr<Callback> callback, UdpBatchOptions options);
 
-  UdpServerImpl(td::UdpSocketFd fd, std::unique_ptr<Callback> callback);
+  UdpServerImpl(td::UdpSocketFd fd, std::unique_ptr<Callback> callback, UdpBatchOptions options);
 
  private:
   td::actor::ActorOwn<> fd_listener_;
@@ -55,18 +55,23 @@ class UdpServerImpl : public UdpServer {
 void UdpServerImpl::send(td::UdpMessage &&message) {
   //LOG(WARNING) << "TO: " << message.address;
   fd_.send(std::move(message));
-  loop();  // TODO: some yield logic
+  // Messages sent during one run of the actor are flushed together, so that they can be batched
+  if (fd_.send_queue_size() >= fd_.get_options().batch_size) {
+    loop();
+  } else {
+    yield();
+  }
 }
 
 td::actor::ActorOwn<UdpServerImpl> UdpServerImpl::create(td::Slice name, td::UdpSocketFd fd,
-                                                         std::unique_ptr<Callback> callback) {
+                                                         std::unique_ptr<Callback> callback, UdpBatchOptions options) {
   return td::actor::create_actor<UdpServerImpl>(
       actor::ActorOptions().with_name(name).with_poll(!td::Poll::is_edge_triggered()), std::move(fd),
-      std::move(callback));
+      std::move(callback), options);
 }
 
-UdpServerImpl::UdpServerImpl(td::UdpSocketFd fd, std::unique_ptr<Callback> callback)
-    : callback_(std::move(callback)), fd_(std::move(fd)) {
+UdpServerImpl::UdpServerImpl(td::UdpSocketFd fd, std::unique_ptr<Callback> callback, UdpBatchOptions options)
+    : callback_(std::move(callback)), fd_(std::move(fd), options) {
 }
 
 void UdpServerImpl::start_up() {
@@ -389,12 +394,13 @@ class UdpServerViaTcp : public UdpServer {
 
 }  // namespace detail
 
-Result<actor::ActorOwn<UdpServer>> UdpServer::create(td::Slice name, int32 port, std::unique_ptr<Callback> callback) {
+Result<actor::ActorOwn<UdpServer>> UdpServer::create(td::Slice name, int32 port, std::unique_ptr<Callback> callback,
+                                                    UdpBatchOptions options) {
   td::IPAddress from_ip;
   TRY_STATUS(from_ip.init_ipv4_port("0.0.0.0", port));
   TRY_RESULT(fd, UdpSocketFd::open(from_ip));
   fd.maximize_rcv_buffer().ensure();
-  return detail::UdpServerImpl::create(name, std::move(fd), std::move(callback));
+  return detail::UdpServerImpl::create(name, std::move(fd), std::move(callback), options);
 }
 Result<actor::ActorOwn<UdpServer>> UdpServer::create_via_tcp(td::Slice name, int32 port,
                                                              std::unique_ptr<Callback> callback) {
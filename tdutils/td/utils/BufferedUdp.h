@@ -21,6 +21,7 @@
 #include "td/utils/buffer.h"
 #include "td/utils/common.h"
 #include "td/utils/logging.h"
+#include "td/utils/misc.h"
 #include "td/utils/optional.h"
 #include "td/utils/port/detail/PollableFd.h"
 #include "td/utils/port/thread_local.h"
@@ -30,78 +31,170 @@
 #include "td/utils/VectorQueue.h"
 
 #include <array>
+#include <vector>
 
 namespace td {
 
+struct UdpBatchOptions {
+  // Max number of messages in one recvmmsg/sendmmsg call, at most UdpSocketFd::MAX_BATCH_SIZE
+  size_t batch_size = 16;
+  // Send consecutive datagrams to the same address as one UDP_SEGMENT message
+  bool gso = false;
+  // Receive coalesced datagrams (UDP_GRO)
+  bool gro = false;
+};
+
 #if TD_PORT_POSIX
 namespace detail {
 class UdpWriter {
  public:
-  static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    std::array<UdpSocketFd::OutboundMessage, 16> messages;
+  static Status write_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue, size_t batch_size,
+                           std::vector<Slice> &segments_buffer) TD_WARN_UNUSED_RESULT {
+    std::array<UdpSocketFd::OutboundMessage, UdpSocketFd::MAX_BATCH_SIZE> messages;
+    std::array<size_t, UdpSocketFd::MAX_BATCH_SIZE> queue_messages;
     auto to_send = queue.as_span();
-    size_t to_send_n = td::min(messages.size(), to_send.size());
-    to_send.truncate(to_send_n);
-    for (size_t i = 0; i < to_send_n; i++) {
-      messages[i].to = &to_send[i].address;
-      messages[i].data = to_send[i].data.as_slice();
+    batch_size = clamp<size_t>(batch_size, 1, messages.size());
+    bool gso = fd.is_gso_enabled();
+    if (gso) {
+      segments_buffer.resize(batch_size * UdpSocketFd::MAX_SEGMENTS);
+    }
+    size_t to_send_n = 0;
+    size_t pos = 0;
+    while (pos < to_send.size() && to_send_n < batch_size) {
+      auto &message = messages[to_send_n];
+      message.to = &to_send[pos].address;
+      message.data = to_send[pos].data.as_slice();
+      message.segments = {};
+      size_t cnt = gso ? count_segments(to_send, pos) : 1;
+      if (cnt > 1) {
+        Slice *segments = segments_buffer.data() + to_send_n * UdpSocketFd::MAX_SEGMENTS;
+        for (size_t i = 0; i < cnt; i++) {
+          segments[i] = to_send[pos + i].data.as_slice();
+        }
+        message.segments = Span<Slice>(segments, cnt);
+      }
+      queue_messages[to_send_n++] = cnt;
+      pos += cnt;
     }
 
     size_t cnt;
     auto status = fd.send_messages(::td::Span<UdpSocketFd::OutboundMessage>(messages).truncate(to_send_n), cnt);
-    queue.pop_n(cnt);
+    size_t sent = 0;
+    for (size_t i = 0; i < cnt; i++) {
+      sent += queue_messages[i];
+    }
+    queue.pop_n(sent);
     return status;
   }
+
+ private:
+  // Number of messages starting from pos which can be sent as one segmented message
+  static size_t count_segments(Span<UdpMessage> messages, size_t pos) {
+    const auto &first = messages[pos];
+    size_t segment_size = first.data.size();
+    size_t total_size = segment_size;
+    size_t cnt = 1;
+    while (pos + cnt < messages.size() && cnt < UdpSocketFd::MAX_SEGMENTS) {
+      const auto &next = messages[pos + cnt];
+      if (next.data.size() > segment_size || next.data.empty() ||
+          total_size + next.data.size() > UdpSocketFd::MAX_SEGMENTED_MESSAGE_SIZE || !(next.address == first.address)) {
+        break;
+      }
+      total_size += next.data.size();
+      cnt++;
+      if (next.data.size() < segment_size) {
+        // Only the last segment may be shorter
+        break;
+      }
+    }
+    return cnt;
+  }
 };
 
 class UdpReaderHelper {
  public:
-  void init_inbound_message(UdpSocketFd::InboundMessage &message) {
+  void init_inbound_message(UdpSocketFd::InboundMessage &message, size_t max_packet_size, bool gro) {
     message.from = &message_.address;
     message.error = &message_.error;
-    if (buffer_.size() < MAX_PACKET_SIZE) {
-      buffer_ = BufferSlice(RESERVED_SIZE);
+    message.segment_size = &segment_size_;
+    if (gro) {
+      if (gro_buffer_.size() != max_packet_size) {
+        gro_buffer_ = BufferSlice(max_packet_size);
+      }
+      message.data = gro_buffer_.as_slice();
+      return;
+    }
+    gro_buffer_ = {};
+    if (buffer_.size() < max_packet_size) {
+      buffer_ = BufferSlice(max(RESERVED_SIZE, max_packet_size * 2));
     }
-    CHECK(buffer_.size() >= MAX_PACKET_SIZE);
-    message.data = buffer_.as_slice().truncate(MAX_PACKET_SIZE);
+    CHECK(buffer_.size() >= max_packet_size);
+    message.data = buffer_.as_slice().truncate(max_packet_size);
   }
 
-  UdpMessage extract_udp_message(UdpSocketFd::InboundMessage &message) {
+  // Received datagrams share one buffer, which is reused until it is exhausted.
+  // A coalesced (GRO) read is copied out of its 64KB receive buffer, which is reused for the next read: received
+  // messages keep alive only the bytes that were actually received.
+  template <class F>
+  void extract_udp_messages(UdpSocketFd::InboundMessage &message, size_t max_packet_size, F &&f) {
+    auto size = message.data.size();
+    CHECK(size <= max_packet_size);
+    if (!gro_buffer_.empty()) {
+      BufferSlice data(message.data);
+      if (segment_size_ == 0) {
+        message_.data = std::move(data);
+        f(std::move(message_));
+        return;
+      }
+      for (size_t pos = 0; pos < size; pos += segment_size_) {
+        UdpMessage segment;
+        segment.address = message_.address;
+        segment.data = data.from_slice(data.as_slice().substr(pos, segment_size_));
+        f(std::move(segment));
+      }
+      return;
+    }
     message_.data = buffer_.from_slice(message.data);
-    auto size = message_.data.size();
+    f(std::move(message_));
     size = (size + 7) & ~7;
-    CHECK(size <= MAX_PACKET_SIZE);
+    CHECK(size <= max_packet_size);
     buffer_.confirm_read(size);
-    return std::move(message_);
   }
 
  private:
-  static constexpr size_t MAX_PACKET_SIZE = 2048;
-  static constexpr size_t RESERVED_SIZE = MAX_PACKET_SIZE * 8;
+  static constexpr size_t RESERVED_SIZE = 2048 * 8;
   UdpMessage message_;
+  size_t segment_size_ = 0;
   BufferSlice buffer_;
+  BufferSlice gro_buffer_;
 };
 
 // One for thread is enough
 class UdpReader {
  public:
-  UdpReader() {
-    for (size_t i = 0; i < messages_.size(); i++) {
-      helpers_[i].init_inbound_message(messages_[i]);
-    }
-  }
-  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue) TD_WARN_UNUSED_RESULT {
-    for (size_t i = 0; i < messages_.size(); i++) {
-      CHECK(messages_[i].data.size() == 2048);
+  static constexpr size_t MAX_PACKET_SIZE = 2048;
+  // With UDP_GRO the kernel may coalesce datagrams up to the maximum UDP message size
+  static constexpr size_t MAX_GRO_PACKET_SIZE = 65536;
+
+  Status read_once(UdpSocketFd &fd, VectorQueue<UdpMessage> &queue, const UdpBatchOptions &options)
+      TD_WARN_UNUSED_RESULT {
+    size_t batch_size = clamp<size_t>(options.batch_size, 1, messages_.size());
+    size_t max_packet_size = options.gro ? MAX_GRO_PACKET_SIZE : MAX_PACKET_SIZE;
+    // Buffers are allocated on first use and reallocated only if the socket options change
+    for (size_t i = 0; i < batch_size; i++) {
+      if (messages_[i].data.size() != max_packet_size) {
+        helpers_[i].init_inbound_message(messages_[i], max_packet_size, options.gro);
+      }
     }
     size_t cnt = 0;
-    auto status = fd.receive_messages(messages_, cnt);
+    auto status = fd.receive_messages(MutableSpan<UdpSocketFd::InboundMessage>(messages_).truncate(batch_size), cnt);
     for (size_t i = 0; i < cnt; i++) {
-      queue.push(helpers_[i].extract_udp_message(messages_[i]));
-      helpers_[i].init_inbound_message(messages_[i]);
+      helpers_[i].extract_udp_messages(messages_[i], max_packet_size,
+                                       [&](UdpMessage message) { queue.push(std::move(message)); });
+      helpers_[i].init_inbound_message(messages_[i], max_packet_size, options.gro);
     }
-    for (size_t i = cnt; i < messages_.size(); i++) {
-      LOG_CHECK(messages_[i].data.size() == 2048)
+    for (size_t i = cnt; i < batch_size; i++) {
+      LOG_CHECK(messages_[i].data.size() == max_packet_size)
           << " cnt = " << cnt << " i = " << i << " size = " << messages_[i].data.size() << " status = " << status;
     }
     if (status.is_error() && !UdpSocketFd::is_critical_read_error(status)) {
@@ -112,9 +205,8 @@ class UdpReader {
   }
 
  private:
-  static constexpr size_t BUFFER_SIZE = 16;
-  std::array<UdpSocketFd::InboundMessage, BUFFER_SIZE> messages_;
-  std::array<UdpReaderHelper, BUFFER_SIZE> helpers_;
+  std::array<UdpSocketFd::InboundMessage, UdpSocketFd::MAX_BATCH_SIZE> messages_;
+  std::array<UdpReaderHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers_;
 };
 
 }  // namespace detail
@@ -123,7 +215,24 @@ class UdpReader {
 
 class BufferedUdp : public UdpSocketFd {
  public:
-  explicit BufferedUdp(UdpSocketFd fd) : UdpSocketFd(std::move(fd)) {
+  explicit BufferedUdp(UdpSocketFd fd, UdpBatchOptions options = {})
+      : UdpSocketFd(std::move(fd)), options_(options) {
+#if TD_PORT_POSIX
+    if (options_.gso) {
+      auto status = enable_gso();
+      if (status.is_error()) {
+        LOG(WARNING) << "Failed to enable UDP GSO: " << status;
+        options_.gso = false;
+      }
+    }
+    if (options_.gro) {
+      auto status = enable_gro();
+      if (status.is_error()) {
+        LOG(WARNING) << "Failed to enable UDP GRO: " << status;
+        options_.gro = false;
+      }
+    }
+#endif
   }
 
 #if TD_PORT_POSIX
@@ -150,6 +259,18 @@ class BufferedUdp : public UdpSocketFd {
   }
 #endif
 
+  size_t send_queue_size() const {
+#if TD_PORT_POSIX
+    return output_.size();
+#else
+    return 0;
+#endif
+  }
+
+  const UdpBatchOptions &get_options() const {
+    return options_;
+  }
+
   UdpSocketFd move_as_udp_socket_fd() {
     return std::move(as_fd());
   }
@@ -159,9 +280,11 @@ class BufferedUdp : public UdpSocketFd {
   }
 
  private:
+  UdpBatchOptions options_;
 #if TD_PORT_POSIX
   VectorQueue<UdpMessage> input_;
   VectorQueue<UdpMessage> output_;
+  std::vector<Slice> segments_buffer_;
 
   VectorQueue<UdpMessage> &input() {
     return input_;
@@ -171,12 +294,12 @@ class BufferedUdp : public UdpSocketFd {
   }
 
   Status flush_send_once() TD_WARN_UNUSED_RESULT {
-    return detail::UdpWriter::write_once(as_fd(), output_);
+    return detail::UdpWriter::write_once(as_fd(), output_, options_.batch_size, segments_buffer_);
   }
 
   Status flush_read_once() TD_WARN_UNUSED_RESULT {
     init_thread_local<detail::UdpReader>(udp_reader_);
-    return udp_reader_->read_once(as_fd(), input_);
+    return udp_reader_->read_once(as_fd(), input_, options_);
   }
 
   static TD_THREAD_LOCAL detail::UdpReader *udp_reader_;
@@ -45,6 +45,13 @@
 
 #if TD_LINUX
 #include <linux/errqueue.h>
+#include <netinet/udp.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
 #endif
 #endif  // TD_PORT_POSIX
 
@@ -400,11 +407,20 @@ class UdpSocketReceiveHelper {
   }
 
   void from_native(struct msghdr &message_header, size_t message_size, UdpSocketFd::InboundMessage &message) {
+    if (message.segment_size != nullptr) {
+      *message.segment_size = 0;
+    }
 #if TD_LINUX
     struct cmsghdr *cmsg;
     struct sock_extended_err *ee = nullptr;
     for (cmsg = CMSG_FIRSTHDR(&message_header); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message_header, cmsg)) {
-      if (cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_level == IPPROTO_IP) {
+      if (cmsg->cmsg_type == UDP_GRO && cmsg->cmsg_level == IPPROTO_UDP) {
+        int gso_size;
+        std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+        if (message.segment_size != nullptr && gso_size > 0 && static_cast<size_t>(gso_size) < message_size) {
+          *message.segment_size = static_cast<size_t>(gso_size);
+        }
+      } else if (cmsg->cmsg_type == IP_PKTINFO && cmsg->cmsg_level == IPPROTO_IP) {
         //auto *pi = reinterpret_cast<struct in_pktinfo *>(CMSG_DATA(cmsg));
       } else if (cmsg->cmsg_type == IPV6_PKTINFO && cmsg->cmsg_level == IPPROTO_IPV6) {
         //auto *pi = reinterpret_cast<struct in6_pktinfo *>(CMSG_DATA(cmsg));
@@ -460,18 +476,44 @@ class UdpSocketSendHelper {
     CHECK(message.to != nullptr && message.to->is_valid());
     message_header.msg_name = const_cast<struct sockaddr *>(message.to->get_sockaddr());
     message_header.msg_namelen = narrow_cast<socklen_t>(message.to->get_sockaddr_len());
-    io_vec_.iov_base = const_cast<char *>(message.data.begin());
-    io_vec_.iov_len = message.data.size();
-    message_header.msg_iov = &io_vec_;
-    message_header.msg_iovlen = 1;
-    //TODO
+    message_header.msg_flags = 0;
     message_header.msg_control = nullptr;
     message_header.msg_controllen = 0;
-    message_header.msg_flags = 0;
+    if (message.segments.empty()) {
+      io_vec_[0].iov_base = const_cast<char *>(message.data.begin());
+      io_vec_[0].iov_len = message.data.size();
+      message_header.msg_iov = io_vec_.data();
+      message_header.msg_iovlen = 1;
+      return;
+    }
+#if TD_LINUX
+    CHECK(message.segments.size() <= io_vec_.size());
+    for (size_t i = 0; i < message.segments.size(); i++) {
+      io_vec_[i].iov_base = const_cast<char *>(message.segments[i].begin());
+      io_vec_[i].iov_len = message.segments[i].size();
+    }
+    message_header.msg_iov = io_vec_.data();
+    message_header.msg_iovlen = message.segments.size();
+    if (message.segments.size() > 1) {
+      message_header.msg_control = control_buf_;
+      message_header.msg_controllen = sizeof(control_buf_);
+      struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message_header);
+      cmsg->cmsg_level = IPPROTO_UDP;
+      cmsg->cmsg_type = UDP_SEGMENT;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      auto segment_size = narrow_cast<uint16_t>(message.segments[0].size());
+      std::memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(segment_size));
+    }
+#else
+    UNREACHABLE();
+#endif
   }
 
  private:
-  struct iovec io_vec_;
+  std::array<struct iovec, UdpSocketFd::MAX_SEGMENTS> io_vec_;
+#if TD_LINUX
+  alignas(struct cmsghdr) char control_buf_[CMSG_SPACE(sizeof(uint16_t))];
+#endif
 };
 
 class UdpSocketFdImpl {
@@ -572,6 +614,9 @@ class UdpSocketFdImpl {
       is_sent = true;
       return Status::OK();
     }
+    if (disable_gso_on_error(message, sendmsg_errno)) {
+      return Status::OK();
+    }
     return process_sendmsg_error(sendmsg_errno, is_sent);
   }
   Status process_sendmsg_error(int sendmsg_errno, bool &is_sent) {
@@ -629,6 +674,34 @@ class UdpSocketFdImpl {
     }
   }
 
+  Status enable_gso() {
+#if TD_LINUX
+    int value = 0;
+    socklen_t len = sizeof(value);
+    if (getsockopt(get_native_fd().socket(), IPPROTO_UDP, UDP_SEGMENT, &value, &len) != 0) {
+      return OS_ERROR("UDP_SEGMENT is not supported");
+    }
+    gso_enabled_ = true;
+    return Status::OK();
+#else
+    return Status::Error("UDP_SEGMENT is not supported");
+#endif
+  }
+  bool is_gso_enabled() const {
+    return gso_enabled_;
+  }
+  Status enable_gro() {
+#if TD_LINUX
+    int value = 1;
+    if (setsockopt(get_native_fd().socket(), IPPROTO_UDP, UDP_GRO, &value, sizeof(value)) != 0) {
+      return OS_ERROR("UDP_GRO is not supported");
+    }
+    return Status::OK();
+#else
+    return Status::Error("UDP_GRO is not supported");
+#endif
+  }
+
   Status send_messages(Span<UdpSocketFd::OutboundMessage> messages, size_t &cnt) {
 #if TD_HAS_MMSG
     return send_messages_fast(messages, cnt);
@@ -647,15 +720,42 @@ class UdpSocketFdImpl {
 
  private:
   PollableFdInfo info_;
+  bool gso_enabled_ = false;
+
+  // The kernel may reject segmented messages, e.g. if the segment size exceeds the path MTU or checksum offload is
+  // disabled. In this case segmentation is turned off and the messages are resent one by one.
+  // All messages of a failed batch are checked: any segmented message in it would fail the same way on the next call.
+  bool disable_gso_on_error(Span<UdpSocketFd::OutboundMessage> messages, int sendmsg_errno) {
+    if (sendmsg_errno != EINVAL && sendmsg_errno != EIO) {
+      return false;
+    }
+    bool has_segments = false;
+    for (auto &message : messages) {
+      if (message.segments.size() > 1) {
+        has_segments = true;
+        break;
+      }
+    }
+    if (!has_segments) {
+      return false;
+    }
+    LOG(WARNING) << "Disable UDP_SEGMENT for " << get_native_fd() << ": "
+                 << Status::PosixError(sendmsg_errno, "segmented send has failed");
+    gso_enabled_ = false;
+    return true;
+  }
 
   Status send_messages_slow(Span<UdpSocketFd::OutboundMessage> messages, size_t &cnt) {
     cnt = 0;
     for (auto &message : messages) {
-      CHECK(!message.data.empty());
+      CHECK(!message.data.empty() || !message.segments.empty());
       bool is_sent;
       auto error = send_message(message, is_sent);
       cnt += is_sent;
       TRY_STATUS(std::move(error));
+      if (!is_sent) {
+        break;
+      }
     }
     return Status::OK();
   }
@@ -666,8 +766,8 @@ class UdpSocketFdImpl {
     //  struct msghdr msg_hdr; [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    struct std::array<detail::UdpSocketSendHelper, 16> helpers;
-    struct std::array<struct mmsghdr, 16> headers;
+    struct std::array<detail::UdpSocketSendHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers;
+    struct std::array<struct mmsghdr, UdpSocketFd::MAX_BATCH_SIZE> headers;
     size_t to_send = min(messages.size(), headers.size());
     for (size_t i = 0; i < to_send; i++) {
       helpers[i].to_native(messages[i], headers[i].msg_hdr);
@@ -683,6 +783,10 @@ class UdpSocketFdImpl {
       return Status::OK();
     }
 
+    cnt = 0;
+    if (disable_gso_on_error(Span<UdpSocketFd::OutboundMessage>(messages.data(), to_send), sendmmsg_errno)) {
+      return Status::OK();
+    }
     bool is_sent = false;
     auto status = process_sendmsg_error(sendmmsg_errno, is_sent);
     cnt = is_sent;
@@ -717,8 +821,8 @@ class UdpSocketFdImpl {
     //  struct msghdr msg_hdr; [> Message header <]
     //  unsigned int msg_len;  [> Number of bytes transmitted <]
     //};
-    struct std::array<detail::UdpSocketReceiveHelper, 16> helpers;
-    struct std::array<struct mmsghdr, 16> headers;
+    struct std::array<detail::UdpSocketReceiveHelper, UdpSocketFd::MAX_BATCH_SIZE> helpers;
+    struct std::array<struct mmsghdr, UdpSocketFd::MAX_BATCH_SIZE> headers;
     size_t to_receive = min(messages.size(), headers.size());
     for (size_t i = 0; i < to_receive; i++) {
       helpers[i].to_native(messages[i], headers[i].msg_hdr);
@@ -855,6 +959,16 @@ Status UdpSocketFd::send_messages(Span<OutboundMessage> messages, size_t &count)
 Status UdpSocketFd::receive_messages(MutableSpan<InboundMessage> messages, size_t &count) {
   return impl_->receive_messages(messages, count);
 }
+
+Status UdpSocketFd::enable_gso() {
+  return impl_->enable_gso();
+}
+bool UdpSocketFd::is_gso_enabled() const {
+  return impl_->is_gso_enabled();
+}
+Status UdpSocketFd::enable_gro() {
+  return impl_->enable_gro();
+}
 #endif
 #if TD_PORT_WINDOWS
 Result<optional<UdpMessage>> UdpSocketFd::receive() {
@@ -72,16 +72,34 @@ class UdpSocketFd {
   static bool is_critical_read_error(const Status &status);
 
 #if TD_PORT_POSIX
+  // Maximum number of messages processed by one send_messages/receive_messages call
+  static constexpr size_t MAX_BATCH_SIZE = 64;
+  // Maximum size of a message with several UDP segments
+  static constexpr size_t MAX_SEGMENTED_MESSAGE_SIZE = 65535;
+  static constexpr size_t MAX_SEGMENTS = 64;
+
   struct OutboundMessage {
     const IPAddress *to;
     Slice data;
+    // If not empty, data is ignored and the segments are sent as one message, which is split by the kernel into
+    // separate datagrams (UDP_SEGMENT). All segments except the last one must have the same size
+    Span<Slice> segments;
   };
   struct InboundMessage {
     IPAddress *from;
     MutableSlice data;
     Status *error;
+    // If not null, receives the size of datagrams coalesced into data, or 0 if data is a single datagram
+    size_t *segment_size = nullptr;
   };
 
+  // UDP_SEGMENT send offload. Returns an error if it is not supported
+  Status enable_gso();
+  // May become false after enable_gso() if the kernel rejects segmented messages
+  bool is_gso_enabled() const;
+  // UDP_GRO receive offload. Returns an error if it is not supported
+  Status enable_gro();
+
   Status send_message(const OutboundMessage &message, bool &is_sent) TD_WARN_UNUSED_RESULT;
   Status receive_message(InboundMessage &message, bool &is_received) TD_WARN_UNUSED_RESULT;
 
@@ -0,0 +1,93 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "block-handle.hpp"
+
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+namespace {
+
+using ton::validator::BlockHandle;
+using ton::validator::BlockHandleImpl;
+
+ton::BlockIdExt random_block_id(ton::WorkchainId workchain, ton::BlockSeqno seqno) {
+  ton::BlockIdExt id{workchain, ton::shardIdAll, seqno, td::Bits256::zero(), td::Bits256::zero()};
+  td::Random::secure_bytes(id.root_hash.as_slice());
+  td::Random::secure_bytes(id.file_hash.as_slice());
+  return id;
+}
+
+BlockHandle make_handle() {
+  auto handle = BlockHandleImpl::create_empty(random_block_id(ton::basechainId, 10));
+  handle->set_prev(random_block_id(ton::basechainId, 9));
+  handle->set_next(random_block_id(ton::basechainId, 11));
+  handle->set_logical_time(1000000);
+  handle->set_unix_time(1700000000);
+  handle->set_state_root_hash(td::Bits256::zero());
+  handle->set_masterchain_ref_block(123);
+  handle->set_received();
+  handle->set_applied();
+  return handle;
+}
+
+// Handles are only destroyed after they are written to db
+BlockHandle round_trip(const BlockHandle &handle) {
+  handle->flushed_upto(handle->version());
+  auto res = BlockHandleImpl::create(handle->serialize());
+  res->flushed_upto(res->version());
+  return res;
+}
+
+void check_same(const BlockHandle &a, const BlockHandle &b) {
+  ASSERT_EQ(a->id(), b->id());
+  ASSERT_EQ(a->one_prev(true), b->one_prev(true));
+  ASSERT_EQ(a->one_next(true), b->one_next(true));
+  ASSERT_EQ(a->logical_time(), b->logical_time());
+  ASSERT_EQ(a->unix_time(), b->unix_time());
+  ASSERT_TRUE(a->state() == b->state());
+  ASSERT_EQ(a->masterchain_ref_block(), b->masterchain_ref_block());
+  ASSERT_EQ(a->received(), b->received());
+  ASSERT_EQ(a->is_applied(), b->is_applied());
+  ASSERT_EQ(a->inited_out_msg_queue_size(), b->inited_out_msg_queue_size());
+}
+
+}  // namespace
+
+TEST(BlockHandle, SerializeWithoutQueueSize) {
+  auto handle = make_handle();
+  auto res = round_trip(handle);
+  check_same(handle, res);
+  ASSERT_TRUE(!res->inited_out_msg_queue_size());
+}
+
+TEST(BlockHandle, SerializeWithQueueSize) {
+  auto handle = make_handle();
+  handle->set_out_msg_queue_size(0);
+  auto res = round_trip(handle);
+  check_same(handle, res);
+  ASSERT_TRUE(res->inited_out_msg_queue_size());
+  ASSERT_EQ(0u, res->out_msg_queue_size());
+
+  handle = make_handle();
+  handle->set_out_msg_queue_size(1ULL << 40);
+  res = round_trip(handle);
+  check_same(handle, res);
+  ASSERT_EQ(1ULL << 40, res->out_msg_queue_size());
+
+  // The size is serialized the same way after another round trip
+  ASSERT_EQ(res->serialize().as_slice(), round_trip(res)->serialize().as_slice());
+}
@@ -0,0 +1,236 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "catchain/catchain-block-log.h"
+
+#include "td/actor/actor.h"
+#include "td/utils/as.h"
+#include "td/utils/crypto.h"
+#include "td/utils/filesystem.h"
+#include "td/utils/port/FileFd.h"
+#include "td/utils/port/path.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <functional>
+
+namespace {
+
+using ton::catchain::CatChainBlockHash;
+using ton::catchain::CatChainBlockLog;
+
+constexpr size_t BLOCK_SIZE = 100;
+constexpr size_t RECORD_HEADER_SIZE = 12;
+constexpr size_t BLOCK_RECORD_SIZE = RECORD_HEADER_SIZE + 32 + BLOCK_SIZE;
+constexpr size_t CHECKPOINT_RECORD_SIZE = RECORD_HEADER_SIZE + 8;
+
+struct TestBlock {
+  CatChainBlockHash hash;
+  td::BufferSlice data;
+};
+
+std::vector<TestBlock> gen_blocks(size_t count, td::Random::Xorshift128plus &rnd) {
+  std::vector<TestBlock> res;
+  for (size_t i = 0; i < count; i++) {
+    td::BufferSlice data(BLOCK_SIZE);
+    rnd.bytes(data.as_slice());
+    CatChainBlockHash hash;
+    td::sha256(data.as_slice(), hash.as_slice());
+    res.push_back(TestBlock{hash, std::move(data)});
+  }
+  return res;
+}
+
+// Opens the log after the replay and appends blocks on an actor, as CatChainReceiverImpl does, then syncs it
+class LogWriter : public td::actor::Actor {
+ public:
+  LogWriter(std::string path, CatChainBlockLog::Replay replay, std::function<void(CatChainBlockLog &)> write,
+            td::Promise<td::Unit> promise)
+      : path_(std::move(path)), replay_(std::move(replay)), write_(std::move(write)), promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    log_ = std::make_unique<CatChainBlockLog>(path_);
+    log_->open(replay_).ensure();
+    write_(*log_);
+    log_->sync([SelfId = actor_id(this)](td::Result<td::Unit> R) {
+      R.ensure();
+      td::actor::send_closure(SelfId, &LogWriter::finish);
+    });
+  }
+
+  void finish() {
+    log_ = nullptr;
+    promise_.set_value(td::Unit());
+    stop();
+  }
+
+ private:
+  std::string path_;
+  CatChainBlockLog::Replay replay_;
+  std::function<void(CatChainBlockLog &)> write_;
+  td::Promise<td::Unit> promise_;
+  std::unique_ptr<CatChainBlockLog> log_;
+};
+
+void write_log(td::CSlice path, CatChainBlockLog::Replay replay, std::function<void(CatChainBlockLog &)> write) {
+  td::actor::Scheduler scheduler({1});
+  scheduler.run_in_context([&] {
+    td::actor::create_actor<LogWriter>("writer", path.str(), std::move(replay), std::move(write),
+                                       [](td::Result<td::Unit> R) {
+                                         R.ensure();
+                                         td::actor::SchedulerContext::get()->stop();
+                                       })
+        .release();
+  });
+  scheduler.run();
+  scheduler.stop();
+}
+
+void write_blocks(td::CSlice path, const std::vector<TestBlock> &blocks, size_t from, size_t to) {
+  write_log(path, CatChainBlockLog::replay(path).move_as_ok(), [&](CatChainBlockLog &log) {
+    for (size_t i = from; i < to; i++) {
+      log.add_block(blocks[i].hash, blocks[i].data.as_slice());
+    }
+  });
+}
+
+void check_blocks(const CatChainBlockLog::Replay &replay, const std::vector<TestBlock> &blocks, size_t verified) {
+  ASSERT_EQ(blocks.size(), replay.blocks.size());
+  for (size_t i = 0; i < blocks.size(); i++) {
+    ASSERT_TRUE(replay.blocks[i].hash == blocks[i].hash);
+    ASSERT_EQ(blocks[i].data.as_slice(), replay.blocks[i].data.as_slice());
+    ASSERT_EQ(i < verified, replay.blocks[i].verified);
+  }
+}
+
+}  // namespace
+
+TEST(CatChainBlockLog, Replay) {
+  td::CSlice path = "catchain-block-log-replay.blocks";
+  CatChainBlockLog::destroy(path);
+  td::Random::Xorshift128plus rnd(123);
+
+  auto empty = CatChainBlockLog::replay(path).move_as_ok();
+  ASSERT_TRUE(empty.blocks.empty());
+  ASSERT_TRUE(empty.root.is_zero());
+
+  // More than one checkpoint interval: a checkpoint is written in the middle and on sync
+  auto blocks = gen_blocks(CatChainBlockLog::checkpoint_interval() + 100, rnd);
+  CatChainBlockHash root = blocks.back().hash;
+  write_log(path, CatChainBlockLog::Replay(), [&](CatChainBlockLog &log) {
+    for (auto &block : blocks) {
+      log.add_block(block.hash, block.data.as_slice());
+    }
+    log.set_root(root);
+  });
+
+  auto replay = CatChainBlockLog::replay(path).move_as_ok();
+  check_blocks(replay, blocks, blocks.size());
+  ASSERT_TRUE(replay.root == root);
+  ASSERT_EQ(0u, replay.dropped_size);
+  ASSERT_EQ(td::stat(path).move_as_ok().size_, static_cast<td::int64>(replay.valid_size));
+
+  // Appending after the replay continues the same log
+  auto more = gen_blocks(10, rnd);
+  write_blocks(path, more, 0, more.size());
+  for (auto &block : more) {
+    blocks.push_back(std::move(block));
+  }
+  replay = CatChainBlockLog::replay(path).move_as_ok();
+  check_blocks(replay, blocks, blocks.size());
+  ASSERT_TRUE(replay.root == root);
+
+  CatChainBlockLog::destroy(path);
+}
+
+TEST(CatChainBlockLog, TornTail) {
+  td::CSlice path = "catchain-block-log-torn.blocks";
+  CatChainBlockLog::destroy(path);
+  td::Random::Xorshift128plus rnd(239);
+
+  auto blocks = gen_blocks(20, rnd);
+  write_blocks(path, blocks, 0, 10);
+  write_blocks(path, blocks, 10, 20);
+
+  // The node was stopped while the last checkpoint was being written
+  auto size = td::stat(path).move_as_ok().size_;
+  {
+    auto fd = td::FileFd::open(path, td::FileFd::Flags::Write).move_as_ok();
+    fd.truncate_to_current_position(size - 5).ensure();
+    fd.close();
+  }
+  auto replay = CatChainBlockLog::replay(path).move_as_ok();
+  check_blocks(replay, blocks, 10);
+  ASSERT_EQ(CHECKPOINT_RECORD_SIZE - 5, replay.dropped_size);
+  ASSERT_EQ(static_cast<td::uint64>(size) - CHECKPOINT_RECORD_SIZE, replay.valid_size);
+
+  // Opening the log truncates the torn record before new records are appended
+  auto more = gen_blocks(1, rnd);
+  write_log(path, std::move(replay),
+            [&](CatChainBlockLog &log) { log.add_block(more[0].hash, more[0].data.as_slice()); });
+  blocks.push_back(std::move(more[0]));
+  replay = CatChainBlockLog::replay(path).move_as_ok();
+  check_blocks(replay, blocks, blocks.size());
+  ASSERT_EQ(0u, replay.dropped_size);
+  ASSERT_EQ(td::stat(path).move_as_ok().size_, static_cast<td::int64>(replay.valid_size));
+
+  // Garbage after the last record is dropped as well
+  td::write_file(path, td::read_file(path).move_as_ok().as_slice().str() + "garbage").ensure();
+  replay = CatChainBlockLog::replay(path).move_as_ok();
+  check_blocks(replay, blocks, blocks.size());
+  ASSERT_EQ(7u, replay.dropped_size);
+
+  CatChainBlockLog::destroy(path);
+}
+
+TEST(CatChainBlockLog, CheckpointMismatch) {
+  td::CSlice path = "catchain-block-log-mismatch.blocks";
+  CatChainBlockLog::destroy(path);
+  td::Random::Xorshift128plus rnd(1);
+
+  auto blocks = gen_blocks(20, rnd);
+  write_blocks(path, blocks, 0, 10);
+  write_blocks(path, blocks, 10, 20);
+  check_blocks(CatChainBlockLog::replay(path).move_as_ok(), blocks, blocks.size());
+
+  // A block record changed together with its own crc: the record looks intact, but the checkpoints after it
+  // do not match the prefix, so no block is trusted without verification
+  auto data = td::read_file(path).move_as_ok().as_slice().str();
+  size_t offset = 3 * BLOCK_RECORD_SIZE;
+  data[offset + RECORD_HEADER_SIZE + 32] ^= 1;
+  td::as<td::uint32>(&data[offset + 8]) =
+      td::crc32c(td::Slice(data).substr(offset + RECORD_HEADER_SIZE, 32 + BLOCK_SIZE));
+  td::write_file(path, data).ensure();
+
+  auto replay = CatChainBlockLog::replay(path).move_as_ok();
+  ASSERT_EQ(blocks.size(), replay.blocks.size());
+  ASSERT_EQ(0u, replay.dropped_size);
+  for (auto &block : replay.blocks) {
+    ASSERT_TRUE(!block.verified);
+  }
+  ASSERT_TRUE(replay.blocks[3].data.as_slice() != blocks[3].data.as_slice());
+
+  // A record with a broken crc ends the log
+  data[offset + 8] ^= 1;
+  td::write_file(path, data).ensure();
+  replay = CatChainBlockLog::replay(path).move_as_ok();
+  blocks.resize(3);
+  check_blocks(replay, blocks, 0);
+  ASSERT_EQ(data.size() - offset, replay.dropped_size);
+
+  CatChainBlockLog::destroy(path);
+}
@@ -0,0 +1,77 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "keys/encryptor.h"
+#include "keys/keys.hpp"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+namespace {
+
+td::BufferSlice random_buffer(size_t size) {
+  td::BufferSlice res(size);
+  td::Random::secure_bytes(res.as_slice());
+  return res;
+}
+
+// Checks that decrypt_in_place gives the same results as decrypt: the same plaintext for valid messages and an error
+// for tampered ones. digest_offset is the position of the sha256 digest of the plaintext in the encrypted message.
+void check_decrypt_in_place(const ton::PrivateKey &pk, size_t digest_offset) {
+  auto encryptor = pk.compute_public_key().create_encryptor().move_as_ok();
+  auto decryptor = pk.create_decryptor().move_as_ok();
+  for (size_t size : {0, 1, 15, 16, 31, 32, 33, 100, 1000, 4096}) {
+    auto data = random_buffer(size);
+    auto encrypted = encryptor->encrypt(data.as_slice()).move_as_ok();
+
+    auto copied = decryptor->decrypt(encrypted.as_slice()).move_as_ok();
+    ASSERT_EQ(data.as_slice(), copied.as_slice());
+
+    auto buffer = encrypted.clone();
+    auto begin = buffer.as_slice().begin();
+    auto end = buffer.as_slice().end();
+    auto in_place = decryptor->decrypt_in_place(std::move(buffer)).move_as_ok();
+    ASSERT_EQ(data.as_slice(), in_place.as_slice());
+    // The result is a view of the encrypted message
+    ASSERT_TRUE(in_place.as_slice().begin() >= begin && in_place.as_slice().end() <= end);
+
+    for (size_t pos : {digest_offset, digest_offset + 31, encrypted.size() - 1}) {
+      if (pos >= encrypted.size() || (pos == encrypted.size() - 1 && size == 0)) {
+        continue;
+      }
+      auto tampered = encrypted.clone();
+      tampered.as_slice()[pos] ^= 1;
+      ASSERT_TRUE(decryptor->decrypt(tampered.as_slice()).is_error());
+      ASSERT_TRUE(decryptor->decrypt_in_place(tampered.clone()).is_error());
+    }
+
+    ASSERT_TRUE(decryptor->decrypt(encrypted.as_slice().substr(0, digest_offset + 31)).is_error());
+    ASSERT_TRUE(decryptor->decrypt_in_place(td::BufferSlice(encrypted.as_slice().substr(0, digest_offset + 31)))
+                    .is_error());
+  }
+}
+
+}  // namespace
+
+TEST(Encryptor, Ed25519DecryptInPlace) {
+  // ephemeral public key, digest, ciphertext
+  check_decrypt_in_place(ton::privkeys::Ed25519::random(), 32);
+}
+
+TEST(Encryptor, AesDecryptInPlace) {
+  // digest, ciphertext
+  auto key = random_buffer(32);
+  check_decrypt_in_place(ton::privkeys::AES{key.as_slice()}, 0);
+}
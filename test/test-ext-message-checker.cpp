@@ -0,0 +1,243 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "impl/ext-message-checker.hpp"
+
+#include "vm/cells/CellBuilder.h"
+#include "vm/cells/CellSlice.h"
+
+#include "td/actor/actor.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+#include <set>
+
+namespace {
+
+using ton::validator::ExtMessageChecker;
+
+// What the stand-in check does with a message
+enum Verdict { Accept, Reject, FailBatch };
+
+class TestExtMessage : public ton::validator::ExtMessage {
+ public:
+  TestExtMessage(ton::StdSmcAddress addr, Verdict verdict) : addr_(addr) {
+    td::Random::secure_bytes(hash_.as_slice());
+    root_ = vm::CellBuilder().store_long(verdict, 8).finalize();
+  }
+  ton::AccountIdPrefixFull shard() const override {
+    return {ton::basechainId, ton::extract_top64(addr_)};
+  }
+  td::BufferSlice serialize() const override {
+    return {};
+  }
+  td::Ref<vm::Cell> root_cell() const override {
+    return root_;
+  }
+  Hash hash() const override {
+    return hash_;
+  }
+  ton::WorkchainId wc() const override {
+    return ton::basechainId;
+  }
+  ton::StdSmcAddress addr() const override {
+    return addr_;
+  }
+
+ private:
+  ton::StdSmcAddress addr_;
+  Hash hash_;
+  td::Ref<vm::Cell> root_;
+};
+
+struct Counters {
+  int fetches = 0;
+  std::vector<size_t> batches;
+  std::set<ton::StdSmcAddress> unavailable;
+};
+
+// Answers account state queries and runs messages without a validator manager
+class StandInChecker : public ExtMessageChecker {
+ public:
+  explicit StandInChecker(std::shared_ptr<Counters> counters) : ExtMessageChecker({}, 1), counters_(counters) {
+  }
+
+ protected:
+  void fetch_account_state(ton::WorkchainId wc, ton::StdSmcAddress addr, td::Promise<AccountState> promise) override {
+    ++counters_->fetches;
+    if (counters_->unavailable.count(addr)) {
+      promise.set_error(td::Status::Error("no state"));
+      return;
+    }
+    promise.set_value(AccountState{});
+  }
+  void check_batch(ton::WorkchainId wc, ton::StdSmcAddress addr, AccountState state,
+                   std::vector<td::Ref<vm::Cell>> msg_roots, td::Promise<std::vector<td::Status>> promise) override {
+    counters_->batches.push_back(msg_roots.size());
+    std::vector<td::Status> res;
+    for (auto &root : msg_roots) {
+      switch (vm::load_cell_slice(root).prefetch_ulong(8)) {
+        case Accept:
+          res.push_back(td::Status::OK());
+          break;
+        case Reject:
+          res.push_back(td::Status::Error("rejected"));
+          break;
+        default:
+          promise.set_error(td::Status::Error("config is not available"));
+          return;
+      }
+    }
+    promise.set_value(std::move(res));
+  }
+
+ private:
+  std::shared_ptr<Counters> counters_;
+};
+
+// Sends groups of messages to the checker one after another; every group is sent at once, so messages of a group
+// to the same account get into one batch
+class Tester : public td::actor::Actor {
+ public:
+  using Group = std::vector<td::Ref<TestExtMessage>>;
+  using Results = std::vector<td::Result<td::Ref<ton::validator::ExtMessage>>>;
+
+  Tester(std::shared_ptr<Counters> counters, std::vector<Group> groups, std::vector<Results> &results,
+         td::Promise<td::Unit> promise)
+      : counters_(std::move(counters))
+      , groups_(std::move(groups))
+      , results_(results)
+      , promise_(std::move(promise)) {
+  }
+
+  void start_up() override {
+    checker_ = td::actor::create_actor<StandInChecker>("checker", counters_);
+    send_group();
+  }
+
+ private:
+  std::shared_ptr<Counters> counters_;
+  std::vector<Group> groups_;
+  std::vector<Results> &results_;
+  td::Promise<td::Unit> promise_;
+  td::actor::ActorOwn<StandInChecker> checker_;
+  size_t pending_ = 0;
+
+  void send_group() {
+    if (results_.size() == groups_.size()) {
+      promise_.set_value(td::Unit());
+      stop();
+      return;
+    }
+    auto &group = groups_[results_.size()];
+    results_.emplace_back(group.size());
+    pending_ = group.size();
+    for (size_t i = 0; i < group.size(); i++) {
+      td::actor::send_closure(checker_, &ExtMessageChecker::check_message, group[i],
+                              [SelfId = actor_id(this), i](td::Result<td::Ref<ton::validator::ExtMessage>> R) {
+                                td::actor::send_closure(SelfId, &Tester::got_result, i, std::move(R));
+                              });
+    }
+  }
+
+  void got_result(size_t i, td::Result<td::Ref<ton::validator::ExtMessage>> R) {
+    results_.back()[i] = std::move(R);
+    if (--pending_ == 0) {
+      send_group();
+    }
+  }
+};
+
+std::vector<Tester::Results> run_checker(std::shared_ptr<Counters> counters, std::vector<Tester::Group> groups) {
+  std::vector<Tester::Results> results;
+  td::actor::Scheduler scheduler({1});
+  scheduler.run_in_context([&] {
+    td::actor::create_actor<Tester>("tester", counters, std::move(groups), results, [](td::Result<td::Unit> R) {
+      R.ensure();
+      td::actor::SchedulerContext::get()->stop();
+    }).release();
+  });
+  scheduler.run();
+  scheduler.stop();
+  return results;
+}
+
+ton::StdSmcAddress random_addr() {
+  ton::StdSmcAddress addr;
+  td::Random::secure_bytes(addr.as_slice());
+  return addr;
+}
+
+td::Ref<TestExtMessage> make_message(ton::StdSmcAddress addr, Verdict verdict) {
+  return td::Ref<TestExtMessage>{true, addr, verdict};
+}
+
+}  // namespace
+
+TEST(ExtMessageChecker, AcceptReject) {
+  auto counters = std::make_shared<Counters>();
+  auto addr1 = random_addr(), addr2 = random_addr();
+  auto accepted1 = make_message(addr1, Accept);
+  auto rejected = make_message(addr1, Reject);
+  auto accepted2 = make_message(addr2, Accept);
+  auto results = run_checker(counters, {{accepted1, rejected, accepted2}});
+
+  ASSERT_EQ(1u, results.size());
+  ASSERT_TRUE(results[0][0].is_ok());
+  ASSERT_TRUE(results[0][0].ok()->hash() == accepted1->hash());
+  ASSERT_TRUE(results[0][1].is_error());
+  ASSERT_TRUE(results[0][2].is_ok());
+  // One state fetch and one batch per account
+  ASSERT_EQ(2, counters->fetches);
+  std::sort(counters->batches.begin(), counters->batches.end());
+  ASSERT_TRUE(counters->batches == std::vector<size_t>({1, 2}));
+}
+
+TEST(ExtMessageChecker, RejectedCache) {
+  auto counters = std::make_shared<Counters>();
+  auto addr = random_addr();
+  auto accepted = make_message(addr, Accept);
+  auto rejected = make_message(addr, Reject);
+  auto results = run_checker(counters, {{accepted, rejected}, {rejected}, {accepted}});
+
+  ASSERT_EQ(3u, results.size());
+  ASSERT_TRUE(results[0][1].is_error());
+  // The second rejection is answered from the cache without checking the message again
+  ASSERT_TRUE(results[1][0].is_error());
+  ASSERT_EQ(results[0][1].error().message(), results[1][0].error().message());
+  // Accepted messages are not cached
+  ASSERT_TRUE(results[2][0].is_ok());
+  ASSERT_EQ(2, counters->fetches);
+  ASSERT_EQ(2u, counters->batches.size());
+}
+
+TEST(ExtMessageChecker, FailuresAreNotCached) {
+  auto counters = std::make_shared<Counters>();
+  auto addr1 = random_addr(), addr2 = random_addr();
+  counters->unavailable.insert(addr2);
+  auto batch_failed = make_message(addr1, FailBatch);
+  auto no_state = make_message(addr2, Accept);
+  auto results = run_checker(counters, {{batch_failed, no_state}, {batch_failed, no_state}});
+
+  ASSERT_EQ(2u, results.size());
+  for (auto &group : results) {
+    ASSERT_TRUE(group[0].is_error());
+    ASSERT_TRUE(group[1].is_error());
+  }
+  // Both messages are checked again instead of being answered from the cache
+  ASSERT_EQ(4, counters->fetches);
+  ASSERT_EQ(2u, counters->batches.size());
+}
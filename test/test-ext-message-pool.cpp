@@ -0,0 +1,160 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-pool.hpp"
+
+#include "td/utils/port/sleep.h"
+#include "td/utils/Random.h"
+#include "td/utils/tests.h"
+
+namespace {
+
+using ton::validator::ExtMessagePool;
+
+class TestExtMessage : public ton::validator::ExtMessage {
+ public:
+  TestExtMessage(ton::WorkchainId wc, ton::StdSmcAddress addr, Hash hash) : wc_(wc), addr_(addr), hash_(hash) {
+  }
+  ton::AccountIdPrefixFull shard() const override {
+    return {wc_, ton::extract_top64(addr_)};
+  }
+  td::BufferSlice serialize() const override {
+    return {};
+  }
+  td::Ref<vm::Cell> root_cell() const override {
+    return {};
+  }
+  Hash hash() const override {
+    return hash_;
+  }
+  ton::WorkchainId wc() const override {
+    return wc_;
+  }
+  ton::StdSmcAddress addr() const override {
+    return addr_;
+  }
+
+ private:
+  ton::WorkchainId wc_;
+  ton::StdSmcAddress addr_;
+  Hash hash_;
+};
+
+ton::StdSmcAddress random_addr() {
+  ton::StdSmcAddress addr;
+  td::Random::secure_bytes(addr.as_slice());
+  return addr;
+}
+
+td::Ref<TestExtMessage> make_message(ton::StdSmcAddress addr) {
+  TestExtMessage::Hash hash;
+  td::Random::secure_bytes(hash.as_slice());
+  return td::Ref<TestExtMessage>{true, ton::basechainId, addr, hash};
+}
+
+std::vector<std::pair<td::Ref<ton::validator::ExtMessage>, int>> snapshot(ExtMessagePool &pool) {
+  td::Random::Fast rnd;
+  return pool.get_shard_snapshot(ton::ShardIdFull{ton::basechainId}, rnd);
+}
+
+}  // namespace
+
+TEST(ExtMessagePool, Add) {
+  ExtMessagePool pool;
+  auto addr = random_addr();
+  auto msg1 = make_message(addr);
+  auto msg2 = make_message(addr);
+  auto msg3 = make_message(random_addr());
+  ASSERT_TRUE(pool.add(msg1, 0));
+  ASSERT_TRUE(pool.add(msg2, 0));
+  ASSERT_TRUE(pool.add(msg3, 1));
+  ASSERT_TRUE(!pool.add(msg1, 0));
+  ASSERT_EQ(3u, pool.size());
+  ASSERT_EQ(2u, pool.size(0));
+  ASSERT_EQ(1u, pool.size(1));
+  ASSERT_TRUE(pool.contains(msg1->hash()));
+
+  auto res = snapshot(pool);
+  ASSERT_EQ(3u, res.size());
+  ASSERT_TRUE(res[0].first->hash() == msg3->hash());
+  ASSERT_EQ(1, res[0].second);
+  ASSERT_TRUE(res[1].first->hash() == msg1->hash());
+  ASSERT_TRUE(res[2].first->hash() == msg2->hash());
+
+  ASSERT_TRUE(pool.erase(msg1->hash()));
+  ASSERT_TRUE(!pool.erase(msg1->hash()));
+  ASSERT_TRUE(!pool.contains(msg1->hash()));
+  ASSERT_EQ(2u, pool.size());
+  ASSERT_EQ(2u, snapshot(pool).size());
+}
+
+TEST(ExtMessagePool, PriorityReplacement) {
+  ExtMessagePool pool;
+  auto msg = make_message(random_addr());
+  ASSERT_TRUE(pool.add(msg, 0));
+  ASSERT_TRUE(pool.add(msg, 1));
+  ASSERT_TRUE(!pool.add(msg, 1));
+  ASSERT_TRUE(!pool.add(msg, 0));
+  ASSERT_EQ(1u, pool.size());
+  ASSERT_EQ(0u, pool.size(0));
+  ASSERT_EQ(1u, pool.size(1));
+
+  auto res = snapshot(pool);
+  ASSERT_EQ(1u, res.size());
+  ASSERT_EQ(1, res[0].second);
+}
+
+TEST(ExtMessagePool, PerAddressLimit) {
+  ExtMessagePool pool(600.0, 2);
+  auto addr = random_addr();
+  ASSERT_TRUE(pool.add(make_message(addr), 1));
+  ASSERT_TRUE(pool.add(make_message(addr), 1));
+  ASSERT_TRUE(!pool.add(make_message(addr), 1));
+  ASSERT_TRUE(pool.add(make_message(addr), 0));
+  ASSERT_TRUE(pool.add(make_message(random_addr()), 1));
+
+  // A replacement rejected by the limit keeps the lower priority copy
+  auto msg = make_message(addr);
+  ASSERT_TRUE(pool.add(msg, 0));
+  ASSERT_TRUE(!pool.add(msg, 1));
+  ASSERT_TRUE(pool.contains(msg->hash()));
+  ASSERT_EQ(2u, pool.size(0));
+  ASSERT_EQ(3u, pool.size(1));
+  ASSERT_EQ(5u, snapshot(pool).size());
+}
+
+TEST(ExtMessagePool, Expiry) {
+  ExtMessagePool pool(1.0);
+  auto msg1 = make_message(random_addr());
+  auto msg2 = make_message(random_addr());
+  ASSERT_TRUE(pool.add(msg1, 0));
+  ASSERT_TRUE(pool.add(msg2, 1));
+  ASSERT_EQ(0u, pool.erase_expired());
+  ASSERT_EQ(2u, pool.size());
+
+  td::usleep_for(2100000);
+  auto msg3 = make_message(random_addr());
+  ASSERT_TRUE(pool.add(msg3, 0));
+  ExtMessagePool::SnapshotStats stats;
+  td::Random::Fast rnd;
+  auto res = pool.get_shard_snapshot(ton::ShardIdFull{ton::basechainId}, rnd, &stats);
+  ASSERT_EQ(2u, stats.expired);
+  ASSERT_EQ(1u, stats.processed);
+  ASSERT_EQ(1u, res.size());
+  ASSERT_TRUE(res[0].first->hash() == msg3->hash());
+  ASSERT_TRUE(!pool.contains(msg1->hash()));
+  ASSERT_EQ(1u, pool.size());
+}
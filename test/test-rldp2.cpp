@@ -26,6 +26,7 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "adnl/adnl-network-manager.h"
+#include "adnl/adnl-network-simulator.h"
 #include "adnl/adnl-test-loopback-implementation.h"
 #include "adnl/adnl.h"
 #include "rldp2/rldp.h"
@@ -34,9 +35,33 @@
 #include "td/utils/port/path.h"
 #include "td/utils/Random.h"
 
+#include <cmath>
 #include <memory>
 #include <set>
 
+namespace {
+// Answer to a multipath query: all peers must answer with the same data
+td::BufferSlice make_answer(td::uint32 size) {
+  td::BufferSlice d{size};
+  for (td::uint32 i = 0; i < size; i++) {
+    d.as_slice()[i] = static_cast<char>(i * 7 + size);
+  }
+  return d;
+}
+
+class MultipathCallback : public ton::adnl::Adnl::Callback {
+ public:
+  void receive_message(ton::adnl::AdnlNodeIdShort src, ton::adnl::AdnlNodeIdShort dst, td::BufferSlice data) override {
+  }
+  void receive_query(ton::adnl::AdnlNodeIdShort src, ton::adnl::AdnlNodeIdShort dst, td::BufferSlice data,
+                     td::Promise<td::BufferSlice> promise) override {
+    CHECK(data.size() == 5);
+    td::uint32 s = *reinterpret_cast<const td::uint32 *>(data.as_slice().remove_prefix(1).begin());
+    promise.set_value(make_answer(s));
+  }
+};
+}  // namespace
+
 int main() {
   SET_VERBOSITY_LEVEL(verbosity_INFO);
 
@@ -53,6 +78,8 @@ int main() {
 
   ton::adnl::AdnlNodeIdShort src;
   ton::adnl::AdnlNodeIdShort dst;
+  // Peers that hold the same data as dst, for multipath queries
+  std::vector<ton::adnl::AdnlNodeIdShort> mirrors;
 
   td::actor::Scheduler scheduler({0});
 
@@ -84,6 +111,18 @@ int main() {
 
     td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, src, true, true);
     td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, dst, true, true);
+
+    for (int i = 0; i < 2; i++) {
+      auto pk = ton::PrivateKey{ton::privkeys::Ed25519::random()};
+      auto pub = pk.compute_public_key();
+      auto id = ton::adnl::AdnlNodeIdShort{pub.compute_short_id()};
+      td::actor::send_closure(keyring, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
+      td::actor::send_closure(adnl, &ton::adnl::Adnl::add_id, ton::adnl::AdnlNodeIdFull{pub}, addr, td::uint8(0));
+      td::actor::send_closure(rldp, &ton::rldp2::Rldp::add_id, id);
+      td::actor::send_closure(adnl, &ton::adnl::Adnl::add_peer, src, ton::adnl::AdnlNodeIdFull{pub}, addr);
+      td::actor::send_closure(network_manager, &ton::adnl::TestLoopbackNetworkManager::add_node_id, id, true, true);
+      mirrors.push_back(id);
+    }
   });
 
   auto send_packet = [&](td::uint32 i) {
@@ -197,6 +236,151 @@ int main() {
     LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
   }
 
+  // Multipath queries: the answer is striped between dst and its mirrors, which answer with the same data
+  scheduler.run_in_context([&] {
+    for (auto &id : mirrors) {
+      td::actor::send_closure(adnl, &ton::adnl::Adnl::subscribe, id, "2", std::make_unique<MultipathCallback>());
+    }
+    td::actor::send_closure(adnl, &ton::adnl::Adnl::subscribe, dst, "2", std::make_unique<MultipathCallback>());
+  });
+
+  auto send_multipath_query = [&](std::vector<ton::adnl::AdnlNodeIdShort> dsts, char prefix, td::uint32 size,
+                                  double timeout, bool expect_ok) {
+    auto f = td::Clocks::system();
+    scheduler.run_in_context([&] {
+      remaining++;
+      auto query = send_packet(size);
+      query.as_slice()[0] = prefix;
+      td::actor::send_closure(rldp, &ton::rldp2::Rldp::send_query_multipath, src, std::move(dsts), std::string("t"),
+                              td::PromiseCreator::lambda([&, size, expect_ok](td::Result<td::BufferSlice> R) {
+                                if (expect_ok) {
+                                  CHECK(R.ok().as_slice() == make_answer(size).as_slice());
+                                } else {
+                                  CHECK(R.is_error());
+                                }
+                                remaining--;
+                              }),
+                              td::Timestamp::in(timeout), std::move(query), size + 1024);
+    });
+
+    auto t = td::Timestamp::in(timeout + 10.0);
+    while (scheduler.run(16)) {
+      if (!remaining) {
+        break;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "failed to receive packets: remaining=" << remaining;
+      }
+    }
+    LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
+  };
+
+  std::vector<ton::adnl::AdnlNodeIdShort> dsts{dst, mirrors[0], mirrors[1]};
+  for (auto &size : std::vector<td::uint32>{1, 1024, 1 << 20, 3 << 20}) {
+    LOG(ERROR) << "testing multipath delivering of packet of size " << size;
+    send_multipath_query(dsts, '2', size, 1024.0, true);
+  }
+  // Nobody answers: the striped receiver fails with a timeout
+  LOG(ERROR) << "testing multipath query timeout";
+  send_multipath_query(dsts, '3', 1024, 3.0, false);
+
+  // SimulatedLink: the same seed gives the same losses and delays, the bottleneck queue drops what does not fit
+  {
+    ton::adnl::SimulatedLinkProfile profile{0.01, 0.005, 0.3, 0.0, 0.5};
+    ton::adnl::SimulatedLink a(profile, 239), b(profile, 239);
+    for (int i = 0; i < 100; i++) {
+      auto at_a = a.send(i * 0.001, 100);
+      auto at_b = b.send(i * 0.001, 100);
+      CHECK(bool(at_a) == bool(at_b));
+      if (at_a) {
+        CHECK(at_a.value() == at_b.value());
+        CHECK(at_a.value() >= i * 0.001 + 0.01 && at_a.value() <= i * 0.001 + 0.015);
+      }
+    }
+    CHECK(a.stats().lost > 0 && a.stats().lost < 100);
+
+    ton::adnl::SimulatedLink queue({0.0, 0.0, 0.0, 1000.0, 0.5}, 1);
+    for (int i = 0; i < 6; i++) {
+      auto at = queue.send(0.0, 100);
+      CHECK(at && std::abs(at.value() - 0.1 * (i + 1)) < 1e-9);
+    }
+    CHECK(!queue.send(0.0, 100));
+    CHECK(queue.stats().dropped == 1);
+  }
+
+  // Queries through another Adnl on SimulatedNetworkManager: every link has delay, jitter, loss and a bandwidth limit
+  td::actor::ActorOwn<ton::adnl::SimulatedNetworkManager> sim_network;
+  td::actor::ActorOwn<ton::adnl::Adnl> sim_adnl;
+  td::actor::ActorOwn<ton::rldp2::Rldp> sim_rldp;
+  ton::adnl::AdnlNodeIdShort sim_src, sim_dst;
+  scheduler.run_in_context([&] {
+    auto sim_root = db_root_ + "/simulated";
+    td::mkdir(sim_root).ensure();
+    sim_network = td::actor::create_actor<ton::adnl::SimulatedNetworkManager>(
+        "simulated net", 239, ton::adnl::SimulatedLinkProfile{0.02, 0.005, 0.05, 20e6, 0.2});
+    sim_adnl = ton::adnl::Adnl::create(sim_root, keyring.get());
+    sim_rldp = ton::rldp2::Rldp::create(sim_adnl.get());
+    td::actor::send_closure(sim_adnl, &ton::adnl::Adnl::register_network_manager, sim_network.get());
+
+    auto addr = ton::adnl::TestLoopbackNetworkManager::generate_dummy_addr_list();
+    std::vector<ton::adnl::AdnlNodeIdFull> ids;
+    for (int i = 0; i < 2; i++) {
+      auto pk = ton::PrivateKey{ton::privkeys::Ed25519::random()};
+      auto pub = pk.compute_public_key();
+      td::actor::send_closure(keyring, &ton::keyring::Keyring::add_key, std::move(pk), true, [](td::Unit) {});
+      td::actor::send_closure(sim_adnl, &ton::adnl::Adnl::add_id, ton::adnl::AdnlNodeIdFull{pub}, addr, td::uint8(0));
+      td::actor::send_closure(sim_rldp, &ton::rldp2::Rldp::add_id, ton::adnl::AdnlNodeIdShort{pub.compute_short_id()});
+      ids.emplace_back(pub);
+    }
+    sim_src = ids[0].compute_short_id();
+    sim_dst = ids[1].compute_short_id();
+    td::actor::send_closure(sim_adnl, &ton::adnl::Adnl::add_peer, sim_src, ids[1], addr);
+    td::actor::send_closure(sim_adnl, &ton::adnl::Adnl::subscribe, sim_dst, "2", std::make_unique<MultipathCallback>());
+  });
+
+  for (auto &size : std::vector<td::uint32>{1024, 1 << 20}) {
+    LOG(ERROR) << "testing delivering of packet of size " << size << " over the simulated network";
+    auto f = td::Clocks::system();
+    scheduler.run_in_context([&] {
+      remaining++;
+      auto query = send_packet(size);
+      query.as_slice()[0] = '2';
+      td::actor::send_closure(sim_rldp, &ton::rldp2::Rldp::send_query_ex, sim_src, sim_dst, std::string("t"),
+                              td::PromiseCreator::lambda([&, size](td::Result<td::BufferSlice> R) {
+                                CHECK(R.ok().as_slice() == make_answer(size).as_slice());
+                                remaining--;
+                              }),
+                              td::Timestamp::in(1024.0), std::move(query), size + 1024);
+    });
+    auto t = td::Timestamp::in(1024.0);
+    while (scheduler.run(16)) {
+      if (!remaining) {
+        break;
+      }
+      if (t.is_in_past()) {
+        LOG(FATAL) << "failed to receive packets: remaining=" << remaining;
+      }
+    }
+    LOG(ERROR) << "success. Time=" << (td::Clocks::system() - f);
+  }
+
+  // The answer went through the impaired link: packets were lost and retransmitted
+  scheduler.run_in_context([&] {
+    remaining++;
+    td::actor::send_closure(sim_network, &ton::adnl::SimulatedNetworkManager::get_link_stats, sim_dst, sim_src,
+                            td::PromiseCreator::lambda([&](td::Result<ton::adnl::SimulatedLink::Stats> R) {
+                              auto stats = R.move_as_ok();
+                              CHECK(stats.bytes > (1 << 20));
+                              CHECK(stats.lost > 0);
+                              remaining--;
+                            }));
+  });
+  while (scheduler.run(16)) {
+    if (!remaining) {
+      break;
+    }
+  }
+
   td::rmrf(db_root_).ensure();
   std::_Exit(0);
   return 0;
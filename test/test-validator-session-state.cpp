@@ -26,11 +26,14 @@
     Copyright 2017-2020 Telegram Systems LLP
 */
 #include "adnl/adnl.h"
+#include "tl-utils/tl-utils.hpp"
 
+#include "td/utils/format.h"
 #include "td/utils/misc.h"
 #include "td/utils/port/signals.h"
 #include "td/utils/port/path.h"
 #include "td/utils/Random.h"
+#include "td/utils/Time.h"
 
 #include "validator-session/validator-session-description.h"
 #include "validator-session/validator-session-state.h"
@@ -63,6 +66,7 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
     td::Bits256 x = td::Bits256::zero();
     auto &d = x.as_array();
     d[0] = static_cast<td::uint8>(idx);
+    d[1] = static_cast<td::uint8>(idx >> 8);
     return ton::PublicKeyHash{x};
   }
   ton::PublicKey get_source_public_key(td::uint32 idx) const override {
@@ -74,7 +78,7 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   td::uint32 get_source_idx(ton::PublicKeyHash id) const override {
     auto x = id.bits256_value();
     auto y = x.as_array();
-    return y[0];
+    return y[0] | (y[1] << 8);
   }
   ton::ValidatorWeight get_node_weight(td::uint32 idx) const override {
     return 1;
@@ -123,19 +127,19 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
     return ((t * 1ull) << 32) + t2;
   }
   const RootObject *get_by_hash(HashType hash, bool allow_temp) const override {
-    auto x = hash % cache_size;
-
-    return cache_[x].load(std::memory_order_relaxed).ptr;
+    return cache_.get(hash);
   }
   void update_hash(const RootObject *obj, HashType hash) override {
     if (!is_persistent(obj)) {
       return;
     }
-    auto x = hash % cache_size;
-    Cached p{obj};
-    cache_[x].store(p, std::memory_order_relaxed);
+    cache_.put(obj, hash);
   }
   void on_reuse() override {
+    reused_++;
+  }
+  td::uint64 reused() const {
+    return reused_;
   }
   td::Timestamp attempt_start_at(td::uint32 att) const override {
     return td::Timestamp::at_unix(att * opts_.round_attempt_duration);
@@ -191,12 +195,7 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   }
 
   Description(ton::validatorsession::ValidatorSessionOptions opts, td::uint32 total_nodes)
-      : opts_(opts), total_nodes_(total_nodes), mem_perm_(1 << 30), mem_temp_(1 << 22) {
-    for (auto &el : cache_) {
-      Cached v{nullptr};
-      el.store(v, std::memory_order_relaxed);
-    }
-
+      : opts_(opts), total_nodes_(total_nodes), cache_(20), mem_perm_(1 << 30), mem_temp_(1 << 22) {
     CHECK(total_nodes_ > 0);
   }
 
@@ -204,14 +203,9 @@ class Description : public ton::validatorsession::ValidatorSessionDescription {
   ton::validatorsession::ValidatorSessionOptions opts_;
 
   td::uint32 total_nodes_;
+  td::uint64 reused_ = 0;
 
-  static constexpr td::uint32 cache_size = (1 << 20);
-
-  struct Cached {
-    const RootObject *ptr;
-  };
-  std::array<std::atomic<Cached>, cache_size> cache_;
-
+  ton::validatorsession::ValidatorSessionDescriptionImpl::InternTable cache_;
   ton::validatorsession::ValidatorSessionDescriptionImpl::MemPool mem_perm_, mem_temp_;
 };
 
@@ -219,6 +213,189 @@ double myrand() {
   return td::Random::fast(0, 100) * 0.01;
 }
 
+template <class T, class... Args>
+ton::validatorsession::HashType get_reference_hash(Description &desc, Args &&...args) {
+  return desc.compute_hash(
+      ton::serialize_tl_object(ton::create_tl_object<T>(std::forward<Args>(args)...), true).as_slice());
+}
+
+// The hashes are consensus-visible, so they are checked both against the hashes of serialized TL objects and against
+// fixed values, which do not depend on the TL serializer
+void check_hashes(Description &desc) {
+  using ton::validatorsession::get_tl_hash;
+  using ton::validatorsession::get_vector_hash;
+  using ton::validatorsession::get_vs_hash;
+  namespace ton_api = ton::ton_api;
+
+  td::uint32 int32 = 239;
+  CHECK(get_vs_hash(desc, int32) == 0x2bbb7384);
+  CHECK(get_vs_hash(desc, int32) == get_reference_hash<ton_api::hashable_int32>(desc, int32));
+
+  td::uint64 int64 = 0x0123456789abcdefull;
+  CHECK(get_vs_hash(desc, int64) == 0xb72d68f6);
+  CHECK(get_vs_hash(desc, int64) == get_reference_hash<ton_api::hashable_int64>(desc, int64));
+
+  td::Bits256 int256;
+  for (td::uint32 i = 0; i < 32; i++) {
+    int256.as_array()[i] = static_cast<td::uint8>(i);
+  }
+  CHECK(get_vs_hash(desc, int256) == 0xc82383f7);
+  CHECK(get_vs_hash(desc, int256) == get_reference_hash<ton_api::hashable_int256>(desc, int256));
+
+  CHECK(get_vs_hash(desc, true) == 0x31916729);
+  CHECK(get_vs_hash(desc, false) == 0x828022f7);
+  CHECK(get_vs_hash(desc, true) == get_reference_hash<ton_api::hashable_bool>(desc, true));
+  CHECK(get_vs_hash(desc, false) == get_reference_hash<ton_api::hashable_bool>(desc, false));
+
+  // The long value does not fit into the stack buffer of get_tl_hash
+  td::BufferSlice short_bytes("validator");
+  td::BufferSlice long_bytes(300);
+  for (size_t i = 0; i < long_bytes.size(); i++) {
+    long_bytes.as_slice()[i] = static_cast<char>(i);
+  }
+  CHECK(get_vs_hash(desc, short_bytes) == 0x87937b50);
+  CHECK(get_vs_hash(desc, long_bytes) == 0x5c1411f1);
+  CHECK(get_vs_hash(desc, short_bytes) == get_reference_hash<ton_api::hashable_bytes>(desc, short_bytes.clone()));
+  CHECK(get_vs_hash(desc, long_bytes) == get_reference_hash<ton_api::hashable_bytes>(desc, long_bytes.clone()));
+
+  CHECK(get_tl_hash<ton_api::hashable_pair>(desc, 1, 2) == 0x9c3d13ea);
+  CHECK(get_tl_hash<ton_api::hashable_pair>(desc, 1, 2) == get_reference_hash<ton_api::hashable_pair>(desc, 1, 2));
+
+  auto check_vector = [&](std::vector<td::uint32> value, ton::validatorsession::HashType expected) {
+    std::vector<td::int32> hashes;
+    for (auto x : value) {
+      hashes.push_back(get_vs_hash(desc, x));
+    }
+    auto hash = get_vs_hash(desc, value);
+    CHECK(hash == expected);
+    CHECK(hash == get_vs_hash(desc, static_cast<td::uint32>(value.size()), value.data()));
+    CHECK(hash == get_reference_hash<ton_api::hashable_vector>(desc, std::move(hashes)));
+  };
+  check_vector({}, 0xca235157);
+  check_vector({1, 2, 3}, 0x8ad3c76a);
+  // Does not fit into the stack buffer of get_vector_hash
+  std::vector<td::uint32> large(2000);
+  for (td::uint32 i = 0; i < large.size(); i++) {
+    large[i] = i;
+  }
+  check_vector(large, 0x45f5d478);
+
+  std::vector<bool> bools{true, false, true};
+  CHECK(get_vs_hash(desc, bools) == 0xff87c697);
+  CHECK(get_vs_hash(desc, bools) ==
+        get_vector_hash(desc, bools.size(), [&](size_t i) { return get_vs_hash(desc, static_cast<bool>(bools[i])); }));
+
+  std::vector<td::uint32> small{1, 2, 3};
+  auto cnt_hash = ton::validatorsession::CntVector<td::uint32>::create_hash(desc, small);
+  CHECK(cnt_hash == 0xd01748ca);
+  CHECK(cnt_hash == get_reference_hash<ton_api::hashable_cntVector>(desc, static_cast<td::int32>(0x8ad3c76a)));
+  auto sorted_hash = ton::validatorsession::CntSortedVector<td::uint32>::create_hash(desc, small);
+  CHECK(sorted_hash == 0x660a6984);
+  CHECK(sorted_hash ==
+        get_reference_hash<ton_api::hashable_cntSortedVector>(desc, static_cast<td::int32>(0x8ad3c76a)));
+}
+
+void check_mem_pool() {
+  ton::validatorsession::ValidatorSessionDescriptionImpl::MemPool pool(1 << 12);
+  for (td::uint32 i = 0; i < 10; i++) {
+    CHECK(pool.alloc(3000, 8));
+  }
+  CHECK(pool.chunk_count() == 10);
+  // A spike of allocations is not kept after clear()
+  pool.clear();
+  CHECK(pool.chunk_count() == 2);
+  // A chunk which stays idle is freed, the first one is always kept
+  for (td::uint32 i = 0; i < 20; i++) {
+    CHECK(pool.alloc(3000, 8));
+    CHECK(pool.contains(pool.alloc(1, 1)));
+    pool.clear();
+  }
+  CHECK(pool.chunk_count() == 1);
+}
+
+// Every node repeatedly merges the states of a few peers into its own state and applies its actions, as it is done
+// when catchain blocks are processed. Reports the throughput of merges (including moving the result to persistent
+// memory) for the given validator set size.
+void bench_state_merge(const ton::validatorsession::ValidatorSessionOptions &opts, td::uint32 total_nodes,
+                       td::uint32 steps) {
+  auto descptr = std::make_unique<Description>(opts, total_nodes);
+  auto &desc = *descptr;
+  std::vector<const ton::validatorsession::ValidatorSessionState *> states(total_nodes);
+  for (auto &s : states) {
+    s = ton::validatorsession::ValidatorSessionState::create(desc);
+    s = ton::validatorsession::ValidatorSessionState::move_to_persistent(desc, s);
+  }
+  td::uint64 ts = desc.get_ts();
+  td::uint64 merges = 0;
+  double merge_time = 0;
+  auto reused_before = desc.reused();
+  for (td::uint32 step = 0; step < steps; step++) {
+    auto att = desc.get_attempt_seqno(ts);
+    td::uint32 x = td::Random::fast(0, total_nodes - 1);
+    auto s = states[x];
+
+    double started_at = td::Time::now();
+    for (td::uint32 z = 0; z < 3; z++) {
+      auto y = td::Random::fast(0, total_nodes - 1);
+      s = ton::validatorsession::ValidatorSessionState::merge(desc, s, states[y]);
+      s = ton::validatorsession::ValidatorSessionState::move_to_persistent(desc, s);
+      merges++;
+    }
+    merge_time += td::Time::now() - started_at;
+
+    auto round = s->cur_round_seqno();
+    if (desc.get_node_priority(x, round) >= 0 && !s->check_block_is_sent_by(desc, x)) {
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_submittedBlock>(
+          round, ton::Bits256::zero(), ton::Bits256::zero(), ton::Bits256::zero());
+      s = ton::validatorsession::ValidatorSessionState::action(desc, s, x, att, act.get());
+    }
+    auto vec = s->choose_blocks_to_approve(desc, x);
+    if (vec.size() > 0) {
+      auto B = vec[td::Random::fast(0, static_cast<td::uint32>(vec.size() - 1))];
+      td::BufferSlice sig{B ? 1u : 0u};
+      if (B) {
+        sig.as_slice()[0] = 127;
+      }
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_approvedBlock>(
+          round, ton::validatorsession::SentBlock::get_block_id(B), std::move(sig));
+      s = ton::validatorsession::ValidatorSessionState::action(desc, s, x, att, act.get());
+    }
+    bool found;
+    auto to_sign = s->choose_block_to_sign(desc, x, found);
+    if (found) {
+      td::BufferSlice sig{to_sign ? 1u : 0u};
+      if (to_sign) {
+        sig.as_slice()[0] = 126;
+      }
+      auto act = ton::create_tl_object<ton::ton_api::validatorSession_message_commit>(
+          round, ton::validatorsession::SentBlock::get_block_id(to_sign), std::move(sig));
+      s = ton::validatorsession::ValidatorSessionState::action(desc, s, x, att, act.get());
+    }
+    if (s->check_need_generate_vote_for(desc, x, att)) {
+      auto act = s->generate_vote_for(desc, x, att);
+      s = ton::validatorsession::ValidatorSessionState::action(desc, s, x, att, act.get());
+    }
+    while (true) {
+      auto act = s->create_action(desc, x, att);
+      s = ton::validatorsession::ValidatorSessionState::action(desc, s, x, att, act.get());
+      if (act->get_id() == ton::ton_api::validatorSession_message_empty::ID) {
+        break;
+      }
+    }
+    states[x] = ton::validatorsession::ValidatorSessionState::move_to_persistent(desc, s);
+    CHECK(states[x]);
+    desc.clear_temp_memory();
+
+    if (myrand() <= 2.0 / total_nodes) {
+      ts += 1ull << 32;
+    }
+  }
+  LOG(ERROR) << "state merge benchmark: " << total_nodes << " validators, " << merges << " merges in "
+             << td::format::as_time(merge_time) << ", " << static_cast<td::uint64>(static_cast<double>(merges) / merge_time)
+             << " merges/s, " << (desc.reused() - reused_before) << " objects reused, "
+             << states[0]->cur_round_seqno() << " rounds";
+}
+
 int main() {
   SET_VERBOSITY_LEVEL(verbosity_INFO);
 
@@ -231,6 +408,9 @@ int main() {
     auto descptr = new Description(opts, total_nodes);
     auto &desc = *descptr;
 
+    check_hashes(desc);
+    check_mem_pool();
+
     auto c1 = desc.candidate_id(0, td::Bits256::zero(), td::Bits256::zero(), td::Bits256::zero());
     auto c2 = desc.candidate_id(1, td::Bits256::zero(), td::Bits256::zero(), td::Bits256::zero());
     CHECK(c1 != c2);
@@ -981,6 +1161,10 @@ int main() {
     delete descptr;
   }
 
+  for (td::uint32 nodes : {100, 400, 700}) {
+    bench_state_merge(opts, nodes, 10 * nodes);
+  }
+
   std::_Exit(0);
   return 0;
 }
@@ -26,12 +26,20 @@
 #include "vm/cells/CellString.h"
 
 #include "tonlib/utils.h"
+#include "tonlib/ExtClientBalancer.h"
+#include "tonlib/StateCache.h"
+#include "tonlib/TransactionStream.h"
 #include "tonlib/TonlibClient.h"
 #include "tonlib/Client.h"
 
+#include "auto/tl/lite_api.hpp"
 #include "auto/tl/ton_api_json.h"
 #include "auto/tl/tonlib_api_json.h"
 
+#include "common/errorcode.h"
+#include "ton/lite-tl.hpp"
+#include "tl-utils/lite-utils.hpp"
+
 #include "td/utils/benchmark.h"
 #include "td/utils/filesystem.h"
 #include "td/utils/optional.h"
@@ -47,6 +55,11 @@
 #include "tonlib/keys/Mnemonic.h"
 #include "tonlib/keys/SimpleEncryption.h"
 
+#include <algorithm>
+#include <ctime>
+#include <functional>
+#include <set>
+
 TEST(Tonlib, CellString) {
   for (unsigned size :
        {0, 1, 7, 8, 35, 127, 128, 255, 256, (int)vm::CellString::max_bytes - 1, (int)vm::CellString::max_bytes}) {
@@ -299,6 +312,644 @@ TEST(Tonlib, Keys) {
   CHECK(decrypted_key.private_key.as_octet_string() == other_decrypted_key.private_key.as_octet_string());
 }
 
+TEST(Tonlib, StateCache) {
+  tonlib::StateCache<int, std::string> cache(10);
+  CHECK(cache.get(1) == nullptr);
+  cache.put(1, "a", 4);
+  cache.put(2, "b", 4);
+  CHECK(*cache.get(1) == "a");
+  // 2 is the least recently used one now
+  cache.put(3, "c", 4);
+  CHECK(cache.get(2) == nullptr);
+  CHECK(*cache.get(1) == "a");
+  CHECK(*cache.get(3) == "c");
+  CHECK(cache.size() == 8);
+  cache.put(4, "d", 11);
+  CHECK(cache.get(4) == nullptr);
+  cache.put(1, "e", 6);
+  CHECK(cache.size() == 10);
+  CHECK(*cache.get(1) == "e");
+  cache.erase_if([](int key, const std::string &) { return key == 3; });
+  CHECK(cache.get(3) == nullptr);
+  CHECK(cache.count() == 1);
+  CHECK(cache.size() == 6);
+  CHECK(cache.hits() == 4);
+  CHECK(cache.misses() == 4);
+  cache.clear();
+  CHECK(cache.count() == 0);
+  CHECK(cache.size() == 0);
+}
+
+TEST(Tonlib, StateCacheLastBlock) {
+  auto key = [](ton::WorkchainId workchain, ton::BlockSeqno seqno) {
+    return tonlib::AccountStateCacheKey{
+        ton::BlockIdExt(workchain, ton::shardIdAll, seqno, td::Bits256::zero(), td::Bits256::zero()), 0,
+        td::Bits256::zero()};
+  };
+  tonlib::StateCache<tonlib::AccountStateCacheKey, int> cache(100);
+  cache.put(key(ton::masterchainId, 9), 1, 1);
+  cache.put(key(ton::masterchainId, 10), 2, 1);
+  cache.put(key(ton::masterchainId, 11), 3, 1);
+  cache.put(key(ton::basechainId, 20), 4, 1);
+  tonlib::drop_outdated_account_states(cache, std::get<0>(key(ton::masterchainId, 10)));
+  CHECK(cache.count() == 2);
+  CHECK(cache.get(key(ton::masterchainId, 9)) == nullptr);
+  CHECK(*cache.get(key(ton::masterchainId, 10)) == 2);
+  CHECK(*cache.get(key(ton::masterchainId, 11)) == 3);
+  CHECK(cache.get(key(ton::basechainId, 20)) == nullptr);
+}
+
+TEST(Tonlib, GetMethodCacheKey) {
+  auto cell = [](td::uint64 x) { return vm::CellBuilder().store_long(x, 64).finalize(); };
+  ton::SmartContract::State state{cell(1), cell(2)};
+  auto make_args = [&] {
+    ton::SmartContract::Args args;
+    args.set_method_id("seqno");
+    td::Ref<vm::Stack> stack(true);
+    stack.write().push_smallint(7);
+    args.set_stack(std::move(stack));
+    args.set_now(1000);
+    args.set_address(block::StdAddress(ton::basechainId, td::Bits256::zero()));
+    args.set_balance(100);
+    return args;
+  };
+
+  auto key = tonlib::get_method_cache_key(state, make_args());
+  CHECK(key);
+  CHECK(key.value() == tonlib::get_method_cache_key(state, make_args()).value());
+
+  // Every input of the get-method changes the key
+  std::vector<td::Bits256> keys{key.value()};
+  auto check_new_key = [&](const ton::SmartContract::State &state, ton::SmartContract::Args args) {
+    auto key = tonlib::get_method_cache_key(state, args);
+    CHECK(key);
+    for (auto &other : keys) {
+      CHECK(other != key.value());
+    }
+    keys.push_back(key.value());
+  };
+  check_new_key({cell(3), cell(2)}, make_args());
+  check_new_key({cell(1), cell(3)}, make_args());
+  check_new_key({cell(1), td::Ref<vm::Cell>()}, make_args());
+  check_new_key(state, make_args().set_method_id("get_public_key"));
+  check_new_key(state, make_args().set_stack({vm::StackEntry(td::make_refint(8))}));
+  check_new_key(state, make_args().set_now(1001));
+  check_new_key(state, make_args().set_address(block::StdAddress(ton::masterchainId, td::Bits256::zero())));
+  check_new_key(state, make_args().set_address(block::StdAddress(ton::basechainId, td::Bits256::ones())));
+  check_new_key(state, make_args().set_balance(101));
+  check_new_key(state, make_args().set_extra_currencies(cell(4)));
+
+  // Results that depend on unknown inputs are not cached
+  ton::SmartContract::Args args;
+  args.set_method_id("seqno");
+  CHECK(!tonlib::get_method_cache_key(state, args));
+}
+
+namespace {
+using StandInHandler = std::function<td::BufferSlice(ton::lite_api::Function&)>;
+
+// Answers getMasterchainInfo with its seqno and everything else with the handler after a fixed delay
+class StandInLiteServer : public ton::adnl::AdnlExtClient {
+ public:
+  StandInLiteServer(double delay, ton::BlockSeqno mc_seqno, StandInHandler handler, std::shared_ptr<int> queries)
+      : delay_(delay), mc_seqno_(mc_seqno), handler_(std::move(handler)), queries_(std::move(queries)) {
+  }
+  void check_ready(td::Promise<td::Unit> promise) override {
+    promise.set_value(td::Unit());
+  }
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    auto query = ton::fetch_tl_object<ton::lite_api::liteServer_query>(data, true).move_as_ok();
+    auto f = ton::fetch_tl_object<ton::lite_api::Function>(query->data_, true).move_as_ok();
+    td::BufferSlice answer;
+    if (f->get_id() == ton::lite_api::liteServer_getMasterchainInfo::ID) {
+      answer = ton::serialize_tl_object(
+          ton::create_tl_object<ton::lite_api::liteServer_masterchainInfo>(
+              ton::create_tl_lite_block_id(ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, mc_seqno_, {}, {}}),
+              td::Bits256::zero(),
+              ton::create_tl_object<ton::lite_api::tonNode_zeroStateIdExt>(-1, td::Bits256::zero(), td::Bits256::zero())),
+          true);
+    } else {
+      ++*queries_;
+      answer = handler_(*f);
+    }
+    answers_.push_back({td::Timestamp::in(delay_), std::move(promise), std::move(answer)});
+    alarm_timestamp().relax(answers_.back().at);
+  }
+  void alarm() override {
+    for (auto it = answers_.begin(); it != answers_.end();) {
+      if (it->at.is_in_past()) {
+        it->promise.set_value(std::move(it->answer));
+        it = answers_.erase(it);
+      } else {
+        alarm_timestamp().relax(it->at);
+        ++it;
+      }
+    }
+  }
+
+ private:
+  struct Answer {
+    td::Timestamp at;
+    td::Promise<td::BufferSlice> promise;
+    td::BufferSlice answer;
+  };
+  double delay_;
+  ton::BlockSeqno mc_seqno_;
+  StandInHandler handler_;
+  std::shared_ptr<int> queries_;
+  std::vector<Answer> answers_;
+};
+
+struct StandIn {
+  double delay;
+  ton::BlockSeqno mc_seqno;
+  StandInHandler handler;
+  std::shared_ptr<int> queries = std::make_shared<int>(0);
+};
+
+td::BufferSlice current_time_handler(ton::lite_api::Function&) {
+  return ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_currentTime>(1), true);
+}
+
+// Runs a balancer over the stand-ins, which are told apart by port, and the actor returned by create_tester
+// until the actor stops the scheduler
+template <class F>
+void run_with_stand_ins(std::vector<StandIn>& stand_ins, tonlib::ExtClientBalancer::Options options,
+                        F&& create_tester) {
+  std::vector<liteclient::LiteServerConfig> servers;
+  for (size_t i = 0; i < stand_ins.size(); ++i) {
+    td::IPAddress addr;
+    addr.init_ipv4_port("127.0.0.1", static_cast<int>(1000 + i)).ensure();
+    servers.emplace_back(ton::adnl::AdnlNodeIdFull{}, addr);
+  }
+  auto connector = [&](const liteclient::LiteServerConfig& config,
+                       std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback) {
+    auto& stand_in = stand_ins.at(config.addr.get_port() - 1000);
+    return td::actor::ActorOwn<ton::adnl::AdnlExtClient>(td::actor::create_actor<StandInLiteServer>(
+        "standin", stand_in.delay, stand_in.mc_seqno, stand_in.handler, stand_in.queries));
+  };
+
+  td::actor::Scheduler scheduler({1});
+  td::actor::ActorOwn<tonlib::ExtClientBalancer> balancer;
+  td::actor::ActorOwn<td::actor::Actor> tester;
+  scheduler.run_in_context([&] {
+    balancer = tonlib::ExtClientBalancer::create(servers, options, connector);
+    tester = create_tester(balancer.get());
+  });
+  scheduler.run();
+  scheduler.run_in_context([&] {
+    tester.reset();
+    balancer.reset();
+  });
+}
+
+// Sends queries once the first probes are answered and stops the scheduler when all of them are answered
+class BalancerTester : public td::actor::Actor {
+ public:
+  BalancerTester(td::actor::ActorId<tonlib::ExtClientBalancer> balancer, std::vector<td::BufferSlice> queries,
+                 std::vector<td::Result<td::BufferSlice>>& answers, double& elapsed)
+      : balancer_(std::move(balancer)), queries_(std::move(queries)), answers_(answers), elapsed_(elapsed) {
+  }
+  void start_up() override {
+    alarm_timestamp() = td::Timestamp::in(0.5);
+  }
+  void alarm() override {
+    started_at_ = td::Time::now();
+    answers_.resize(queries_.size());
+    pending_ = queries_.size();
+    for (size_t i = 0; i < queries_.size(); ++i) {
+      auto query = ton::serialize_tl_object(
+          ton::create_tl_object<ton::lite_api::liteServer_query>(std::move(queries_[i])), true);
+      td::actor::send_closure(balancer_, &liteclient::ExtClient::send_query, "query", std::move(query),
+                              td::Timestamp::in(10.0), [SelfId = actor_id(this), i](td::Result<td::BufferSlice> R) {
+                                td::actor::send_closure(SelfId, &BalancerTester::on_answer, i, std::move(R));
+                              });
+    }
+  }
+  void on_answer(size_t i, td::Result<td::BufferSlice> R) {
+    answers_[i] = std::move(R);
+    if (--pending_ == 0) {
+      elapsed_ = td::Time::now() - started_at_;
+      td::actor::SchedulerContext::get()->stop();
+    }
+  }
+
+ private:
+  td::actor::ActorId<tonlib::ExtClientBalancer> balancer_;
+  std::vector<td::BufferSlice> queries_;
+  std::vector<td::Result<td::BufferSlice>>& answers_;
+  double& elapsed_;
+  size_t pending_ = 0;
+  double started_at_ = 0.0;
+};
+
+// Sends the queries through a balancer over the stand-ins and returns the answers
+std::vector<td::Result<td::BufferSlice>> query_stand_ins(std::vector<StandIn>& stand_ins,
+                                                         tonlib::ExtClientBalancer::Options options,
+                                                         std::vector<td::BufferSlice> queries, double& elapsed) {
+  std::vector<td::Result<td::BufferSlice>> answers;
+  run_with_stand_ins(stand_ins, options, [&](td::actor::ActorId<tonlib::ExtClientBalancer> balancer) {
+    return td::actor::create_actor<BalancerTester>("tester", balancer, std::move(queries), answers, elapsed);
+  });
+  return answers;
+}
+
+// Has masterchain blocks from from_seqno to to_seqno, and answers "not in db" to getBlock for other blocks
+StandInHandler block_handler(ton::BlockSeqno from_seqno, ton::BlockSeqno to_seqno,
+                             std::vector<ton::BlockSeqno>& requested) {
+  return [=, &requested](ton::lite_api::Function& f) {
+    auto& query = static_cast<ton::lite_api::liteServer_getBlock&>(f);
+    auto seqno = static_cast<ton::BlockSeqno>(query.id_->seqno_);
+    requested.push_back(seqno);
+    if (seqno < from_seqno || seqno > to_seqno) {
+      return ton::serialize_tl_object(
+          ton::create_tl_object<ton::lite_api::liteServer_error>(ton::ErrorCode::notready, "block handle not in db"),
+          true);
+    }
+    return ton::serialize_tl_object(
+        ton::create_tl_object<ton::lite_api::liteServer_blockData>(std::move(query.id_), td::BufferSlice("block")),
+        true);
+  };
+}
+
+td::BufferSlice not_ready_handler(ton::lite_api::Function&) {
+  return ton::serialize_tl_object(
+      ton::create_tl_object<ton::lite_api::liteServer_error>(ton::ErrorCode::notready, "not ready"), true);
+}
+
+td::BufferSlice get_block_query(ton::BlockSeqno seqno) {
+  return ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getBlock>(ton::create_tl_lite_block_id(
+                                      ton::BlockIdExt{ton::masterchainId, ton::shardIdAll, seqno, {}, {}})),
+                                  true);
+}
+}  // namespace
+
+TEST(Tonlib, ExtClientBalancer) {
+  // Fast, slow and behind on masterchain
+  std::vector<StandIn> stand_ins{
+      {0.01, 100, current_time_handler}, {5.0, 100, current_time_handler}, {0.01, 10, current_time_handler}};
+  tonlib::ExtClientBalancer::Options options;
+  options.max_in_flight = 4;
+  std::vector<td::BufferSlice> queries;
+  for (int i = 0; i < 40; ++i) {
+    queries.push_back(ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getTime>(), true));
+  }
+  double elapsed = 0.0;
+  for (auto& answer : query_stand_ins(stand_ins, options, std::move(queries), elapsed)) {
+    answer.ensure();
+  }
+
+  // The slow server gets a few queries when the fast one is busy, but they are answered by the fast one after hedging.
+  // Waiting for the slow server would take at least its delay, the rest is a margin for a loaded machine
+  LOG(INFO) << "fast: " << *stand_ins[0].queries << ", slow: " << *stand_ins[1].queries
+            << ", behind: " << *stand_ins[2].queries << ", elapsed: " << elapsed;
+  CHECK(*stand_ins[2].queries == 0);
+  CHECK(*stand_ins[0].queries > *stand_ins[1].queries);
+  CHECK(elapsed < 5.0);
+}
+
+TEST(Tonlib, ExtClientBalancerBlocks) {
+  // The first server has the recent blocks only, the second one is a few blocks late but keeps all of them.
+  // Neither is far enough behind to be skipped for other queries
+  std::vector<ton::BlockSeqno> recent_requested, archive_requested;
+  std::vector<StandIn> stand_ins{{0.01, 100, block_handler(50, 100, recent_requested)},
+                                 {0.01, 90, block_handler(1, 90, archive_requested)}};
+  tonlib::ExtClientBalancer::Options options;
+  options.max_seqno_lag = 20;
+  options.initial_hedge_delay = 5.0;
+  options.min_hedge_delay = 5.0;
+
+  // Old blocks go to both servers, and "not in db" answers of the first one are retried on the second one.
+  // Blocks the second server hasn't reached go to the first one only
+  std::vector<td::BufferSlice> queries;
+  for (int i = 0; i < 20; ++i) {
+    queries.push_back(get_block_query(10));
+  }
+  for (int i = 0; i < 10; ++i) {
+    queries.push_back(get_block_query(95));
+  }
+  queries.push_back(get_block_query(200));
+  double elapsed = 0.0;
+  auto answers = query_stand_ins(stand_ins, options, std::move(queries), elapsed);
+
+  for (size_t i = 0; i + 1 < answers.size(); ++i) {
+    auto block = ton::fetch_tl_object<ton::lite_api::liteServer_blockData>(answers[i].move_as_ok(), true).move_as_ok();
+    ASSERT_EQ(i < 20 ? 10 : 95, block->id_->seqno_);
+  }
+  ASSERT_TRUE(std::count(recent_requested.begin(), recent_requested.end(), 10) > 0);
+  ASSERT_EQ(20, std::count(archive_requested.begin(), archive_requested.end(), 10));
+  ASSERT_EQ(0, std::count(archive_requested.begin(), archive_requested.end(), 95));
+
+  // A block no server has: the "not in db" answer is passed to the caller when there is no other server to try
+  auto error = ton::fetch_tl_object<ton::lite_api::liteServer_error>(answers.back().move_as_ok(), true).move_as_ok();
+  ASSERT_EQ(ton::ErrorCode::notready, error->code_);
+  ASSERT_EQ(1, std::count(recent_requested.begin(), recent_requested.end(), 200));
+  ASSERT_EQ(1, std::count(archive_requested.begin(), archive_requested.end(), 200));
+}
+
+TEST(Tonlib, ExtClientBalancerSaturated) {
+  // The first server is not ready for anything, so every query is retried on the second one, which takes one query
+  // at a time. Queries wait for it for most of the run
+  std::vector<StandIn> stand_ins{{0.01, 100, not_ready_handler}, {0.4, 100, current_time_handler}};
+  tonlib::ExtClientBalancer::Options options;
+  options.max_in_flight = 1;
+  std::vector<td::BufferSlice> queries;
+  for (int i = 0; i < 3; ++i) {
+    queries.push_back(ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getTime>(), true));
+  }
+  double elapsed = 0.0;
+  auto cpu_started_at = std::clock();
+  for (auto& answer : query_stand_ins(stand_ins, options, std::move(queries), elapsed)) {
+    ton::fetch_tl_object<ton::lite_api::liteServer_currentTime>(answer.move_as_ok(), true).ensure();
+  }
+  double cpu_time = static_cast<double>(std::clock() - cpu_started_at) / CLOCKS_PER_SEC;
+
+  // Waiting queries must not keep the balancer busy until the server is free
+  LOG(INFO) << "elapsed: " << elapsed << ", cpu time: " << cpu_time;
+  ASSERT_TRUE(elapsed >= 1.1);
+  ASSERT_TRUE(cpu_time < 0.5);
+}
+
+namespace {
+using TransactionId = tonlib::TransactionStream::TransactionId;
+
+// History of one account with transactions at lt 10, 20, ... plus lt_shift, each linked to the previous one.
+// Histories with different utimes differ in all transaction hashes
+struct TransactionHistory {
+  static constexpr ton::LogicalTime LT_STEP = 10;
+  block::StdAddress address{0, td::Bits256::zero()};
+  std::map<ton::LogicalTime, td::Ref<vm::Cell>> transactions;
+
+  explicit TransactionHistory(size_t count, ton::LogicalTime lt_shift = 0, td::uint32 utime = 0) {
+    auto empty = vm::CellBuilder().finalize();
+    auto in_out_msgs = vm::CellBuilder().store_long(0, 2).finalize();
+    TransactionId prev{0, td::Bits256::zero()};
+    for (size_t i = 1; i <= count; ++i) {
+      ton::LogicalTime lt = i * LT_STEP + lt_shift;
+      vm::CellBuilder cb;
+      cb.store_long(7, 4)
+          .store_bits(address.addr.cbits(), 256)
+          .store_long(lt, 64)
+          .store_bits(prev.hash.cbits(), 256)
+          .store_long(prev.lt, 64)
+          .store_long(utime, 32)
+          .store_long(0, 15 + 2 + 2)
+          .store_ref(in_out_msgs)
+          .store_long(0, 4 + 1)
+          .store_ref(empty)
+          .store_ref(empty);
+      auto cell = cb.finalize();
+      prev = TransactionId{lt, cell->get_hash().bits()};
+      transactions.emplace(lt, std::move(cell));
+    }
+  }
+
+  TransactionId last() const {
+    auto it = transactions.rbegin();
+    return TransactionId{it->first, it->second->get_hash().bits()};
+  }
+
+  // The last transaction of the account in a block with the given lt, as its proven state would show
+  td::optional<TransactionId> last_before(ton::LogicalTime lt) const {
+    auto it = transactions.upper_bound(lt);
+    if (it == transactions.begin()) {
+      return {};
+    }
+    --it;
+    return TransactionId{it->first, it->second->get_hash().bits()};
+  }
+};
+
+// Answers getTransactions from any of the histories and counts the transactions it sends
+StandInHandler transactions_handler(std::vector<const TransactionHistory*> histories, std::shared_ptr<size_t> served) {
+  return [histories, served](ton::lite_api::Function& f) {
+    auto& query = static_cast<ton::lite_api::liteServer_getTransactions&>(f);
+    for (auto history : histories) {
+      auto it = history->transactions.find(static_cast<ton::LogicalTime>(query.lt_));
+      if (it == history->transactions.end() || td::Bits256(it->second->get_hash().bits()) != query.hash_) {
+        continue;
+      }
+      std::vector<td::Ref<vm::Cell>> roots;
+      std::vector<ton::tl_object_ptr<ton::lite_api::tonNode_blockIdExt>> ids;
+      for (auto jt = std::make_reverse_iterator(std::next(it));
+           jt != history->transactions.rend() && roots.size() < static_cast<size_t>(query.count_); ++jt) {
+        roots.push_back(jt->second);
+        ids.push_back(ton::create_tl_lite_block_id(ton::BlockIdExt{0, ton::shardIdAll, 1, {}, {}}));
+      }
+      *served += roots.size();
+      return ton::serialize_tl_object(
+          ton::create_tl_object<ton::lite_api::liteServer_transactionList>(
+              std::move(ids), vm::std_boc_serialize_multi(std::move(roots)).move_as_ok()),
+          true);
+    }
+    return ton::serialize_tl_object(
+        ton::create_tl_object<ton::lite_api::liteServer_error>(ton::ErrorCode::error, "cannot locate transaction"),
+        true);
+  };
+}
+
+// Takes the transactions to start chains from as given instead of looking them up with block proofs
+class TestTransactionStream : public tonlib::TransactionStream {
+ public:
+  TestTransactionStream(tonlib::ExtClientRef client, block::StdAddress address, TransactionId from,
+                        ton::LogicalTime to_lt, td::int32 parallelism,
+                        std::function<td::optional<TransactionId>(ton::LogicalTime)> find_anchor)
+      : TransactionStream(client, std::move(address), from.lt, from.hash, to_lt, parallelism)
+      , find_anchor_(std::move(find_anchor)) {
+  }
+
+ protected:
+  void find_anchors() override {
+    for (auto lt : split_points()) {
+      got_anchor(find_anchor_(lt));
+    }
+  }
+
+ private:
+  std::function<td::optional<TransactionId>(ton::LogicalTime)> find_anchor_;
+};
+
+struct TransactionStreamTest {
+  ton::LogicalTime to_lt = 0;
+  td::int32 parallelism = 4;
+  std::function<td::optional<TransactionId>(ton::LogicalTime)> find_anchor;
+  td::int32 read_count = 100;
+  // After the first read the reader waits for a while and notes how many transactions were fetched by then
+  bool pause = false;
+
+  std::vector<ton::LogicalTime> lts;
+  td::Status error;
+  size_t served_at_pause = 0;
+};
+
+// Opens a stream once the first probes are answered, reads it to the end or to an error and stops the scheduler
+class TransactionStreamTester : public td::actor::Actor {
+ public:
+  TransactionStreamTester(td::actor::ActorId<tonlib::ExtClientBalancer> balancer, const TransactionHistory& history,
+                          std::shared_ptr<size_t> served, TransactionStreamTest& test)
+      : balancer_(std::move(balancer)), history_(history), served_(std::move(served)), test_(test) {
+  }
+  void start_up() override {
+    alarm_timestamp() = td::Timestamp::in(0.5);
+  }
+  void alarm() override {
+    if (stream_.empty()) {
+      tonlib::ExtClientRef client;
+      client.adnl_ext_client_ = balancer_;
+      stream_ = td::actor::create_actor<TestTransactionStream>("stream", client, history_.address, history_.last(),
+                                                               test_.to_lt, test_.parallelism, test_.find_anchor);
+    } else {
+      test_.served_at_pause = *served_;
+    }
+    read(test_.pause && test_.lts.empty() ? 1 : test_.read_count);
+  }
+  void read(td::int32 count) {
+    td::actor::send_closure(stream_, &tonlib::TransactionStream::read, count,
+                            [SelfId = actor_id(this)](td::Result<block::TransactionList::Info> R) {
+                              td::actor::send_closure(SelfId, &TransactionStreamTester::on_read, std::move(R));
+                            });
+  }
+  void on_read(td::Result<block::TransactionList::Info> R) {
+    if (R.is_error()) {
+      test_.error = R.move_as_error();
+      td::actor::SchedulerContext::get()->stop();
+      return;
+    }
+    auto info = R.move_as_ok();
+    if (info.transactions.empty()) {
+      td::actor::SchedulerContext::get()->stop();
+      return;
+    }
+    bool first = test_.lts.empty();
+    auto lt = info.lt;
+    for (auto& transaction : info.transactions) {
+      test_.lts.push_back(lt);
+      lt = transaction.prev_trans_lt;
+    }
+    if (first && test_.pause) {
+      alarm_timestamp() = td::Timestamp::in(1.0);
+      return;
+    }
+    read(test_.read_count);
+  }
+
+ private:
+  td::actor::ActorId<tonlib::ExtClientBalancer> balancer_;
+  const TransactionHistory& history_;
+  std::shared_ptr<size_t> served_;
+  TransactionStreamTest& test_;
+  td::actor::ActorOwn<TestTransactionStream> stream_;
+};
+
+// Reads the history through a stream over two stand-in liteservers, which also know the transactions of the fork
+void read_transaction_stream(const TransactionHistory& history, TransactionStreamTest& test,
+                             const TransactionHistory* fork = nullptr) {
+  auto served = std::make_shared<size_t>(0);
+  std::vector<const TransactionHistory*> histories{&history};
+  if (fork) {
+    histories.push_back(fork);
+  }
+  std::vector<StandIn> stand_ins{{0.001, 100, transactions_handler(histories, served)},
+                                 {0.001, 100, transactions_handler(histories, served)}};
+  run_with_stand_ins(stand_ins, tonlib::ExtClientBalancer::Options(),
+                     [&](td::actor::ActorId<tonlib::ExtClientBalancer> balancer) {
+                       return td::actor::create_actor<TransactionStreamTester>("tester", balancer, history, served,
+                                                                               test);
+                     });
+}
+
+std::vector<ton::LogicalTime> expected_lts(const TransactionHistory& history, ton::LogicalTime to_lt) {
+  std::vector<ton::LogicalTime> res;
+  for (auto it = history.transactions.rbegin(); it != history.transactions.rend() && it->first >= to_lt; ++it) {
+    res.push_back(it->first);
+  }
+  return res;
+}
+}  // namespace
+
+TEST(Tonlib, TransactionStream) {
+  TransactionHistory history(500);
+  auto find_anchor = [&](ton::LogicalTime lt) { return history.last_before(lt); };
+
+  TransactionStreamTest test;
+  test.find_anchor = find_anchor;
+  read_transaction_stream(history, test);
+  test.error.ensure();
+  ASSERT_TRUE(test.lts == expected_lts(history, 0));
+
+  // Split points that can't be resolved merge their chains with the neighbouring ones
+  std::set<ton::LogicalTime> failed;
+  test = {};
+  test.find_anchor = [&](ton::LogicalTime lt) -> td::optional<TransactionId> {
+    if (failed.empty()) {
+      failed.insert(lt);
+      return {};
+    }
+    return history.last_before(lt);
+  };
+  test.parallelism = 8;
+  read_transaction_stream(history, test);
+  test.error.ensure();
+  ASSERT_EQ(1u, failed.size());
+  ASSERT_TRUE(test.lts == expected_lts(history, 0));
+
+  test = {};
+  test.find_anchor = [](ton::LogicalTime) -> td::optional<TransactionId> { return {}; };
+  read_transaction_stream(history, test);
+  test.error.ensure();
+  ASSERT_TRUE(test.lts == expected_lts(history, 0));
+
+  // The history is cut at to_lt, which falls between two transactions
+  for (td::int32 parallelism : {1, 3}) {
+    test = {};
+    test.find_anchor = find_anchor;
+    test.parallelism = parallelism;
+    test.to_lt = 2345;
+    read_transaction_stream(history, test);
+    test.error.ensure();
+    ASSERT_EQ(2350u, test.lts.back());
+    ASSERT_TRUE(test.lts == expected_lts(history, 2345));
+  }
+}
+
+TEST(Tonlib, TransactionStreamChainMismatch) {
+  TransactionHistory history(500);
+
+  // The start of the last chain is proven in another history: a transaction with the same lt but another hash,
+  // or with an lt the chain above it steps over. The chain above fails to meet it
+  for (ton::LogicalTime lt_shift : {0, 5}) {
+    TransactionHistory fork(500, lt_shift, 1);
+    TransactionStreamTest test;
+    test.find_anchor = [&](ton::LogicalTime lt) -> td::optional<TransactionId> {
+      return lt < 2000 ? fork.last_before(lt) : history.last_before(lt);
+    };
+    read_transaction_stream(history, test, &fork);
+    ASSERT_TRUE(test.error.is_error());
+    LOG(INFO) << test.error;
+    ASSERT_TRUE(test.error.message().str().find("doesn't reach proven transaction") != std::string::npos);
+  }
+}
+
+TEST(Tonlib, TransactionStreamBackPressure) {
+  TransactionHistory history(3 * tonlib::TransactionStream::MAX_BUFFERED);
+
+  // Nothing is read for a while after the first transaction: chains stop fetching once the buffer is full
+  TransactionStreamTest test;
+  test.find_anchor = [&](ton::LogicalTime lt) { return history.last_before(lt); };
+  test.read_count = 1000;
+  test.pause = true;
+  read_transaction_stream(history, test);
+  test.error.ensure();
+  LOG(INFO) << "fetched " << test.served_at_pause << " transactions while paused";
+  ASSERT_TRUE(test.served_at_pause >= tonlib::TransactionStream::MAX_BUFFERED);
+  // Besides the buffer, a chain may have had a query in flight when it filled up, and may have dropped
+  // the transactions fetched past its end
+  ASSERT_TRUE(test.served_at_pause <= tonlib::TransactionStream::MAX_BUFFERED + 1 +
+                                          2 * test.parallelism * tonlib::TransactionStream::FETCH_COUNT);
+  ASSERT_TRUE(test.lts == expected_lts(history, 0));
+}
+
 TEST(Tonlib, ParseAddres) {
   using tonlib_api::make_object;
   Client client;
@@ -0,0 +1,517 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tonlib/ExtClientBalancer.h"
+
+#include "tonlib/TonlibError.h"
+
+#include "auto/tl/lite_api.hpp"
+#include "common/errorcode.h"
+#include "tl-utils/lite-utils.hpp"
+
+#include "td/utils/as.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+
+#include <deque>
+#include <map>
+#include <numeric>
+
+namespace tonlib {
+
+class ExtClientBalancerImpl : public ExtClientBalancer {
+ public:
+  ExtClientBalancerImpl(std::vector<liteclient::LiteServerConfig> servers, Options options, Connector connector)
+      : options_(std::move(options)), connector_(std::move(connector)), hedge_delay_(options_.initial_hedge_delay) {
+    CHECK(!servers.empty());
+    if (!connector_) {
+      connector_ = [](const liteclient::LiteServerConfig &config,
+                      std::unique_ptr<ton::adnl::AdnlExtClient::Callback> callback) {
+        return ton::adnl::AdnlExtClient::create(config.adnl_id, config.addr, std::move(callback));
+      };
+    }
+    servers_.resize(servers.size());
+    for (size_t i = 0; i < servers.size(); ++i) {
+      servers_[i].config = std::move(servers[i]);
+    }
+  }
+
+  void start_up() override {
+    LOG(INFO) << "Started liteserver balancer, " << servers_.size() << " liteservers";
+    shuffle_connect_order();
+    alarm();
+  }
+
+  void send_query(std::string name, td::BufferSlice data, td::Timestamp timeout,
+                  td::Promise<td::BufferSlice> promise) override {
+    auto query_id = next_query_id_++;
+    Query &query = queries_[query_id];
+    query.info = liteclient::get_query_info(data);
+    query.idempotent = query.info.query_id != ton::lite_api::liteServer_sendMessage::ID;
+    query.name = std::move(name);
+    query.data = std::move(data);
+    query.timeout = timeout;
+    query.promise = std::move(promise);
+    if (!waiting_.empty()) {
+      waiting_.push_back(query_id);
+      return;
+    }
+    switch (send_attempt(query_id, query)) {
+      case SendResult::Sent:
+        break;
+      case SendResult::Busy:
+        waiting_.push_back(query_id);
+        break;
+      case SendResult::NoServer:
+        fail_query(query_id, td::Status::Error(PSTRING() << "no liteserver for query " << query.info.to_str()));
+        break;
+    }
+  }
+
+  void get_servers_status(td::Promise<std::vector<bool>> promise) override {
+    std::vector<bool> status(servers_.size());
+    for (size_t i = 0; i < servers_.size(); ++i) {
+      status[i] = !servers_[i].client.empty() && is_eligible(servers_[i], false);
+    }
+    promise.set_result(std::move(status));
+  }
+
+  void reset_servers() override {
+    LOG(INFO) << "Force resetting all liteservers";
+    for (Server &server : servers_) {
+      server.client.reset();
+      server.ignore_until = {};
+      server.probe_at = {};
+      server.latency = 0.0;
+      server.mc_seqno = 0;
+    }
+    max_mc_seqno_ = 0;
+    shuffle_connect_order();
+    maintain_connections();
+  }
+
+ private:
+  struct Server {
+    liteclient::LiteServerConfig config;
+    td::actor::ActorOwn<ton::adnl::AdnlExtClient> client;
+    size_t in_flight = 0;
+    double latency = 0.0;  // EWMA, 0 if unknown
+    ton::BlockSeqno mc_seqno = 0;  // 0 if unknown
+    td::Timestamp ignore_until;
+    td::Timestamp probe_at;
+    bool probing = false;
+  };
+  struct Query {
+    std::string name;
+    td::BufferSlice data;
+    liteclient::QueryInfo info;
+    bool idempotent = true;
+    td::Timestamp timeout;
+    td::Promise<td::BufferSlice> promise;
+    std::vector<size_t> servers;
+    size_t pending = 0;
+    td::Timestamp hedge_at;
+    td::Status error;
+    td::BufferSlice not_ready_answer;  // passed to the caller if no other server has the block
+  };
+  enum class SendResult { Sent, Busy, NoServer };
+
+  Options options_;
+  Connector connector_;
+  std::vector<Server> servers_;
+  std::vector<size_t> connect_order_;
+  ton::BlockSeqno max_mc_seqno_ = 0;
+
+  std::map<td::uint64, Query> queries_;
+  std::deque<td::uint64> waiting_;
+  td::uint64 next_query_id_ = 0;
+
+  std::vector<double> latencies_;
+  size_t next_latency_ = 0;
+  size_t latencies_since_update_ = 0;
+  double hedge_delay_;
+  td::uint64 hedged_queries_ = 0;
+
+  static constexpr size_t LATENCY_SAMPLES = 256;
+  static constexpr size_t LATENCY_UPDATE_INTERVAL = 16;
+  static constexpr double PROBE_TIMEOUT = 5.0;
+  static constexpr double ALARM_INTERVAL = 1.0;
+
+  void shuffle_connect_order() {
+    connect_order_.resize(servers_.size());
+    std::iota(connect_order_.begin(), connect_order_.end(), 0);
+    td::Random::Fast rnd;
+    td::random_shuffle(td::as_mutable_span(connect_order_), rnd);
+  }
+
+  bool is_eligible(const Server &server, bool allow_behind) const {
+    if (server.ignore_until && !server.ignore_until.is_in_past()) {
+      return false;
+    }
+    return allow_behind || server.mc_seqno == 0 || server.mc_seqno + options_.max_seqno_lag >= max_mc_seqno_;
+  }
+
+  // Masterchain seqno a server must have reached to answer the query, 0 if unknown or not needed
+  static ton::BlockSeqno required_mc_seqno(const liteclient::QueryInfo &info) {
+    if (info.type == liteclient::QueryInfo::t_mc_seqno ||
+        (info.type == liteclient::QueryInfo::t_seqno && info.shard_id.is_masterchain())) {
+      return static_cast<ton::BlockSeqno>(info.value);
+    }
+    return 0;
+  }
+
+  // liteServer.error "not ready" means that the server does not have the block yet (or any more)
+  static bool is_not_ready_answer(td::Slice answer) {
+    if (answer.size() < 4 || td::as<td::int32>(answer.data()) != ton::lite_api::liteServer_error::ID) {
+      return false;
+    }
+    auto r_error = ton::fetch_tl_object<ton::lite_api::liteServer_error>(answer, true);
+    return r_error.is_ok() && r_error.ok()->code_ == ton::ErrorCode::notready;
+  }
+
+  double get_latency(const Server &server) const {
+    return server.latency > 0.0 ? server.latency : hedge_delay_;
+  }
+
+  td::optional<size_t> select_server(const Query &query, bool &busy) {
+    // Servers that have not reached the masterchain block of the query according to the last probe are used only
+    // if no other server can process it, and servers that are behind - only after them
+    ton::BlockSeqno mc_seqno = required_mc_seqno(query.info);
+    for (int pass = mc_seqno == 0 ? 1 : 0; pass < 3; ++pass) {
+      bool allow_behind = pass == 2;
+      size_t best = servers_.size();
+      double best_score = 0.0;
+      for (size_t i = 0; i < servers_.size(); ++i) {
+        const Server &server = servers_[i];
+        if (!is_eligible(server, allow_behind) || (pass == 0 && server.mc_seqno < mc_seqno) ||
+            !server.config.accepts_query(query.info) ||
+            std::find(query.servers.begin(), query.servers.end(), i) != query.servers.end()) {
+          continue;
+        }
+        if (server.in_flight >= options_.max_in_flight) {
+          busy = true;
+          continue;
+        }
+        // New connections are opened only if no connected server fits
+        double score = get_latency(server) * static_cast<double>(server.in_flight + 1);
+        if (server.client.empty()) {
+          score += 1e9;
+        }
+        if (best == servers_.size() || score < best_score) {
+          best = i;
+          best_score = score;
+        }
+      }
+      if (best != servers_.size()) {
+        return best;
+      }
+      if (busy) {
+        return {};
+      }
+    }
+    return {};
+  }
+
+  SendResult send_attempt(td::uint64 query_id, Query &query) {
+    bool busy = false;
+    auto r_server = select_server(query, busy);
+    if (!r_server) {
+      return busy ? SendResult::Busy : SendResult::NoServer;
+    }
+    size_t idx = r_server.unwrap();
+    Server &server = servers_[idx];
+    if (server.client.empty()) {
+      connect(idx);
+    }
+    ++server.in_flight;
+    query.servers.push_back(idx);
+    ++query.pending;
+    if (query.idempotent && query.servers.size() < options_.max_attempts) {
+      query.hedge_at = td::Timestamp::in(hedge_delay_);
+      alarm_timestamp().relax(query.hedge_at);
+    } else {
+      query.hedge_at = {};
+    }
+    LOG(DEBUG) << "Sending query " << query.info.to_str() << " to liteserver " << server.config.addr << ", attempt "
+               << query.servers.size();
+    td::actor::send_closure(server.client, &ton::adnl::AdnlExtClient::send_query, query.name, query.data.clone(),
+                            query.timeout,
+                            [SelfId = actor_id(this), query_id, idx,
+                             started_at = td::Time::now()](td::Result<td::BufferSlice> R) {
+                              td::actor::send_closure(SelfId, &ExtClientBalancerImpl::on_answer, query_id, idx,
+                                                      td::Time::now() - started_at, std::move(R));
+                            });
+    return SendResult::Sent;
+  }
+
+  void on_answer(td::uint64 query_id, size_t idx, double latency, td::Result<td::BufferSlice> R) {
+    Server &server = servers_[idx];
+    CHECK(server.in_flight > 0);
+    --server.in_flight;
+    bool not_ready = false;
+    if (R.is_ok()) {
+      add_latency(server, latency);
+      not_ready = is_not_ready_answer(R.ok());
+    } else if (R.error().code() == ton::ErrorCode::timeout || R.error().code() == ton::ErrorCode::cancelled) {
+      on_server_error(idx);
+    }
+    auto it = queries_.find(query_id);
+    if (it != queries_.end()) {
+      Query &query = it->second;
+      --query.pending;
+      if (R.is_ok() && !not_ready) {
+        query.promise.set_value(R.move_as_ok());
+        queries_.erase(it);
+      } else {
+        if (not_ready) {
+          LOG(DEBUG) << "Liteserver " << server.config.addr << " is not ready for query " << query.info.to_str();
+          query.not_ready_answer = R.move_as_ok();
+        } else {
+          query.error = R.move_as_error();
+        }
+        if (query.pending == 0) {
+          retry_query(query_id, query);
+        }
+      }
+    }
+    send_waiting();
+  }
+
+  void retry_query(td::uint64 query_id, Query &query) {
+    if (query.idempotent && query.servers.size() < options_.max_attempts && !query.timeout.is_in_past()) {
+      switch (send_attempt(query_id, query)) {
+        case SendResult::Sent:
+          return;
+        case SendResult::Busy:
+          // Nothing is in flight, so there is nothing to hedge until the query is sent again
+          query.hedge_at = {};
+          waiting_.push_back(query_id);
+          return;
+        case SendResult::NoServer:
+          break;
+      }
+    }
+    fail_query(query_id, std::move(query.error));
+  }
+
+  void fail_query(td::uint64 query_id, td::Status error) {
+    auto it = queries_.find(query_id);
+    CHECK(it != queries_.end());
+    if (!it->second.not_ready_answer.empty()) {
+      it->second.promise.set_value(std::move(it->second.not_ready_answer));
+    } else {
+      it->second.promise.set_error(std::move(error));
+    }
+    queries_.erase(it);
+  }
+
+  void send_waiting() {
+    while (!waiting_.empty()) {
+      auto query_id = waiting_.front();
+      auto it = queries_.find(query_id);
+      if (it == queries_.end()) {
+        waiting_.pop_front();
+        continue;
+      }
+      auto result = send_attempt(query_id, it->second);
+      if (result == SendResult::Busy) {
+        break;
+      }
+      waiting_.pop_front();
+      if (result == SendResult::NoServer) {
+        fail_query(query_id, it->second.error.is_error() ? std::move(it->second.error)
+                                                         : td::Status::Error(PSTRING() << "no liteserver for query "
+                                                                                       << it->second.info.to_str()));
+      }
+    }
+  }
+
+  void add_latency(Server &server, double latency) {
+    if (server.latency > 0.0) {
+      server.latency += options_.latency_ewma_alpha * (latency - server.latency);
+    } else {
+      server.latency = latency;
+    }
+    if (latencies_.size() < LATENCY_SAMPLES) {
+      latencies_.push_back(latency);
+    } else {
+      latencies_[next_latency_] = latency;
+      next_latency_ = (next_latency_ + 1) % LATENCY_SAMPLES;
+    }
+    // The percentile is recomputed on every sample until there are enough of them, and then periodically
+    if (latencies_.size() <= LATENCY_UPDATE_INTERVAL || ++latencies_since_update_ >= LATENCY_UPDATE_INTERVAL) {
+      latencies_since_update_ = 0;
+      std::vector<double> sorted = latencies_;
+      auto pos = static_cast<size_t>(options_.hedge_percentile * static_cast<double>(sorted.size() - 1));
+      std::nth_element(sorted.begin(), sorted.begin() + pos, sorted.end());
+      hedge_delay_ = std::max(options_.min_hedge_delay, sorted[pos]);
+    }
+  }
+
+  void connect(size_t idx) {
+    class Callback : public ton::adnl::AdnlExtClient::Callback {
+     public:
+      Callback(td::actor::ActorId<ExtClientBalancerImpl> parent, size_t idx) : parent_(std::move(parent)), idx_(idx) {
+      }
+      void on_ready() override {
+      }
+      void on_stop_ready() override {
+        td::actor::send_closure(parent_, &ExtClientBalancerImpl::on_server_disconnected, idx_);
+      }
+
+     private:
+      td::actor::ActorId<ExtClientBalancerImpl> parent_;
+      size_t idx_;
+    };
+    Server &server = servers_[idx];
+    LOG(INFO) << "Connecting to liteserver " << server.config.addr;
+    server.client = connector_(server.config, std::make_unique<Callback>(actor_id(this), idx));
+    server.probe_at = td::Timestamp::now();
+    alarm_timestamp().relax(server.probe_at);
+  }
+
+  void maintain_connections() {
+    size_t connected = 0;
+    for (const Server &server : servers_) {
+      if (!server.client.empty() && is_eligible(server, true)) {
+        ++connected;
+      }
+    }
+    for (size_t idx : connect_order_) {
+      if (connected >= options_.connections) {
+        break;
+      }
+      if (servers_[idx].client.empty() && is_eligible(servers_[idx], true)) {
+        connect(idx);
+        ++connected;
+      }
+    }
+  }
+
+  void on_server_error(size_t idx) {
+    servers_[idx].ignore_until = td::Timestamp::in(options_.bad_server_timeout);
+  }
+
+  void on_server_disconnected(size_t idx) {
+    on_server_error(idx);
+    servers_[idx].client.reset();
+    servers_[idx].mc_seqno = 0;
+    maintain_connections();
+  }
+
+  void probe(size_t idx) {
+    Server &server = servers_[idx];
+    server.probing = true;
+    server.probe_at = td::Timestamp::in(options_.probe_interval);
+    auto query = ton::serialize_tl_object(
+        ton::create_tl_object<ton::lite_api::liteServer_query>(
+            ton::serialize_tl_object(ton::create_tl_object<ton::lite_api::liteServer_getMasterchainInfo>(), true)),
+        true);
+    td::actor::send_closure(server.client, &ton::adnl::AdnlExtClient::send_query, "probe", std::move(query),
+                            td::Timestamp::in(PROBE_TIMEOUT),
+                            [SelfId = actor_id(this), idx, started_at = td::Time::now()](td::Result<td::BufferSlice> R) {
+                              td::actor::send_closure(SelfId, &ExtClientBalancerImpl::on_probe, idx,
+                                                      td::Time::now() - started_at, std::move(R));
+                            });
+  }
+
+  void on_probe(size_t idx, double latency, td::Result<td::BufferSlice> R) {
+    Server &server = servers_[idx];
+    server.probing = false;
+    auto r_info = [&]() -> td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_masterchainInfo>> {
+      TRY_RESULT(data, std::move(R));
+      return ton::fetch_tl_object<ton::lite_api::liteServer_masterchainInfo>(data, true);
+    }();
+    if (r_info.is_error()) {
+      LOG(INFO) << "Liteserver " << server.config.addr << " failed probe: " << r_info.error();
+      on_server_error(idx);
+      return;
+    }
+    add_latency(server, latency);
+    server.ignore_until = {};
+    server.mc_seqno = r_info.ok()->last_->seqno_;
+    if (server.mc_seqno > max_mc_seqno_) {
+      max_mc_seqno_ = server.mc_seqno;
+    } else if (server.mc_seqno + options_.max_seqno_lag < max_mc_seqno_) {
+      LOG(INFO) << "Liteserver " << server.config.addr << " is behind: mc seqno " << server.mc_seqno << ", "
+                << max_mc_seqno_ << " on other liteservers";
+    }
+    send_waiting();
+  }
+
+  void alarm() override {
+    for (size_t i = 0; i < servers_.size(); ++i) {
+      Server &server = servers_[i];
+      if (!server.client.empty() && !server.probing && server.probe_at && server.probe_at.is_in_past()) {
+        probe(i);
+      }
+    }
+    maintain_connections();
+    for (auto &[query_id, query] : queries_) {
+      if (!query.hedge_at || !query.hedge_at.is_in_past() || query.pending == 0) {
+        continue;
+      }
+      query.hedge_at = {};
+      switch (send_attempt(query_id, query)) {
+        case SendResult::Sent:
+          ++hedged_queries_;
+          break;
+        case SendResult::Busy:
+          query.hedge_at = td::Timestamp::in(options_.min_hedge_delay);
+          break;
+        case SendResult::NoServer:
+          break;
+      }
+    }
+    for (auto it = waiting_.begin(); it != waiting_.end();) {
+      auto query = queries_.find(*it);
+      if (query != queries_.end() && query->second.timeout && query->second.timeout.is_in_past()) {
+        fail_query(*it, td::Status::Error(ton::ErrorCode::timeout, "no free liteserver"));
+        it = waiting_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    alarm_timestamp() = td::Timestamp::in(ALARM_INTERVAL);
+    for (auto &[query_id, query] : queries_) {
+      if (query.pending > 0) {
+        alarm_timestamp().relax(query.hedge_at);
+      }
+    }
+    for (const Server &server : servers_) {
+      if (!server.client.empty() && !server.probing) {
+        alarm_timestamp().relax(server.probe_at);
+      }
+    }
+  }
+
+  void tear_down() override {
+    for (auto &[query_id, query] : queries_) {
+      query.promise.set_error(TonlibError::Cancelled());
+    }
+    queries_.clear();
+    if (hedged_queries_ > 0) {
+      LOG(INFO) << "Liteserver balancer sent " << hedged_queries_ << " hedged queries";
+    }
+  }
+};
+
+td::actor::ActorOwn<ExtClientBalancer> ExtClientBalancer::create(std::vector<liteclient::LiteServerConfig> servers,
+                                                                 Options options, Connector connector) {
+  return td::actor::create_actor<ExtClientBalancerImpl>("ExtClientBalancer", std::move(servers), std::move(options),
+                                                        std::move(connector));
+}
+}  // namespace tonlib
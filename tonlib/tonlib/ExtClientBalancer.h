@@ -0,0 +1,53 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "lite-client/ext-client.h"
+
+#include <functional>
+
+namespace tonlib {
+// Spreads liteserver queries over several connections.
+// A query goes to the eligible server with the fewest queries in flight, weighted by the average latency of the server.
+// A server is not eligible if it has too many queries in flight, failed recently or is behind the other servers
+// on masterchain seqno, which is known from periodic getMasterchainInfo probes. Queries to a masterchain block go
+// to servers that have reached it first, and a "not ready" liteServer.error answer is retried on another server.
+// If there is no answer to an idempotent query (anything but sendMessage) after a percentile of recent latencies,
+// the query is also sent to another server, and the first answer is used.
+class ExtClientBalancer : public liteclient::ExtClient {
+ public:
+  struct Options {
+    size_t connections = 3;
+    size_t max_in_flight = 32;
+    double latency_ewma_alpha = 0.2;
+    double hedge_percentile = 0.95;
+    double min_hedge_delay = 0.05;
+    double initial_hedge_delay = 1.0;
+    size_t max_attempts = 2;
+    ton::BlockSeqno max_seqno_lag = 2;
+    double probe_interval = 5.0;
+    double bad_server_timeout = 30.0;
+  };
+  // Creates a connection to a liteserver, ton::adnl::AdnlExtClient::create by default.
+  // Tests use it to replace liteservers with in-process actors
+  using Connector = std::function<td::actor::ActorOwn<ton::adnl::AdnlExtClient>(
+      const liteclient::LiteServerConfig &, std::unique_ptr<ton::adnl::AdnlExtClient::Callback>)>;
+
+  static td::actor::ActorOwn<ExtClientBalancer> create(std::vector<liteclient::LiteServerConfig> servers,
+                                                       Options options, Connector connector = {});
+};
+}  // namespace tonlib
@@ -0,0 +1,131 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ton/ton-types.h"
+
+#include "td/utils/common.h"
+
+#include <list>
+#include <map>
+#include <tuple>
+
+namespace tonlib {
+// LRU cache bounded by the total estimated size of its values.
+// Values are immutable once stored: a proven account state or a get-method result never changes for the same key,
+// entries only become useless when a newer masterchain block is known.
+template <class KeyT, class ValueT>
+class StateCache {
+ public:
+  explicit StateCache(size_t max_size) : max_size_(max_size) {
+  }
+
+  const ValueT *get(const KeyT &key) {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      ++misses_;
+      return nullptr;
+    }
+    ++hits_;
+    order_.splice(order_.end(), order_, it->second.order_it);
+    return &it->second.value;
+  }
+
+  void put(KeyT key, ValueT value, size_t size) {
+    if (size > max_size_) {
+      return;
+    }
+    erase(key);
+    order_.push_back(key);
+    values_.emplace(std::move(key), Entry{std::move(value), size, std::prev(order_.end())});
+    size_ += size;
+    while (size_ > max_size_) {
+      erase(order_.front());
+    }
+  }
+
+  void erase(const KeyT &key) {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return;
+    }
+    size_ -= it->second.size;
+    order_.erase(it->second.order_it);
+    values_.erase(it);
+  }
+
+  template <class F>
+  void erase_if(F &&f) {
+    for (auto it = values_.begin(); it != values_.end();) {
+      if (f(it->first, it->second.value)) {
+        size_ -= it->second.size;
+        order_.erase(it->second.order_it);
+        it = values_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void clear() {
+    order_.clear();
+    values_.clear();
+    size_ = 0;
+  }
+
+  td::uint64 hits() const {
+    return hits_;
+  }
+  td::uint64 misses() const {
+    return misses_;
+  }
+  size_t count() const {
+    return values_.size();
+  }
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  struct Entry {
+    ValueT value;
+    size_t size;
+    typename std::list<KeyT>::iterator order_it;
+  };
+  std::list<KeyT> order_;
+  std::map<KeyT, Entry> values_;
+  size_t max_size_;
+  size_t size_ = 0;
+  td::uint64 hits_ = 0;
+  td::uint64 misses_ = 0;
+};
+
+// A proven account state is cached for the block it was proven in
+using AccountStateCacheKey = std::tuple<ton::BlockIdExt, ton::WorkchainId, ton::StdSmcAddress>;
+
+// Called when a new masterchain block becomes the last one. Account states proven in older blocks are never requested
+// again unless a query asks for that block explicitly, so they are dropped.
+template <class ValueT>
+void drop_outdated_account_states(StateCache<AccountStateCacheKey, ValueT> &cache,
+                                  const ton::BlockIdExt &last_block_id) {
+  auto seqno = last_block_id.seqno();
+  cache.erase_if([seqno](const AccountStateCacheKey &key, const ValueT &) {
+    auto &block_id = std::get<0>(key);
+    return !block_id.is_masterchain() || block_id.seqno() < seqno;
+  });
+}
+}  // namespace tonlib
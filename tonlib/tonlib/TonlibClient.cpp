@@ -18,6 +18,7 @@
 */
 #include "TonlibClient.h"
 
+#include "tonlib/ExtClientBalancer.h"
 #include "tonlib/ExtClientOutbound.h"
 #include "tonlib/LastBlock.h"
 #include "tonlib/LastConfig.h"
@@ -26,6 +27,7 @@
 #include "tonlib/keys/Mnemonic.h"
 #include "tonlib/keys/SimpleEncryption.h"
 #include "tonlib/TonlibError.h"
+#include "tonlib/TransactionStream.h"
 
 #include "smc-envelope/GenericAccount.h"
 #include "smc-envelope/ManualDns.h"
@@ -53,6 +55,7 @@
 #include "vm/memo.h"
 
 #include "td/utils/as.h"
+#include "td/utils/crypto.h"
 #include "td/utils/Random.h"
 #include "td/utils/optional.h"
 #include "td/utils/overloaded.h"
@@ -2146,6 +2149,7 @@ void TonlibClient::hangup() {
   raw_client_ = {};
   raw_last_block_ = {};
   raw_last_config_ = {};
+  transaction_streams_.clear();
   try_stop();
 }
 
@@ -2186,7 +2190,7 @@ void TonlibClient::init_ext_client() {
     raw_client_ = std::move(client);
   } else {
     ext_client_outbound_ = {};
-    raw_client_ = liteclient::ExtClient::create(config_.lite_servers, nullptr);
+    raw_client_ = ExtClientBalancer::create(config_.lite_servers, ExtClientBalancer::Options{});
   }
 }
 
@@ -2196,6 +2200,10 @@ void TonlibClient::update_last_block_state(LastBlockState state, td::uint32 conf
   }
 
   last_block_storage_.save_state(last_state_key_, state);
+
+  // Get-method results are computed with the last config, so all of them are dropped
+  drop_outdated_account_states(account_state_cache_, state.last_block_id);
+  get_method_cache_.clear();
 }
 
 void TonlibClient::update_sync_state(LastBlockSyncState state, td::uint32 config_generation) {
@@ -2952,6 +2960,8 @@ td::Result<TonlibClient::FullConfig> TonlibClient::validate_config(tonlib_api::o
 void TonlibClient::set_config(FullConfig full_config) {
   config_ = std::move(full_config.config);
   config_generation_++;
+  account_state_cache_.clear();
+  get_method_cache_.clear();
   wallet_id_ = full_config.wallet_id;
   rwallet_init_public_key_ = full_config.rwallet_init_public_key;
   last_state_key_ = full_config.last_state_key;
@@ -3468,6 +3478,60 @@ td::Status TonlibClient::do_request(tonlib_api::raw_getTransactionsV2& request,
   return td::Status::OK();
 }
 
+td::Status TonlibClient::do_request(const tonlib_api::raw_openTransactionStream& request,
+                                    td::Promise<object_ptr<tonlib_api::raw_transactionStream>>&& promise) {
+  if (!request.account_address_) {
+    return TonlibError::EmptyField("account_address");
+  }
+  if (!request.from_transaction_id_) {
+    return TonlibError::EmptyField("from_transaction_id");
+  }
+  TRY_RESULT(account_address, get_account_address(request.account_address_->account_address_));
+  auto lt = request.from_transaction_id_->lt_;
+  auto hash_str = request.from_transaction_id_->hash_;
+  if (hash_str.size() != 32) {
+    return td::Status::Error(400, "Invalid transaction id hash size");
+  }
+  td::Bits256 hash;
+  hash.as_slice().copy_from(hash_str);
+  if (request.to_lt_ < 0) {
+    return TonlibError::InvalidField("to_lt", "can't be negative");
+  }
+
+  auto id = ++next_transaction_stream_id_;
+  transaction_streams_[id] =
+      td::actor::create_actor<TransactionStream>("TransactionStream", client_.get_client(), account_address, lt, hash,
+                                                 request.to_lt_, request.parallelism_);
+  promise.set_value(tonlib_api::make_object<tonlib_api::raw_transactionStream>(id));
+  return td::Status::OK();
+}
+
+td::Status TonlibClient::do_request(const tonlib_api::raw_readTransactionStream& request,
+                                    td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise) {
+  auto it = transaction_streams_.find(request.id_);
+  if (it == transaction_streams_.end()) {
+    return TonlibError::InvalidTransactionStreamId();
+  }
+  td::actor::send_closure(
+      it->second, &TransactionStream::read, request.count_,
+      promise.wrap([try_decode_messages = request.try_decode_messages_](auto&& x) mutable {
+        return ToRawTransactions(td::optional<td::Ed25519::PrivateKey>(), try_decode_messages)
+            .to_raw_transactions(std::move(x));
+      }));
+  return td::Status::OK();
+}
+
+td::Status TonlibClient::do_request(const tonlib_api::raw_closeTransactionStream& request,
+                                    td::Promise<object_ptr<tonlib_api::ok>>&& promise) {
+  auto it = transaction_streams_.find(request.id_);
+  if (it == transaction_streams_.end()) {
+    return TonlibError::InvalidTransactionStreamId();
+  }
+  transaction_streams_.erase(it);
+  promise.set_value(tonlib_api::make_object<tonlib_api::ok>());
+  return td::Status::OK();
+}
+
 td::Status TonlibClient::do_request(const tonlib_api::getAccountState& request,
                                     td::Promise<object_ptr<tonlib_api::fullAccountState>>&& promise) {
   if (!request.account_address_) {
@@ -4775,6 +4839,45 @@ td::Status TonlibClient::do_request(const tonlib_api::smc_getLibrariesExt& reque
   return td::Status::OK();
 }
 
+td::Result<td::Ref<vm::Cell>> serialize_stack(const vm::Stack& stack) {
+  vm::CellBuilder cb;
+  td::Ref<vm::Cell> cell;
+  if (!stack.serialize(cb) || !cb.finalize_to(cell)) {
+    return td::Status::Error("Failed to serialize stack");
+  }
+  return cell;
+}
+
+// Everything a get-method result depends on, except for the config and libraries.
+// The config only changes with the last block, when the cache is dropped, and results that needed a missing library
+// are never stored.
+td::optional<td::Bits256> get_method_cache_key(const ton::SmartContract::State& state,
+                                               const ton::SmartContract::Args& args) {
+  if (!args.method_id || !args.stack || !args.now || !args.address) {
+    return {};
+  }
+  auto r_stack = TRY_VM(serialize_stack(*args.stack.value()));
+  if (r_stack.is_error()) {
+    return {};
+  }
+  td::Sha256State sha256;
+  sha256.init();
+  for (auto& cell : {state.code, state.data, r_stack.ok(), args.extra_currencies}) {
+    sha256.feed(cell.is_null() ? td::Bits256::zero().as_slice() : cell->get_hash().as_slice());
+  }
+  sha256.feed(args.address.value().addr.as_slice());
+  char buf[24];
+  td::as<td::int32>(buf) = args.method_id.value();
+  td::as<td::int32>(buf + 4) = args.now.value();
+  td::as<td::int32>(buf + 8) = args.address.value().workchain;
+  td::as<td::uint32>(buf + 12) = 0;
+  td::as<td::uint64>(buf + 16) = args.balance;
+  sha256.feed(td::Slice(buf, sizeof(buf)));
+  td::Bits256 res;
+  sha256.extract(res.as_slice());
+  return res;
+}
+
 td::Status TonlibClient::do_request(const tonlib_api::smc_runGetMethod& request,
                                     td::Promise<object_ptr<tonlib_api::smc_runResult>>&& promise) {
   auto it = smcs_.find(request.id_);
@@ -4799,8 +4902,20 @@ td::Status TonlibClient::do_request(const tonlib_api::smc_runGetMethod& request,
   args.set_now(it->second->get_sync_time());
   args.set_address(it->second->get_address());
 
-  client_.with_last_config([self = this, smc = std::move(smc), args = std::move(args), promise = std::move(promise)
-  ](td::Result<LastConfigState> r_state) mutable {
+  auto cache_key = get_method_cache_key(smc->get_state(), args);
+  if (cache_key) {
+    auto cached = get_method_cache_.get(cache_key.value());
+    if (cached) {
+      TRY_RESULT(res_stack, to_tonlib_api(cached->stack));
+      promise.set_value(
+          tonlib_api::make_object<tonlib_api::smc_runResult>(cached->gas_used, std::move(res_stack), cached->exit_code));
+      return td::Status::OK();
+    }
+  }
+
+  client_.with_last_config([self = this, smc = std::move(smc), args = std::move(args),
+                            cache_key = std::move(cache_key),
+                            promise = std::move(promise)](td::Result<LastConfigState> r_state) mutable {
     TRY_RESULT_PROMISE(promise, state, std::move(r_state));
     args.set_config(state.config);
     args.set_prev_blocks_info(state.prev_blocks_info);
@@ -4815,17 +4930,18 @@ td::Status TonlibClient::do_request(const tonlib_api::smc_runGetMethod& request,
         LOG(DEBUG) << "Requesting found libraries in code (" << libraryList.size() << ")";
         self->client_.send_query(
             ton::lite_api::liteServer_getLibraries(std::move(libraryList)),
-            [self, smc = std::move(smc), args = std::move(args), promise = std::move(promise)](
+            [self, smc = std::move(smc), args = std::move(args), cache_key = std::move(cache_key),
+             promise = std::move(promise)](
                 td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_libraryResult>> r_libraries) mutable {
               self->process_new_libraries(std::move(r_libraries));
-              self->perform_smc_execution(std::move(smc), std::move(args), std::move(promise));
+              self->perform_smc_execution(std::move(smc), std::move(args), std::move(cache_key), std::move(promise));
             });
       } else {
-        self->perform_smc_execution(std::move(smc), std::move(args), std::move(promise));
+        self->perform_smc_execution(std::move(smc), std::move(args), std::move(cache_key), std::move(promise));
       }
     }
     else {
-      self->perform_smc_execution(std::move(smc), std::move(args), std::move(promise));
+      self->perform_smc_execution(std::move(smc), std::move(args), std::move(cache_key), std::move(promise));
     }
   });
   return td::Status::OK();
@@ -4859,6 +4975,7 @@ void TonlibClient::process_new_libraries(
 }
 
 void TonlibClient::perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::SmartContract::Args args,
+                                         td::optional<td::Bits256> cache_key,
                                          td::Promise<object_ptr<tonlib_api::smc_runResult>>&& promise) {
 
   args.set_libraries(libraries);
@@ -4879,7 +4996,8 @@ void TonlibClient::perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::S
     std::vector<td::Bits256> req = {hash};
     client_.send_query(ton::lite_api::liteServer_getLibraries(std::move(req)),
                 [self = this, res = std::move(res), res_stack = std::move(res_stack), hash,
-                 smc = std::move(smc), args = std::move(args), promise = std::move(promise)]
+                 smc = std::move(smc), args = std::move(args), cache_key = std::move(cache_key),
+                 promise = std::move(promise)]
                 (td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_libraryResult>> r_libraries) mutable
     {
       if (r_libraries.is_error()) {
@@ -4911,15 +5029,42 @@ void TonlibClient::perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::S
         LOG(WARNING) << "cannot obtain library " << hash.to_hex() << ", it may not exist";
         promise.set_value(tonlib_api::make_object<tonlib_api::smc_runResult>(res.gas_used, std::move(res_stack), res.code));
       } else {
-        self->perform_smc_execution(std::move(smc), std::move(args), std::move(promise));
+        self->perform_smc_execution(std::move(smc), std::move(args), std::move(cache_key), std::move(promise));
       }
     });
   }
   else {
+    // Results that depend on a missing library are not cached: the library may be loaded later
+    if (cache_key) {
+      cache_get_method_result(cache_key.value(), res);
+    }
     promise.set_value(tonlib_api::make_object<tonlib_api::smc_runResult>(res.gas_used, std::move(res_stack), res.code));
   }
 }
 
+void TonlibClient::cache_get_method_result(const td::Bits256& cache_key, const ton::SmartContract::Answer& res) {
+  auto r_cell = TRY_VM(serialize_stack(*res.stack));
+  if (r_cell.is_error()) {
+    return;
+  }
+  vm::CellStorageStat stat{1 << 16};
+  auto r_info = TRY_VM(stat.compute_used_storage(r_cell.move_as_ok()));
+  if (r_info.is_error()) {
+    return;
+  }
+  size_t size = sizeof(CachedRunResult) + stat.bits / 8 + stat.cells * 64;
+  get_method_cache_.put(cache_key, CachedRunResult{res.gas_used, res.stack, res.code}, size);
+}
+
+td::Status TonlibClient::do_request(const tonlib_api::cache_getStats& request,
+                                    td::Promise<object_ptr<tonlib_api::cache_stats>>&& promise) {
+  promise.set_value(tonlib_api::make_object<tonlib_api::cache_stats>(
+      account_state_cache_.hits(), account_state_cache_.misses(), account_state_cache_.count(),
+      get_method_cache_.hits(), get_method_cache_.misses(), get_method_cache_.count(),
+      account_state_cache_.size() + get_method_cache_.size()));
+  return td::Status::OK();
+}
+
 td::Result<tonlib_api::object_ptr<tonlib_api::dns_EntryData>> to_tonlib_api(
     const ton::ManualDns::EntryData& entry_data) {
   td::Result<tonlib_api::object_ptr<tonlib_api::dns_EntryData>> res;
@@ -5388,21 +5533,58 @@ tonlib_api::object_ptr<tonlib_api::Object> TonlibClient::do_static_request(
 
 td::Status TonlibClient::do_request(int_api::GetAccountState request,
                                     td::Promise<td::unique_ptr<AccountState>>&& promise) {
+  if (!request.block_id) {
+    // The cache is keyed by block, so the last block is resolved before the lookup
+    client_.with_last_block([self = this, request = std::move(request),
+                             promise = std::move(promise)](td::Result<LastBlockState> r_last_block) mutable {
+      TRY_RESULT_PROMISE(promise, last_block, std::move(r_last_block));
+      request.block_id = std::move(last_block.last_block_id);
+      self->make_request(std::move(request), std::move(promise));
+    });
+    return td::Status::OK();
+  }
+  auto make_account_state = [address = request.address, wallet_id = wallet_id_,
+                             o_public_key = std::move(request.public_key)](RawAccountState&& state) mutable {
+    auto res = td::make_unique<AccountState>(std::move(address), std::move(state), wallet_id);
+    if (false && o_public_key) {
+      res->guess_type_by_public_key(o_public_key.value());
+    }
+    return res;
+  };
+  auto cached = account_state_cache_.get({request.block_id.value(), request.address.workchain, request.address.addr});
+  if (cached) {
+    promise.set_value(make_account_state(RawAccountState(**cached)));
+    return td::Status::OK();
+  }
+
   auto actor_id = actor_id_++;
   actors_[actor_id] = td::actor::create_actor<GetRawAccountState>(
       "GetAccountState", client_.get_client(), request.address, std::move(request.block_id),
       actor_shared(this, actor_id),
-      promise.wrap([address = request.address, wallet_id = wallet_id_,
-                    o_public_key = std::move(request.public_key)](auto&& state) mutable {
-        auto res = td::make_unique<AccountState>(std::move(address), std::move(state), wallet_id);
-        if (false && o_public_key) {
-          res->guess_type_by_public_key(o_public_key.value());
-        }
-        return res;
-      }));
+      [SelfId = td::actor::actor_id(this), address = request.address,
+       make_account_state = std::move(make_account_state),
+       promise = std::move(promise)](td::Result<RawAccountState> r_state) mutable {
+        TRY_RESULT_PROMISE(promise, state, std::move(r_state));
+        td::actor::send_closure(SelfId, &TonlibClient::cache_account_state, std::move(address),
+                                std::make_shared<const RawAccountState>(state));
+        promise.set_value(make_account_state(std::move(state)));
+      });
   return td::Status::OK();
 }
 
+void TonlibClient::cache_account_state(block::StdAddress address, std::shared_ptr<const RawAccountState> state) {
+  // The cached state holds the whole received account cell tree, code and data point into it. On-chain storage stats
+  // are not used: they don't count pruned branches and cells of the account that are shared with other accounts
+  vm::CellStorageStat stat;
+  if (state->info.true_root.not_null()) {
+    stat.add_used_storage(state->info.true_root).ignore();
+  }
+  size_t size = sizeof(RawAccountState) + state->frozen_hash.size() + stat.bits / 8 +
+                stat.cells * (sizeof(vm::DataCell) + 64);
+  AccountStateCacheKey key{state->block_id, address.workchain, address.addr};
+  account_state_cache_.put(std::move(key), std::move(state), size);
+}
+
 td::Status TonlibClient::do_request(int_api::GetAccountStateByTransaction request,
                                     td::Promise<td::unique_ptr<AccountState>>&& promise) {
   auto actor_id = actor_id_++;
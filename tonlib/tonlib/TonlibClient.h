@@ -26,6 +26,7 @@
 #include "tonlib/KeyStorage.h"
 #include "tonlib/KeyValue.h"
 #include "tonlib/LastBlockStorage.h"
+#include "tonlib/StateCache.h"
 
 #include "td/actor/actor.h"
 
@@ -36,6 +37,7 @@
 #include "lite-client/ext-client.h"
 
 #include <map>
+#include <tuple>
 
 namespace tonlib {
 namespace int_api {
@@ -53,12 +55,17 @@ inline std::string to_string(const int_api::SendMessage&) {
 }
 }  // namespace int_api
 class AccountState;
+struct RawAccountState;
 class Query;
 class RunEmulator;
+class TransactionStream;
 
 td::Result<tonlib_api::object_ptr<tonlib_api::dns_EntryData>> to_tonlib_api(
     const ton::ManualDns::EntryData& entry_data);
 td::Result<ton::ManualDns::EntryData> to_dns_entry_data(tonlib_api::dns_EntryData& entry_data);
+// Key of a cached get-method result, empty if the result can't be cached
+td::optional<td::Bits256> get_method_cache_key(const ton::SmartContract::State& state,
+                                               const ton::SmartContract::Args& args);
 
 class TonlibClient : public td::actor::Actor {
  public:
@@ -113,6 +120,18 @@ class TonlibClient : public td::actor::Actor {
   QueryContext query_context_;
   vm::Dictionary libraries{256};
 
+  // Proven account states and get-method results, dropped when a new masterchain block becomes the last one
+  static constexpr size_t ACCOUNT_STATE_CACHE_SIZE = 64 << 20;
+  static constexpr size_t GET_METHOD_CACHE_SIZE = 16 << 20;
+  struct CachedRunResult {
+    td::int64 gas_used;
+    td::Ref<vm::Stack> stack;
+    td::int32 exit_code;
+  };
+  StateCache<AccountStateCacheKey, std::shared_ptr<const RawAccountState>> account_state_cache_{
+      ACCOUNT_STATE_CACHE_SIZE};
+  StateCache<td::Bits256, CachedRunResult> get_method_cache_{GET_METHOD_CACHE_SIZE};
+
   // network
   td::actor::ActorOwn<liteclient::ExtClient> raw_client_;
   td::actor::ActorId<ExtClientOutbound> ext_client_outbound_;
@@ -245,6 +264,15 @@ class TonlibClient : public td::actor::Actor {
   td::Status do_request(tonlib_api::raw_getTransactionsV2& request,
                         td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise);
 
+  td::int64 next_transaction_stream_id_{0};
+  std::map<td::int64, td::actor::ActorOwn<TransactionStream>> transaction_streams_;
+  td::Status do_request(const tonlib_api::raw_openTransactionStream& request,
+                        td::Promise<object_ptr<tonlib_api::raw_transactionStream>>&& promise);
+  td::Status do_request(const tonlib_api::raw_readTransactionStream& request,
+                        td::Promise<object_ptr<tonlib_api::raw_transactions>>&& promise);
+  td::Status do_request(const tonlib_api::raw_closeTransactionStream& request,
+                        td::Promise<object_ptr<tonlib_api::ok>>&& promise);
+
   td::Status do_request(const tonlib_api::getAccountState& request,
                         td::Promise<object_ptr<tonlib_api::fullAccountState>>&& promise);
   td::Status do_request(const tonlib_api::getAccountStateByTransaction& request,
@@ -352,7 +380,9 @@ class TonlibClient : public td::actor::Actor {
   void process_new_libraries(
       td::Result<ton::lite_api::object_ptr<ton::lite_api::liteServer_libraryResult>> r_libraries);
   void perform_smc_execution(td::Ref<ton::SmartContract> smc, ton::SmartContract::Args args,
+                             td::optional<td::Bits256> cache_key,
                              td::Promise<object_ptr<tonlib_api::smc_runResult>>&& promise);
+  void cache_get_method_result(const td::Bits256& cache_key, const ton::SmartContract::Answer& res);
 
   void do_dns_request(std::string name, td::Bits256 category, td::int32 ttl, td::optional<ton::BlockIdExt> block_id,
                       block::StdAddress address, td::Promise<object_ptr<tonlib_api::dns_resolved>>&& promise);
@@ -365,6 +395,7 @@ class TonlibClient : public td::actor::Actor {
                           td::Promise<object_ptr<tonlib_api::dns_resolved>>&& promise);
 
   td::Status do_request(int_api::GetAccountState request, td::Promise<td::unique_ptr<AccountState>>&&);
+  void cache_account_state(block::StdAddress address, std::shared_ptr<const RawAccountState> state);
   td::Status do_request(int_api::GetAccountStateByTransaction request, td::Promise<td::unique_ptr<AccountState>>&&);
   td::Status do_request(int_api::GetPrivateKey request, td::Promise<KeyStorage::PrivateKey>&&);
   td::Status do_request(int_api::GetDnsResolver request, td::Promise<block::StdAddress>&&);
@@ -375,6 +406,9 @@ class TonlibClient : public td::actor::Actor {
   td::Status do_request(const tonlib_api::liteServer_getInfo& request,
                         td::Promise<object_ptr<tonlib_api::liteServer_info>>&& promise);
 
+  td::Status do_request(const tonlib_api::cache_getStats& request,
+                        td::Promise<object_ptr<tonlib_api::cache_stats>>&& promise);
+
   td::Status do_request(tonlib_api::withBlock& request, td::Promise<object_ptr<tonlib_api::Object>>&& promise);
 
   td::Status do_request(const tonlib_api::blocks_getMasterchainInfo& masterchain_info,
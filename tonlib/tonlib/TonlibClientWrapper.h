@@ -40,8 +40,11 @@ class TonlibClientWrapper : public td::actor::Actor {
   void send_request(tonlib_api::object_ptr<F> obj, td::Promise<typename F::ReturnType> promise) {
     auto id = next_request_id_++;
     auto P = promise.wrap([](tonlib_api::object_ptr<tonlib_api::Object> x) -> td::Result<typename F::ReturnType> {
-      if (x->get_id() != F::ReturnType::element_type::ID) {
-        return td::Status::Error("Invalid response from tonlib");
+      // withBlock can return any object, the caller checks the type
+      if constexpr (!std::is_same<typename F::ReturnType::element_type, tonlib_api::Object>::value) {
+        if (x->get_id() != F::ReturnType::element_type::ID) {
+          return td::Status::Error("Invalid response from tonlib");
+        }
       }
       return ton::move_tl_object_as<typename F::ReturnType::element_type>(std::move(x));
     });
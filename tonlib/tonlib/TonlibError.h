@@ -75,6 +75,9 @@ struct TonlibError {
   static td::Status InvalidSmcId() {
     return td::Status::Error(400, "INVALID_SMC_ID");
   }
+  static td::Status InvalidTransactionStreamId() {
+    return td::Status::Error(400, "INVALID_TRANSACTION_STREAM_ID");
+  }
   static td::Status InvalidConfig(td::Slice reason) {
     return td::Status::Error(400, PSLICE() << "INVALID_CONFIG: " << reason);
   }
@@ -0,0 +1,302 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "tonlib/TransactionStream.h"
+
+#include "tonlib/LastBlock.h"
+#include "tonlib/LastConfig.h"
+#include "tonlib/TonlibError.h"
+#include "tonlib/utils.h"
+
+#include "auto/tl/lite_api.hpp"
+#include "ton/lite-tl.hpp"
+#include "ton/ton-shard.h"
+#include "vm/excno.hpp"
+
+namespace tonlib {
+
+// Defined in TonlibClient.cpp next to blocks.lookupBlock, which checks its proofs the same way
+td::Status check_lookup_block_proof(ton::tl_object_ptr<ton::lite_api::liteServer_lookupBlockResult>& result, int mode,
+                                    ton::BlockId blkid, ton::BlockIdExt client_mc_blkid, td::uint64 lt,
+                                    td::uint32 utime);
+
+TransactionStream::TransactionStream(ExtClientRef ext_client_ref, block::StdAddress address, ton::LogicalTime lt,
+                                     ton::Bits256 hash, ton::LogicalTime to_lt, td::int32 parallelism)
+    : address_(std::move(address)), to_lt_(to_lt), parallelism_(td::clamp(parallelism, 1, MAX_PARALLELISM)) {
+  client_.set_client(ext_client_ref);
+  anchors_.push_back(TransactionId{lt, hash});
+}
+
+void TransactionStream::read(td::int32 count, td::Promise<block::TransactionList::Info> promise) {
+  if (status_.is_error()) {
+    promise.set_error(status_.clone());
+    return;
+  }
+  reads_.push_back(
+      Read{static_cast<size_t>(td::clamp(count, 1, static_cast<td::int32>(MAX_BUFFERED))), std::move(promise)});
+  serve_reads();
+}
+
+void TransactionStream::start_up() {
+  auto from_lt = anchors_[0].lt;
+  if (parallelism_ == 1 || from_lt <= to_lt_ || from_lt - to_lt_ < static_cast<ton::LogicalTime>(parallelism_)) {
+    start_chains();
+    return;
+  }
+  pending_anchors_ = parallelism_ - 1;
+  find_anchors();
+}
+
+std::vector<ton::LogicalTime> TransactionStream::split_points() const {
+  std::vector<ton::LogicalTime> res;
+  auto step = (anchors_[0].lt - to_lt_) / parallelism_;
+  for (td::int32 i = 1; i < parallelism_; i++) {
+    res.push_back(to_lt_ + step * i);
+  }
+  return res;
+}
+
+void TransactionStream::find_anchors() {
+  client_.with_last_block([self = this](td::Result<LastBlockState> r_last_block) {
+    if (r_last_block.is_error()) {
+      self->fail(r_last_block.move_as_error_prefix(TonlibError::Internal("get last block failed ")));
+      return;
+    }
+    self->lookup_anchors(r_last_block.ok().last_block_id);
+  });
+}
+
+void TransactionStream::lookup_anchors(ton::BlockIdExt mc_block_id) {
+  auto blkid = ton::BlockId(address_.workchain, ton::shard_prefix(address_.addr, 60), 0);
+  for (auto lt : split_points()) {
+    client_.send_query(
+        ton::lite_api::liteServer_lookupBlockWithProof(2, ton::create_tl_lite_block_id_simple(blkid),
+                                                       ton::create_tl_lite_block_id(mc_block_id), lt, 0),
+        [self = this, blkid, mc_block_id, lt](auto r_result) {
+          self->with_anchor_block(blkid, mc_block_id, lt, std::move(r_result));
+        });
+  }
+}
+
+void TransactionStream::with_anchor_block(
+    ton::BlockId blkid, ton::BlockIdExt mc_block_id, ton::LogicalTime lt,
+    td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_lookupBlockResult>> r_result) {
+  auto r_block_id = [&]() -> td::Result<ton::BlockIdExt> {
+    TRY_RESULT(result, std::move(r_result));
+    TRY_STATUS(check_lookup_block_proof(result, 2, blkid, mc_block_id, lt, 0));
+    return ton::create_block_id(result->id_);
+  }();
+  if (r_block_id.is_error()) {
+    LOG(INFO) << "cannot find block with lt " << lt << " for " << address_ << ": " << r_block_id.error();
+    got_anchor({});
+    return;
+  }
+  auto block_id = r_block_id.move_as_ok();
+  client_.send_query(
+      ton::lite_api::liteServer_getAccountState(
+          ton::create_tl_lite_block_id(block_id),
+          ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr)),
+      [self = this, block_id](auto r_state) { self->with_anchor_state(block_id, std::move(r_state)); });
+}
+
+void TransactionStream::with_anchor_state(
+    ton::BlockIdExt block_id, td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountState>> r_state) {
+  auto r_info = [&]() -> td::Result<block::AccountState::Info> {
+    TRY_RESULT(state, std::move(r_state));
+    block::AccountState account_state;
+    account_state.blk = ton::create_block_id(state->id_);
+    account_state.shard_blk = ton::create_block_id(state->shardblk_);
+    account_state.shard_proof = std::move(state->shard_proof_);
+    account_state.proof = std::move(state->proof_);
+    account_state.state = std::move(state->state_);
+    TRY_RESULT(info, TRY_VM(account_state.validate(block_id, address_)));
+    return std::move(info);
+  }();
+  if (r_info.is_error()) {
+    LOG(INFO) << "cannot get state of " << address_ << " in block " << block_id.to_str() << ": " << r_info.error();
+    got_anchor({});
+    return;
+  }
+  auto info = r_info.move_as_ok();
+  if (info.last_trans_lt == 0) {
+    got_anchor({});
+    return;
+  }
+  got_anchor(TransactionId{info.last_trans_lt, info.last_trans_hash});
+}
+
+void TransactionStream::got_anchor(td::optional<TransactionId> anchor) {
+  if (anchor) {
+    anchors_.push_back(anchor.unwrap());
+  }
+  CHECK(pending_anchors_ > 0);
+  if (--pending_anchors_ == 0 && status_.is_ok()) {
+    start_chains();
+  }
+}
+
+void TransactionStream::start_chains() {
+  std::sort(anchors_.begin() + 1, anchors_.end(),
+            [](const TransactionId& a, const TransactionId& b) { return a.lt > b.lt; });
+  std::vector<TransactionId> anchors{anchors_[0]};
+  for (size_t i = 1; i < anchors_.size(); i++) {
+    if (anchors_[i].lt < anchors.back().lt && anchors_[i].lt >= to_lt_) {
+      anchors.push_back(anchors_[i]);
+    }
+  }
+  anchors_.clear();
+  for (size_t i = 0; i < anchors.size(); i++) {
+    Chain chain;
+    chain.next = anchors[i];
+    chain.last = i + 1 == anchors.size();
+    if (!chain.last) {
+      chain.stop = anchors[i + 1];
+    }
+    chain.done = chain.last && is_chain_end(chain).move_as_ok();
+    chains_.push_back(std::move(chain));
+  }
+  VLOG(lite_server) << "reading transactions of " << address_ << " in " << chains_.size() << " chains";
+  started_ = true;
+  serve_reads();
+}
+
+td::Result<bool> TransactionStream::is_chain_end(const Chain& chain) const {
+  if (chain.last) {
+    return chain.next.lt == 0 || chain.next.lt < to_lt_;
+  }
+  if (chain.next.lt > chain.stop.lt) {
+    return false;
+  }
+  if (chain.next.lt < chain.stop.lt || chain.next.hash != chain.stop.hash) {
+    return td::Status::Error(PSLICE() << "transaction chain of " << address_
+                                      << " doesn't reach proven transaction with lt " << chain.stop.lt);
+  }
+  return true;
+}
+
+void TransactionStream::fetch() {
+  for (size_t i = head_; i < chains_.size(); i++) {
+    auto& chain = chains_[i];
+    if (chain.done || chain.in_flight) {
+      continue;
+    }
+    if (buffered_ >= MAX_BUFFERED && (i != head_ || !chain.ready.empty())) {
+      continue;
+    }
+    chain.in_flight = true;
+    client_.send_query(
+        ton::lite_api::liteServer_getTransactions(
+            FETCH_COUNT, ton::create_tl_object<ton::lite_api::liteServer_accountId>(address_.workchain, address_.addr),
+            chain.next.lt, chain.next.hash),
+        [self = this, i](auto r_transactions) { self->with_transactions(i, std::move(r_transactions)); });
+  }
+}
+
+void TransactionStream::with_transactions(
+    size_t i, td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions) {
+  if (status_.is_error()) {
+    return;
+  }
+  auto& chain = chains_[i];
+  chain.in_flight = false;
+  auto status = do_with_transactions(chain, std::move(r_transactions));
+  if (status.is_error()) {
+    fail(std::move(status));
+    return;
+  }
+  serve_reads();
+}
+
+td::Status TransactionStream::do_with_transactions(
+    Chain& chain, td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions) {
+  TRY_RESULT(transactions, std::move(r_transactions));
+  block::TransactionList list;
+  for (auto& id : transactions->ids_) {
+    list.blkids.push_back(ton::create_block_id(std::move(id)));
+  }
+  list.lt = chain.next.lt;
+  list.hash = chain.next.hash;
+  list.transactions_boc = std::move(transactions->transactions_);
+  TRY_RESULT_PREFIX(info, TRY_VM(list.validate()), TonlibError::ValidateTransactions());
+  for (auto& transaction : info.transactions) {
+    TransactionId prev{transaction.prev_trans_lt, transaction.prev_trans_hash};
+    chain.ready.push_back(Transaction{chain.next, std::move(transaction)});
+    buffered_++;
+    chain.next = prev;
+    TRY_RESULT(done, is_chain_end(chain));
+    if (done) {
+      chain.done = true;
+      break;
+    }
+  }
+  return td::Status::OK();
+}
+
+void TransactionStream::serve_reads() {
+  if (!started_ || status_.is_error()) {
+    return;
+  }
+  while (!reads_.empty()) {
+    auto& read = reads_.front();
+    block::TransactionList::Info res;
+    res.lt = 0;
+    res.hash.set_zero();
+    while (res.transactions.size() < read.count && head_ < chains_.size()) {
+      auto& chain = chains_[head_];
+      if (chain.ready.empty()) {
+        if (!chain.done) {
+          break;
+        }
+        head_++;
+        continue;
+      }
+      auto& transaction = chain.ready.front();
+      if (res.transactions.empty()) {
+        res.lt = transaction.id.lt;
+        res.hash = transaction.id.hash;
+      }
+      res.transactions.push_back(std::move(transaction.info));
+      chain.ready.pop_front();
+      buffered_--;
+    }
+    if (res.transactions.empty() && head_ < chains_.size()) {
+      break;
+    }
+    read.promise.set_value(std::move(res));
+    reads_.pop_front();
+  }
+  fetch();
+}
+
+void TransactionStream::fail(td::Status status) {
+  status_ = std::move(status);
+  for (auto& read : reads_) {
+    read.promise.set_error(status_.clone());
+  }
+  reads_.clear();
+  for (auto& chain : chains_) {
+    chain.ready.clear();
+  }
+  buffered_ = 0;
+}
+
+void TransactionStream::hangup() {
+  if (status_.is_ok()) {
+    fail(TonlibError::Cancelled());
+  }
+  stop();
+}
+}  // namespace tonlib
@@ -0,0 +1,110 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "tonlib/ExtClient.h"
+
+#include "block/block.h"
+#include "block/check-proof.h"
+
+#include "td/actor/actor.h"
+#include "td/utils/optional.h"
+
+#include <deque>
+
+namespace tonlib {
+// Reads the history of an account from a given transaction down to to_lt, walking several parts of it in parallel.
+// The lt range is split at blocks found with lookupBlockWithProof, and the proven state of the account in each of
+// them gives a transaction of the account to start a chain from. Every chain is walked with getTransactions until it
+// reaches the start of the next chain exactly, so one block proof per split point is enough for all hops of a chain.
+// Transactions are returned in descending lt order; chains ahead of the one being read stop fetching while too many
+// transactions are buffered.
+class TransactionStream : public td::actor::Actor {
+ public:
+  static constexpr td::int32 MAX_PARALLELISM = 16;
+  static constexpr td::int32 FETCH_COUNT = 16;
+  static constexpr size_t MAX_BUFFERED = 1024;
+
+  struct TransactionId {
+    ton::LogicalTime lt;
+    ton::Bits256 hash;
+  };
+
+  TransactionStream(ExtClientRef ext_client_ref, block::StdAddress address, ton::LogicalTime lt, ton::Bits256 hash,
+                    ton::LogicalTime to_lt, td::int32 parallelism);
+
+  // Returns up to count next transactions, or no transactions when the stream is over
+  void read(td::int32 count, td::Promise<block::TransactionList::Info> promise);
+
+ protected:
+  // Finds a transaction to start a chain from for each of split_points() and passes it to got_anchor,
+  // or passes nothing if the split point can't be resolved. Tests replace it to do without block proofs
+  virtual void find_anchors();
+  std::vector<ton::LogicalTime> split_points() const;
+  void got_anchor(td::optional<TransactionId> anchor);
+
+ private:
+  struct Transaction {
+    TransactionId id;
+    block::Transaction::Info info;
+  };
+  struct Chain {
+    TransactionId next;
+    TransactionId stop;
+    bool last{false};
+    bool in_flight{false};
+    bool done{false};
+    std::deque<Transaction> ready;
+  };
+  struct Read {
+    size_t count;
+    td::Promise<block::TransactionList::Info> promise;
+  };
+
+  block::StdAddress address_;
+  ton::LogicalTime to_lt_;
+  td::int32 parallelism_;
+  ExtClient client_;
+
+  std::vector<TransactionId> anchors_;
+  size_t pending_anchors_{0};
+  bool started_{false};
+  std::vector<Chain> chains_;
+  size_t head_{0};
+  size_t buffered_{0};
+  std::deque<Read> reads_;
+  td::Status status_;
+
+  void start_up() override;
+  void hangup() override;
+
+  void lookup_anchors(ton::BlockIdExt mc_block_id);
+  void with_anchor_block(ton::BlockId blkid, ton::BlockIdExt mc_block_id, ton::LogicalTime lt,
+                         td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_lookupBlockResult>> r_result);
+  void with_anchor_state(ton::BlockIdExt block_id,
+                         td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_accountState>> r_state);
+  void start_chains();
+  td::Result<bool> is_chain_end(const Chain& chain) const;
+  void fetch();
+  void with_transactions(size_t i,
+                         td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions);
+  td::Status do_with_transactions(
+      Chain& chain, td::Result<ton::tl_object_ptr<ton::lite_api::liteServer_transactionList>> r_transactions);
+  void serve_reads();
+  void fail(td::Status status);
+};
+}  // namespace tonlib
@@ -1559,6 +1559,50 @@ td::Status GetAdnlStatsQuery::receive(td::BufferSlice data) {
   return td::Status::OK();
 }
 
+td::Status GetAdnlDecryptionStatsQuery::run() {
+  TRY_STATUS(tokenizer_.check_endl());
+  return td::Status::OK();
+}
+
+td::Status GetAdnlDecryptionStatsQuery::send() {
+  auto b = ton::create_serialize_tl_object<ton::ton_api::engine_validator_getAdnlDecryptionStats>();
+  td::actor::send_closure(console_, &ValidatorEngineConsole::envelope_send_query, std::move(b), create_promise());
+  return td::Status::OK();
+}
+
+td::Status GetAdnlDecryptionStatsQuery::receive(td::BufferSlice data) {
+  TRY_RESULT_PREFIX(stats, ton::fetch_tl_object<ton::ton_api::adnl_decryptionStats>(data.as_slice(), true),
+                    "received incorrect answer: ");
+  td::StringBuilder sb;
+  sb << "=========================== ADNL DECRYPTION STATS ============================\n";
+  auto print_decryption = [&](const std::string &name,
+                              const ton::tl_object_ptr<ton::ton_api::adnl_stats_decryption> &obj) {
+    if (obj->decrypted_total_ == 0) {
+      return;
+    }
+    double duration = obj->ts_end_ - obj->ts_start_;
+    double rate = duration > 0.0 ? (double)obj->decrypted_total_ / duration : 0.0;
+    sb << "  " << name << ": " << td::StringBuilder::FixedDouble(rate, 1) << " packets/s, decrypt avg="
+       << td::format::as_time(obj->decrypt_time_avg_) << " max=" << td::format::as_time(obj->decrypt_time_max_)
+       << ", parse avg=" << td::format::as_time(obj->parse_time_avg_)
+       << " max=" << td::format::as_time(obj->parse_time_max_);
+    if (obj->received_bytes_ > 0) {
+      sb << ", copied " << td::format::as_size(obj->copied_bytes_) << " of "
+         << td::format::as_size(obj->received_bytes_) << " ("
+         << td::StringBuilder::FixedDouble(100.0 * (double)obj->copied_bytes_ / (double)obj->received_bytes_, 1)
+         << "%)";
+    }
+    sb << "\n";
+  };
+  for (auto &local_id : stats->local_ids_) {
+    sb << "LOCAL ID " << local_id->short_id_ << "\n";
+    print_decryption("recent", local_id->recent_);
+    print_decryption("total ", local_id->total_);
+  }
+  td::TerminalIO::out() << sb.as_cslice();
+  return td::Status::OK();
+}
+
 td::Status AddShardQuery::run() {
   TRY_RESULT_ASSIGN(shard_, tokenizer_.get_token<ton::ShardIdFull>());
   TRY_STATUS(tokenizer_.check_endl());
@@ -1400,6 +1400,25 @@ class GetAdnlStatsQuery : public Query {
   bool all_ = false;
 };
 
+class GetAdnlDecryptionStatsQuery : public Query {
+ public:
+  GetAdnlDecryptionStatsQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
+      : Query(console, std::move(tokenizer)) {
+  }
+  td::Status run() override;
+  td::Status send() override;
+  td::Status receive(td::BufferSlice data) override;
+  static std::string get_name() {
+    return "get-adnl-decryption-stats";
+  }
+  static std::string get_help() {
+    return "get-adnl-decryption-stats\tdisplay rate and latency of decryption and parsing of inbound adnl packets";
+  }
+  std::string name() const override {
+    return get_name();
+  }
+};
+
 class AddShardQuery : public Query {
  public:
   AddShardQuery(td::actor::ActorId<ValidatorEngineConsole> console, Tokenizer tokenizer)
@@ -1845,7 +1845,7 @@ void ValidatorEngine::start() {
 }
 
 void ValidatorEngine::start_adnl() {
-  adnl_network_manager_ = ton::adnl::AdnlNetworkManager::create(config_.out_port);
+  adnl_network_manager_ = ton::adnl::AdnlNetworkManager::create(config_.out_port, udp_options_);
   adnl_ = ton::adnl::Adnl::create(db_root_, keyring_.get());
   td::actor::send_closure(adnl_, &ton::adnl::Adnl::register_network_manager, adnl_network_manager_.get());
 
@@ -2623,15 +2623,26 @@ static td::Result<td::Ref<ton::validator::CollatorOptions>> parse_collator_optio
 void ValidatorEngine::load_collator_options() {
   auto r_data = td::read_file(collator_options_file());
   if (r_data.is_error()) {
+    set_collator_options(validator_options_->get_collator_options());
     return;
   }
   td::BufferSlice data = r_data.move_as_ok();
   auto r_collator_options = parse_collator_options(data.as_slice());
   if (r_collator_options.is_error()) {
     LOG(ERROR) << "Failed to read collator options from file: " << r_collator_options.move_as_error();
+    set_collator_options(validator_options_->get_collator_options());
     return;
   }
-  validator_options_.write().set_collator_options(r_collator_options.move_as_ok());
+  set_collator_options(r_collator_options.move_as_ok());
+}
+
+// Prefetch options come from the command line, not from collator-options.json
+void ValidatorEngine::set_collator_options(td::Ref<ton::validator::CollatorOptions> opts) {
+  auto &o = opts.write();
+  o.prefetch_workers = collator_prefetch_workers_;
+  o.prefetch_max_queue_msgs = collator_prefetch_max_queue_msgs_;
+  o.prefetch_timeout = collator_prefetch_timeout_;
+  validator_options_.write().set_collator_options(std::move(opts));
 }
 
 void ValidatorEngine::check_key(ton::PublicKeyHash id, td::Promise<td::Unit> promise) {
@@ -4013,7 +4024,7 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_setCollat
     promise.set_value(create_control_query_error(r_collator_options.move_as_error_prefix("failed to write file: ")));
     return;
   }
-  validator_options_.write().set_collator_options(r_collator_options.move_as_ok());
+  set_collator_options(r_collator_options.move_as_ok());
   td::actor::send_closure(validator_manager_, &ton::validator::ValidatorManagerInterface::update_options,
                           validator_options_);
   promise.set_value(ton::create_serialize_tl_object<ton::ton_api::engine_validator_success>());
@@ -4061,6 +4072,29 @@ void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getAdnlSt
       });
 }
 
+void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_getAdnlDecryptionStats &query,
+                                        td::BufferSlice data, ton::PublicKeyHash src, td::uint32 perm,
+                                        td::Promise<td::BufferSlice> promise) {
+  if (!(perm & ValidatorEnginePermissions::vep_default)) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::error, "not authorized")));
+    return;
+  }
+  if (adnl_.empty()) {
+    promise.set_value(create_control_query_error(td::Status::Error(ton::ErrorCode::notready, "not started")));
+    return;
+  }
+  td::actor::send_closure(
+      adnl_, &ton::adnl::Adnl::get_decryption_stats,
+      [promise = std::move(promise)](td::Result<ton::tl_object_ptr<ton::ton_api::adnl_decryptionStats>> R) mutable {
+        if (R.is_ok()) {
+          promise.set_value(ton::serialize_tl_object(R.move_as_ok(), true));
+        } else {
+          promise.set_value(create_control_query_error(
+              td::Status::Error(ton::ErrorCode::notready, "failed to get adnl decryption stats")));
+        }
+      });
+}
+
 void ValidatorEngine::run_control_query(ton::ton_api::engine_validator_addShard &query,
                                         td::BufferSlice data, ton::PublicKeyHash src, td::uint32 perm,
                                         td::Promise<td::BufferSlice> promise) {
@@ -4546,6 +4580,36 @@ int main(int argc, char *argv[]) {
         acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_catchain_max_block_delay_slow, v); });
         return td::Status::OK();
       });
+  p.add_checked_option(
+      '\0', "collator-prefetch-workers",
+      "number of actors that load accounts used by the collator in parallel with collation (default: 0 - disabled)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+        if (v > 64) {
+          return td::Status::Error("collator-prefetch-workers should be at most 64");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_collator_prefetch_workers, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "collator-prefetch-max-queue-msgs",
+      "max number of messages in each neighbor's queue scanned by the collator prefetcher (default: 4096)",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<td::uint32>(s));
+        acts.push_back(
+            [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_collator_prefetch_max_queue_msgs, v); });
+        return td::Status::OK();
+      });
+  p.add_checked_option(
+      '\0', "collator-prefetch-timeout", "time limit for the collator prefetcher, in seconds (default: 0.2)",
+      [&](td::Slice s) -> td::Status {
+        auto v = td::to_double(s);
+        if (v <= 0) {
+          return td::Status::Error("collator-prefetch-timeout should be positive");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_collator_prefetch_timeout, v); });
+        return td::Status::OK();
+      });
   p.add_option(
       '\0', "fast-state-serializer",
       "faster persistent state serializer, but requires more RAM",
@@ -4608,6 +4672,25 @@ int main(int argc, char *argv[]) {
             [&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_broadcast_speed_multiplier_private, v); });
         return td::Status::OK();
       });
+  p.add_checked_option(
+      '\0', "udp-batch-size",
+      PSTRING() << "max number of UDP packets in one recvmmsg/sendmmsg call (default: 16, max: "
+                << td::UdpSocketFd::MAX_BATCH_SIZE << ")",
+      [&](td::Slice s) -> td::Status {
+        TRY_RESULT(v, td::to_integer_safe<size_t>(s));
+        if (v == 0 || v > td::UdpSocketFd::MAX_BATCH_SIZE) {
+          return td::Status::Error(PSTRING() << "udp-batch-size should be in range [1, "
+                                             << td::UdpSocketFd::MAX_BATCH_SIZE << "]");
+        }
+        acts.push_back([&x, v]() { td::actor::send_closure(x, &ValidatorEngine::set_udp_batch_size, v); });
+        return td::Status::OK();
+      });
+  p.add_option('\0', "udp-gso", "send bursts of UDP packets to the same address as one message (UDP_SEGMENT)", [&]() {
+    acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_udp_gso, true); });
+  });
+  p.add_option('\0', "udp-gro", "enable UDP receive offload (UDP_GRO)", [&]() {
+    acts.push_back([&x]() { td::actor::send_closure(x, &ValidatorEngine::set_udp_gro, true); });
+  });
   auto S = p.run(argc, argv);
   if (S.is_error()) {
     LOG(ERROR) << "failed to parse options: " << S.move_as_error();
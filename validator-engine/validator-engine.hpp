@@ -167,6 +167,7 @@ class ValidatorEngine : public td::actor::Actor {
 
   std::vector<td::IPAddress> addrs_;
   std::vector<td::IPAddress> proxy_addrs_;
+  td::UdpBatchOptions udp_options_;
 
   ton::adnl::AdnlNodesList adnl_static_nodes_;
   std::shared_ptr<ton::dht::DhtGlobalConfig> dht_config_;
@@ -219,6 +220,9 @@ class ValidatorEngine : public td::actor::Actor {
   bool celldb_preload_all_ = false;
   bool celldb_in_memory_ = false;
   td::optional<double> catchain_max_block_delay_, catchain_max_block_delay_slow_;
+  td::uint32 collator_prefetch_workers_ = 0;
+  td::uint32 collator_prefetch_max_queue_msgs_ = 4096;
+  double collator_prefetch_timeout_ = 0.2;
   bool read_config_ = false;
   bool started_keyring_ = false;
   bool started_ = false;
@@ -287,6 +291,15 @@ class ValidatorEngine : public td::actor::Actor {
   void add_ip(td::IPAddress addr) {
     addrs_.push_back(addr);
   }
+  void set_udp_batch_size(size_t value) {
+    udp_options_.batch_size = value;
+  }
+  void set_udp_gso(bool value) {
+    udp_options_.gso = value;
+  }
+  void set_udp_gro(bool value) {
+    udp_options_.gro = value;
+  }
   void add_key_to_set(ton::PublicKey key) {
     keys_[key.compute_short_id()] = key;
   }
@@ -324,6 +337,15 @@ class ValidatorEngine : public td::actor::Actor {
   void set_catchain_max_block_delay_slow(double value) {
     catchain_max_block_delay_slow_ = value;
   }
+  void set_collator_prefetch_workers(td::uint32 value) {
+    collator_prefetch_workers_ = value;
+  }
+  void set_collator_prefetch_max_queue_msgs(td::uint32 value) {
+    collator_prefetch_max_queue_msgs_ = value;
+  }
+  void set_collator_prefetch_timeout(double value) {
+    collator_prefetch_timeout_ = value;
+  }
   void set_fast_state_serializer_enabled(bool value) {
     fast_state_serializer_enabled_ = value;
   }
@@ -445,6 +467,7 @@ class ValidatorEngine : public td::actor::Actor {
       ton::tl_object_ptr<ton::ton_api::engine_validator_customOverlay> overlay, td::Promise<td::Unit> promise);
   void del_custom_overlay_from_config(std::string name, td::Promise<td::Unit> promise);
   void load_collator_options();
+  void set_collator_options(td::Ref<ton::validator::CollatorOptions> opts);
 
   void check_key(ton::PublicKeyHash id, td::Promise<td::Unit> promise);
 
@@ -546,6 +569,8 @@ class ValidatorEngine : public td::actor::Actor {
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   void run_control_query(ton::ton_api::engine_validator_getAdnlStats &query, td::BufferSlice data,
                          ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
+  void run_control_query(ton::ton_api::engine_validator_getAdnlDecryptionStats &query, td::BufferSlice data,
+                         ton::PublicKeyHash src, td::uint32 perm, td::Promise<td::BufferSlice> promise);
   template <class T>
   void run_control_query(T &query, td::BufferSlice data, ton::PublicKeyHash src, td::uint32 perm,
                          td::Promise<td::BufferSlice> promise) {
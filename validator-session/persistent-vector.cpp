@@ -26,35 +26,20 @@ namespace ton {
 
 namespace validatorsession {
 
-HashType get_vector_hash(ValidatorSessionDescription& desc, std::vector<HashType>&& value) {
-  std::vector<td::int32> v;
-  v.resize(value.size());
-  for (size_t i = 0; i < v.size(); i++) {
-    v[i] = value[i];
-  }
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_vector>(std::move(v));
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
-}
-
 HashType get_vs_hash(ValidatorSessionDescription& desc, const td::uint32& value) {
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_int32>(value);
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+  return get_tl_hash<ton_api::hashable_int32>(desc, value);
 }
 HashType get_vs_hash(ValidatorSessionDescription& desc, const td::Bits256& value) {
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_int256>(value);
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+  return get_tl_hash<ton_api::hashable_int256>(desc, value);
 }
 HashType get_vs_hash(ValidatorSessionDescription& desc, const td::uint64& value) {
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_int64>(value);
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+  return get_tl_hash<ton_api::hashable_int64>(desc, value);
 }
 HashType get_vs_hash(ValidatorSessionDescription& desc, const bool& value) {
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_bool>(value);
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+  return get_tl_hash<ton_api::hashable_bool>(desc, value);
 }
 HashType get_vs_hash(ValidatorSessionDescription& desc, const td::BufferSlice& value) {
-  auto obj = ton::create_tl_object<ton::ton_api::hashable_bytes>(value.clone());
-  return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+  return get_tl_hash<ton_api::hashable_bytes>(desc, value.clone());
 }
 
 }  // namespace validatorsession
@@ -22,6 +22,7 @@
 
 #include "td/utils/int_types.h"
 #include "td/utils/buffer.h"
+#include "td/utils/tl_storers.h"
 
 #include "adnl/utils.hpp"
 
@@ -43,7 +44,43 @@ inline HashType get_vs_hash(ValidatorSessionDescription& desc, const T* value) {
   return value ? value->get_hash(desc) : desc.zero_hash();
 }
 
-HashType get_vector_hash(ValidatorSessionDescription& desc, std::vector<HashType>&& value);
+// Hash of a hashable.* TL object, the same as desc.compute_hash(serialize_tl_object(obj, true)).
+// The object is built on the stack and serialized into a stack buffer, so hashing does not touch the heap
+template <class T, class... Args>
+inline HashType get_tl_hash(ValidatorSessionDescription& desc, Args&&... args) {
+  const T obj(std::forward<Args>(args)...);
+  td::TlStorerCalcLength calc;
+  obj.store(calc);
+  size_t len = calc.get_length() + 4;
+  alignas(8) td::uint8 buf[64];
+  if (len > sizeof(buf)) {
+    return desc.compute_hash(serialize_tl_object(&obj, true).as_slice());
+  }
+  td::TlStorerUnsafe storer(buf);
+  storer.store_binary(T::ID);
+  obj.store(storer);
+  return desc.compute_hash(td::Slice(buf, len));
+}
+
+// Hash of hashable.vector with elements element_hash(0), ..., element_hash(size - 1).
+// The serialized vector is written directly to a buffer, which is on the stack for vectors of realistic sizes
+template <class F>
+inline HashType get_vector_hash(ValidatorSessionDescription& desc, size_t size, F&& element_hash) {
+  constexpr size_t static_size = 1024;
+  td::uint32 static_buf[static_size];
+  std::unique_ptr<td::uint32[]> dynamic_buf;
+  td::uint32* buf = static_buf;
+  if (size + 2 > static_size) {
+    dynamic_buf = std::make_unique<td::uint32[]>(size + 2);
+    buf = dynamic_buf.get();
+  }
+  buf[0] = static_cast<td::uint32>(ton_api::hashable_vector::ID);
+  buf[1] = static_cast<td::uint32>(size);
+  for (size_t i = 0; i < size; i++) {
+    buf[i + 2] = element_hash(i);
+  }
+  return desc.compute_hash(td::Slice(reinterpret_cast<const td::uint8*>(buf), (size + 2) * 4));
+}
 HashType get_pair_hash(ValidatorSessionDescription& desc, const HashType& left, const HashType& right);
 
 HashType get_vs_hash(ValidatorSessionDescription& desc, const bool& value);
@@ -59,31 +96,18 @@ inline HashType get_vs_hash(ValidatorSessionDescription& desc, const std::pair<T
 
 template <typename T>
 inline HashType get_vs_hash(ValidatorSessionDescription& desc, const std::vector<T>& value) {
-  std::vector<HashType> v;
-  v.resize(value.size());
-  for (size_t i = 0; i < value.size(); i++) {
-    v[i] = get_vs_hash(desc, value[i]);
-  }
-  return get_vector_hash(desc, std::move(v));
+  return get_vector_hash(desc, value.size(), [&](size_t i) { return get_vs_hash(desc, value[i]); });
 }
 inline HashType get_vs_hash(ValidatorSessionDescription& desc, const std::vector<bool>& value) {
-  std::vector<HashType> v;
-  v.resize(value.size());
-  for (size_t i = 0; i < value.size(); i++) {
+  return get_vector_hash(desc, value.size(), [&](size_t i) {
     bool b = value[i];
-    v[i] = get_vs_hash(desc, b);
-  }
-  return get_vector_hash(desc, std::move(v));
+    return get_vs_hash(desc, b);
+  });
 }
 
 template <typename T>
 inline HashType get_vs_hash(ValidatorSessionDescription& desc, td::uint32 size, const T* value) {
-  std::vector<HashType> v;
-  v.resize(size);
-  for (size_t i = 0; i < size; i++) {
-    v[i] = get_vs_hash(desc, value[i]);
-  }
-  return get_vector_hash(desc, std::move(v));
+  return get_vector_hash(desc, size, [&](size_t i) { return get_vs_hash(desc, value[i]); });
 }
 
 inline bool move_to_persistent(ValidatorSessionDescription& desc, bool v) {
@@ -107,12 +131,10 @@ template <typename T>
 class CntVector : public ValidatorSessionDescription::RootObject {
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, std::vector<T>& value) {
-    auto obj = create_tl_object<ton_api::hashable_cntVector>(get_vs_hash(desc, value));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_cntVector>(desc, get_vs_hash(desc, value));
   }
   static HashType create_hash(ValidatorSessionDescription& desc, td::uint32 size, const T* value) {
-    auto obj = create_tl_object<ton_api::hashable_cntVector>(get_vs_hash(desc, size, value));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_cntVector>(desc, get_vs_hash(desc, size, value));
   }
   static bool compare(const RootObject* r, td::uint32 size, const T* data, HashType hash) {
     if (!r || r->get_size() < sizeof(CntVector)) {
@@ -556,12 +578,10 @@ template <typename T, typename Compare = std::less<T>>
 class CntSortedVector : public ValidatorSessionDescription::RootObject {
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, std::vector<T>& value) {
-    auto obj = create_tl_object<ton_api::hashable_cntSortedVector>(get_vs_hash(desc, value));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_cntSortedVector>(desc, get_vs_hash(desc, value));
   }
   static HashType create_hash(ValidatorSessionDescription& desc, td::uint32 size, const T* value) {
-    auto obj = create_tl_object<ton_api::hashable_cntSortedVector>(get_vs_hash(desc, size, value));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_cntSortedVector>(desc, get_vs_hash(desc, size, value));
   }
   static bool compare(const RootObject* r, td::uint32 size, const T* data, HashType hash) {
     if (!r || r->get_size() < sizeof(CntSortedVector)) {
@@ -50,11 +50,6 @@ ValidatorSessionDescriptionImpl::ValidatorSessionDescriptionImpl(ValidatorSessio
   auto it = rev_sources_.find(local_id);
   CHECK(it != rev_sources_.end());
   self_idx_ = it->second;
-
-  for (auto &el : cache_) {
-    Cached v{nullptr};
-    el.store(v, std::memory_order_relaxed);
-  }
 }
 
 td::int32 ValidatorSessionDescriptionImpl::get_node_priority(td::uint32 src_idx, td::uint32 round) const {
@@ -141,9 +136,7 @@ td::uint32 ValidatorSessionDescriptionImpl::get_vote_for_author(td::uint32 attem
 
 const ValidatorSessionDescription::RootObject *ValidatorSessionDescriptionImpl::get_by_hash(HashType hash,
                                                                                             bool allow_temp) const {
-  auto x = hash % cache_size;
-
-  return cache_[x].load(std::memory_order_relaxed).ptr;
+  return cache_.get(hash);
 }
 
 HashType ValidatorSessionDescriptionImpl::compute_hash(td::Slice data) const {
@@ -154,9 +147,7 @@ void ValidatorSessionDescriptionImpl::update_hash(const RootObject *obj, HashTyp
   if (!is_persistent(obj)) {
     return;
   }
-  auto x = hash % cache_size;
-  Cached p{obj};
-  cache_[x].store(p, std::memory_order_relaxed);
+  cache_.put(obj, hash);
 }
 
 void *ValidatorSessionDescriptionImpl::alloc(size_t size, size_t align, bool temp) {
@@ -172,6 +163,43 @@ std::unique_ptr<ValidatorSessionDescription> ValidatorSessionDescription::create
   return std::make_unique<ValidatorSessionDescriptionImpl>(std::move(opts), nodes, local_id);
 }
 
+ValidatorSessionDescriptionImpl::InternTable::InternTable(size_t size_log)
+    : mask_((size_t(1) << size_log) - 1), slots_(new Slot[size_t(1) << size_log]) {
+}
+
+const ValidatorSessionDescription::RootObject *ValidatorSessionDescriptionImpl::InternTable::get(HashType hash) const {
+  for (size_t i = 0; i < probe_count; i++) {
+    auto &slot = slots_[(hash + i) & mask_];
+    if (slot.hash.load(std::memory_order_relaxed) == hash) {
+      auto ptr = slot.ptr.load(std::memory_order_relaxed);
+      if (ptr) {
+        return ptr;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void ValidatorSessionDescriptionImpl::InternTable::put(const RootObject *obj, HashType hash) {
+  Slot *victim = nullptr;
+  for (size_t i = 0; i < probe_count; i++) {
+    auto &slot = slots_[(hash + i) & mask_];
+    auto ptr = slot.ptr.load(std::memory_order_relaxed);
+    if (ptr && slot.hash.load(std::memory_order_relaxed) == hash) {
+      victim = &slot;
+      break;
+    }
+    if (!ptr && !victim) {
+      victim = &slot;
+    }
+  }
+  if (!victim) {
+    victim = &slots_[(hash + next_victim_++ % probe_count) & mask_];
+  }
+  victim->hash.store(hash, std::memory_order_relaxed);
+  victim->ptr.store(obj, std::memory_order_relaxed);
+}
+
 ValidatorSessionDescriptionImpl::MemPool::MemPool(size_t chunk_size) : chunk_size_(chunk_size) {
 }
 
@@ -184,40 +212,43 @@ ValidatorSessionDescriptionImpl::MemPool::~MemPool() {
 void *ValidatorSessionDescriptionImpl::MemPool::alloc(size_t size, size_t align) {
   CHECK(align && !(align & (align - 1)));  // align should be a power of 2
   CHECK(size + align <= chunk_size_);
-  auto get_padding = [&](const uint8_t* ptr) {
-    return (-(size_t)ptr) & (align - 1);
-  };
   while (true) {
     size_t idx = ptr_ / chunk_size_;
-    if (idx < data_.size()) {
-      auto ptr = data_[idx] + (ptr_ % chunk_size_);
-      ptr_ += get_padding(ptr);
-      ptr += get_padding(ptr);
-      ptr_ += size;
-      if (ptr_ <= data_.size() * chunk_size_) {
-        return static_cast<void *>(ptr);
-      } else {
-        ptr_ = data_.size() * chunk_size_;
-      }
+    if (idx == data_.size()) {
+      data_.push_back(new td::uint8[chunk_size_]);
+      last_used_.push_back(generation_);
+    }
+    size_t offset = ptr_ % chunk_size_;
+    auto ptr = data_[idx] + offset;
+    size_t padding = (-(size_t)ptr) & (align - 1);
+    if (offset + padding + size <= chunk_size_) {
+      last_used_[idx] = generation_;
+      ptr_ += padding + size;
+      return static_cast<void *>(ptr + padding);
     }
-    data_.push_back(new td::uint8[chunk_size_]);
+    ptr_ = (idx + 1) * chunk_size_;
   }
 }
 
 void ValidatorSessionDescriptionImpl::MemPool::clear() {
-  while (data_.size() > 1) {
+  generation_++;
+  ptr_ = 0;
+  // Chunks are always filled in order, so the idle ones are at the end
+  while (data_.size() > 1 &&
+         (data_.size() > max_kept_chunks || generation_ - last_used_.back() > max_idle_generations)) {
     delete[] data_.back();
     data_.pop_back();
+    last_used_.pop_back();
   }
-  ptr_ = 0;
 }
 
 bool ValidatorSessionDescriptionImpl::MemPool::contains(const void* ptr) const {
   if (ptr == nullptr) {
     return true;
   }
-  for (auto &v : data_) {
-    if (ptr >= v && ptr <= v + chunk_size_) {
+  size_t used = std::min(data_.size(), (ptr_ + chunk_size_ - 1) / chunk_size_);
+  for (size_t i = 0; i < used; i++) {
+    if (ptr >= data_[i] && ptr <= data_[i] + chunk_size_) {
       return true;
     }
   }
@@ -49,16 +49,34 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
   ValidatorWeight total_weight_;
   td::uint32 self_idx_;
 
-  static constexpr td::uint32 cache_size = (1 << 20);
+  static constexpr size_t cache_size_log = 20;
   static constexpr size_t mem_chunk_size_perm = (1 << 27);
   static constexpr size_t mem_chunk_size_temp = (1 << 27);
 
-  struct Cached {
-    const RootObject *ptr;
+ public:
+  // Intern table of persistent objects, keyed by their (already computed) hashes.
+  // Open addressing: an object is stored in one of probe_count consecutive slots starting at hash % size.
+  // A slot keeps the hash together with the pointer, so slots of other objects are skipped without reading them.
+  // It is a cache: when all slots are taken, one of them is overwritten.
+  class InternTable {
+   public:
+    explicit InternTable(size_t size_log);
+    const RootObject *get(HashType hash) const;
+    void put(const RootObject *obj, HashType hash);
+
+   private:
+    static constexpr size_t probe_count = 4;
+    struct Slot {
+      std::atomic<HashType> hash{0};
+      std::atomic<const RootObject *> ptr{nullptr};
+    };
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    size_t next_victim_ = 0;
   };
-  std::array<std::atomic<Cached>, cache_size> cache_;
 
- public:
+  // Bump allocator. clear() starts a new generation: all previous allocations are dropped at once,
+  // but chunks are kept for reuse. Chunks that were not used for max_idle_generations are freed.
   class MemPool {
    public:
     explicit MemPool(size_t chunk_size);
@@ -66,14 +84,27 @@ class ValidatorSessionDescriptionImpl : public ValidatorSessionDescription {
     void *alloc(size_t size, size_t align);
     void clear();
     bool contains(const void* ptr) const;
+    td::uint64 generation() const {
+      return generation_;
+    }
+    size_t chunk_count() const {
+      return data_.size();
+    }
 
    private:
+    // Chunks idle for more generations are freed. At most max_kept_chunks chunks survive clear(), so a spike of
+    // temporary allocations does not stay pinned for max_idle_generations
+    static constexpr td::uint64 max_idle_generations = 16;
+    static constexpr size_t max_kept_chunks = 2;
     size_t chunk_size_;
     std::vector<td::uint8 *> data_;
+    std::vector<td::uint64> last_used_;
     size_t ptr_ = 0;
+    td::uint64 generation_ = 0;
   };
 
  private:
+  InternTable cache_ = InternTable(cache_size_log);
   MemPool mem_perm_ = MemPool(mem_chunk_size_perm);
   MemPool mem_temp_ = MemPool(mem_chunk_size_temp);
 
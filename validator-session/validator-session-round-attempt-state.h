@@ -40,8 +40,7 @@ using HashType = ValidatorSessionDescription::HashType;
 struct SessionBlockCandidateSignature : public ValidatorSessionDescription::RootObject {
  public:
   static auto create_hash(ValidatorSessionDescription& desc, td::Slice data) {
-    auto obj = create_tl_object<ton_api::hashable_blockSignature>(desc.compute_hash(data));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_blockSignature>(desc, desc.compute_hash(data));
   }
 
   static bool compare(const RootObject* r, td::Slice data, HashType hash) {
@@ -108,10 +107,9 @@ class SentBlock : public ValidatorSessionDescription::RootObject {
   static HashType create_hash(ValidatorSessionDescription& desc, td::uint32 src_idx, ValidatorSessionRootHash root_hash,
                               ValidatorSessionFileHash file_hash,
                               ValidatorSessionCollatedDataFileHash collated_data_file_hash) {
-    auto obj = create_tl_object<ton_api::hashable_sentBlock>(src_idx, get_vs_hash(desc, root_hash),
-                                                             get_vs_hash(desc, file_hash),
-                                                             get_vs_hash(desc, collated_data_file_hash));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_sentBlock>(desc, src_idx, get_vs_hash(desc, root_hash),
+                                                    get_vs_hash(desc, file_hash),
+                                                    get_vs_hash(desc, collated_data_file_hash));
   }
   static bool compare(const RootObject* root_object, td::uint32 src_idx, const ValidatorSessionRootHash& root_hash,
                       const ValidatorSessionFileHash& file_hash,
@@ -231,8 +229,7 @@ class SentBlock : public ValidatorSessionDescription::RootObject {
 class SessionBlockCandidate : public ValidatorSessionDescription::RootObject {
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, HashType block, HashType approved) {
-    auto obj = create_tl_object<ton_api::hashable_blockCandidate>(block, approved);
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_blockCandidate>(desc, block, approved);
   }
   static bool compare(const RootObject* r, const SentBlock* block, const SessionBlockCandidateSignatureVector* approved,
                       HashType hash) {
@@ -333,8 +330,7 @@ class SessionBlockCandidate : public ValidatorSessionDescription::RootObject {
 class SessionVoteCandidate : public ValidatorSessionDescription::RootObject {
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, HashType block, HashType voted) {
-    auto obj = create_tl_object<ton_api::hashable_blockVoteCandidate>(block, voted);
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_blockVoteCandidate>(desc, block, voted);
   }
   static bool compare(const RootObject* r, const SentBlock* block, const CntVector<bool>* voted, HashType hash) {
     if (!r || r->get_size() < sizeof(SessionVoteCandidate)) {
@@ -438,9 +434,8 @@ class ValidatorSessionRoundAttemptState : public ValidatorSessionDescription::Ro
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, td::uint32 seqno, HashType votes,
                               HashType precommitted, bool vote_for_inited, HashType vote_for) {
-    auto obj = create_tl_object<ton_api::hashable_validatorSessionRoundAttempt>(seqno, votes, precommitted,
-                                                                                vote_for_inited, vote_for);
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_validatorSessionRoundAttempt>(desc, seqno, votes, precommitted,
+                                                                       vote_for_inited, vote_for);
   }
   static bool compare(const RootObject* r, td::uint32 seqno, const VoteVector* votes,
                       const CntVector<bool>* precommitted, const SentBlock* vote_for, bool vote_for_inited,
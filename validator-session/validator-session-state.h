@@ -45,9 +45,8 @@ class ValidatorSessionOldRoundState : public ValidatorSessionDescription::RootOb
  public:
   static HashType create_hash(ValidatorSessionDescription& desc, td::uint32 seqno, HashType block, HashType signatures,
                               HashType approve_signatures) {
-    auto obj =
-        create_tl_object<ton_api::hashable_validatorSessionOldRound>(seqno, block, signatures, approve_signatures);
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_validatorSessionOldRound>(desc, seqno, block, signatures,
+                                                                   approve_signatures);
   }
   static bool compare(const RootObject* r, td::uint32 seqno, const SentBlock* block,
                       const SessionBlockCandidateSignatureVector* signatures,
@@ -186,11 +185,10 @@ class ValidatorSessionRoundState : public ValidatorSessionDescription::RootObjec
                               const CntVector<td::uint32>* last_precommit, const ApproveVector* sent,
                               const CntVector<const SessionBlockCandidateSignature*>* signatures,
                               const AttemptVector* attempts) {
-    auto obj = create_tl_object<ton_api::hashable_validatorSessionRound>(
-        get_vs_hash(desc, precommitted_block), seqno, precommitted, get_vs_hash(desc, first_attempt),
+    return get_tl_hash<ton_api::hashable_validatorSessionRound>(
+        desc, get_vs_hash(desc, precommitted_block), seqno, precommitted, get_vs_hash(desc, first_attempt),
         get_vs_hash(desc, last_precommit), get_vs_hash(desc, sent), get_vs_hash(desc, signatures),
         get_vs_hash(desc, attempts));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
   }
   static bool compare(const RootObject* root_object, const SentBlock* precommitted_block, td::uint32 seqno,
                       bool precommitted, const CntVector<td::uint32>* first_attempt,
@@ -402,9 +400,8 @@ class ValidatorSessionState : public ValidatorSessionDescription::RootObject {
   static HashType create_hash(ValidatorSessionDescription& desc, const CntVector<td::uint32>* att,
                               const CntVector<const ValidatorSessionOldRoundState*>* old_rounds,
                               const ValidatorSessionRoundState* cur_round) {
-    auto obj = create_tl_object<ton_api::hashable_validatorSession>(
-        get_vs_hash(desc, att), get_vs_hash(desc, old_rounds), get_vs_hash(desc, cur_round));
-    return desc.compute_hash(serialize_tl_object(obj, true).as_slice());
+    return get_tl_hash<ton_api::hashable_validatorSession>(desc, get_vs_hash(desc, att), get_vs_hash(desc, old_rounds),
+                                                           get_vs_hash(desc, cur_round));
   }
   static bool compare(const RootObject* r, const CntVector<td::uint32>* att,
                       const CntVector<const ValidatorSessionOldRoundState*>* old_rounds,
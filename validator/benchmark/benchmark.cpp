@@ -0,0 +1,206 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "td/utils/benchmark.h"
+#include "td/utils/format.h"
+#include "td/utils/Random.h"
+
+#include "ext-message-pool.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace {
+
+class BenchExtMessage : public ton::validator::ExtMessage {
+ public:
+  BenchExtMessage(ton::WorkchainId wc, ton::StdSmcAddress addr) : wc_(wc), addr_(addr) {
+    td::Random::secure_bytes(hash_.as_slice());
+  }
+  ton::AccountIdPrefixFull shard() const override {
+    return {wc_, ton::extract_top64(addr_)};
+  }
+  td::BufferSlice serialize() const override {
+    return {};
+  }
+  td::Ref<vm::Cell> root_cell() const override {
+    return {};
+  }
+  Hash hash() const override {
+    return hash_;
+  }
+  ton::WorkchainId wc() const override {
+    return wc_;
+  }
+  ton::StdSmcAddress addr() const override {
+    return addr_;
+  }
+
+ private:
+  ton::WorkchainId wc_;
+  ton::StdSmcAddress addr_;
+  Hash hash_;
+};
+
+std::vector<td::Ref<ton::validator::ExtMessage>> gen_messages(size_t count, size_t accounts) {
+  std::vector<ton::StdSmcAddress> addrs(accounts);
+  for (auto &addr : addrs) {
+    td::Random::secure_bytes(addr.as_slice());
+  }
+  std::vector<td::Ref<ton::validator::ExtMessage>> res;
+  for (size_t i = 0; i < count; ++i) {
+    res.push_back(td::Ref<BenchExtMessage>{true, ton::basechainId, addrs[td::Random::fast(0, (int)accounts - 1)]});
+  }
+  return res;
+}
+
+std::vector<ton::ShardIdFull> gen_shards(int split_depth) {
+  std::vector<ton::ShardIdFull> res;
+  for (ton::ShardId i = 0; i < (1ULL << split_depth); ++i) {
+    res.emplace_back(ton::basechainId, (i * 2 + 1) << (63 - split_depth));
+  }
+  return res;
+}
+
+// Per-priority layout used by ValidatorManagerImpl before ExtMessagePool.
+// select() produces the same result as ExtMessagePool::get_shard_snapshot: accounts in random order, FIFO inside
+// an account, so both benchmarks do the same work.
+class MapMempool {
+ public:
+  bool add(td::Ref<ton::validator::ExtMessage> message) {
+    auto hash = message->hash();
+    if (hashes_.count(hash)) {
+      return false;
+    }
+    Id id{message->shard(), hash};
+    hashes_.emplace(hash, id);
+    messages_.emplace(id, Entry{std::move(message), next_seqno_++});
+    return true;
+  }
+  void erase(const ton::Bits256 &hash) {
+    auto it = hashes_.find(hash);
+    if (it != hashes_.end()) {
+      messages_.erase(it->second);
+      hashes_.erase(it);
+    }
+  }
+  std::vector<std::pair<td::Ref<ton::validator::ExtMessage>, int>> select(ton::ShardIdFull shard,
+                                                                          td::Random::Fast &rnd) {
+    Id left{ton::AccountIdPrefixFull{shard.workchain, shard.shard & (shard.shard - 1)}, ton::Bits256::zero()};
+    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, td::uint64> account_order;
+    std::vector<std::pair<std::pair<td::uint64, td::uint64>, const Entry *>> cur;
+    for (auto it = messages_.lower_bound(left); it != messages_.end() && ton::shard_contains(shard, it->first.dst);
+         ++it) {
+      auto &msg = it->second.message;
+      auto r = account_order.emplace(std::make_pair(msg->wc(), msg->addr()), 0);
+      if (r.second) {
+        r.first->second = rnd();
+      }
+      cur.emplace_back(std::make_pair(r.first->second, it->second.seqno), &it->second);
+    }
+    std::sort(cur.begin(), cur.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<std::pair<td::Ref<ton::validator::ExtMessage>, int>> res;
+    res.reserve(cur.size());
+    for (const auto &p : cur) {
+      res.emplace_back(p.second->message, 0);
+    }
+    return res;
+  }
+
+ private:
+  struct Id {
+    ton::AccountIdPrefixFull dst;
+    ton::Bits256 hash;
+    bool operator<(const Id &other) const {
+      return dst < other.dst || (dst == other.dst && hash < other.hash);
+    }
+  };
+  struct Entry {
+    td::Ref<ton::validator::ExtMessage> message;
+    td::uint64 seqno;
+  };
+  std::map<Id, Entry> messages_;
+  std::map<ton::Bits256, Id> hashes_;
+  td::uint64 next_seqno_ = 0;
+};
+
+template <class Pool>
+class MempoolBenchmark : public td::Benchmark {
+ public:
+  MempoolBenchmark(std::string name, size_t count, size_t accounts, int split_depth)
+      : name_(std::move(name)), count_(count), accounts_(accounts), split_depth_(split_depth) {
+  }
+  std::string get_description() const override {
+    return PSTRING() << name_ << " insert+select+erase messages=" << count_ << " accounts=" << accounts_
+                     << " shards=" << (1 << split_depth_);
+  }
+  void start_up() override {
+    messages_ = gen_messages(count_, accounts_);
+    shards_ = gen_shards(split_depth_);
+  }
+  void run(int n) override {
+    size_t selected = 0;
+    for (int i = 0; i < n; ++i) {
+      Pool pool;
+      for (auto &msg : messages_) {
+        pool.add(msg);
+      }
+      for (auto &shard : shards_) {
+        selected += select(pool, shard);
+      }
+      for (auto &msg : messages_) {
+        pool.erase(msg->hash());
+      }
+    }
+    td::do_not_optimize_away(selected);
+  }
+
+ private:
+  std::string name_;
+  size_t count_;
+  size_t accounts_;
+  int split_depth_;
+  std::vector<td::Ref<ton::validator::ExtMessage>> messages_;
+  std::vector<ton::ShardIdFull> shards_;
+  td::Random::Fast rnd_;
+
+  size_t select(MapMempool &pool, ton::ShardIdFull shard) {
+    return pool.select(shard, rnd_).size();
+  }
+  size_t select(ton::validator::ExtMessagePool &pool, ton::ShardIdFull shard) {
+    return pool.get_shard_snapshot(shard, rnd_).size();
+  }
+};
+
+class ExtMessagePoolAdapter : public ton::validator::ExtMessagePool {
+ public:
+  bool add(td::Ref<ton::validator::ExtMessage> message) {
+    return ExtMessagePool::add(std::move(message), 0);
+  }
+};
+
+}  // namespace
+
+int main() {
+  SET_VERBOSITY_LEVEL(VERBOSITY_NAME(ERROR));
+  for (size_t count : {10000, 100000, 300000}) {
+    for (int split_depth : {0, 4}) {
+      td::bench(MempoolBenchmark<MapMempool>("std::map", count, count / 10, split_depth));
+      td::bench(MempoolBenchmark<ExtMessagePoolAdapter>("ExtMessagePool", count, count / 10, split_depth));
+    }
+  }
+  return 0;
+}
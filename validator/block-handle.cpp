@@ -39,7 +39,8 @@ td::BufferSlice BlockHandleImpl::serialize() const {
       (flags & dbf_inited_next_left) ? create_tl_block_id(next_[0]) : nullptr,
       (flags & dbf_inited_next_right) ? create_tl_block_id(next_[1]) : nullptr, (flags & dbf_inited_lt) ? lt_ : 0,
       (flags & dbf_inited_ts) ? ts_ : 0, (flags & dbf_inited_state) ? state_ : RootHash::zero(),
-      (flags & dbf_inited_masterchain_ref_block) ? masterchain_ref_seqno_ : 0);
+      (flags & dbf_inited_masterchain_ref_block) ? masterchain_ref_seqno_ : 0,
+      (flags & dbf_inited_out_msg_queue_size) ? static_cast<td::int64>(out_msg_queue_size_) : 0);
 }
 
 BlockHandleImpl::BlockHandleImpl(td::Slice data) {
@@ -55,6 +56,8 @@ BlockHandleImpl::BlockHandleImpl(td::Slice data) {
   state_ = (flags_ & dbf_inited_state) ? obj->state_ : RootHash::zero();
   masterchain_ref_seqno_ =
       (flags_ & dbf_inited_masterchain_ref_block) ? static_cast<BlockSeqno>(obj->masterchain_ref_seqno_) : 0;
+  out_msg_queue_size_ =
+      (flags_ & dbf_inited_out_msg_queue_size) ? static_cast<td::uint64>(obj->out_msg_queue_size_) : 0;
   get_thread_safe_counter().add(1);
 }
 
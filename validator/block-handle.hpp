@@ -57,6 +57,7 @@ struct BlockHandleImpl : public BlockHandleInterface {
     dbf_archived = 0x200000,
     dbf_applied = 0x400000,
     dbf_inited_masterchain_ref_block = 0x800000,
+    dbf_inited_out_msg_queue_size = 0x1000000,
     dbf_deleted = 0x2000000,
     dbf_deleted_boc = 0x4000000,
     dbf_moved_new = 0x8000000,
@@ -74,6 +75,7 @@ struct BlockHandleImpl : public BlockHandleInterface {
   UnixTime ts_;
   RootHash state_;
   BlockSeqno masterchain_ref_seqno_;
+  td::uint64 out_msg_queue_size_;
 
   static constexpr td::uint64 lock_const() {
     return static_cast<td::uint64>(1) << 32;
@@ -208,6 +210,13 @@ struct BlockHandleImpl : public BlockHandleInterface {
     CHECK(inited_masterchain_ref_block());
     return id_.is_masterchain() ? id_.seqno() : masterchain_ref_seqno_;
   }
+  bool inited_out_msg_queue_size() const override {
+    return flags_.load(std::memory_order_consume) & Flags::dbf_inited_out_msg_queue_size;
+  }
+  td::uint64 out_msg_queue_size() const override {
+    CHECK(inited_out_msg_queue_size());
+    return out_msg_queue_size_;
+  }
   std::vector<BlockIdExt> prev() const override {
     if (is_zero()) {
       return {};
@@ -496,6 +505,19 @@ struct BlockHandleImpl : public BlockHandleInterface {
       unlock();
     }
   }
+  void set_out_msg_queue_size(td::uint64 size) override {
+    if (inited_out_msg_queue_size()) {
+      if (out_msg_queue_size_ != size) {
+        LOG(WARNING) << "out msg queue size mismatch for block " << id_.to_str() << ": stored " << out_msg_queue_size_
+                     << ", new " << size << ", keeping the stored value";
+      }
+    } else {
+      lock();
+      out_msg_queue_size_ = size;
+      flags_ |= Flags::dbf_inited_out_msg_queue_size;
+      unlock();
+    }
+  }
 
   void unsafe_clear_applied() override {
     if (is_applied()) {
@@ -0,0 +1,229 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ton::validator {
+
+template <ExtMessagePool::Link ExtMessagePool::Entry::*link>
+void ExtMessagePool::list_push_back(List &list, td::uint32 slot) {
+  Link &l = entries_[slot].*link;
+  l.prev = list.tail;
+  l.next = npos;
+  if (list.tail == npos) {
+    list.head = slot;
+  } else {
+    (entries_[list.tail].*link).next = slot;
+  }
+  list.tail = slot;
+  ++list.size;
+}
+
+template <ExtMessagePool::Link ExtMessagePool::Entry::*link>
+void ExtMessagePool::list_erase(List &list, td::uint32 slot) {
+  Link &l = entries_[slot].*link;
+  if (l.prev == npos) {
+    list.head = l.next;
+  } else {
+    (entries_[l.prev].*link).next = l.next;
+  }
+  if (l.next == npos) {
+    list.tail = l.prev;
+  } else {
+    (entries_[l.next].*link).prev = l.prev;
+  }
+  l = Link{};
+  --list.size;
+}
+
+ExtMessagePool::List &ExtMessagePool::shard_bucket(const Entry &entry) {
+  auto &buckets = priorities_[entry.priority].shard_buckets[entry.dst.workchain];
+  if (buckets.empty()) {
+    buckets.resize(1 << shard_bucket_bits());
+  }
+  return buckets[shard_bucket_idx(entry.dst.account_id_prefix)];
+}
+
+bool ExtMessagePool::add(td::Ref<ExtMessage> message, int priority) {
+  Hash hash = message->hash();
+  AccountKey account{message->wc(), message->addr()};
+  auto it = by_hash_.find(hash);
+  if (it != by_hash_.end() && entries_[it->second].priority >= priority) {
+    return false;
+  }
+  auto it2 = by_account_.find(PriorityAccountKey{priority, account});
+  if (it2 != by_account_.end() && it2->second.size >= per_address_limit_) {
+    return false;
+  }
+  // The copy with a lower priority is replaced only once the new one is sure to be added
+  if (it != by_hash_.end()) {
+    erase_slot(it->second);
+  }
+
+  td::uint32 slot;
+  if (free_slots_.empty()) {
+    slot = static_cast<td::uint32>(entries_.size());
+    entries_.emplace_back();
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  Entry &entry = entries_[slot];
+  entry.dst = message->shard();
+  entry.message = std::move(message);
+  entry.hash = hash;
+  entry.account = account;
+  entry.priority = priority;
+  entry.seqno = next_seqno_++;
+  entry.active = true;
+  entry.generation = 0;
+  entry.reactivate_at = td::Timestamp::never();
+
+  auto time_slot = static_cast<td::int64>(std::floor((td::Time::now() + ttl_) / expiry_granularity()));
+  if (expiry_buckets_.empty() || expiry_buckets_.back().time_slot < time_slot) {
+    expiry_buckets_.push_back(ExpiryBucket{time_slot, List{}});
+  }
+  entry.expiry_bucket = first_expiry_bucket_ + expiry_buckets_.size() - 1;
+
+  by_hash_[hash] = slot;
+  list_push_back<&Entry::account_link>(by_account_[PriorityAccountKey{priority, account}], slot);
+  list_push_back<&Entry::expiry_link>(expiry_buckets_.back().list, slot);
+  list_push_back<&Entry::shard_link>(shard_bucket(entry), slot);
+  ++priorities_[priority].size;
+  return true;
+}
+
+void ExtMessagePool::erase_slot(td::uint32 slot) {
+  Entry &entry = entries_[slot];
+  list_erase<&Entry::shard_link>(shard_bucket(entry), slot);
+  list_erase<&Entry::expiry_link>(expiry_buckets_.at(entry.expiry_bucket - first_expiry_bucket_).list, slot);
+  auto it = by_account_.find(PriorityAccountKey{entry.priority, entry.account});
+  CHECK(it != by_account_.end());
+  list_erase<&Entry::account_link>(it->second, slot);
+  if (it->second.size == 0) {
+    by_account_.erase(it);
+  }
+  --priorities_[entry.priority].size;
+  by_hash_.erase(entry.hash);
+  entry.message.clear();
+  free_slots_.push_back(slot);
+}
+
+bool ExtMessagePool::erase(const Hash &hash) {
+  auto it = by_hash_.find(hash);
+  if (it == by_hash_.end()) {
+    return false;
+  }
+  erase_slot(it->second);
+  return true;
+}
+
+bool ExtMessagePool::is_active(Entry &entry) {
+  if (!entry.active && entry.reactivate_at.is_in_past()) {
+    entry.active = true;
+    entry.generation++;
+  }
+  return entry.active;
+}
+
+void ExtMessagePool::postpone_or_erase(const Hash &hash, size_t soft_limit) {
+  auto it = by_hash_.find(hash);
+  if (it == by_hash_.end()) {
+    return;
+  }
+  Entry &entry = entries_[it->second];
+  if (size(entry.priority) < soft_limit && entry.generation <= 2) {
+    if (entry.active) {
+      entry.active = false;
+      entry.reactivate_at = td::Timestamp::in(entry.generation * 5.0);
+    }
+  } else {
+    erase_slot(it->second);
+  }
+}
+
+size_t ExtMessagePool::erase_expired() {
+  auto now_slot = static_cast<td::int64>(std::floor(td::Time::now() / expiry_granularity()));
+  size_t erased = 0;
+  while (!expiry_buckets_.empty() && expiry_buckets_.front().time_slot < now_slot) {
+    List &list = expiry_buckets_.front().list;
+    while (list.head != npos) {
+      erase_slot(list.head);
+      ++erased;
+    }
+    expiry_buckets_.pop_front();
+    ++first_expiry_bucket_;
+  }
+  return erased;
+}
+
+std::vector<std::pair<td::Ref<ExtMessage>, int>> ExtMessagePool::get_shard_snapshot(ShardIdFull shard,
+                                                                                   td::Random::Fast &rnd,
+                                                                                   SnapshotStats *stats) {
+  size_t expired = erase_expired();
+  size_t processed = 0;
+  ShardId lowbit = shard.shard & (~shard.shard + 1);
+  td::uint32 first_bucket = shard_bucket_idx(shard.shard ^ lowbit);
+  td::uint32 last_bucket = shard_bucket_idx(shard.shard | (lowbit - 1));
+  bool check_shard = shard.pfx_len() > static_cast<int>(shard_bucket_bits());
+
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> res;
+  // Every account gets an independent random key, so sorting by it gives a uniformly random order of accounts
+  td::HashMap<AccountKey, td::uint64, AccountKeyHasher> account_order;
+  std::vector<std::pair<td::uint64, td::uint32>> cur;
+  for (auto it = priorities_.rbegin(); it != priorities_.rend(); ++it) {
+    auto it2 = it->second.shard_buckets.find(shard.workchain);
+    if (it2 == it->second.shard_buckets.end()) {
+      continue;
+    }
+    cur.clear();
+    for (td::uint32 i = first_bucket; i <= last_bucket; ++i) {
+      for (td::uint32 slot = it2->second[i].head; slot != npos; slot = entries_[slot].shard_link.next) {
+        Entry &entry = entries_[slot];
+        if (check_shard && !shard_contains(shard, entry.dst)) {
+          continue;
+        }
+        ++processed;
+        if (is_active(entry)) {
+          auto r = account_order.emplace(entry.account, 0);
+          if (r.second) {
+            r.first->second = rnd();
+          }
+          cur.emplace_back(r.first->second, slot);
+        }
+      }
+    }
+    std::sort(cur.begin(), cur.end(), [&](const auto &a, const auto &b) {
+      if (a.first != b.first) {
+        return a.first < b.first;
+      }
+      return entries_[a.second].seqno < entries_[b.second].seqno;
+    });
+    for (const auto &p : cur) {
+      res.emplace_back(entries_[p.second].message, it->first);
+    }
+  }
+  if (stats) {
+    stats->processed = processed;
+    stats->expired = expired;
+  }
+  return res;
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,161 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "interfaces/external-message.h"
+#include "ton/ton-shard.h"
+#include "td/utils/HashMap.h"
+#include "td/utils/Random.h"
+#include "td/utils/Time.h"
+#include "td/utils/as.h"
+
+#include <deque>
+#include <map>
+
+namespace ton::validator {
+
+// Mempool of external messages.
+// All entries are stored in one slab and indexed by message hash. Every entry is linked into three intrusive lists:
+// - shard bucket: (priority, workchain, top bits of the destination account prefix),
+// - expiry bucket: messages added within the same expiry_granularity() seconds expire together,
+// - account FIFO: messages of the same priority to the same destination in the order they were added.
+class ExtMessagePool {
+ public:
+  using Hash = ExtMessage::Hash;
+
+  static constexpr td::uint32 shard_bucket_bits() {
+    return 8;
+  }
+  static constexpr double expiry_granularity() {
+    return 1.0;
+  }
+
+  explicit ExtMessagePool(double ttl = 600.0, size_t per_address_limit = 256)
+      : ttl_(ttl), per_address_limit_(per_address_limit) {
+  }
+
+  // Returns false if the message was not added: it is already present with the same or higher priority,
+  // or the destination account has too many messages with this priority
+  bool add(td::Ref<ExtMessage> message, int priority);
+  bool erase(const Hash &hash);
+  bool contains(const Hash &hash) const {
+    return by_hash_.count(hash);
+  }
+  // Postpones the message if it was not postponed too many times and the mempool is small, otherwise erases it
+  void postpone_or_erase(const Hash &hash, size_t soft_limit);
+  size_t erase_expired();
+
+  size_t size() const {
+    return by_hash_.size();
+  }
+  size_t size(int priority) const {
+    auto it = priorities_.find(priority);
+    return it == priorities_.end() ? 0 : it->second.size;
+  }
+
+  struct SnapshotStats {
+    size_t processed = 0;
+    size_t expired = 0;
+  };
+  // Active messages to accounts in the shard, grouped by priority (highest first).
+  // Accounts are returned in random order, messages to the same account are returned in FIFO order.
+  std::vector<std::pair<td::Ref<ExtMessage>, int>> get_shard_snapshot(ShardIdFull shard, td::Random::Fast &rnd,
+                                                                       SnapshotStats *stats = nullptr);
+
+ private:
+  static constexpr td::uint32 npos = static_cast<td::uint32>(-1);
+
+  struct Link {
+    td::uint32 prev = npos;
+    td::uint32 next = npos;
+  };
+  struct List {
+    td::uint32 head = npos;
+    td::uint32 tail = npos;
+    size_t size = 0;
+  };
+  using AccountKey = std::pair<WorkchainId, StdSmcAddress>;
+  using PriorityAccountKey = std::pair<int, AccountKey>;
+
+  struct Entry {
+    td::Ref<ExtMessage> message;
+    Hash hash;
+    AccountKey account;
+    AccountIdPrefixFull dst;
+    int priority = 0;
+    td::uint64 seqno = 0;
+    td::uint64 expiry_bucket = 0;
+
+    // Same postpone policy as MessageExt
+    bool active = true;
+    td::uint32 generation = 0;
+    td::Timestamp reactivate_at;
+
+    Link shard_link, expiry_link, account_link;
+  };
+
+  struct HashHasher {
+    size_t operator()(const Hash &hash) const {
+      return td::as<size_t>(hash.data());
+    }
+  };
+  struct AccountKeyHasher {
+    size_t operator()(const AccountKey &key) const {
+      return td::as<size_t>(key.second.data()) ^ static_cast<size_t>(key.first);
+    }
+  };
+  struct PriorityAccountKeyHasher {
+    size_t operator()(const PriorityAccountKey &key) const {
+      return AccountKeyHasher()(key.second) ^ static_cast<size_t>(key.first);
+    }
+  };
+
+  struct PriorityBuckets {
+    std::map<WorkchainId, std::vector<List>> shard_buckets;
+    size_t size = 0;
+  };
+
+  struct ExpiryBucket {
+    td::int64 time_slot;
+    List list;
+  };
+
+  double ttl_;
+  size_t per_address_limit_;
+  td::uint64 next_seqno_ = 0;
+
+  std::vector<Entry> entries_;
+  std::vector<td::uint32> free_slots_;
+  td::HashMap<Hash, td::uint32, HashHasher> by_hash_;
+  td::HashMap<PriorityAccountKey, List, PriorityAccountKeyHasher> by_account_;
+  std::map<int, PriorityBuckets> priorities_;
+  std::deque<ExpiryBucket> expiry_buckets_;
+  td::uint64 first_expiry_bucket_ = 0;
+
+  static td::uint32 shard_bucket_idx(AccountIdPrefix prefix) {
+    return static_cast<td::uint32>(prefix >> (64 - shard_bucket_bits()));
+  }
+  List &shard_bucket(const Entry &entry);
+  void erase_slot(td::uint32 slot);
+  bool is_active(Entry &entry);
+
+  template <Link Entry::*link>
+  void list_push_back(List &list, td::uint32 slot);
+  template <Link Entry::*link>
+  void list_erase(List &list, td::uint32 slot);
+};
+
+}  // namespace ton::validator
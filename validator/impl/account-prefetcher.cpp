@@ -0,0 +1,175 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "account-prefetcher.hpp"
+#include "block/block.h"
+#include "block/block-auto.h"
+#include "block/block-parse.h"
+#include "ton/ton-shard.h"
+#include "vm/dict.h"
+#include "td/actor/MultiPromise.h"
+
+#include <atomic>
+
+namespace ton::validator {
+
+void AccountPrefetcher::start_up() {
+  std::vector<vm::AugmentedDictionary> dicts;
+  for (auto& root : accounts_roots_) {
+    dicts.emplace_back(root, 256, block::tlb::aug_ShardAccounts);
+  }
+  td::uint32 loaded = 0;
+  for (const StdSmcAddress& addr : addrs_) {
+    if (deadline_.is_in_past()) {
+      break;
+    }
+    try {
+      for (auto& dict : dicts) {
+        auto value = dict.lookup(addr);
+        if (value.is_null()) {
+          continue;
+        }
+        // ShardAccount: account:^Account last_trans_hash:bits256 last_trans_lt:uint64
+        auto account_root = value->prefetch_ref();
+        if (account_root.is_null()) {
+          break;
+        }
+        auto r_account = account_root->load_cell();
+        if (r_account.is_error()) {
+          break;
+        }
+        auto& account = r_account.ok_ref().data_cell;
+        for (unsigned i = 0; i < account->size_refs(); ++i) {
+          // Code, data, extra currencies. Errors (e.g. library cells) are ignored here, the collator will report them
+          account->get_ref(i)->load_cell().ignore();
+        }
+        ++loaded;
+        break;
+      }
+    } catch (vm::VmError&) {
+      // Broken state is reported by the collator itself
+    } catch (vm::VmVirtError&) {
+    }
+  }
+  promise_.set_value(std::move(loaded));
+  stop();
+}
+
+void AccountPrefetcher::prefetch_accounts(std::vector<td::Ref<vm::Cell>> accounts_roots,
+                                          std::vector<StdSmcAddress> addrs, td::Timestamp deadline, size_t max_workers,
+                                          td::Promise<td::uint32> promise) {
+  std::sort(addrs.begin(), addrs.end());
+  addrs.erase(std::unique(addrs.begin(), addrs.end()), addrs.end());
+  if (addrs.empty() || accounts_roots.empty()) {
+    promise.set_value(0);
+    return;
+  }
+  size_t workers = std::max<size_t>(1, std::min(max_workers, addrs.size()));
+  size_t chunk_size = (addrs.size() + workers - 1) / workers;
+  auto loaded = std::make_shared<std::atomic<td::uint32>>(0);
+  td::MultiPromise mp;
+  auto ig = mp.init_guard();
+  ig.add_promise([loaded, promise = std::move(promise)](td::Result<td::Unit> R) mutable {
+    TRY_STATUS_PROMISE(promise, R.move_as_status());
+    promise.set_value(loaded->load());
+  });
+  // Sorted addresses are split into contiguous ranges, so that each worker walks its own part of the dictionary
+  for (size_t l = 0; l < addrs.size(); l += chunk_size) {
+    size_t r = std::min(addrs.size(), l + chunk_size);
+    std::vector<StdSmcAddress> chunk(addrs.begin() + l, addrs.begin() + r);
+    td::actor::create_actor<AccountPrefetcher>(
+        "accprefetch", accounts_roots, std::move(chunk), deadline,
+        [loaded, promise = ig.get_promise()](td::Result<td::uint32> R) mutable {
+          if (R.is_ok()) {
+            *loaded += R.ok();
+          }
+          promise.set_value(td::Unit());
+        })
+        .release();
+  }
+}
+
+void AccountPrefetcher::prefetch_queue_destinations(td::Ref<vm::Cell> out_queue_root, ShardIdFull shard,
+                                                    std::vector<td::Ref<vm::Cell>> accounts_roots, size_t max_msgs,
+                                                    td::Timestamp deadline, size_t max_workers,
+                                                    td::Promise<td::uint32> promise) {
+  if (out_queue_root.is_null()) {
+    promise.set_value(0);
+    return;
+  }
+  td::actor::create_actor<OutQueueScanner>(
+      "outqscan", std::move(out_queue_root), shard, max_msgs, deadline,
+      [accounts_roots = std::move(accounts_roots), deadline, max_workers,
+       promise = std::move(promise)](td::Result<std::vector<StdSmcAddress>> R) mutable {
+        TRY_RESULT_PROMISE(promise, addrs, std::move(R));
+        prefetch_accounts(std::move(accounts_roots), std::move(addrs), deadline, max_workers, std::move(promise));
+      })
+      .release();
+}
+
+std::vector<td::Ref<vm::Cell>> AccountPrefetcher::get_accounts_roots(
+    const std::vector<td::Ref<vm::Cell>>& state_roots) {
+  std::vector<td::Ref<vm::Cell>> res;
+  for (const auto& root : state_roots) {
+    block::gen::ShardStateUnsplit::Record state;
+    if (root.is_null() || !tlb::unpack_cell(root, state)) {
+      continue;
+    }
+    auto accounts = vm::load_cell_slice(std::move(state.accounts)).prefetch_ref();
+    if (accounts.not_null()) {
+      res.push_back(std::move(accounts));
+    }
+  }
+  return res;
+}
+
+void OutQueueScanner::start_up() {
+  std::vector<StdSmcAddress> res;
+  try {
+    vm::AugmentedDictionary dict{out_queue_root_, 352, block::tlb::aug_OutMsgQueue};
+    // Key: next_addr workchain (32 bits), next_addr prefix (64 bits), message hash (256 bits)
+    td::BitArray<96> prefix;
+    prefix.bits().store_int(shard_.workchain, 32);
+    (prefix.bits() + 32).store_uint(shard_.shard, 64);
+    if (dict.cut_prefix_subdict(prefix.bits(), 32 + shard_.pfx_len())) {
+      auto f = [&](td::Ref<vm::CellSlice> value, td::Ref<vm::CellSlice>, td::ConstBitPtr, int) -> bool {
+        if (res.size() >= max_msgs_ || deadline_.is_in_past()) {
+          return false;
+        }
+        block::EnqueuedMsgDescr descr;
+        if (!descr.unpack(value.write()) || !shard_contains(shard_, descr.dest_prefix_)) {
+          // Transit message or a broken one
+          return true;
+        }
+        block::gen::CommonMsgInfo::Record_int_msg_info info;
+        WorkchainId wc;
+        StdSmcAddress addr;
+        if (tlb::unpack_cell_inexact(descr.msg_, info) &&
+            block::tlb::t_MsgAddressInt.extract_std_address(info.dest, wc, addr)) {
+          res.push_back(addr);
+        }
+        return true;
+      };
+      dict.check_for_each_extra(f);
+    }
+  } catch (vm::VmError&) {
+  } catch (vm::VmVirtError&) {
+  }
+  promise_.set_value(std::move(res));
+  stop();
+}
+
+}  // namespace ton::validator
@@ -0,0 +1,78 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "ton/ton-types.h"
+#include "td/actor/actor.h"
+#include "vm/cells.h"
+
+namespace ton::validator {
+
+// Loads the cells of accounts that are going to be used in collation: the ShardAccounts dictionary path,
+// the account cell and its direct children (code and data roots).
+// Cells loaded from celldb are cached in ExtCell, so the collator does not wait for disk reads later.
+// The prefetcher must be given "pure" roots (not UsageCell) to avoid adding cells to the state usage tree.
+class AccountPrefetcher : public td::actor::Actor {
+ public:
+  AccountPrefetcher(std::vector<td::Ref<vm::Cell>> accounts_roots, std::vector<StdSmcAddress> addrs,
+                    td::Timestamp deadline, td::Promise<td::uint32> promise)
+      : accounts_roots_(std::move(accounts_roots))
+      , addrs_(std::move(addrs))
+      , deadline_(deadline)
+      , promise_(std::move(promise)) {
+  }
+
+  void start_up() override;
+
+  // Prefetches accounts in parallel, using up to max_workers actors
+  static void prefetch_accounts(std::vector<td::Ref<vm::Cell>> accounts_roots, std::vector<StdSmcAddress> addrs,
+                                td::Timestamp deadline, size_t max_workers, td::Promise<td::uint32> promise);
+  // Scans messages in a neighbor's OutMsgQueue that are going to the given shard and prefetches their destinations
+  static void prefetch_queue_destinations(td::Ref<vm::Cell> out_queue_root, ShardIdFull shard,
+                                          std::vector<td::Ref<vm::Cell>> accounts_roots, size_t max_msgs,
+                                          td::Timestamp deadline, size_t max_workers, td::Promise<td::uint32> promise);
+  // Returns the roots of ShardAccounts dictionaries of ShardStateUnsplit
+  static std::vector<td::Ref<vm::Cell>> get_accounts_roots(const std::vector<td::Ref<vm::Cell>>& state_roots);
+
+ private:
+  std::vector<td::Ref<vm::Cell>> accounts_roots_;
+  std::vector<StdSmcAddress> addrs_;
+  td::Timestamp deadline_;
+  td::Promise<td::uint32> promise_;
+};
+
+class OutQueueScanner : public td::actor::Actor {
+ public:
+  OutQueueScanner(td::Ref<vm::Cell> out_queue_root, ShardIdFull shard, size_t max_msgs, td::Timestamp deadline,
+                  td::Promise<std::vector<StdSmcAddress>> promise)
+      : out_queue_root_(std::move(out_queue_root))
+      , shard_(shard)
+      , max_msgs_(max_msgs)
+      , deadline_(deadline)
+      , promise_(std::move(promise)) {
+  }
+
+  void start_up() override;
+
+ private:
+  td::Ref<vm::Cell> out_queue_root_;
+  ShardIdFull shard_;
+  size_t max_msgs_;
+  td::Timestamp deadline_;
+  td::Promise<std::vector<StdSmcAddress>> promise_;
+};
+
+}  // namespace ton::validator
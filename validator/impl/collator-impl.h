@@ -85,6 +85,9 @@ class Collator final : public td::actor::Actor {
   ton::BlockSeqno prev_key_block_seqno_{0};
   int step{0};
   int pending{0};
+  std::vector<Ref<vm::Cell>> prefetch_accounts_roots_;
+  td::Timestamp prefetch_deadline_;
+  td::uint32 prefetched_accounts_{0};
   static constexpr int max_ihr_msg_size = 65535;   // 64k
   static constexpr int max_ext_msg_size = 65535;   // 64k
   static constexpr int max_blk_sign_size = 65535;  // 64k
@@ -256,6 +259,9 @@ class Collator final : public td::actor::Actor {
   bool fix_processed_upto(block::MsgProcessedUptoCollection& upto);
   void got_neighbor_out_queue(int i, td::Result<Ref<MessageQueue>> res);
   void got_out_queue_size(size_t i, td::Result<td::uint64> res);
+  void prefetch_ext_msg_destinations();
+  void prefetch_queue_destinations(Ref<vm::Cell> out_queue_root);
+  void after_prefetch_accounts(td::Result<td::uint32> res);
   bool adjust_shard_config();
   bool store_shard_fees(ShardIdFull shard, const block::CurrencyCollection& fees,
                         const block::CurrencyCollection& created);
@@ -33,6 +33,7 @@
 #include "fabric.h"
 #include "validator-set.hpp"
 #include "top-shard-descr.hpp"
+#include "account-prefetcher.hpp"
 #include <ctime>
 #include "td/utils/Random.h"
 
@@ -872,6 +873,7 @@ void Collator::got_neighbor_out_queue(int i, td::Result<Ref<MessageQueue>> res)
     return;
   }
   descr.set_queue_root(qinfo.out_queue->prefetch_ref(0));
+  prefetch_queue_destinations(descr.outmsg_root);
   // comment the next two lines in the future when the output queues become huge
   //  CHECK(block::gen::t_OutMsgQueueInfo.validate_ref(1000000, outq_descr->root_cell()));
   //  CHECK(block::tlb::t_OutMsgQueueInfo.validate_ref(1000000, outq_descr->root_cell()));
@@ -1529,6 +1531,7 @@ bool Collator::do_preinit() {
   if (!init_block_limits()) {
     return fatal_error("cannot initialize block limits");
   }
+  prefetch_ext_msg_destinations();
   if (!request_neighbor_msg_queues()) {
     return false;
   }
@@ -1538,6 +1541,75 @@ bool Collator::do_preinit() {
   return true;
 }
 
+/**
+ * Starts loading accounts that are destinations of inbound external messages.
+ * Accounts are loaded by AccountPrefetcher actors in parallel with collation, which does not wait for them:
+ * cells that are already loaded by the time the collator needs them are taken from memory.
+ */
+void Collator::prefetch_ext_msg_destinations() {
+  if (collator_opts_->prefetch_workers == 0) {
+    return;
+  }
+  std::vector<Ref<vm::Cell>> state_roots;
+  for (const auto& state : prev_states) {
+    state_roots.push_back(state->root_cell());
+  }
+  // Pure roots: prefetching must not affect the state usage tree
+  prefetch_accounts_roots_ = AccountPrefetcher::get_accounts_roots(state_roots);
+  prefetch_deadline_ = td::Timestamp::in(collator_opts_->prefetch_timeout);
+  std::vector<StdSmcAddress> addrs;
+  for (const auto& msg : ext_msg_list_) {
+    block::gen::CommonMsgInfo::Record_ext_in_msg_info info;
+    WorkchainId wc;
+    StdSmcAddress addr;
+    if (tlb::unpack_cell_inexact(msg.cell, info) &&
+        block::tlb::t_MsgAddressInt.extract_std_address(info.dest, wc, addr)) {
+      addrs.push_back(addr);
+    }
+  }
+  if (addrs.empty()) {
+    return;
+  }
+  AccountPrefetcher::prefetch_accounts(prefetch_accounts_roots_, std::move(addrs), prefetch_deadline_,
+                                       collator_opts_->prefetch_workers,
+                                       [self = get_self()](td::Result<td::uint32> res) {
+                                         td::actor::send_closure(std::move(self), &Collator::after_prefetch_accounts,
+                                                                 std::move(res));
+                                       });
+}
+
+/**
+ * Starts loading accounts that are destinations of messages in the outbound queue of a neighbor.
+ *
+ * @param out_queue_root The root of the OutMsgQueue of the neighbor.
+ */
+void Collator::prefetch_queue_destinations(Ref<vm::Cell> out_queue_root) {
+  if (collator_opts_->prefetch_workers == 0 || out_queue_root.is_null() || prefetch_accounts_roots_.empty() ||
+      prefetch_deadline_.is_in_past()) {
+    return;
+  }
+  AccountPrefetcher::prefetch_queue_destinations(
+      std::move(out_queue_root), shard_, prefetch_accounts_roots_, collator_opts_->prefetch_max_queue_msgs,
+      prefetch_deadline_, collator_opts_->prefetch_workers, [self = get_self()](td::Result<td::uint32> res) {
+        td::actor::send_closure(std::move(self), &Collator::after_prefetch_accounts, std::move(res));
+      });
+}
+
+/**
+ * Callback function called after a batch of accounts is prefetched.
+ * Prefetching is best-effort, so errors are only logged.
+ *
+ * @param res The number of loaded accounts or an error.
+ */
+void Collator::after_prefetch_accounts(td::Result<td::uint32> res) {
+  if (res.is_error()) {
+    LOG(INFO) << "failed to prefetch accounts: " << res.move_as_error();
+  } else {
+    prefetched_accounts_ += res.ok();
+    LOG(DEBUG) << "prefetched " << res.ok() << " accounts (" << prefetched_accounts_ << " total)";
+  }
+}
+
 /**
  * Adjusts the shard configuration by adding new workchains to the shard configuration in the masterchain state.
  * Used in masterchain collator.
@@ -2507,6 +2579,8 @@ td::Result<block::Account*> Collator::make_account(td::ConstBitPtr addr, bool fo
  */
 bool Collator::combine_account_transactions() {
   vm::AugmentedDictionary dict{256, block::tlb::aug_ShardAccountBlocks};
+  // accounts are sorted by address, so ShardAccountBlocks is built in one pass after the loop
+  std::vector<vm::DictionaryFixed::key_value_t> account_blocks;
   for (auto& z : accounts) {
     block::Account& acc = *(z.second);
     CHECK(acc.addr == z.first);
@@ -2543,10 +2617,7 @@ bool Collator::combine_account_transactions() {
         return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
                            " failed to pass handwritten validation tests");
       }
-      if (!dict.set(z.first, csr, vm::Dictionary::SetMode::Add)) {
-        return fatal_error(std::string{"new AccountBlock for "} + z.first.to_hex() +
-                           " could not be added to ShardAccountBlocks");
-      }
+      account_blocks.emplace_back(z.first.cbits(), std::move(csr));
       // update account_dict
       if (acc.total_state->get_hash() != acc.orig_total_state->get_hash()) {
         // account changed
@@ -2596,6 +2667,9 @@ bool Collator::combine_account_transactions() {
       }
     }
   }
+  if (!dict.build_from_sorted(account_blocks, 256)) {
+    return fatal_error("new AccountBlocks could not be added to ShardAccountBlocks");
+  }
   vm::CellBuilder cb;
   if (!(cb.append_cellslice_bool(std::move(dict).extract_root()) && cb.finalize_to(shard_account_blocks_))) {
     return fatal_error("cannot serialize ShardAccountBlocks");
@@ -5673,6 +5747,8 @@ bool Collator::create_block_candidate() {
     td::actor::send_closure_later(manager, &ValidatorManager::complete_external_messages, std::move(delay_ext_msgs_),
                                   std::move(bad_ext_msgs_));
   }
+  td::actor::send_closure(manager, &ValidatorManager::record_out_msg_queue_size, block_candidate->id,
+                          out_msg_queue_size_);
 
   double work_time = work_timer_.elapsed();
   double cpu_work_time = cpu_work_timer_.elapsed();
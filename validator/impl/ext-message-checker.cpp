@@ -0,0 +1,192 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "ext-message-checker.hpp"
+#include "external-message.hpp"
+#include "fabric.h"
+
+namespace ton::validator {
+
+void ExtMessageChecker::start_up() {
+  for (td::uint32 i = 0; i < std::max<td::uint32>(workers_cnt_, 1); ++i) {
+    workers_.push_back(td::actor::create_actor<ExtMessageCheckWorker>(PSTRING() << "extmsgcheck" << i));
+  }
+}
+
+void ExtMessageChecker::alarm() {
+  if (flush_at_ && flush_at_.is_in_past()) {
+    flush();
+  }
+  if (cleanup_rejected_at_ && cleanup_rejected_at_.is_in_past()) {
+    while (!rejected_expire_queue_.empty() && rejected_expire_queue_.front().first.is_in_past()) {
+      rejected_.erase(rejected_expire_queue_.front().second);
+      rejected_expire_queue_.pop();
+    }
+    cleanup_rejected_at_ =
+        rejected_expire_queue_.empty() ? td::Timestamp::never() : rejected_expire_queue_.front().first;
+  }
+  alarm_timestamp() = flush_at_;
+  alarm_timestamp().relax(cleanup_rejected_at_);
+}
+
+void ExtMessageChecker::check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise) {
+  auto it = rejected_.find(message->hash());
+  if (it != rejected_.end()) {
+    ++total_rejected_cache_hits_;
+    promise.set_error(it->second.clone());
+    return;
+  }
+  auto &batch = pending_[{message->wc(), message->addr()}];
+  batch.push_back({std::move(message), std::move(promise), td::Timestamp::now()});
+  ++pending_cnt_;
+  if (pending_cnt_ >= max_batch_size()) {
+    flush();
+    return;
+  }
+  if (!flush_at_) {
+    flush_at_ = td::Timestamp::in(batch_delay());
+    alarm_timestamp().relax(flush_at_);
+  }
+}
+
+void ExtMessageChecker::flush() {
+  flush_at_ = td::Timestamp::never();
+  if (pending_.empty()) {
+    return;
+  }
+  ++total_batches_;
+  for (auto &p : pending_) {
+    ++total_accounts_;
+    in_flight_cnt_ += p.second.size();
+    WorkchainId wc = p.first.first;
+    StdSmcAddress addr = p.first.second;
+    fetch_account_state(wc, addr,
+                        [SelfId = actor_id(this), wc, addr, batch = std::move(p.second)](
+                            td::Result<AccountState> R) mutable {
+                          td::actor::send_closure(SelfId, &ExtMessageChecker::got_account_state, wc, addr,
+                                                  std::move(batch), std::move(R));
+                        });
+  }
+  pending_.clear();
+  pending_cnt_ = 0;
+}
+
+void ExtMessageChecker::got_account_state(WorkchainId wc, StdSmcAddress addr, std::vector<Pending> batch,
+                                          td::Result<AccountState> R) {
+  if (R.is_error()) {
+    finish_batch(std::move(batch), td::Status::Error("Failed to get account state"));
+    return;
+  }
+  std::vector<td::Ref<vm::Cell>> msg_roots;
+  for (const Pending &p : batch) {
+    msg_roots.push_back(p.message->root_cell());
+  }
+  check_batch(wc, addr, R.move_as_ok(), std::move(msg_roots),
+              [SelfId = actor_id(this), batch = std::move(batch)](td::Result<std::vector<td::Status>> R) mutable {
+                td::actor::send_closure(SelfId, &ExtMessageChecker::finish_batch, std::move(batch), std::move(R));
+              });
+}
+
+void ExtMessageChecker::fetch_account_state(WorkchainId wc, StdSmcAddress addr, td::Promise<AccountState> promise) {
+  run_fetch_account_state(wc, addr, manager_, std::move(promise));
+}
+
+void ExtMessageChecker::check_batch(WorkchainId wc, StdSmcAddress addr, AccountState state,
+                                    std::vector<td::Ref<vm::Cell>> msg_roots,
+                                    td::Promise<std::vector<td::Status>> promise) {
+  auto &worker = workers_[next_worker_++ % workers_.size()];
+  td::actor::send_closure(worker, &ExtMessageCheckWorker::run_batch, wc, addr, std::move(std::get<0>(state)),
+                          std::get<1>(state), std::get<2>(state), std::move(std::get<3>(state)), std::move(msg_roots),
+                          std::move(promise));
+}
+
+void ExtMessageChecker::finish_batch(std::vector<Pending> batch, td::Result<std::vector<td::Status>> R) {
+  in_flight_cnt_ -= batch.size();
+  if (R.is_error()) {
+    for (Pending &p : batch) {
+      finish_message(p, R.error().clone(), false);
+    }
+    return;
+  }
+  auto results = R.move_as_ok();
+  CHECK(results.size() == batch.size());
+  for (size_t i = 0; i < batch.size(); ++i) {
+    finish_message(batch[i], std::move(results[i]), true);
+  }
+}
+
+void ExtMessageChecker::finish_message(Pending &pending, td::Status status, bool cache_rejected) {
+  ++total_messages_;
+  double latency = td::Time::now() - pending.received_at.at();
+  total_latency_ += latency;
+  ++total_latency_cnt_;
+  max_latency_ = std::max(max_latency_, latency);
+  if (status.is_ok()) {
+    pending.promise.set_value(std::move(pending.message));
+    return;
+  }
+  if (cache_rejected && rejected_.emplace(pending.message->hash(), status.clone()).second) {
+    rejected_expire_queue_.emplace(td::Timestamp::in(rejected_cache_ttl()), pending.message->hash());
+    if (!cleanup_rejected_at_) {
+      cleanup_rejected_at_ = rejected_expire_queue_.front().first;
+      alarm_timestamp().relax(cleanup_rejected_at_);
+    }
+  }
+  pending.promise.set_error(std::move(status));
+}
+
+void ExtMessageChecker::prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise) {
+  std::vector<std::pair<std::string, std::string>> vec;
+  vec.emplace_back("ext_msg_checker.queue", PSTRING() << "pending:" << pending_cnt_ << " in_flight:" << in_flight_cnt_);
+  vec.emplace_back("ext_msg_checker.total",
+                   PSTRING() << "messages:" << total_messages_ << " batches:" << total_batches_
+                             << " accounts:" << total_accounts_ << " rejected_cache_hits:" << total_rejected_cache_hits_
+                             << " rejected_cache_size:" << rejected_.size());
+  vec.emplace_back("ext_msg_checker.latency",
+                   PSTRING() << "avg:" << (total_latency_cnt_ ? total_latency_ / (double)total_latency_cnt_ : 0.0)
+                             << " max:" << max_latency_);
+  promise.set_value(std::move(vec));
+}
+
+void ExtMessageCheckWorker::run_batch(WorkchainId wc, StdSmcAddress addr, td::Ref<vm::CellSlice> shard_acc,
+                                      UnixTime utime, LogicalTime lt, std::unique_ptr<block::ConfigInfo> config,
+                                      std::vector<td::Ref<vm::Cell>> msg_roots,
+                                      td::Promise<std::vector<td::Status>> promise) {
+  bool special = wc == masterchainId && config->is_special_smartcontract(addr);
+  std::vector<td::Status> results;
+  for (auto &msg_root : msg_roots) {
+    // Every message is checked independently against the same account state
+    block::Account acc;
+    if (!acc.unpack(shard_acc, utime, special)) {
+      // Not a property of the messages, so the whole batch fails and nothing is put into the rejected cache
+      promise.set_error(td::Status::Error("Failed to unpack account state"));
+      return;
+    }
+    auto status = ExtMessageQ::run_message_on_account(wc, &acc, utime, lt + 1, std::move(msg_root), *config);
+    if (status.code() == ErrorCode::failure) {
+      // Config params could not be fetched: this is the same for all messages of the batch and not cached either
+      promise.set_error(std::move(status));
+      return;
+    }
+    if (status.is_error()) {
+      status = td::Status::Error(PSLICE() << "External message was not accepted\n" << status.message());
+    }
+    results.push_back(std::move(status));
+  }
+  promise.set_value(std::move(results));
+}
+
+}  // namespace ton::validator
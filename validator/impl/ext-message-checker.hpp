@@ -0,0 +1,99 @@
+/*
+    This file is part of TON Blockchain Library.
+
+    TON Blockchain Library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    TON Blockchain Library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with TON Blockchain Library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#pragma once
+#include "ton/ton-types.h"
+#include "td/actor/actor.h"
+#include "interfaces/validator-manager.h"
+#include "block/mc-config.h"
+
+#include <queue>
+
+namespace ton::validator {
+
+class ExtMessageCheckWorker;
+
+// Pre-checks external messages (liteServer.sendMessage) in batches:
+// messages to the same account that arrive within a short window are checked against one account state snapshot,
+// and the accept phase runs on a pool of worker actors.
+class ExtMessageChecker : public td::actor::Actor {
+ public:
+  ExtMessageChecker(td::actor::ActorId<ValidatorManager> manager, td::uint32 workers)
+      : manager_(std::move(manager)), workers_cnt_(workers) {
+  }
+
+  void start_up() override;
+  void alarm() override;
+
+  void check_message(td::Ref<ExtMessage> message, td::Promise<td::Ref<ExtMessage>> promise);
+  void prepare_stats(td::Promise<std::vector<std::pair<std::string, std::string>>> promise);
+
+  static constexpr double batch_delay() {
+    return 0.005;
+  }
+  static constexpr size_t max_batch_size() {
+    return 1024;
+  }
+  static constexpr double rejected_cache_ttl() {
+    return 5.0;
+  }
+
+ protected:
+  using AccountState = std::tuple<td::Ref<vm::CellSlice>, UnixTime, LogicalTime, std::unique_ptr<block::ConfigInfo>>;
+
+  // Fetch the state of the account and run the messages of a batch on it. Tests replace them to do without a manager
+  virtual void fetch_account_state(WorkchainId wc, StdSmcAddress addr, td::Promise<AccountState> promise);
+  virtual void check_batch(WorkchainId wc, StdSmcAddress addr, AccountState state,
+                           std::vector<td::Ref<vm::Cell>> msg_roots, td::Promise<std::vector<td::Status>> promise);
+
+ private:
+  td::actor::ActorId<ValidatorManager> manager_;
+  td::uint32 workers_cnt_;
+  std::vector<td::actor::ActorOwn<ExtMessageCheckWorker>> workers_;
+  size_t next_worker_ = 0;
+
+  struct Pending {
+    td::Ref<ExtMessage> message;
+    td::Promise<td::Ref<ExtMessage>> promise;
+    td::Timestamp received_at;
+  };
+  std::map<std::pair<WorkchainId, StdSmcAddress>, std::vector<Pending>> pending_;
+  size_t pending_cnt_ = 0;
+  size_t in_flight_cnt_ = 0;
+  td::Timestamp flush_at_ = td::Timestamp::never();
+
+  std::map<ExtMessage::Hash, td::Status> rejected_;
+  std::queue<std::pair<td::Timestamp, ExtMessage::Hash>> rejected_expire_queue_;
+  td::Timestamp cleanup_rejected_at_ = td::Timestamp::never();
+
+  td::uint64 total_messages_ = 0, total_batches_ = 0, total_accounts_ = 0, total_rejected_cache_hits_ = 0;
+  double total_latency_ = 0.0, max_latency_ = 0.0;
+  td::uint64 total_latency_cnt_ = 0;
+
+  void flush();
+  void got_account_state(WorkchainId wc, StdSmcAddress addr, std::vector<Pending> batch, td::Result<AccountState> R);
+  void finish_batch(std::vector<Pending> batch, td::Result<std::vector<td::Status>> R);
+  void finish_message(Pending &pending, td::Status status, bool cache_rejected);
+};
+
+class ExtMessageCheckWorker : public td::actor::Actor {
+ public:
+  void run_batch(WorkchainId wc, StdSmcAddress addr, td::Ref<vm::CellSlice> shard_acc, UnixTime utime,
+                 LogicalTime lt, std::unique_ptr<block::ConfigInfo> config, std::vector<td::Ref<vm::Cell>> msg_roots,
+                 td::Promise<std::vector<td::Status>> promise);
+};
+
+}  // namespace ton::validator
@@ -112,7 +112,7 @@ void ExtMessageQ::run_message(td::Ref<ExtMessage> message, td::actor::ActorId<to
           if (!acc.unpack(shard_acc, utime, special)) {
             promise.set_error(td::Status::Error(PSLICE() << "Failed to unpack account state"));
           } else {
-            auto status = run_message_on_account(wc, &acc, utime, lt + 1, msg_root, std::move(config));
+            auto status = run_message_on_account(wc, &acc, utime, lt + 1, msg_root, *config);
             if (status.is_ok()) {
               promise.set_value(std::move(message));
             } else {
@@ -128,7 +128,7 @@ td::Status ExtMessageQ::run_message_on_account(ton::WorkchainId wc,
                                                block::Account* acc,
                                                UnixTime utime, LogicalTime lt,
                                                td::Ref<vm::Cell> msg_root,
-                                               std::unique_ptr<block::ConfigInfo> config) {
+                                               const block::ConfigInfo& config) {
 
    Ref<vm::Cell> old_mparams;
    std::vector<block::StoragePrices> storage_prices_;
@@ -140,14 +140,14 @@ td::Status ExtMessageQ::run_message_on_account(ton::WorkchainId wc,
    td::RefInt256 masterchain_create_fee, basechain_create_fee;
 
    auto fetch_res = block::FetchConfigParams::fetch_config_params(
-       *config, &old_mparams, &storage_prices_, &storage_phase_cfg_, &rand_seed_, &compute_phase_cfg_,
+       config, &old_mparams, &storage_prices_, &storage_phase_cfg_, &rand_seed_, &compute_phase_cfg_,
        &action_phase_cfg_, &serialize_config_, &masterchain_create_fee, &basechain_create_fee, wc, utime);
    if(fetch_res.is_error()) {
      auto error = fetch_res.move_as_error();
      LOG(DEBUG) << "Cannot fetch config params: " << error.message();
-     return error.move_as_error_prefix("Cannot fetch config params: ");
+     return td::Status::Error(ErrorCode::failure, PSLICE() << "Cannot fetch config params: " << error.message());
    }
-   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config->get_libraries_root(), 256);
+   compute_phase_cfg_.libraries = std::make_unique<vm::Dictionary>(config.get_libraries_root(), 256);
    compute_phase_cfg_.with_vm_log = true;
    compute_phase_cfg_.stop_on_accept_message = true;
 
@@ -63,11 +63,12 @@ class ExtMessageQ : public ExtMessage {
                                                              block::SizeLimitsConfig::ExtMsgLimits limits);
   static void run_message(td::Ref<ExtMessage> message, td::actor::ActorId<ton::validator::ValidatorManager> manager,
                           td::Promise<td::Ref<ExtMessage>> promise);
+  // Fails with ErrorCode::failure if config params can't be fetched, which doesn't depend on the message
   static td::Status run_message_on_account(ton::WorkchainId wc,
                                            block::Account* acc,
                                            UnixTime utime, LogicalTime lt,
                                            td::Ref<vm::Cell> msg_root,
-                                           std::unique_ptr<block::ConfigInfo> config);
+                                           const block::ConfigInfo& config);
 };
 
 }  // namespace validator
@@ -6923,9 +6923,10 @@ bool ValidateQuery::save_candidate() {
 
 /**
  * Callback function called after saving block candidate.
- * Finishes validation.
+ * Reports the new outbound message queue size to the manager and finishes validation.
  */
 void ValidateQuery::written_candidate() {
+  td::actor::send_closure(manager, &ValidatorManager::record_out_msg_queue_size, id_, new_out_msg_queue_size_);
   finish_query();
 }
 
@@ -20,6 +20,7 @@
 #include "auto/tl/ton_api.h"
 // #include "adnl/utils.hpp"
 #include "block/block.h"
+#include "crypto/Ed25519.h"
 
 #include <set>
 
@@ -40,44 +41,25 @@ bool ValidatorSetQ::is_validator(NodeIdShort id) const {
 
 td::Result<ValidatorWeight> ValidatorSetQ::check_signatures(RootHash root_hash, FileHash file_hash,
                                                             td::Ref<BlockSignatureSet> signatures) const {
-  auto &sigs = signatures->signatures();
-
   auto block = create_serialize_tl_object<ton_api::ton_blockId>(root_hash, file_hash);
-
-  ValidatorWeight weight = 0;
-
-  std::set<NodeIdShort> nodes;
-  for (auto &sig : sigs) {
-    if (nodes.count(sig.node) == 1) {
-      return td::Status::Error(ErrorCode::protoviolation, "duplicate node to sign");
-    }
-    nodes.insert(sig.node);
-
-    auto vdescr = get_validator(sig.node);
-    if (!vdescr) {
-      return td::Status::Error(ErrorCode::protoviolation, "unknown node to sign");
-    }
-
-    auto E = ValidatorFullId{vdescr->key}.create_encryptor().move_as_ok();
-    TRY_STATUS(E->check_signature(block.as_slice(), sig.signature.as_slice()));
-    weight += vdescr->weight;
-  }
-
-  if (weight * 3 <= total_weight_ * 2) {
-    return td::Status::Error(ErrorCode::protoviolation, "too small sig weight");
-  }
-  return weight;
+  return check_signatures_impl(block.as_slice(), std::move(signatures));
 }
 
 td::Result<ValidatorWeight> ValidatorSetQ::check_approve_signatures(RootHash root_hash, FileHash file_hash,
                                                                     td::Ref<BlockSignatureSet> signatures) const {
-  auto &sigs = signatures->signatures();
-
   auto block = create_serialize_tl_object<ton_api::ton_blockIdApprove>(root_hash, file_hash);
+  return check_signatures_impl(block.as_slice(), std::move(signatures));
+}
+
+td::Result<ValidatorWeight> ValidatorSetQ::check_signatures_impl(td::Slice data,
+                                                                 td::Ref<BlockSignatureSet> signatures) const {
+  auto &sigs = signatures->signatures();
 
   ValidatorWeight weight = 0;
 
   std::set<NodeIdShort> nodes;
+  std::vector<td::Ed25519::SignatureToCheck> batch;
+  batch.reserve(sigs.size());
   for (auto &sig : sigs) {
     if (nodes.count(sig.node) == 1) {
       return td::Status::Error(ErrorCode::protoviolation, "duplicate node to sign");
@@ -89,11 +71,16 @@ td::Result<ValidatorWeight> ValidatorSetQ::check_approve_signatures(RootHash roo
       return td::Status::Error(ErrorCode::protoviolation, "unknown node to sign");
     }
 
-    auto E = ValidatorFullId{vdescr->key}.create_encryptor().move_as_ok();
-    TRY_STATUS(E->check_signature(block.as_slice(), sig.signature.as_slice()));
+    batch.push_back({vdescr->key.as_slice(), data, sig.signature.as_slice()});
     weight += vdescr->weight;
   }
 
+  size_t bad_index = 0;
+  auto S = td::Ed25519::verify_batch(batch, &bad_index);
+  if (S.is_error()) {
+    return S.move_as_error_prefix(PSTRING() << "bad signature of node " << sigs[bad_index].node << ": ");
+  }
+
   if (weight * 3 <= total_weight_ * 2) {
     return td::Status::Error(ErrorCode::protoviolation, "too small sig weight");
   }
@@ -63,6 +63,8 @@ class ValidatorSetQ : public ValidatorSet {
   ValidatorWeight total_weight_;
   std::vector<ValidatorDescr> ids_;
   std::vector<std::pair<NodeIdShort, size_t>> ids_map_;
+
+  td::Result<ValidatorWeight> check_signatures_impl(td::Slice data, td::Ref<BlockSignatureSet> signatures) const;
 };
 
 class ValidatorSetCompute {
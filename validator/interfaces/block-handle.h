@@ -50,6 +50,7 @@ struct BlockHandleInterface {
   virtual bool inited_merge_before() const = 0;
   virtual bool inited_is_key_block() const = 0;
   virtual bool inited_masterchain_ref_block() const = 0;
+  virtual bool inited_out_msg_queue_size() const = 0;
   virtual bool split_after() const = 0;
   virtual bool merge_before() const = 0;
   virtual bool is_key_block() const = 0;
@@ -62,6 +63,7 @@ struct BlockHandleInterface {
   virtual bool is_archived() const = 0;
   virtual bool is_applied() const = 0;
   virtual BlockSeqno masterchain_ref_block() const = 0;
+  virtual td::uint64 out_msg_queue_size() const = 0;
   virtual std::vector<BlockIdExt> prev() const = 0;
   virtual BlockIdExt one_prev(bool left) const = 0;
   virtual std::vector<BlockIdExt> next() const = 0;
@@ -97,6 +99,7 @@ struct BlockHandleInterface {
   virtual void set_archived() = 0;
   virtual void set_applied() = 0;
   virtual void set_masterchain_ref_block(BlockSeqno seqno) = 0;
+  virtual void set_out_msg_queue_size(td::uint64 size) = 0;
 
   virtual void unsafe_clear_applied() = 0;
   virtual void unsafe_clear_next() = 0;
@@ -213,6 +213,8 @@ class ValidatorManager : public ValidatorManagerInterface {
   }
   virtual void record_validate_query_stats(BlockIdExt block_id, double work_time, double cpu_work_time, bool success) {
   }
+  virtual void record_out_msg_queue_size(BlockIdExt block_id, td::uint64 size) {
+  }
 
   virtual void add_persistent_state_description(td::Ref<PersistentStateDescription> desc) = 0;
 
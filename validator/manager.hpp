@@ -34,8 +34,10 @@
 #include "rldp/rldp.h"
 #include "token-manager.h"
 #include "queue-size-counter.hpp"
+#include "ext-message-pool.hpp"
 #include "validator-telemetry.hpp"
 #include "impl/candidates-buffer.hpp"
+#include "impl/ext-message-checker.hpp"
 
 #include <map>
 #include <set>
@@ -240,19 +242,7 @@ class ValidatorManagerImpl : public ValidatorManager {
   std::map<BlockIdExt, ReceivedBlock> cached_block_candidates_;
   std::list<BlockIdExt> cached_block_candidates_lru_;
 
-  struct ExtMessages {
-    std::map<MessageId<ExtMessage>, std::unique_ptr<MessageExt<ExtMessage>>> ext_messages_;
-    std::map<std::pair<ton::WorkchainId, ton::StdSmcAddress>, std::map<ExtMessage::Hash, MessageId<ExtMessage>>>
-        ext_addr_messages_;
-    void erase(const MessageId<ExtMessage>& id) {
-      auto it = ext_messages_.find(id);
-      CHECK(it != ext_messages_.end());
-      ext_addr_messages_[it->second->address()].erase(id.hash);
-      ext_messages_.erase(it);
-    }
-  };
-  std::map<int, ExtMessages> ext_msgs_;  // priority -> messages
-  std::map<ExtMessage::Hash, std::pair<int, MessageId<ExtMessage>>> ext_messages_hashes_;  // hash -> priority
+  ExtMessagePool ext_msg_pool_;
   td::Timestamp cleanup_mempool_at_;
   // IHR ?
   std::map<MessageId<IhrMessage>, std::unique_ptr<MessageExt<IhrMessage>>> ihr_messages_;
@@ -643,6 +633,11 @@ class ValidatorManagerImpl : public ValidatorManager {
     }
     td::actor::send_closure(queue_size_counter_, &QueueSizeCounter::get_queue_size, block_id, std::move(promise));
   }
+  void record_out_msg_queue_size(BlockIdExt block_id, td::uint64 size) override {
+    if (!queue_size_counter_.empty()) {
+      td::actor::send_closure(queue_size_counter_, &QueueSizeCounter::add_queue_size, block_id, size);
+    }
+  }
 
   void get_block_handle_for_litequery(BlockIdExt block_id, td::Promise<ConstBlockHandle> promise) override;
   void get_block_data_for_litequery(BlockIdExt block_id, td::Promise<td::Ref<BlockData>> promise) override;
@@ -690,6 +685,7 @@ class ValidatorManagerImpl : public ValidatorManager {
  private:
   td::actor::ActorOwn<adnl::AdnlExtServer> lite_server_;
   td::actor::ActorOwn<LiteServerCache> lite_server_cache_;
+  td::actor::ActorOwn<ExtMessageChecker> ext_message_checker_;
   std::vector<td::uint16> pending_ext_ports_;
   std::vector<adnl::AdnlNodeIdShort> pending_ext_ids_;
 
@@ -740,6 +736,9 @@ class ValidatorManagerImpl : public ValidatorManager {
   static size_t max_ext_msg_per_addr() {
     return 3 * 10;
   }
+  static td::uint32 ext_msg_check_workers() {
+    return 4;
+  }
 
   void got_persistent_state_descriptions(std::vector<td::Ref<PersistentStateDescription>> descs);
   void add_persistent_state_description_impl(td::Ref<PersistentStateDescription> desc);
@@ -111,6 +111,11 @@ void QueueSizeCounter::get_queue_size_ex(ton::BlockIdExt block_id, bool calc_who
                               return;
                             }
                             BlockHandle handle = R.move_as_ok();
+                            if (handle->inited_out_msg_queue_size()) {
+                              td::actor::send_closure(SelfId, &QueueSizeCounter::on_result, block_id,
+                                                      handle->out_msg_queue_size(), true);
+                              return;
+                            }
                             td::actor::send_closure(
                                 manager, &ValidatorManager::wait_block_state, handle, 0, td::Timestamp::in(10.0),
                                 [SelfId, handle](td::Result<td::Ref<ShardState>> R) mutable {
@@ -125,8 +130,16 @@ void QueueSizeCounter::get_queue_size_ex(ton::BlockIdExt block_id, bool calc_who
                           });
 }
 
+void QueueSizeCounter::add_queue_size(BlockIdExt block_id, td::uint64 size) {
+  on_result(block_id, size, false);
+}
+
 void QueueSizeCounter::get_queue_size_cont(BlockHandle handle, td::Ref<ShardState> state) {
-  Entry &entry = results_[handle->id()];
+  auto it = results_.find(handle->id());
+  if (it == results_.end() || it->second.done_) {
+    return;
+  }
+  Entry &entry = it->second;
   CHECK(entry.started_);
   bool calc_whole = entry.calc_whole_ || handle->id().seqno() == 0;
   if (!calc_whole) {
@@ -142,12 +155,7 @@ void QueueSizeCounter::get_queue_size_cont(BlockHandle handle, td::Ref<ShardStat
       on_error(handle->id(), r_size.move_as_error());
       return;
     }
-    entry.done_ = true;
-    entry.queue_size_ = r_size.move_as_ok();
-    for (auto &promise : entry.promises_) {
-      promise.set_result(entry.queue_size_);
-    }
-    entry.promises_.clear();
+    save_queue_size(std::move(handle), r_size.move_as_ok());
     return;
   }
 
@@ -165,23 +173,45 @@ void QueueSizeCounter::get_queue_size_cont(BlockHandle handle, td::Ref<ShardStat
             td::actor::send_closure(SelfId, &QueueSizeCounter::on_error, state->get_block_id(), R.move_as_error());
             return;
           }
-          td::actor::send_closure(SelfId, &QueueSizeCounter::get_queue_size_cont2, state, R.move_as_ok(), prev_size);
+          td::actor::send_closure(SelfId, &QueueSizeCounter::get_queue_size_cont2, handle, state, R.move_as_ok(),
+                                  prev_size);
         });
   });
 }
 
-void QueueSizeCounter::get_queue_size_cont2(td::Ref<ShardState> state, td::Ref<ShardState> prev_state,
-                                            td::uint64 prev_size) {
+void QueueSizeCounter::get_queue_size_cont2(BlockHandle handle, td::Ref<ShardState> state,
+                                            td::Ref<ShardState> prev_state, td::uint64 prev_size) {
   BlockIdExt block_id = state->get_block_id();
-  Entry &entry = results_[block_id];
-  CHECK(entry.started_);
+  auto it = results_.find(block_id);
+  if (it == results_.end() || it->second.done_) {
+    return;
+  }
+  CHECK(it->second.started_);
   auto r_size = recalc_queue_size(state, prev_state, prev_size);
   if (r_size.is_error()) {
     on_error(block_id, r_size.move_as_error());
     return;
   }
+  save_queue_size(std::move(handle), r_size.move_as_ok());
+}
+
+void QueueSizeCounter::save_queue_size(BlockHandle handle, td::uint64 size) {
+  if (!handle->inited_out_msg_queue_size()) {
+    handle->set_out_msg_queue_size(size);
+    handle->flush(manager_, handle, [](td::Result<td::Unit>) {});
+  }
+  on_result(handle->id(), size, true);
+}
+
+void QueueSizeCounter::on_result(BlockIdExt block_id, td::uint64 size, bool persisted) {
+  Entry &entry = results_[block_id];
+  entry.persisted_ |= persisted;
+  if (entry.done_) {
+    return;
+  }
+  entry.started_ = true;
   entry.done_ = true;
-  entry.queue_size_ = r_size.move_as_ok();
+  entry.queue_size_ = size;
   for (auto &promise : entry.promises_) {
     promise.set_result(entry.queue_size_);
   }
@@ -194,7 +224,9 @@ void QueueSizeCounter::on_error(ton::BlockIdExt block_id, td::Status error) {
     return;
   }
   Entry &entry = it->second;
-  CHECK(!entry.done_);
+  if (entry.done_) {
+    return;
+  }
   for (auto &promise : entry.promises_) {
     promise.set_error(error.clone());
   }
@@ -266,10 +298,31 @@ void QueueSizeCounter::get_queue_size_ex_retry(BlockIdExt block_id, bool calc_wh
                             td::Timestamp::in(5.0));
                         return;
                       }
+                      td::actor::send_closure(SelfId, &QueueSizeCounter::persist_queue_size, block_id);
                       promise.set_result(td::Unit());
                     });
 }
 
+void QueueSizeCounter::persist_queue_size(BlockIdExt block_id) {
+  auto it = results_.find(block_id);
+  if (it == results_.end() || !it->second.done_ || it->second.persisted_) {
+    return;
+  }
+  // Size reported by the collator or the validator: the block is accepted now, so it can be stored in its handle
+  it->second.persisted_ = true;
+  td::actor::send_closure(manager_, &ValidatorManager::get_block_handle, block_id, false,
+                          [manager = manager_, size = it->second.queue_size_](td::Result<BlockHandle> R) {
+                            if (R.is_error()) {
+                              return;
+                            }
+                            BlockHandle handle = R.move_as_ok();
+                            if (!handle->inited_out_msg_queue_size()) {
+                              handle->set_out_msg_queue_size(size);
+                              handle->flush(manager, handle, [](td::Result<td::Unit>) {});
+                            }
+                          });
+}
+
 void QueueSizeCounter::process_top_shard_blocks_finish() {
   ++current_seqno_;
   wait_shard_client();
@@ -28,6 +28,8 @@ class QueueSizeCounter : public td::actor::Actor {
 
   void start_up() override;
   void get_queue_size(BlockIdExt block_id, td::Promise<td::uint64> promise);
+  // Size computed incrementally by the collator or the validator, so it does not need to be recalculated from states
+  void add_queue_size(BlockIdExt block_id, td::uint64 size);
   void alarm() override;
 
   void update_options(td::Ref<ValidatorManagerOptions> opts) {
@@ -48,6 +50,7 @@ class QueueSizeCounter : public td::actor::Actor {
     bool started_ = false;
     bool done_ = false;
     bool calc_whole_ = false;
+    bool persisted_ = false;
     td::uint64 queue_size_ = 0;
     std::vector<td::Promise<td::uint64>> promises_;
   };
@@ -55,8 +58,12 @@ class QueueSizeCounter : public td::actor::Actor {
 
   void get_queue_size_ex(BlockIdExt block_id, bool calc_whole, td::Promise<td::uint64> promise);
   void get_queue_size_cont(BlockHandle handle, td::Ref<ShardState> state);
-  void get_queue_size_cont2(td::Ref<ShardState> state, td::Ref<ShardState> prev_state, td::uint64 prev_size);
+  void get_queue_size_cont2(BlockHandle handle, td::Ref<ShardState> state, td::Ref<ShardState> prev_state,
+                            td::uint64 prev_size);
+  void save_queue_size(BlockHandle handle, td::uint64 size);
+  void on_result(BlockIdExt block_id, td::uint64 size, bool persisted);
   void on_error(BlockIdExt block_id, td::Status error);
+  void persist_queue_size(BlockIdExt block_id);
 
   void process_top_shard_blocks();
   void process_top_shard_blocks_cont(td::Ref<MasterchainState> state, bool init = false);
@@ -71,6 +71,12 @@ struct CollatorOptions : public td::CntObject {
   std::set<std::pair<WorkchainId, StdSmcAddress>> whitelist;
   // Prioritize these accounts on each phase of process_dispatch_queue
   std::set<std::pair<WorkchainId, StdSmcAddress>> prioritylist;
+
+  // Load accounts that are going to be used in the block (destinations of external messages and of messages in
+  // neighbors' queues) in parallel with collation. See AccountPrefetcher
+  td::uint32 prefetch_workers = 0;  // 0 - disabled
+  td::uint32 prefetch_max_queue_msgs = 4096;
+  double prefetch_timeout = 0.2;
 };
 
 struct ValidatorManagerOptions : public td::CntObject {